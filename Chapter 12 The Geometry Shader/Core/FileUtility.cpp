@@ -131,8 +131,8 @@ ByteArray Utility::ReadFileSync( const wstring& fileName)
     return ReadFileHelperEx(make_shared<wstring>(fileName));
 }
 
-task<ByteArray> Utility::ReadFileAsync(const wstring& fileName)
+JobSystem::Task<ByteArray> Utility::ReadFileAsync(const wstring& fileName)
 {
     shared_ptr<wstring> SharedPtr = make_shared<wstring>(fileName);
-    return create_task( [=] { return ReadFileHelperEx(SharedPtr); } );
+    return JobSystem::Async( [=] { return ReadFileHelperEx(SharedPtr); } );
 }
@@ -18,6 +18,7 @@
 #include "GameInput.h"
 #include "BufferManager.h"
 #include "CommandContext.h"
+#include "JobSystem.h"
 // #include "PostEffects.h"
 
 #pragma comment(lib, "runtimeobject.lib")
@@ -38,6 +39,7 @@ namespace GameCore
 			return false;
 
         SystemTime::Initialize();
+        JobSystem::Initialize();
         GameInput::Initialize();
         EngineTuning::Initialize();
 
@@ -51,6 +53,7 @@ namespace GameCore
         game.Cleanup();
 
         GameInput::Shutdown();
+        JobSystem::Shutdown();
     }
 
 	void UpdateApplication(IGameApp& game)
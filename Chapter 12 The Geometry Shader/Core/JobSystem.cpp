@@ -0,0 +1,523 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "SystemTime.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        class TaskState
+        {
+        public:
+            std::atomic<bool> done{ false };
+            std::mutex mutex;
+            std::vector<std::function<void()>> continuations;   // ǰϵĺ
+        };
+    }
+}
+
+using namespace JobSystem;
+
+namespace
+{
+    struct Job
+    {
+        std::function<void()> func;
+        std::atomic<int>* counter = nullptr;    //  TaskGroup ļִ1
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // еĹ߳óʱƬһȻû˯
+    const int kSpinCount = 64;
+
+    // 0Ŷзǹ̹߳ãi߳ʹõi+1Ŷ
+    std::vector<std::unique_ptr<WorkQueue>> s_Queues;
+    std::vector<std::thread> s_Workers;
+
+    std::atomic<int> s_PendingJobs{ 0 };        // же
+    std::atomic<int> s_SleepingWorkers{ 0 };
+    std::atomic<bool> s_Quit{ false };
+    std::mutex s_SleepMutex;
+    std::condition_variable s_WakeUp;
+
+    thread_local uint32_t t_QueueIndex = 0;
+    thread_local uint32_t t_RandomState = 0x9E3779B9u;
+
+    uint32_t NextRandom()
+    {
+        // xorshift32
+        uint32_t x = t_RandomState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        t_RandomState = x;
+        return x;
+    }
+
+    void Push(Job job)
+    {
+        WorkQueue& queue = *s_Queues[t_QueueIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+
+        // ߳˯ǰ s_SleepingWorkers ټ s_PendingJobsһܿԷ޸
+        s_PendingJobs.fetch_add(1);
+        if (s_SleepingWorkers.load() > 0)
+        {
+            { std::lock_guard<std::mutex> lock(s_SleepMutex); }
+            s_WakeUp.notify_one();
+        }
+    }
+
+    bool TryGetJob(Job& job)
+    {
+        // ȡԼѹݻڻ
+        WorkQueue& own = *s_Queues[t_QueueIndex];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                s_PendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+
+        if (s_PendingJobs.load(std::memory_order_relaxed) == 0)
+            return false;
+
+        // λÿʼȡѹͨҲ
+        uint32_t count = (uint32_t)s_Queues.size();
+        uint32_t start = NextRandom() % count;
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            uint32_t index = (start + k) % count;
+            if (index == t_QueueIndex)
+                continue;
+
+            WorkQueue& victim = *s_Queues[index];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                s_PendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Execute(Job& job)
+    {
+        job.func();
+        if (job.counter != nullptr)
+            job.counter->fetch_sub(1, std::memory_order_release);
+    }
+
+    void WorkerMain(uint32_t index)
+    {
+        t_QueueIndex = index + 1;
+        t_RandomState = 0x9E3779B9u * (index + 1);
+
+        for (;;)
+        {
+            Job job;
+            if (TryGetJob(job))
+            {
+                Execute(job);
+                continue;
+            }
+
+            for (int spin = 0; spin < kSpinCount && s_PendingJobs.load(std::memory_order_relaxed) == 0; ++spin)
+                std::this_thread::yield();
+            if (s_PendingJobs.load(std::memory_order_relaxed) > 0)
+                continue;
+
+            std::unique_lock<std::mutex> lock(s_SleepMutex);
+            s_SleepingWorkers.fetch_add(1);
+            s_WakeUp.wait(lock, [] { return s_PendingJobs.load() > 0 || s_Quit.load(); });
+            s_SleepingWorkers.fetch_sub(1);
+
+            // ˳ǰִʣ
+            if (s_Quit.load() && s_PendingJobs.load() == 0)
+                break;
+        }
+    }
+
+    void SplitRange(TaskGroup& group, int begin, int end, int grain, const std::function<void(int)>& func)
+    {
+        // Ұ벿ֽ߳ȡԼ벿
+        while (end - begin > grain)
+        {
+            int mid = begin + (end - begin) / 2;
+            group.Run([&group, &func, mid, end, grain]() { SplitRange(group, mid, end, grain, func); });
+            end = mid;
+        }
+
+        for (int i = begin; i < end; ++i)
+            func(i);
+    }
+}
+
+void JobSystem::Initialize(uint32_t workerCount, bool pinThreads)
+{
+    ASSERT(s_Workers.empty(), "JobSystem is already initialized");
+
+    uint32_t coreCount = std::thread::hardware_concurrency();
+    if (workerCount == 0)
+        workerCount = coreCount > 1 ? coreCount - 1 : 1;
+
+    s_Quit = false;
+    s_Queues.resize(workerCount + 1);
+    for (auto& queue : s_Queues)
+        queue = std::make_unique<WorkQueue>();
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        s_Workers.emplace_back(WorkerMain, i);
+#ifdef _WIN32
+        if (pinThreads && coreCount > 0)
+            SetThreadAffinityMask(s_Workers.back().native_handle(), 1ull << ((i + 1) % (std::min)(coreCount, 64u)));
+#else
+        (void)pinThreads;
+#endif
+    }
+}
+
+void JobSystem::Shutdown()
+{
+    if (s_Workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(s_SleepMutex);
+        s_Quit = true;
+    }
+    s_WakeUp.notify_all();
+
+    for (auto& worker : s_Workers)
+        worker.join();
+
+    s_Workers.clear();
+    s_Queues.clear();
+}
+
+uint32_t JobSystem::GetWorkerCount()
+{
+    return (uint32_t)s_Workers.size();
+}
+
+void JobSystem::Submit(std::function<void()> job)
+{
+    // ûгʼʱֱڵǰִ߳
+    if (s_Queues.empty())
+    {
+        job();
+        return;
+    }
+
+    Push(Job{ std::move(job), nullptr });
+}
+
+bool JobSystem::RunPendingJob()
+{
+    if (s_Queues.empty())
+        return false;
+
+    Job job;
+    if (!TryGetJob(job))
+        return false;
+
+    Execute(job);
+    return true;
+}
+
+void TaskGroup::Run(std::function<void()> job)
+{
+    if (s_Queues.empty())
+    {
+        job();
+        return;
+    }
+
+    m_Pending.fetch_add(1, std::memory_order_relaxed);
+    Push(Job{ std::move(job), &m_Pending });
+}
+
+void TaskGroup::Wait()
+{
+    while (m_Pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!RunPendingJob())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(int begin, int end, int grain, const std::function<void(int)>& func)
+{
+    grain = (std::max)(grain, 1);
+    if (s_Workers.empty() || end - begin <= grain)
+    {
+        for (int i = begin; i < end; ++i)
+            func(i);
+        return;
+    }
+
+    TaskGroup group;
+    SplitRange(group, begin, end, grain, func);
+    group.Wait();
+}
+
+bool TaskHandle::IsDone() const
+{
+    return m_State->done.load(std::memory_order_acquire);
+}
+
+void TaskHandle::Wait() const
+{
+    while (!IsDone())
+    {
+        if (!RunPendingJob())
+            std::this_thread::yield();
+    }
+}
+
+std::shared_ptr<Internal::TaskState> TaskHandle::CreateState()
+{
+    return std::make_shared<Internal::TaskState>();
+}
+
+void TaskHandle::ContinueWith(std::function<void()> job) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        if (!m_State->done.load(std::memory_order_relaxed))
+        {
+            m_State->continuations.push_back(std::move(job));
+            return;
+        }
+    }
+    Submit(std::move(job));
+}
+
+void TaskHandle::Finish() const
+{
+    std::vector<std::function<void()>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(m_State->mutex);
+        m_State->done.store(true, std::memory_order_release);
+        continuations.swap(m_State->continuations);
+    }
+
+    for (auto& job : continuations)
+        Submit(std::move(job));
+}
+
+namespace
+{
+    int SerialFib(int n)
+    {
+        return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+    }
+
+    int ForkJoinFib(int n)
+    {
+        if (n < 16)
+            return SerialFib(n);
+
+        int a = 0;
+        TaskGroup group;
+        group.Run([&a, n]() { a = ForkJoinFib(n - 1); });
+        int b = ForkJoinFib(n - 2);
+        group.Wait();
+        return a + b;
+    }
+
+    double ElapsedMs(int64_t start)
+    {
+        return SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start);
+    }
+}
+
+bool JobSystem::StressTest()
+{
+    bool passed = true;
+    auto report = [&passed](const wchar_t* name, bool ok)
+    {
+        Utility::Printf(L"JobSystem: %s %s\n", name, ok ? L"passed" : L"FAILED");
+        passed = passed && ok;
+    };
+
+    Utility::Printf(L"JobSystem: %u workers\n", GetWorkerCount());
+
+    // ÿԪǡñһΣͲ
+    {
+        const int count = 100003;
+        std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[count]());
+        const int grains[] = { 1, 7, 64, 1000, count };
+        bool ok = true;
+        for (int round = 0; round < 20; ++round)
+        {
+            for (int grain : grains)
+            {
+                ParallelFor(-37, count - 37, grain, [&visits](int i) { visits[i + 37].fetch_add(1, std::memory_order_relaxed); });
+            }
+        }
+        for (int i = 0; i < count; ++i)
+            ok = ok && visits[i].load() == 20 * (int)_countof(grains);
+        report(L"ParallelFor coverage", ok);
+    }
+
+    // 񲢵ȴ
+    {
+        report(L"nested fork/join", ForkJoinFib(27) == SerialFib(27));
+
+        std::atomic<int64_t> sum{ 0 };
+        ParallelFor(0, 256, 1, [&sum](int i)
+        {
+            ParallelFor(0, 1000, 10, [&sum, i](int j) { sum.fetch_add(i * 1000 + j, std::memory_order_relaxed); });
+        });
+        int64_t n = 256 * 1000;
+        report(L"nested ParallelFor", sum.load() == n * (n - 1) / 2);
+    }
+
+    // : ǰɺϵĶҪִУ
+    {
+        const int chainCount = 1000;
+        std::atomic<int> finished{ 0 };
+        std::vector<Task<int>> results;
+        std::vector<Task<void>> tails;
+        for (int i = 0; i < chainCount; ++i)
+        {
+            Task<int> doubled = Async([i]() { return i; }).Then([](int x) { return x * 2; });
+            results.push_back(doubled.Then([](int x) { return x + 1; }));
+            tails.push_back(results.back().Then([&finished](int) { finished.fetch_add(1); }));
+        }
+
+        bool ok = true;
+        for (int i = 0; i < chainCount; ++i)
+            ok = ok && results[i].Get() == 2 * i + 1;
+        for (auto& tail : tails)
+            tail.Wait();
+
+        // Ѿ֮ٽϵĺ
+        Task<int> late = results[0].Then([](int x) { return x + 41; });
+        Task<int> fromVoid = tails[0].Then([]() { return 7; });
+        ok = ok && finished.load() == chainCount && late.Get() == 42 && fromVoid.Get() == 7;
+        report(L"continuations", ok);
+    }
+
+    // ǹ߳ͬʱǹ0Ŷ
+    {
+        std::atomic<int64_t> sum{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&sum]()
+            {
+                for (int k = 0; k < 200; ++k)
+                    ParallelFor(0, 1000, 16, [&sum](int i) { sum.fetch_add(i, std::memory_order_relaxed); });
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        report(L"external threads", sum.load() == 4 * 200 * (int64_t)(999 * 1000 / 2));
+    }
+
+    // ȴ
+    {
+        const int jobCount = 100000;
+        std::atomic<int> done{ 0 };
+        for (int i = 0; i < jobCount; ++i)
+            Submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        while (done.load() < jobCount)
+        {
+            if (!RunPendingJob())
+                std::this_thread::yield();
+        }
+        report(L"fire and forget", done.load() == jobCount);
+    }
+
+    return passed;
+}
+
+void JobSystem::Benchmark()
+{
+    const int jobCount = 100000;
+
+    // ߳ٵȴÿҪ̴߳0Ŷȡ
+    {
+        int64_t start = SystemTime::GetCurrentTick();
+        TaskGroup group;
+        for (int i = 0; i < jobCount; ++i)
+            group.Run([]() {});
+        group.Wait();
+        Utility::Printf(L"JobSystem: empty jobs from main thread    %.1f ns/job\n", ElapsedMs(start) * 1e6 / jobCount);
+    }
+
+    // ߳񣬴󲿷ԼӶβȡ
+    {
+        int64_t start = SystemTime::GetCurrentTick();
+        Async([jobCount]()
+        {
+            TaskGroup group;
+            for (int i = 0; i < jobCount; ++i)
+                group.Run([]() {});
+            group.Wait();
+            return 0;
+        }).Get();
+        Utility::Printf(L"JobSystem: empty jobs from worker         %.1f ns/job\n", ElapsedMs(start) * 1e6 / jobCount);
+    }
+
+    // Async + Then ӳ
+    {
+        const int roundTrips = 10000;
+        int64_t start = SystemTime::GetCurrentTick();
+        int sum = 0;
+        for (int i = 0; i < roundTrips; ++i)
+            sum += Async([i]() { return i; }).Then([](int x) { return x + 1; }).Get();
+        Utility::Printf(L"JobSystem: Async + Then round trip        %.2f us (%d)\n", ElapsedMs(start) * 1e3 / roundTrips, sum);
+    }
+
+    // ͬ ParallelFor Դѭļٱ
+    {
+        const int count = 1 << 20;
+        std::vector<float> output(count);
+        auto work = [&output](int i)
+        {
+            float x = (float)i;
+            output[i] = sqrtf(x) * 0.5f + sinf(x * 0.001f);
+        };
+
+        int64_t start = SystemTime::GetCurrentTick();
+        for (int i = 0; i < count; ++i)
+            work(i);
+        double serialMs = ElapsedMs(start);
+        Utility::Printf(L"JobSystem: ParallelFor %d elements  serial %.3f ms\n", count, serialMs);
+
+        const int grains[] = { 1, 16, 256, 4096, 65536 };
+        for (int grain : grains)
+        {
+            start = SystemTime::GetCurrentTick();
+            ParallelFor(0, count, grain, work);
+            double ms = ElapsedMs(start);
+            Utility::Printf(L"JobSystem: ParallelFor grain %6d  %.3f ms  x%.2f\n", grain, ms, serialMs / ms);
+        }
+    }
+}
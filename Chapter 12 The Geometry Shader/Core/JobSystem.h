@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+// ƽ̨ϵͳ PPL(concurrency::parallel_forcreate_task)
+// ÿ߳ӵԼ˫˶: ԼӶβѹȡ񣬿ʱеĶͷȡ
+// ǹ̵߳߳(߳)һ
+// ȴɵ̲߳ǰæִжепԼ񲢵ȴ(fork/join)
+//
+// в׳쳣
+namespace JobSystem
+{
+    // workerCount Ϊ0ʱʹ ( - 1) ̣߳ Wait ߳Ҳִ
+    // pinThreads Ϊtrueʱѵḭ߳󶨵i+1߼
+    void Initialize(uint32_t workerCount = 0, bool pinThreads = false);
+
+    // ִʣȫ߳
+    void Shutdown();
+
+    uint32_t GetWorkerCount();
+
+    // ύһĺʱɵ
+    void Submit(std::function<void()> job);
+
+    // ڵǰִ߳һеûʱfalse
+    bool RunPendingJob();
+
+    // fork/join: Run Wait ȴȫɣʱԶȴ
+    class TaskGroup
+    {
+    public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+        ~TaskGroup() { Wait(); }
+
+        void Run(std::function<void()> job);
+        void Wait();
+
+    private:
+        std::atomic<int> m_Pending{ 0 };
+    };
+
+    //  [begin, end) еÿ i  func(i)
+    // 䱻ֳɶΣÿβ grain ԪأͬһεԪһ߳а˳ִ
+    void ParallelFor(int begin, int end, int grain, const std::function<void(int)>& func);
+
+    template <typename T> class Task;
+
+    namespace Internal
+    {
+        class TaskState;
+        struct TaskLauncher;
+
+        template <typename T>
+        struct TaskValue
+        {
+            typedef const T& Reference;
+
+            template <typename F> void Run(F& func) { value = func(); }
+            template <typename F> auto Continue(F& func) const -> decltype(func(std::declval<const T&>())) { return func(value); }
+            Reference Get() const { return value; }
+
+            T value = T();
+        };
+
+        template <>
+        struct TaskValue<void>
+        {
+            typedef void Reference;
+
+            template <typename F> void Run(F& func) { func(); }
+            template <typename F> auto Continue(F& func) const -> decltype(func()) { return func(); }
+            void Get() const {}
+        };
+
+        //  Task<T> ֮ĺķֵ
+        template <typename T, typename F>
+        struct ContinuationResult { typedef decltype(std::declval<F&>()(std::declval<const T&>())) Type; };
+
+        template <typename F>
+        struct ContinuationResult<void, F> { typedef decltype(std::declval<F&>()()) Type; };
+    }
+
+    // 뷵ֵ޹صĲ
+    class TaskHandle
+    {
+    public:
+        bool IsValid() const { return m_State != nullptr; }
+        bool IsDone() const;
+
+        // æֱִ
+        void Wait() const;
+
+    protected:
+        TaskHandle() = default;
+
+        static std::shared_ptr<Internal::TaskState> CreateState();
+
+        // ɺύ jobѾʱύ
+        void ContinueWith(std::function<void()> job) const;
+
+        // ɲύк
+        void Finish() const;
+
+        std::shared_ptr<Internal::TaskState> m_State;
+    };
+
+    // ֵ첽 Async  Then Ϻ
+    template <typename T>
+    class Task : public TaskHandle
+    {
+    public:
+        Task() = default;
+
+        // ȴɲؽ
+        typename Internal::TaskValue<T>::Reference Get() const
+        {
+            Wait();
+            return m_Value->Get();
+        }
+
+        // ɺԽΪִ func func Ӧ
+        template <typename F>
+        Task<typename Internal::ContinuationResult<T, F>::Type> Then(F func) const
+        {
+            typedef typename Internal::ContinuationResult<T, F>::Type R;
+            Task<R> next = Task<R>::Create();
+            std::shared_ptr<Internal::TaskValue<T>> value = m_Value;
+            ContinueWith([next, value, func]() mutable
+            {
+                next.Complete([&]() { return value->Continue(func); });
+            });
+            return next;
+        }
+
+    private:
+        template <typename> friend class Task;
+        friend struct Internal::TaskLauncher;
+
+        static Task Create()
+        {
+            Task task;
+            task.m_State = CreateState();
+            task.m_Value = std::make_shared<Internal::TaskValue<T>>();
+            return task;
+        }
+
+        template <typename F>
+        void Complete(F func) const
+        {
+            m_Value->Run(func);
+            Finish();
+        }
+
+        std::shared_ptr<Internal::TaskValue<T>> m_Value;
+    };
+
+    namespace Internal
+    {
+        struct TaskLauncher
+        {
+            template <typename F>
+            static Task<decltype(std::declval<F&>()())> Launch(F& func)
+            {
+                typedef decltype(std::declval<F&>()()) R;
+                Task<R> task = Task<R>::Create();
+                Submit([task, func]() mutable { task.Complete(func); });
+                return task;
+            }
+        };
+    }
+
+    // ڹִ߳ funcضӦ
+    template <typename F>
+    Task<decltype(std::declval<F&>()())> Async(F func)
+    {
+        return Internal::TaskLauncher::Launch(func);
+    }
+
+    // ȷѹԣ̨ȫͨʱtrue
+    bool StressTest();
+
+    // ȿ: /ȴʱParallelFor ڲͬµļٱ
+    void Benchmark();
+}
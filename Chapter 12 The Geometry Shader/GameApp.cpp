@@ -5,6 +5,7 @@
 #include "CommandContext.h"
 #include "TextureManager.h"
 #include "GeometryGenerator.h"
+#include "JobSystem.h"
 
 #include <DirectXColors.h>
 #include <fstream>
@@ -39,6 +40,18 @@ static int Rand(int a, int b)
 
 void GameApp::Startup(void)
 {
+    if (g_jobSystemTest)
+    {
+        JobSystem::StressTest();
+        JobSystem::Benchmark();
+    }
+
+    if (g_wavesBenchmark)
+        Waves::Benchmark();
+
+    // ģⲽΪ0.03룬ֵÿ֡ܿƽˮ
+    m_waves.SetInterpolation(true);
+
     buildLandGeo();
     buildBoxGeo();
     buildWavesGeo();
@@ -411,6 +424,17 @@ void GameApp::buildWavesGeo()
     geo->bDynamicVertex = true;
 
     geo->vecVertex.resize(m_waves.VertexCount());
+
+    // xz겻仯ֻһ
+    // Derive tex-coords from position by 
+    // mapping [-w/2,w/2] --> [0,1]
+    m_waves.GetVertices(&geo->vecVertex[0].Pos, nullptr, nullptr, sizeof(Vertex));
+    for (auto& v : geo->vecVertex)
+    {
+        v.TexC.x = 0.5f + v.Pos.x / m_waves.Width();
+        v.TexC.y = 0.5f - v.Pos.z / m_waves.Depth();
+    }
+
     geo->createIndex(L"wavesGeo index", (UINT)waveIndices.size(), sizeof(std::uint16_t), waveIndices.data());
 
     SubmeshGeometry submesh;
@@ -598,18 +622,9 @@ void GameApp::UpdateWaves(float deltaT)
     m_waves.Update(deltaT);
 
     // Update the wave vertex buffer with the new solution.
-    for (int i = 0; i < m_waves.VertexCount(); ++i)
-    {
-        auto p = &m_pWavesVec->at(i);
-
-        p->Pos = m_waves.Position(i);
-        p->Normal = m_waves.Normal(i);
-
-        // Derive tex-coords from position by 
-        // mapping [-w/2,w/2] --> [0,1]
-        p->TexC.x = 0.5f + p->Pos.x / m_waves.Width();
-        p->TexC.y = 0.5f - p->Pos.z / m_waves.Depth();
-    }
+    // ֻҪλúͷߣ buildWavesGeo 
+    auto& vertices = *m_pWavesVec;
+    m_waves.GetVertices(&vertices[0].Pos, &vertices[0].Normal, nullptr, sizeof(Vertex));
 
     AnimateMaterials(deltaT);
 }
@@ -3,13 +3,132 @@
 //***************************************************************************************
 
 #include "Waves.h"
-#include <ppl.h>
+#include "Utility.h"
+#include "SystemTime.h"
+#include "JobSystem.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
+#include <immintrin.h>
 
 using namespace DirectX;
 
+namespace
+{
+	// At most this many rows are handled by one job.  A job walks its rows top to
+	// bottom so the three source rows of the stencil stay in cache between rows.
+	const int kRowBlock = 16;
+
+	inline XMFLOAT3& Element(XMFLOAT3* base, size_t stride, int i)
+	{
+		return *(XMFLOAT3*)((uint8_t*)base + i * stride);
+	}
+
+	// The original solver, kept for Waves::Benchmark().  It stores full XMFLOAT3
+	// positions and normalizes one normal and tangent at a time.
+	class LegacyWaves
+	{
+	public:
+		LegacyWaves(int m, int n, float dx, float dt, float speed, float damping)
+		{
+			mNumRows = m;
+			mNumCols = n;
+			mSpatialStep = dx;
+
+			float d = damping*dt + 2.0f;
+			float e = (speed*speed)*(dt*dt) / (dx*dx);
+			mK1 = (damping*dt - 2.0f) / d;
+			mK2 = (4.0f - 8.0f*e) / d;
+			mK3 = (2.0f*e) / d;
+
+			mPrevSolution.resize(m*n);
+			mCurrSolution.resize(m*n);
+			mNormals.resize(m*n);
+			mTangentX.resize(m*n);
+
+			float halfWidth = (n - 1)*dx*0.5f;
+			float halfDepth = (m - 1)*dx*0.5f;
+			for(int i = 0; i < m; ++i)
+			{
+				float z = halfDepth - i*dx;
+				for(int j = 0; j < n; ++j)
+				{
+					float x = -halfWidth + j*dx;
+
+					mPrevSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
+					mCurrSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
+					mNormals[i*n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+					mTangentX[i*n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+				}
+			}
+		}
+
+		void Step()
+		{
+			JobSystem::ParallelFor(1, mNumRows - 1, 1, [this](int i)
+			{
+				for(int j = 1; j < mNumCols-1; ++j)
+				{
+					mPrevSolution[i*mNumCols+j].y =
+						mK1*mPrevSolution[i*mNumCols+j].y +
+						mK2*mCurrSolution[i*mNumCols+j].y +
+						mK3*(mCurrSolution[(i+1)*mNumCols+j].y +
+						     mCurrSolution[(i-1)*mNumCols+j].y +
+						     mCurrSolution[i*mNumCols+j+1].y +
+							 mCurrSolution[i*mNumCols+j-1].y);
+				}
+			});
+
+			std::swap(mPrevSolution, mCurrSolution);
+
+			JobSystem::ParallelFor(1, mNumRows - 1, 1, [this](int i)
+			{
+				for(int j = 1; j < mNumCols-1; ++j)
+				{
+					float l = mCurrSolution[i*mNumCols+j-1].y;
+					float r = mCurrSolution[i*mNumCols+j+1].y;
+					float t = mCurrSolution[(i-1)*mNumCols+j].y;
+					float b = mCurrSolution[(i+1)*mNumCols+j].y;
+					mNormals[i*mNumCols+j].x = -r+l;
+					mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
+					mNormals[i*mNumCols+j].z = b-t;
+
+					XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
+					XMStoreFloat3(&mNormals[i*mNumCols+j], n);
+
+					mTangentX[i*mNumCols+j] = XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
+					XMVECTOR T = XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
+					XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
+				}
+			});
+		}
+
+		void Disturb(int i, int j, float magnitude)
+		{
+			float halfMag = 0.5f*magnitude;
+
+			mCurrSolution[i*mNumCols+j].y     += magnitude;
+			mCurrSolution[i*mNumCols+j+1].y   += halfMag;
+			mCurrSolution[i*mNumCols+j-1].y   += halfMag;
+			mCurrSolution[(i+1)*mNumCols+j].y += halfMag;
+			mCurrSolution[(i-1)*mNumCols+j].y += halfMag;
+		}
+
+		int mNumRows = 0;
+		int mNumCols = 0;
+		float mK1 = 0.0f;
+		float mK2 = 0.0f;
+		float mK3 = 0.0f;
+		float mSpatialStep = 0.0f;
+
+		std::vector<XMFLOAT3> mPrevSolution;
+		std::vector<XMFLOAT3> mCurrSolution;
+		std::vector<XMFLOAT3> mNormals;
+		std::vector<XMFLOAT3> mTangentX;
+	};
+}
+
 Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 {
     mNumRows = m;
@@ -27,28 +146,9 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
     mK2 = (4.0f - 8.0f*e) / d;
     mK3 = (2.0f*e) / d;
 
-    mPrevSolution.resize(m*n);
-    mCurrSolution.resize(m*n);
-    mNormals.resize(m*n);
-    mTangentX.resize(m*n);
-
-    // Generate grid vertices in system memory.
-
-    float halfWidth = (n - 1)*dx*0.5f;
-    float halfDepth = (m - 1)*dx*0.5f;
-    for(int i = 0; i < m; ++i)
-    {
-        float z = halfDepth - i*dx;
-        for(int j = 0; j < n; ++j)
-        {
-            float x = -halfWidth + j*dx;
-
-            mPrevSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
-            mCurrSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
-            mNormals[i*n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-            mTangentX[i*n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-        }
-    }
+    // The grid starts flat.
+    mPrevHeight.assign(m*n, 0.0f);
+    mCurrHeight.assign(m*n, 0.0f);
 }
 
 Waves::~Waves()
@@ -85,72 +185,236 @@ float Waves::Depth()const
 	return mNumRows*mSpatialStep;
 }
 
-void Waves::Update(float dt)
+int Waves::Update(float dt)
 {
-	static float t = 0;
-
 	// Accumulate time.
-	t += dt;
+	mAccumulator += dt;
 
-	// Only update the simulation at the specified time step.
-	if( t >= mTimeStep )
+	// Consume it in whole time steps so slow frames catch up instead of losing
+	// simulation time.
+	int steps = 0;
+	while( mAccumulator >= mTimeStep && steps < mMaxSubSteps )
 	{
-		// Only update interior points; we use zero boundary conditions.
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows-1; ++i)
+		Step();
+
+		mAccumulator -= mTimeStep;
+		++steps;
+	}
+
+	// Past the cap, drop the rest; otherwise a long frame would make the next
+	// frame longer still.
+	if( mAccumulator >= mTimeStep )
+		mAccumulator = fmodf(mAccumulator, mTimeStep);
+
+	return steps;
+}
+
+void Waves::SetMaxSubSteps(int count)
+{
+	mMaxSubSteps = (std::max)(count, 1);
+}
+
+void Waves::SetInterpolation(bool enable)
+{
+	mInterpolate = enable;
+}
+
+float Waves::InterpolationAlpha()const
+{
+	return mAccumulator / mTimeStep;
+}
+
+void Waves::Step()
+{
+	// Only update interior points; we use zero boundary conditions.
+	JobSystem::ParallelFor(1, mNumRows - 1, kRowBlock, [this](int i)
+	{
+		StepRow(i);
+	});
+
+	// We just overwrote the previous buffer with the new data, so
+	// this data needs to become the current solution and the old
+	// current solution becomes the new previous solution.
+	std::swap(mPrevHeight, mCurrHeight);
+}
+
+void Waves::StepRow(int i)
+{
+	// After this update we will be discarding the old previous
+	// buffer, so overwrite that buffer with the new update.
+	// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
+	//
+	// The kernels add the terms in the same order as the scalar loop, so every
+	// width produces exactly the same heights.
+	const float* up = &mCurrHeight[(i-1)*mNumCols];
+	const float* curr = up + mNumCols;
+	const float* down = curr + mNumCols;
+	float* prev = &mPrevHeight[i*mNumCols];
+
+	int j = 1;
+	int end = mNumCols - 1;
+
+#ifdef __AVX__
+	{
+		__m256 k1 = _mm256_set1_ps(mK1);
+		__m256 k2 = _mm256_set1_ps(mK2);
+		__m256 k3 = _mm256_set1_ps(mK3);
+		for(; j + 8 <= end; j += 8)
 		{
-			for(int j = 1; j < mNumCols-1; ++j)
-			{
-				// After this update we will be discarding the old previous
-				// buffer, so overwrite that buffer with the new update.
-				// Note how we can do this inplace (read/write to same element) 
-				// because we won't need prev_ij again and the assignment happens last.
-
-				// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
-				// Moreover, our +z axis goes "down"; this is just to 
-				// keep consistent with our row indices going down.
-
-				mPrevSolution[i*mNumCols+j].y = 
-					mK1*mPrevSolution[i*mNumCols+j].y +
-					mK2*mCurrSolution[i*mNumCols+j].y +
-					mK3*(mCurrSolution[(i+1)*mNumCols+j].y + 
-					     mCurrSolution[(i-1)*mNumCols+j].y + 
-					     mCurrSolution[i*mNumCols+j+1].y + 
-						 mCurrSolution[i*mNumCols+j-1].y);
-			}
-		});
+			__m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_loadu_ps(down + j), _mm256_loadu_ps(up + j)),
+				_mm256_loadu_ps(curr + j + 1)), _mm256_loadu_ps(curr + j - 1));
+			__m256 h = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(k1, _mm256_loadu_ps(prev + j)),
+				_mm256_mul_ps(k2, _mm256_loadu_ps(curr + j))),
+				_mm256_mul_ps(k3, sum));
+			_mm256_storeu_ps(prev + j, h);
+		}
+	}
+#endif
+
+	__m128 k1 = _mm_set1_ps(mK1);
+	__m128 k2 = _mm_set1_ps(mK2);
+	__m128 k3 = _mm_set1_ps(mK3);
+	for(; j + 4 <= end; j += 4)
+	{
+		__m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+			_mm_loadu_ps(down + j), _mm_loadu_ps(up + j)),
+			_mm_loadu_ps(curr + j + 1)), _mm_loadu_ps(curr + j - 1));
+		__m128 h = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(k1, _mm_loadu_ps(prev + j)),
+			_mm_mul_ps(k2, _mm_loadu_ps(curr + j))),
+			_mm_mul_ps(k3, sum));
+		_mm_storeu_ps(prev + j, h);
+	}
 
-		// We just overwrote the previous buffer with the new data, so
-		// this data needs to become the current solution and the old
-		// current solution becomes the new previous solution.
-		std::swap(mPrevSolution, mCurrSolution);
+	for(; j < end; ++j)
+	{
+		prev[j] = mK1*prev[j] + mK2*curr[j] + mK3*(down[j] + up[j] + curr[j+1] + curr[j-1]);
+	}
+}
 
-		t = 0.0f; // reset time
+void Waves::GetVertices(XMFLOAT3* positions, XMFLOAT3* normals, XMFLOAT3* tangentX, size_t stride)const
+{
+	const float* heights = mCurrHeight.data();
 
-		//
-		// Compute normals using finite difference scheme.
-		//
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows - 1; ++i)
+	// After a step mPrevHeight holds the solution one step before mCurrHeight.
+	// The normals need the neighbouring rows, so blend the whole field first.
+	if(mInterpolate)
+	{
+		float alpha = InterpolationAlpha();
+		mRenderHeight.resize(mCurrHeight.size());
+		JobSystem::ParallelFor(0, mNumRows, kRowBlock, [&](int i)
 		{
-			for(int j = 1; j < mNumCols-1; ++j)
-			{
-				float l = mCurrSolution[i*mNumCols+j-1].y;
-				float r = mCurrSolution[i*mNumCols+j+1].y;
-				float t = mCurrSolution[(i-1)*mNumCols+j].y;
-				float b = mCurrSolution[(i+1)*mNumCols+j].y;
-				mNormals[i*mNumCols+j].x = -r+l;
-				mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
-				mNormals[i*mNumCols+j].z = b-t;
-
-				XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
-				XMStoreFloat3(&mNormals[i*mNumCols+j], n);
-
-				mTangentX[i*mNumCols+j] = XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
-				XMVECTOR T = XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
-				XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
-			}
+			const float* prev = &mPrevHeight[i*mNumCols];
+			const float* curr = &mCurrHeight[i*mNumCols];
+			float* out = &mRenderHeight[i*mNumCols];
+			for(int j = 0; j < mNumCols; ++j)
+				out[j] = prev[j] + alpha*(curr[j] - prev[j]);
 		});
+		heights = mRenderHeight.data();
+	}
+
+	JobSystem::ParallelFor(0, mNumRows, kRowBlock, [&](int i)
+	{
+		GetRowVertices(heights, i, positions, normals, tangentX, stride);
+	});
+}
+
+void Waves::GetRowVertices(const float* heights, int i, XMFLOAT3* positions, XMFLOAT3* normals, XMFLOAT3* tangentX, size_t stride)const
+{
+	const int n = mNumCols;
+	const float* curr = heights + i*n;
+
+	if(positions != nullptr)
+	{
+		float halfWidth = (n - 1)*mSpatialStep*0.5f;
+		float halfDepth = (mNumRows - 1)*mSpatialStep*0.5f;
+		float z = halfDepth - i*mSpatialStep;
+		for(int j = 0; j < n; ++j)
+			Element(positions, stride, i*n + j) = XMFLOAT3(-halfWidth + j*mSpatialStep, curr[j], z);
+	}
+
+	if(normals == nullptr && tangentX == nullptr)
+		return;
+
+	// Boundary points are never simulated and stay flat.
+	bool boundaryRow = (i == 0 || i == mNumRows - 1);
+	for(int j = 0; j < n; j += (boundaryRow || j == n - 1) ? 1 : n - 1)
+	{
+		if(normals != nullptr)
+			Element(normals, stride, i*n + j) = XMFLOAT3(0.0f, 1.0f, 0.0f);
+		if(tangentX != nullptr)
+			Element(tangentX, stride, i*n + j) = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	}
+	if(boundaryRow)
+		return;
+
+	// Compute normals and tangents using finite difference scheme, four points at a
+	// time.  The lengths are summed as (x*x + y*y) + z*z and divided like
+	// XMVector3Normalize does, so the results match the per point path.
+	const float* up = curr - n;
+	const float* down = curr + n;
+	float ny = 2.0f*mSpatialStep;
+
+	__m128 normalY = _mm_set1_ps(ny);
+	__m128 normalY2 = _mm_mul_ps(normalY, normalY);
+
+	int j = 1;
+	for(; j + 4 <= n - 1; j += 4)
+	{
+		__m128 l = _mm_loadu_ps(curr + j - 1);
+		__m128 r = _mm_loadu_ps(curr + j + 1);
+		__m128 t = _mm_loadu_ps(up + j);
+		__m128 b = _mm_loadu_ps(down + j);
+
+		XMFLOAT4A outNX, outNY, outNZ, outTX, outTY;
+		if(normals != nullptr)
+		{
+			__m128 x = _mm_sub_ps(l, r);
+			__m128 z = _mm_sub_ps(b, t);
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), normalY2), _mm_mul_ps(z, z)));
+			_mm_store_ps(&outNX.x, _mm_div_ps(x, length));
+			_mm_store_ps(&outNY.x, _mm_div_ps(normalY, length));
+			_mm_store_ps(&outNZ.x, _mm_div_ps(z, length));
+		}
+		if(tangentX != nullptr)
+		{
+			__m128 y = _mm_sub_ps(r, l);
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(normalY2, _mm_mul_ps(y, y)));
+			_mm_store_ps(&outTX.x, _mm_div_ps(normalY, length));
+			_mm_store_ps(&outTY.x, _mm_div_ps(y, length));
+		}
+
+		for(int k = 0; k < 4; ++k)
+		{
+			if(normals != nullptr)
+				Element(normals, stride, i*n + j + k) = XMFLOAT3((&outNX.x)[k], (&outNY.x)[k], (&outNZ.x)[k]);
+			if(tangentX != nullptr)
+				Element(tangentX, stride, i*n + j + k) = XMFLOAT3((&outTX.x)[k], (&outTY.x)[k], 0.0f);
+		}
+	}
+
+	for(; j < n - 1; ++j)
+	{
+		float l = curr[j-1];
+		float r = curr[j+1];
+		float t = up[j];
+		float b = down[j];
+
+		if(normals != nullptr)
+		{
+			float x = l - r;
+			float z = b - t;
+			float length = sqrtf(x*x + ny*ny + z*z);
+			Element(normals, stride, i*n + j) = XMFLOAT3(x / length, ny / length, z / length);
+		}
+		if(tangentX != nullptr)
+		{
+			float y = r - l;
+			float length = sqrtf(ny*ny + y*y);
+			Element(tangentX, stride, i*n + j) = XMFLOAT3(ny / length, y / length, 0.0f);
+		}
 	}
 }
 
@@ -163,10 +427,151 @@ void Waves::Disturb(int i, int j, float magnitude)
 	float halfMag = 0.5f*magnitude;
 
 	// Disturb the ijth vertex height and its neighbors.
-	mCurrSolution[i*mNumCols+j].y     += magnitude;
-	mCurrSolution[i*mNumCols+j+1].y   += halfMag;
-	mCurrSolution[i*mNumCols+j-1].y   += halfMag;
-	mCurrSolution[(i+1)*mNumCols+j].y += halfMag;
-	mCurrSolution[(i-1)*mNumCols+j].y += halfMag;
+	mCurrHeight[i*mNumCols+j]     += magnitude;
+	mCurrHeight[i*mNumCols+j+1]   += halfMag;
+	mCurrHeight[i*mNumCols+j-1]   += halfMag;
+	mCurrHeight[(i+1)*mNumCols+j] += halfMag;
+	mCurrHeight[(i-1)*mNumCols+j] += halfMag;
+}
+
+void Waves::Benchmark()
+{
+	const int sizes[] = { 128, 512, 2048 };
+	for(int n : sizes)
+	{
+		// Keep the number of simulated points roughly the same for every size.
+		int steps = (std::max)(4, (1 << 24) / (n*n));
+
+		LegacyWaves legacy(n, n, 1.0f, 0.03f, 4.0f, 0.2f);
+		Waves waves(n, n, 1.0f, 0.03f, 4.0f, 0.2f);
+		for(int k = 0; k < 16; ++k)
+		{
+			int i = 4 + (k*7919) % (n - 8);
+			int j = 4 + (k*104729) % (n - 8);
+			legacy.Disturb(i, j, 0.5f);
+			waves.Disturb(i, j, 0.5f);
+		}
+
+		std::vector<XMFLOAT3> positions(n*n);
+		std::vector<XMFLOAT3> normals(n*n);
+		std::vector<XMFLOAT3> tangents(n*n);
+
+		// The original solver recomputed normals and tangents on every step, so the
+		// new one is timed with GetVertices() after every step as well.
+		int64_t start = SystemTime::GetCurrentTick();
+		for(int s = 0; s < steps; ++s)
+			legacy.Step();
+		double legacyMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start) / steps;
+
+		double solveMs = 0.0;
+		double vertexMs = 0.0;
+		for(int s = 0; s < steps; ++s)
+		{
+			start = SystemTime::GetCurrentTick();
+			waves.Step();
+			int64_t solved = SystemTime::GetCurrentTick();
+			waves.GetVertices(positions.data(), normals.data(), tangents.data(), sizeof(XMFLOAT3));
+			solveMs += SystemTime::TicksToMillisecs(solved - start);
+			vertexMs += SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - solved);
+		}
+		solveMs /= steps;
+		vertexMs /= steps;
+
+		bool same =
+			memcmp(positions.data(), legacy.mCurrSolution.data(), n*n*sizeof(XMFLOAT3)) == 0 &&
+			memcmp(normals.data(), legacy.mNormals.data(), n*n*sizeof(XMFLOAT3)) == 0 &&
+			memcmp(tangents.data(), legacy.mTangentX.data(), n*n*sizeof(XMFLOAT3)) == 0;
+
+		Utility::Printf(L"Waves %dx%d  %d steps  legacy: %.3f ms  height field: %.3f ms (solve %.3f + vertices %.3f)  x%.1f  %s\n",
+			n, n, steps, legacyMs, solveMs + vertexMs, solveMs, vertexMs, legacyMs / (solveMs + vertexMs),
+			same ? L"identical" : L"MISMATCH");
+	}
+}
+
+void Waves::Replay()
+{
+	// A minute at 60 Hz with some jitter, a 100 ms hitch every 150 frames and a
+	// 500 ms one every 1000 frames so the catch-up and the cap are both exercised.
+	const int frameCount = 3600;
+	std::vector<float> frameTimes(frameCount);
+	uint32_t seed = 1;
+	auto next = [&seed]()
+	{
+		seed = seed*1664525u + 1013904223u;
+		return (seed >> 8) * (1.0f / 16777216.0f);
+	};
+	for(int f = 0; f < frameCount; ++f)
+	{
+		frameTimes[f] = (1.0f / 60.0f) * (0.8f + 0.4f*next());
+		if(f % 150 == 149)
+			frameTimes[f] = 0.1f;
+		if(f % 1000 == 999)
+			frameTimes[f] = 0.5f;
+	}
+
+	const int sizes[] = { 128, 512 };
+	for(int n : sizes)
+	{
+		std::vector<XMFLOAT3> positions[2];
+		std::vector<XMFLOAT3> normals[2];
+		std::vector<float> heights[2];
+
+		int totalSteps = 0;
+		int cappedFrames = 0;
+		double updateMs = 0.0;
+		double vertexMs = 0.0;
+
+		for(int run = 0; run < 2; ++run)
+		{
+			Waves waves(n, n, 1.0f, 0.03f, 4.0f, 0.2f);
+			waves.SetInterpolation(true);
+			positions[run].resize(n*n);
+			normals[run].resize(n*n);
+
+			// Disturb every quarter second of frame time like the demo does.
+			uint32_t disturbSeed = 7;
+			float disturbTime = 0.0f;
+			totalSteps = 0;
+			cappedFrames = 0;
+			updateMs = 0.0;
+			vertexMs = 0.0;
+
+			for(int f = 0; f < frameCount; ++f)
+			{
+				disturbTime += frameTimes[f];
+				while(disturbTime >= 0.25f)
+				{
+					disturbTime -= 0.25f;
+					disturbSeed = disturbSeed*1664525u + 1013904223u;
+					int i = 4 + (disturbSeed >> 8) % (n - 8);
+					int j = 4 + (disturbSeed >> 20) % (n - 8);
+					waves.Disturb(i, j, 0.2f + 0.3f*((disturbSeed & 0xff) / 255.0f));
+				}
+
+				// Time is dropped when more than the capped number of steps is due.
+				float due = waves.mAccumulator + frameTimes[f];
+				cappedFrames += due >= (waves.mMaxSubSteps + 1)*waves.mTimeStep;
+
+				int64_t start = SystemTime::GetCurrentTick();
+				int steps = waves.Update(frameTimes[f]);
+				int64_t updated = SystemTime::GetCurrentTick();
+				waves.GetVertices(positions[run].data(), normals[run].data(), nullptr, sizeof(XMFLOAT3));
+				updateMs += SystemTime::TicksToMillisecs(updated - start);
+				vertexMs += SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - updated);
+
+				totalSteps += steps;
+			}
+
+			heights[run] = waves.mCurrHeight;
+		}
+
+		bool same =
+			heights[0] == heights[1] &&
+			memcmp(positions[0].data(), positions[1].data(), n*n*sizeof(XMFLOAT3)) == 0 &&
+			memcmp(normals[0].data(), normals[1].data(), n*n*sizeof(XMFLOAT3)) == 0;
+
+		Utility::Printf(L"Waves replay %dx%d  %d frames  %d steps (%d frames capped)  step: %.3f ms  vertices: %.3f ms/frame  %s\n",
+			n, n, frameCount, totalSteps, cappedFrames, updateMs / (std::max)(totalSteps, 1), vertexMs / frameCount,
+			same ? L"deterministic" : L"MISMATCH");
+	}
 }
-	
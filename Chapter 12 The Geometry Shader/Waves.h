@@ -4,6 +4,15 @@
 // Performs the calculations for the wave simulation.  After the simulation has been
 // updated, the client must copy the current solution into vertex buffers for rendering.
 // This class only does the calculations, it does not do any drawing.
+//
+// The solver only keeps the heights of the grid in two contiguous float arrays and
+// updates them row by row with SIMD stencil kernels.  Positions, normals and tangents
+// are not stored; they are generated from the height field by GetVertices() when the
+// renderer asks for them.
+//
+// Update() feeds the frame time into a per instance accumulator and advances the
+// simulation in whole time steps, so the result only depends on the sequence of
+// frame times and not on how they line up with the step size.
 //***************************************************************************************
 
 #ifndef WAVES_H
@@ -27,18 +36,53 @@ public:
 	float Width()const;
 	float Depth()const;
 
-	// Returns the solution at the ith grid point.
-    const DirectX::XMFLOAT3& Position(int i)const { return mCurrSolution[i]; }
+	// Returns the height of the solution at the ith grid point.
+    float Height(int i)const { return mCurrHeight[i]; }
 
-	// Returns the solution normal at the ith grid point.
-    const DirectX::XMFLOAT3& Normal(int i)const { return mNormals[i]; }
+	// Writes the solution into caller owned arrays.  Each pointer addresses the first
+	// element and consecutive elements are 'stride' bytes apart, so the arrays may be
+	// members of an interleaved vertex.  Pass nullptr for anything that is not needed.
+	// Boundary points keep the flat normal (0, 1, 0) and tangent (1, 0, 0).
+	// With interpolation enabled the heights are blended between the last two solutions.
+	void GetVertices(DirectX::XMFLOAT3* positions, DirectX::XMFLOAT3* normals,
+		DirectX::XMFLOAT3* tangentX, size_t stride)const;
 
-	// Returns the unit tangent vector at the ith grid point in the local x-axis direction.
-    const DirectX::XMFLOAT3& TangentX(int i)const { return mTangentX[i]; }
-
-	void Update(float dt);
+	// Adds dt to the accumulator and runs as many time steps as it covers, but no
+	// more than the sub-step limit; time beyond the limit is dropped.  Returns the
+	// number of steps taken.
+	int Update(float dt);
 	void Disturb(int i, int j, float magnitude);
 
+	// Caps the steps a single Update() may run when a frame was slow (default 4).
+	void SetMaxSubSteps(int count);
+
+	// Renders the state between the last two solutions that matches the leftover
+	// accumulated time instead of the newest solution.  Adds one step of latency.
+	void SetInterpolation(bool enable);
+
+	// Fraction of a time step left in the accumulator, in [0, 1).
+	float InterpolationAlpha()const;
+
+	// Times the solver against the original XMFLOAT3 implementation on 128^2, 512^2 and
+	// 2048^2 grids, checks that both produce identical results and prints the timings.
+	static void Benchmark();
+
+	// Replays a fixed, generated sequence of frame times (including hitches) and
+	// disturbances through Update() and GetVertices() without any rendering, prints
+	// the cost per step and checks that two runs produce identical results.
+	static void Replay();
+
+private:
+	// Advances the solution by one time step.
+	void Step();
+
+	// Updates the interior points of row i into mPrevHeight.
+	void StepRow(int i);
+
+	// Generates the vertices of row i of the given height field.
+	void GetRowVertices(const float* heights, int i, DirectX::XMFLOAT3* positions,
+		DirectX::XMFLOAT3* normals, DirectX::XMFLOAT3* tangentX, size_t stride)const;
+
 private:
     int mNumRows = 0;
     int mNumCols = 0;
@@ -54,10 +98,17 @@ private:
     float mTimeStep = 0.0f;
     float mSpatialStep = 0.0f;
 
-    std::vector<DirectX::XMFLOAT3> mPrevSolution;
-    std::vector<DirectX::XMFLOAT3> mCurrSolution;
-    std::vector<DirectX::XMFLOAT3> mNormals;
-    std::vector<DirectX::XMFLOAT3> mTangentX;
+    // Frame time not yet consumed by a whole time step.
+    float mAccumulator = 0.0f;
+    int mMaxSubSteps = 4;
+    bool mInterpolate = false;
+
+    // Row major heights h(x_j, z_i), mNumCols floats per row.
+    std::vector<float> mPrevHeight;
+    std::vector<float> mCurrHeight;
+
+    // Blended heights handed to GetRowVertices() when interpolating.
+    mutable std::vector<float> mRenderHeight;
 };
 
-#endif // WAVES_H
\ No newline at end of file
+#endif // WAVES_H
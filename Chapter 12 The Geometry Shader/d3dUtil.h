@@ -4,6 +4,15 @@
 #include <unordered_map>
 #include "VectorMath.h"
 
+// ʱԱ¾ˮģĺʱԴ
+static bool g_wavesBenchmark = false;
+
+// ڣ߻طһι̶֡ʱˮģĺʱȷԣȻֱ˳
+static bool g_wavesReplay = false;
+
+// ʱϵͳѹԺ͵ȿԣԴ
+static bool g_jobSystemTest = false;
+
 // HLSLһ
 struct Light
 {
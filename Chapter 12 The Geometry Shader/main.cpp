@@ -1,4 +1,6 @@
 #include "GameApp.h"
+#include "SystemTime.h"
+#include "JobSystem.h"
 
 int WINAPI WinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 	_In_ LPSTR lpCmdLine, _In_ int nShowCmd )
@@ -8,6 +10,16 @@ int WINAPI WinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	// Replay the wave simulation offline, without creating a window.
+	if (g_wavesReplay)
+	{
+		SystemTime::Initialize();
+		JobSystem::Initialize();
+		Waves::Replay();
+		JobSystem::Shutdown();
+		return 0;
+	}
+
 	GameApp* app = new GameApp();
 	GameCore::RunApplication(*app, hInstance, L"CrossGate");
 	delete app;
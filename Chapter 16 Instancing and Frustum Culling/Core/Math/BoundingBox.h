@@ -0,0 +1,96 @@
+#pragma once
+
+#include "VectorMath.h"
+#include <vector>
+
+namespace Math
+{
+    // ΧУĵͰ볤ʾ
+    class AxisAlignedBox
+    {
+    public:
+        AxisAlignedBox() {}
+        AxisAlignedBox( Vector3 center, Vector3 extent ) : m_center(center), m_extent(extent) {}
+
+        static AxisAlignedBox FromMinMax( Vector3 minBound, Vector3 maxBound )
+        {
+            return AxisAlignedBox((minBound + maxBound) * 0.5f, Abs(maxBound - minBound) * 0.5f);
+        }
+
+        Vector3 GetCenter( void ) const { return m_center; }
+        Vector3 GetExtent( void ) const { return m_extent; }
+        Vector3 GetMin( void ) const { return m_center - m_extent; }
+        Vector3 GetMax( void ) const { return m_center + m_extent; }
+
+    private:
+        Vector3 m_center;
+        Vector3 m_extent;
+    };
+
+    // Χо任Χ(Arvoķ)
+    // ĵֱӱ任볤Ϊ |3x3| * 볤һSIMD
+    // ֻ任СתʱõİΧвܰס
+    inline AxisAlignedBox TransformBoundingBox( const Matrix4& xform, const AxisAlignedBox& box )
+    {
+        Vector3 center = Vector3(xform * box.GetCenter());
+        Vector3 extent = box.GetExtent();
+        Vector3 worldExtent =
+            Abs(Vector3(xform.GetX())) * extent.GetX() +
+            Abs(Vector3(xform.GetY())) * extent.GetY() +
+            Abs(Vector3(xform.GetZ())) * extent.GetZ();
+        return AxisAlignedBox(center, worldExtent);
+    }
+
+    inline AxisAlignedBox TransformBoundingBox( const AffineTransform& xform, const AxisAlignedBox& box )
+    {
+        return TransformBoundingBox(Matrix4(xform), box);
+    }
+
+    // һΧУṹ(SoA)洢ĵͰ볤SIMDһδΧ
+    // 鳤Ȳ뵽8ı벿ֲᱻΪɼ
+    class BoundingBoxSoA
+    {
+    public:
+        static const size_t kAlignment = 8;
+
+        void Resize( size_t count )
+        {
+            m_Count = count;
+            size_t padded = (count + kAlignment - 1) & ~(kAlignment - 1);
+            for (int i = 0; i < 3; ++i)
+            {
+                m_Center[i].assign(padded, 0.0f);
+                m_Extent[i].assign(padded, 0.0f);
+            }
+        }
+
+        void Set( size_t index, Vector3 center, Vector3 extent )
+        {
+            m_Center[0][index] = center.GetX();
+            m_Center[1][index] = center.GetY();
+            m_Center[2][index] = center.GetZ();
+            m_Extent[0][index] = extent.GetX();
+            m_Extent[1][index] = extent.GetY();
+            m_Extent[2][index] = extent.GetZ();
+        }
+
+        void Set( size_t index, const AxisAlignedBox& box )
+        {
+            Set(index, box.GetCenter(), box.GetExtent());
+        }
+
+        size_t Size( void ) const { return m_Count; }
+        const float* CenterX( void ) const { return m_Center[0].data(); }
+        const float* CenterY( void ) const { return m_Center[1].data(); }
+        const float* CenterZ( void ) const { return m_Center[2].data(); }
+        const float* ExtentX( void ) const { return m_Extent[0].data(); }
+        const float* ExtentY( void ) const { return m_Extent[1].data(); }
+        const float* ExtentZ( void ) const { return m_Extent[2].data(); }
+
+    private:
+        size_t m_Count = 0;
+        std::vector<float> m_Center[3];
+        std::vector<float> m_Extent[3];
+    };
+
+} // namespace Math
@@ -110,3 +110,122 @@ Frustum::Frustum(const Matrix4& ProjMat, float NearDivFar)
         ConstructPerspectiveFrustum( RcpXX, RcpYY, NearClip, FarClip );
     }
 }
+
+namespace
+{
+    // SIMDȽϵõĿɼչΪΧţ˳д
+    inline uint32_t AppendVisible( uint32_t mask, size_t base, size_t remaining, uint32_t* out, size_t stride, uint32_t count )
+    {
+        // һгԷΧĲֲɼ
+        if (remaining < 32)
+            mask &= (1u << remaining) - 1;
+
+        unsigned long bit;
+        while (_BitScanForward(&bit, mask))
+        {
+            out[count++ * stride] = (uint32_t)(base + bit);
+            mask &= mask - 1;
+        }
+        return count;
+    }
+}
+
+uint32_t Frustum::IntersectBoundingBoxes( const BoundingBoxSoA& boxes, size_t first, size_t last, uint32_t* visibleIndices, size_t outStride ) const
+{
+    // Χĳĵ㵽ľ + Χڷ߷ϵͶӰ뾶 < 0
+    //  IntersectBoundingBox ѡȡԶȼ
+    float nx[6], ny[6], nz[6], nd[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        Vector4 plane = m_FrustumPlanes[i];
+        nx[i] = plane.GetX();
+        ny[i] = plane.GetY();
+        nz[i] = plane.GetZ();
+        nd[i] = plane.GetW();
+    }
+
+    ASSERT(first % BoundingBoxSoA::kAlignment == 0 && last <= boxes.Size());
+
+    const float* cx = boxes.CenterX();
+    const float* cy = boxes.CenterY();
+    const float* cz = boxes.CenterZ();
+    const float* ex = boxes.ExtentX();
+    const float* ey = boxes.ExtentY();
+    const float* ez = boxes.ExtentZ();
+
+    uint32_t visibleCount = 0;
+
+#ifdef __AVX__
+    __m256 planeX[6], planeY[6], planeZ[6], planeD[6], absX[6], absY[6], absZ[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        planeX[i] = _mm256_set1_ps(nx[i]);
+        planeY[i] = _mm256_set1_ps(ny[i]);
+        planeZ[i] = _mm256_set1_ps(nz[i]);
+        planeD[i] = _mm256_set1_ps(nd[i]);
+        absX[i] = _mm256_set1_ps(fabsf(nx[i]));
+        absY[i] = _mm256_set1_ps(fabsf(ny[i]));
+        absZ[i] = _mm256_set1_ps(fabsf(nz[i]));
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t base = first; base < last; base += 8)
+    {
+        __m256 centerX = _mm256_loadu_ps(cx + base);
+        __m256 centerY = _mm256_loadu_ps(cy + base);
+        __m256 centerZ = _mm256_loadu_ps(cz + base);
+        __m256 extentX = _mm256_loadu_ps(ex + base);
+        __m256 extentY = _mm256_loadu_ps(ey + base);
+        __m256 extentZ = _mm256_loadu_ps(ez + base);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int i = 0; i < 6; ++i)
+        {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[i], centerX), _mm256_mul_ps(planeY[i], centerY)),
+                _mm256_add_ps(_mm256_mul_ps(planeZ[i], centerZ), planeD[i]));
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[i], extentX), _mm256_mul_ps(absY[i], extentY)),
+                _mm256_mul_ps(absZ[i], extentZ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+        }
+
+        visibleCount = AppendVisible((uint32_t)_mm256_movemask_ps(inside), base, last - base, visibleIndices, outStride, visibleCount);
+    }
+#else
+    __m128 planeX[6], planeY[6], planeZ[6], planeD[6], absX[6], absY[6], absZ[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        planeX[i] = _mm_set1_ps(nx[i]);
+        planeY[i] = _mm_set1_ps(ny[i]);
+        planeZ[i] = _mm_set1_ps(nz[i]);
+        planeD[i] = _mm_set1_ps(nd[i]);
+        absX[i] = _mm_set1_ps(fabsf(nx[i]));
+        absY[i] = _mm_set1_ps(fabsf(ny[i]));
+        absZ[i] = _mm_set1_ps(fabsf(nz[i]));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t base = first; base < last; base += 4)
+    {
+        __m128 centerX = _mm_loadu_ps(cx + base);
+        __m128 centerY = _mm_loadu_ps(cy + base);
+        __m128 centerZ = _mm_loadu_ps(cz + base);
+        __m128 extentX = _mm_loadu_ps(ex + base);
+        __m128 extentY = _mm_loadu_ps(ey + base);
+        __m128 extentZ = _mm_loadu_ps(ez + base);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < 6; ++i)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[i], centerX), _mm_mul_ps(planeY[i], centerY)),
+                _mm_add_ps(_mm_mul_ps(planeZ[i], centerZ), planeD[i]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[i], extentX), _mm_mul_ps(absY[i], extentY)),
+                _mm_mul_ps(absZ[i], extentZ));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+
+        visibleCount = AppendVisible((uint32_t)_mm_movemask_ps(inside), base, last - base, visibleIndices, outStride, visibleCount);
+    }
+#endif
+
+    return visibleCount;
+}
@@ -15,6 +15,7 @@
 
 #include "BoundingPlane.h"
 #include "BoundingSphere.h"
+#include "BoundingBox.h"
 
 namespace Math
 {
@@ -47,6 +48,18 @@ namespace Math
         // simple struct in the Model project.)
         bool IntersectBoundingBox(const Vector3 minBound, const Vector3 maxBound) const;
 
+        // һΧУSSEÿδ4AVXʱÿδ8
+        // ɼΧеŰ˳յд visibleIndices֮ outStride uint32
+        // ؿɼΧе
+        uint32_t IntersectBoundingBoxes(const BoundingBoxSoA& boxes, uint32_t* visibleIndices, size_t outStride = 1) const
+        {
+            return IntersectBoundingBoxes(boxes, 0, boxes.Size(), visibleIndices, outStride);
+        }
+
+        // ֻ [first, last) ֮İΧУȻǰΧе
+        // first Ҫ8ı
+        uint32_t IntersectBoundingBoxes(const BoundingBoxSoA& boxes, size_t first, size_t last, uint32_t* visibleIndices, size_t outStride = 1) const;
+
         friend Frustum  operator* ( const OrthogonalTransform& xform, const Frustum& frustum );    // Fast
         friend Frustum  operator* ( const AffineTransform& xform, const Frustum& frustum );        // Slow
         friend Frustum  operator* ( const Matrix4& xform, const Frustum& frustum );                // Slowest (and most general)
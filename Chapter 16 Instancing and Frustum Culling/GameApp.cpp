@@ -5,9 +5,12 @@
 #include "CommandContext.h"
 #include "TextureManager.h"
 #include "GameInput.h"
+#include "SystemTime.h"
+#include "Math/Random.h"
 
 #include <fstream>
 #include <sstream>
+#include <ppl.h>
 #include "GeometryGenerator.h"
 #include "CompiledShaders/dynamicIndexDefaultPS.h"
 #include "CompiledShaders/dynamicIndexDefaultVS.h"
@@ -21,6 +24,13 @@ void GameApp::Startup(void)
 
     m_Camera.SetEyeAtUp({ 0.0f, 0.0f, -15.0f }, { 0.0f, 0.0f, 0.0f }, Math::Vector3(Math::kYUnitVector));
     m_CameraController.reset(new GameCore::CameraController(m_Camera, Math::Vector3(Math::kYUnitVector)));
+
+    if (g_cullBenchmark)
+    {
+        cullBenchmark();
+        cullBoundsReport();
+        cullScalingBenchmark();
+    }
 }
 
 void GameApp::Cleanup(void)
@@ -204,7 +214,7 @@ void GameApp::buildGeo()
     fin >> ignore >> ignore >> ignore >> ignore;
 
     Math::Vector3 vMin = { FLT_MAX, FLT_MAX, FLT_MAX };
-    Math::Vector3 vMax = { FLT_MIN, FLT_MIN, FLT_MIN };
+    Math::Vector3 vMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
     std::vector<Vertex> vertices(vcount);
     for (UINT i = 0; i < vcount; ++i)
@@ -311,6 +321,7 @@ void GameApp::buildRenderItem()
     skullRitem->BaseVertexLocation = skullRitem->geo->geoMap["skull"].BaseVertexLocation;
     skullRitem->vMin = skullRitem->geo->geoMap["skull"].vMin;
     skullRitem->vMax = skullRitem->geo->geoMap["skull"].vMax;
+    skullRitem->localBounds = Math::AxisAlignedBox::FromMinMax(skullRitem->vMin, skullRitem->vMax);
 
     // ΪĿnInstanceCountݣԷֲڲͬλ
     skullRitem->vObjsData.resize(nInstanceCount);
@@ -345,6 +356,7 @@ void GameApp::buildRenderItem()
     }
 
     skullRitem->matrixs.Create(L"skull matrixs", nInstanceCount, sizeof(ObjectConstants), skullRitem->vObjsData.data());
+    updateInstanceBounds(skullRitem.get());
     m_vecRenderItems[(int)RenderLayer::Opaque].push_back(skullRitem.get());
     m_vecAll.push_back(std::move(skullRitem));
 }
@@ -403,23 +415,211 @@ void GameApp::updateInstanceData()
 {
     for (auto& e : m_vecAll)
     {
-        e->visibileCount = 0;
-        for (int i = 0; i < (int)e->vObjsData.size(); ++i)
+        if (g_openFrustumCull)
         {
-            if (g_openFrustumCull)
-            {
-                auto& item = e->vObjsData[i];
-                auto vMin = Math::Vector3(Math::Transpose(item.World) * e->vMin);
-                auto vMax = Math::Vector3(Math::Transpose(item.World) * e->vMax);
-                if (m_Camera.GetWorldSpaceFrustum().IntersectBoundingBox(vMin, vMax))
-                {
-                    e->vDrawObjs[e->visibileCount++].x = i;
-                }
-            }
-            else
-            {
+            // ޳ɼʵֱд vDrawObjs[i].x
+            e->visibileCount = parallelCull(m_Camera.GetWorldSpaceFrustum(),
+                e->bounds, &e->vDrawObjs[0].x, sizeof(e->vDrawObjs[0]) / sizeof(UINT));
+        }
+        else
+        {
+            e->visibileCount = 0;
+            for (int i = 0; i < (int)e->vObjsData.size(); ++i)
                 e->vDrawObjs[e->visibileCount++].x = i;
-            }
         }
     }
-}
\ No newline at end of file
+}
+
+uint32_t GameApp::parallelCull(const Math::Frustum& frustum, const Math::BoundingBoxSoA& bounds, UINT* visible, size_t stride)
+{
+    // ÿι̶İΧУʵʱֻһΣֱڵǰ߳޳
+    const size_t chunkSize = 4096;
+    const size_t count = bounds.Size();
+    if (count <= chunkSize)
+        return frustum.IntersectBoundingBoxes(bounds, visible, stride);
+
+    // ÿдԼĿɼб
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (m_cullChunks.size() < chunkCount)
+        m_cullChunks.resize(chunkCount);
+
+    concurrency::parallel_for(size_t(0), chunkCount, [&](size_t i)
+    {
+        size_t first = i * chunkSize;
+        size_t last = (std::min)(first + chunkSize, count);
+        auto& list = m_cullChunks[i];
+        list.resize(last - first);
+        list.resize(frustum.IntersectBoundingBoxes(bounds, first, last, list.data()));
+    });
+
+    // ٰε˳ϲ봮޳ȫһ
+    uint32_t visibleCount = 0;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        for (UINT index : m_cullChunks[i])
+            visible[visibleCount++ * stride] = index;
+    }
+    return visibleCount;
+}
+
+void GameApp::updateInstanceBounds(RenderItem* item)
+{
+    // ʵ󲻱䣬Χֻıʱ¼
+    item->bounds.Resize(item->vObjsData.size());
+    for (int i = 0; i < (int)item->vObjsData.size(); ++i)
+    {
+        auto& obj = item->vObjsData[i];
+        item->bounds.Set(i, Math::TransformBoundingBox(Math::Transpose(obj.World), item->localBounds));
+    }
+}
+
+void GameApp::cullBenchmark()
+{
+    // 10ΧУԱ޳޳ĺʱ
+    const int count = 100000;
+    const int loop = 20;
+
+    Math::RandomNumberGenerator rng;
+    rng.SetSeed(1);
+
+    std::vector<Math::Vector3> vMin(count);
+    std::vector<Math::Vector3> vMax(count);
+    Math::BoundingBoxSoA bounds;
+    bounds.Resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Math::Vector3 center(rng.NextFloat(-200.0f, 200.0f), rng.NextFloat(-200.0f, 200.0f), rng.NextFloat(-200.0f, 200.0f));
+        Math::Vector3 extent(rng.NextFloat(0.5f, 5.0f), rng.NextFloat(0.5f, 5.0f), rng.NextFloat(0.5f, 5.0f));
+        vMin[i] = center - extent;
+        vMax[i] = center + extent;
+        bounds.Set(i, center, extent);
+    }
+
+    m_Camera.Update();
+    const Math::Frustum& frustum = m_Camera.GetWorldSpaceFrustum();
+    std::vector<UINT> visible(count);
+
+    int scalarCount = 0;
+    int64_t start = SystemTime::GetCurrentTick();
+    for (int n = 0; n < loop; ++n)
+    {
+        scalarCount = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (frustum.IntersectBoundingBox(vMin[i], vMax[i]))
+                visible[scalarCount++] = i;
+        }
+    }
+    double scalarNs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start) * 1e6 / ((double)loop * count);
+
+    uint32_t batchCount = 0;
+    start = SystemTime::GetCurrentTick();
+    for (int n = 0; n < loop; ++n)
+        batchCount = frustum.IntersectBoundingBoxes(bounds, visible.data());
+    double batchNs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start) * 1e6 / ((double)loop * count);
+
+    Utility::Printf("cull %d boxes  visible: %d / %u  scalar: %.2f ns/box  batch: %.2f ns/box\n",
+        count, scalarCount, batchCount, scalarNs, batchNs);
+}
+
+void GameApp::cullScalingBenchmark()
+{
+    // 100ΧУֱ1/2/4/8̣߳ͳƲ޳
+    const int count = 1000000;
+    const int loop = 10;
+
+    Math::RandomNumberGenerator rng;
+    rng.SetSeed(1);
+
+    Math::BoundingBoxSoA bounds;
+    bounds.Resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Math::Vector3 center(rng.NextFloat(-400.0f, 400.0f), rng.NextFloat(-400.0f, 400.0f), rng.NextFloat(-400.0f, 400.0f));
+        Math::Vector3 extent(rng.NextFloat(0.5f, 5.0f), rng.NextFloat(0.5f, 5.0f), rng.NextFloat(0.5f, 5.0f));
+        bounds.Set(i, center, extent);
+    }
+
+    m_Camera.Update();
+    const Math::Frustum& frustum = m_Camera.GetWorldSpaceFrustum();
+    std::vector<UINT> serial(count);
+    std::vector<UINT> visible(count);
+    uint32_t serialCount = frustum.IntersectBoundingBoxes(bounds, serial.data());
+
+    for (unsigned int threads : { 1u, 2u, 4u, 8u })
+    {
+        // õĵƲ߳
+        concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(2,
+            concurrency::MinConcurrency, threads, concurrency::MaxConcurrency, threads));
+
+        uint32_t visibleCount = 0;
+        int64_t start = SystemTime::GetCurrentTick();
+        for (int n = 0; n < loop; ++n)
+            visibleCount = parallelCull(frustum, bounds, visible.data(), 1);
+        double sec = SystemTime::TimeBetweenTicks(start, SystemTime::GetCurrentTick());
+
+        concurrency::CurrentScheduler::Detach();
+
+        bool same = visibleCount == serialCount && std::equal(serial.begin(), serial.begin() + serialCount, visible.begin());
+        Utility::Printf("parallel cull  threads: %u  %.1f M boxes/s  visible: %u  %s\n",
+            threads, (double)count * loop / sec / 1e6, visibleCount, same ? "same as serial" : "MISMATCH");
+    }
+}
+
+void GameApp::cullBoundsReport()
+{
+    // ĻϸÿʵһתԱΧе޳
+    // OBB׶ľȷΪ׼ͳпɼ(໭)вɼ(©)
+    RenderItem* item = m_vecRenderItems[(int)RenderLayer::Opaque][0];
+    const Math::Frustum& frustum = m_Camera.GetWorldSpaceFrustum();
+
+    Math::RandomNumberGenerator rng;
+    rng.SetSeed(1);
+
+    Math::Vector3 localCenter = item->localBounds.GetCenter();
+    Math::Vector3 localExtent = item->localBounds.GetExtent();
+
+    int exactCount = 0;
+    int cornerVisible = 0, cornerFalsePositive = 0, cornerMissed = 0;
+    int arvoVisible = 0, arvoFalsePositive = 0, arvoMissed = 0;
+    for (auto& obj : item->vObjsData)
+    {
+        Math::Matrix3 rotate = Math::Matrix3(Math::Quaternion(
+            Math::Vector3(rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f)),
+            rng.NextFloat(0.0f, Math::XM_2PI)));
+        Math::Matrix4 world = Math::Matrix4(rotate, Math::Vector3(Math::Transpose(obj.World).GetW()));
+
+        // ȷOBBÿ淨߷ϵͶӰ뾶
+        bool exact = true;
+        Math::Vector3 center = Math::Vector3(world * localCenter);
+        for (int p = 0; p < 6; ++p)
+        {
+            Math::BoundingPlane plane = frustum.GetFrustumPlane((Math::Frustum::PlaneID)p);
+            Math::Vector3 n = plane.GetNormal();
+            float radius = Math::Abs(Math::Dot(n, rotate.GetX())) * localExtent.GetX() +
+                Math::Abs(Math::Dot(n, rotate.GetY())) * localExtent.GetY() +
+                Math::Abs(Math::Dot(n, rotate.GetZ())) * localExtent.GetZ();
+            if (plane.DistanceFromPoint(center) + radius < 0.0f)
+                exact = false;
+        }
+        exactCount += exact;
+
+        // ԭֻ任С
+        Math::Vector3 vMin = Math::Vector3(world * item->vMin);
+        Math::Vector3 vMax = Math::Vector3(world * item->vMax);
+        bool corner = frustum.IntersectBoundingBox(Math::Min(vMin, vMax), Math::Max(vMin, vMax));
+        cornerVisible += corner;
+        cornerFalsePositive += corner && !exact;
+        cornerMissed += !corner && exact;
+
+        Math::AxisAlignedBox box = Math::TransformBoundingBox(world, item->localBounds);
+        bool arvo = frustum.IntersectBoundingBox(box.GetMin(), box.GetMax());
+        arvoVisible += arvo;
+        arvoFalsePositive += arvo && !exact;
+        arvoMissed += !arvo && exact;
+    }
+
+    Utility::Printf("cull bounds  instances: %d  exact visible: %d\n", (int)item->vObjsData.size(), exactCount);
+    Utility::Printf("  min/max corners: visible %d  false positive %d  missed %d\n", cornerVisible, cornerFalsePositive, cornerMissed);
+    Utility::Printf("  arvo:            visible %d  false positive %d  missed %d\n", arvoVisible, arvoFalsePositive, arvoMissed);
+}
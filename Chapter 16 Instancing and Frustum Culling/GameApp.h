@@ -27,6 +27,11 @@ public:
 private:
     void cameraUpdate();   // camera
     void updateInstanceData();
+    void updateInstanceBounds(RenderItem* item);
+    uint32_t parallelCull(const Math::Frustum& frustum, const Math::BoundingBoxSoA& bounds, UINT* visible, size_t stride);
+    void cullBenchmark();
+    void cullBoundsReport();
+    void cullScalingBenchmark();
 
 private:
     void buildPSO();
@@ -48,6 +53,9 @@ private:
     std::vector<RenderItem*> m_vecRenderItems[(int)RenderLayer::Count];
     std::vector<std::unique_ptr<RenderItem>> m_vecAll;
 
+    // ޳ʱÿһθԵĿɼбε˳ϲ
+    std::vector<std::vector<UINT>> m_cullChunks;
+
     StructuredBuffer m_mats;    // t1 洢е
     std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_srvs;  // 洢еԴ
 
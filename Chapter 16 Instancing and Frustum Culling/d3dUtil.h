@@ -3,11 +3,14 @@
 #include <string>
 #include <unordered_map>
 #include "VectorMath.h"
+#include "Math/BoundingBox.h"
 
 // Ũ
 static float flFrogAlpha = 0.0f;
 // Ƿ׶޳
 static bool g_openFrustumCull = true;
+// Ƿʱ׶޳ĺʱԱ
+static bool g_cullBenchmark = false;
 
 // HLSLһ
 struct Light
@@ -161,4 +164,7 @@ struct RenderItem
 
     Math::Vector3 vMin;
     Math::Vector3 vMax;
+
+    Math::AxisAlignedBox localBounds;   // ģµİΧ
+    Math::BoundingBoxSoA bounds;        // ÿʵµİΧУ޳
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "CommandContext.h"
 #include "TextureManager.h"
 #include "GameInput.h"
+#include "SystemTime.h"
+#include "Math/Random.h"
 
 #include <fstream>
 #include <sstream>
@@ -22,6 +24,13 @@ void GameApp::Startup(void)
     buildGeo();
     buildMaterials();
     buildRenderItem();
+    buildPickScene();
+
+    if (g_pickBenchmark)
+    {
+        validatePickKernel();
+        pickBenchmark();
+    }
 
     m_Camera.SetEyeAtUp({ 0.0f, 0.0f, -15.0f }, { 0.0f, 0.0f, 0.0f }, Math::Vector3(Math::kYUnitVector));
     m_CameraController.reset(new GameCore::CameraController(m_Camera, Math::Vector3(Math::kYUnitVector)));
@@ -237,7 +246,7 @@ void GameApp::buildGeo()
     fin >> ignore >> ignore >> ignore >> ignore;
 
     Math::Vector3 vMin = { FLT_MAX, FLT_MAX, FLT_MAX };
-    Math::Vector3 vMax = { FLT_MIN, FLT_MIN, FLT_MIN };
+    Math::Vector3 vMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
     std::vector<Vertex> vertices(vcount);
     for (UINT i = 0; i < vcount; ++i)
@@ -478,75 +487,190 @@ void GameApp::checkPick()
     Math::Vector4 rayOriginBase = { 0.0f, 0.0f, 0.0f, 1.0f };
     Math::Vector4 rayDirBase = { vx, vy, 1.0f, 0.0f };
 
-    // תview
+    // תռ䣬ʵѾԤȴ m_PickScene 
     auto inView = Math::Invert(m_Camera.GetViewMatrix());
+    auto rayOrigin = Math::Vector3(XMVector3TransformCoord(rayOriginBase, inView));
+    auto rayDir = Math::Normalize(Math::Vector3(XMVector3TransformNormal(rayDirBase, inView)));
+
+    // ֻʰȡԶüڵ
+    RayHit hit;
+    hit.t = m_Camera.GetFarClip() * Math::Length(Math::Vector3(rayDirBase));
 
-    // е
-    float tmin = FLT_MAX;
     for (auto& e : m_vecAll)
-    {
         e->selectedCount = 0;
 
+    // ʵ
+    if (m_PickScene.Intersect(rayOrigin, rayDir, hit))
+    {
+        auto& target = m_PickTargets[hit.instance];
+        target.first->selectedCount = 1;
+        target.first->vDrawOutLineObjs[0].x = target.second;
+    }
+}
+
+void GameApp::buildPickScene()
+{
+    m_PickScene.Clear();
+    m_PickTargets.clear();
+
+    for (auto& e : m_vecAll)
+    {
+        for (int i = 0; i < (int)e->vObjsData.size(); ++i)
+        {
+            // World д洢תúľ
+            m_PickScene.AddInstance(&e->geo->bvh, Math::Transpose(e->vObjsData[i].World));
+            m_PickTargets.emplace_back(e.get(), i);
+        }
+    }
+
+    m_PickScene.Build();
+}
+
+// ʰȡΪBVHĶգʵ󣬲AABBкȫΣȡ
+bool GameApp::bruteForcePick(Math::Vector3 origin, Math::Vector3 dir, RayHit& hit)
+{
+    bool found = false;
+    for (uint32_t n = 0; n < (uint32_t)m_PickTargets.size(); ++n)
+    {
+        RenderItem* e = m_PickTargets[n].first;
+        auto& item = e->vObjsData[m_PickTargets[n].second];
+
         // ȾĿAABB
         BoundingBox bounds;
         XMStoreFloat3(&bounds.Center, 0.5f * (e->vMin + e->vMax));
         XMStoreFloat3(&bounds.Extents, 0.5f * (e->vMax - e->vMin));
 
-        // ֻ龭׶úȾĿ꼴
-        for (int idx = 0; idx < e->visibileCount; ++idx)
+        // תȾĿģϵʵʱģͿռľռscale
+        //  SceneBVH Ļ㷽ʽһ£ߵĽλȽ
+        auto inObjWorld = Math::Invert(Math::Transpose(item.World));
+        auto rayOrigin = Math::Vector3(XMVector3TransformCoord(origin, inObjWorld));
+        auto rayDir = Math::Vector3(XMVector3TransformNormal(dir, inObjWorld));
+        float scale = Math::Length(rayDir);
+        rayDir = rayDir * (1.0f / scale);
+
+        float tBox = 0.0f;
+        if (!bounds.Intersects(rayOrigin, rayDir, tBox) || tBox / scale > hit.t)
+            continue;
+
+        auto& vertices = e->geo->vecVertex;
+        auto& indices = e->geo->vecIndex;
+        UINT triCount = e->IndexCount / 3;
+        for (UINT i = 0; i < triCount; ++i)
         {
-            auto& item = e->vObjsData[e->vDrawObjs[idx].x];
+            XMVECTOR v0 = XMLoadFloat3(&vertices[indices[i * 3 + 0]].Pos);
+            XMVECTOR v1 = XMLoadFloat3(&vertices[indices[i * 3 + 1]].Pos);
+            XMVECTOR v2 = XMLoadFloat3(&vertices[indices[i * 3 + 2]].Pos);
 
-            // ȡȾĿʵת
-            auto inObjWorld = Math::Invert(Math::Transpose(item.World));
+            float t = 0.0f;
+            if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t) && t / scale < hit.t)
+            {
+                hit.t = t / scale;
+                hit.triangle = i;
+                hit.instance = n;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
 
-            // עĳ˷ǷģԺ޸ģ
-            auto inViewWorld = inObjWorld * inView;
+void GameApp::pickBenchmark(int rayCount, int bruteForceRayCount)
+{
+    // Ӱסеϣڵ㷢
+    Math::RandomNumberGenerator rng;
+    rng.SetSeed(1);
+
+    std::vector<Math::Vector3> origins(rayCount);
+    std::vector<Math::Vector3> dirs(rayCount);
+    for (int i = 0; i < rayCount; ++i)
+    {
+        Math::Vector3 target(rng.NextFloat(-110.0f, 110.0f), rng.NextFloat(-110.0f, 110.0f), rng.NextFloat(-110.0f, 110.0f));
+        Math::Vector3 onSphere(rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f));
+        origins[i] = Math::Normalize(onSphere) * 400.0f;
+        dirs[i] = Math::Normalize(target - origins[i]);
+    }
 
-            // תȾĿģϵ(ԺװAPI)
-            auto rayOrigin = Math::Vector4(XMVector3TransformCoord(rayOriginBase, inViewWorld));
-            auto rayDir = Math::Vector4(XMVector3TransformNormal(rayDirBase, inViewWorld));
+    std::vector<RayHit> hits(rayCount);
+    int hitCount = 0;
+    int64_t start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < rayCount; ++i)
+        hitCount += m_PickScene.Intersect(origins[i], dirs[i], hits[i]);
+    double bvhMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start);
+
+    // ֻ̫ǰһߣͬʱУBVHĽ
+    // ǡôεĹʱ߿ѡвͬΣֻȽʵ;
+    // BVHҶʹõSIMD TriangleTests::Intersects λһ£ֱӱȽ
+    bruteForceRayCount = (std::min)(bruteForceRayCount, rayCount);
+    int mismatch = 0;
+    start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < bruteForceRayCount; ++i)
+    {
+        RayHit ref;
+        bruteForcePick(origins[i], dirs[i], ref);
+        if (ref.instance != hits[i].instance || ref.t != hits[i].t)
+            ++mismatch;
+    }
+    double bruteMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start);
+
+    const MeshBVH& bvh = m_vecAll[0]->geo->bvh;
+    double bvhRate = rayCount / bvhMs;
+    double bruteRate = bruteForceRayCount / bruteMs;
+    Utility::Printf(L"PickBenchmark: %d instances  %d triangles  %d BVH nodes  depth %d\n",
+        (int)m_PickScene.GetInstanceCount(), (int)bvh.GetTriangleCount(), (int)bvh.GetNodeCount(), (int)bvh.GetDepth());
+    Utility::Printf(L"PickBenchmark: BVH %d rays (%d hit)  %.2f ms  %.1f rays/ms\n", rayCount, hitCount, bvhMs, bvhRate);
+    Utility::Printf(L"PickBenchmark: brute force %d rays  %.2f ms  %.3f rays/ms  x%.0f  mismatch: %d\n",
+        bruteForceRayCount, bruteMs, bruteRate, bvhRate / bruteRate, mismatch);
+}
 
-            // Make the ray direction unit length for the intersection tests.
-            rayDir = Math::Vector4(XMVector3Normalize(rayDir));
+// ζԱSIMD(DirectXMath)ཻԣҪλһ
+bool GameApp::validatePickKernel(int rayCount)
+{
+    MeshGeometry* geo = m_mapGeometries["skullGeo"].get();
+    auto& vertices = geo->vecVertex;
+    auto& indices = geo->vecIndex;
+    UINT triCount = (UINT)indices.size() / 3;
 
-            // ȼǷཻAABB
-            float tTemp = 0.0f;
-            if (bounds.Intersects(rayOrigin, rayDir, tTemp))
-            {
-                // ѾཻȾĿ꣬жAABBе
-                if (tTemp > tmin) continue;
+    std::vector<RayTriangle::TrianglePack4> packs((triCount + 3) / 4);
+    for (UINT i = 0; i < triCount; ++i)
+    {
+        RayTriangle::SetTriangle(packs[i / 4], i % 4,
+            vertices[indices[i * 3 + 0]].Pos, vertices[indices[i * 3 + 1]].Pos, vertices[indices[i * 3 + 2]].Pos);
+    }
 
-                auto& vertices = e->geo->vecVertex;
-                auto& indices = e->geo->vecIndex;
-                UINT triCount = e->IndexCount / 3;
+    // Χڵ
+    auto& submesh = geo->geoMap["skull"];
+    Math::Vector3 center = 0.5f * (submesh.vMin + submesh.vMax);
+    Math::Vector3 extent = 0.5f * (submesh.vMax - submesh.vMin);
+    float radius = 2.0f * Math::Length(extent);
 
-                // ж
-                for (UINT i = 0; i < triCount; ++i)
-                {
-                    // Indices for this triangle.
-                    UINT i0 = indices[i * 3 + 0];
-                    UINT i1 = indices[i * 3 + 1];
-                    UINT i2 = indices[i * 3 + 2];
-
-                    // Vertices for this triangle.
-                    XMVECTOR v0 = XMLoadFloat3(&vertices[i0].Pos);
-                    XMVECTOR v1 = XMLoadFloat3(&vertices[i1].Pos);
-                    XMVECTOR v2 = XMLoadFloat3(&vertices[i2].Pos);
-
-                    float t = 0.0f;
-                    if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t))
-                    {
-                        // 漴Ϊ˸ȾĿ꣬¼ȣжһȾĿ
-                        tmin = tTemp;
-
-                        e->selectedCount = 1;
-                        e->vDrawOutLineObjs[0].x = e->vDrawObjs[idx].x;
-
-                        break;
-                    }
-                }
-            }
+    Math::RandomNumberGenerator rng;
+    rng.SetSeed(1);
+
+    int hitCount = 0;
+    int mismatch = 0;
+    for (int r = 0; r < rayCount; ++r)
+    {
+        Math::Vector3 target = center + extent * Math::Vector3(rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f));
+        Math::Vector3 origin = center + Math::Normalize(Math::Vector3(rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f), rng.NextFloat(-1.0f, 1.0f))) * radius;
+        Math::Vector3 dir = Math::Normalize(target - origin);
+
+        RayTriangle::RayPack4 ray = RayTriangle::MakeRay(origin, dir);
+        for (UINT i = 0; i < triCount; ++i)
+        {
+            float t[4];
+            int mask = RayTriangle::Intersect(ray, packs[i / 4], t);
+
+            float ref = 0.0f;
+            bool hit = TriangleTests::Intersects(origin, dir, XMLoadFloat3(&vertices[indices[i * 3 + 0]].Pos),
+                XMLoadFloat3(&vertices[indices[i * 3 + 1]].Pos), XMLoadFloat3(&vertices[indices[i * 3 + 2]].Pos), ref);
+
+            bool simdHit = ((mask >> (i % 4)) & 1) != 0;
+            if (hit != simdHit || (hit && memcmp(&ref, &t[i % 4], sizeof(float)) != 0))
+                ++mismatch;
+            hitCount += hit;
         }
     }
+
+    Utility::Printf(L"PickKernel: %d rays x %u triangles  hit: %d  mismatch: %d\n", rayCount, triCount, hitCount, mismatch);
+    return mismatch == 0;
 }
\ No newline at end of file
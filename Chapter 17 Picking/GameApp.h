@@ -28,12 +28,16 @@ private:
     void cameraUpdate();   // camera
     void updateInstanceData();
     void checkPick();
+    bool bruteForcePick(Math::Vector3 origin, Math::Vector3 dir, RayHit& hit);
+    void pickBenchmark(int rayCount = 100000, int bruteForceRayCount = 1000);
+    bool validatePickKernel(int rayCount = 256);
 
 private:
     void buildPSO();
     void buildGeo();
     void buildMaterials();
     void buildRenderItem();
+    void buildPickScene();
     void drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& ritems, bool bOutLine = false);
 
 private:
@@ -52,6 +56,10 @@ private:
     StructuredBuffer m_mats;    // t1 洢е
     std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_srvs;  // 洢еԴ
 
+    // ʰȡʹõʵBVHԼʵŶӦȾĿʵ
+    SceneBVH m_PickScene;
+    std::vector<std::pair<RenderItem*, int>> m_PickTargets;
+
 private:
     // ǩ
     RootSignature m_RootSignature;
@@ -0,0 +1,459 @@
+#include "MeshBVH.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+    typedef MeshBVH::Node Node;
+
+    const int kBinCount = 12;               // SAHÿϵķͰ
+    const uint32_t kMaxLeafTriangles = 8;   // Ҷӽڵθ(ʱǿƷָ)
+    const uint32_t kMaxLeafInstances = 2;
+    const uint32_t kPackSize = 4;           // һSIMDԵθ
+    const uint32_t kStackSize = 64;         // ջϱջĴСĲʱöϵջ
+
+    struct Bounds
+    {
+        XMFLOAT3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+        XMFLOAT3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void Grow(const XMFLOAT3& p)
+        {
+            min = { (std::min)(min.x, p.x), (std::min)(min.y, p.y), (std::min)(min.z, p.z) };
+            max = { (std::max)(max.x, p.x), (std::max)(max.y, p.y), (std::max)(max.z, p.z) };
+        }
+
+        // հΧе min/max Ƿģܵϲ
+        void Grow(const Bounds& b)
+        {
+            min = { (std::min)(min.x, b.min.x), (std::min)(min.y, b.min.y), (std::min)(min.z, b.min.z) };
+            max = { (std::max)(max.x, b.max.x), (std::max)(max.y, b.max.y), (std::max)(max.z, b.max.z) };
+        }
+
+        // һ룬ֻȽϴС
+        float Area() const
+        {
+            if (min.x > max.x)
+                return 0.0f;
+            float dx = max.x - min.x;
+            float dy = max.y - min.y;
+            float dz = max.z - min.z;
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    inline float Axis(const XMFLOAT3& v, int axis)
+    {
+        return (&v.x)[axis];
+    }
+
+    // ԶµķͰSAHͼԪֻṩΧ
+    // primsPerTest ͼԪһʱ(SIMD)ҶӵĴ۰ԴͼԪ
+    class Builder
+    {
+    public:
+        Builder(const std::vector<Bounds>& prims, uint32_t maxLeafSize, uint32_t primsPerTest, std::vector<Node>& nodes, std::vector<uint32_t>& order) :
+            m_Prims(prims), m_MaxLeafSize(maxLeafSize), m_PrimsPerTest(primsPerTest), m_Nodes(nodes), m_Order(order) {}
+
+        void Build()
+        {
+            uint32_t count = (uint32_t)m_Prims.size();
+
+            m_Order.resize(count);
+            std::iota(m_Order.begin(), m_Order.end(), 0);
+
+            m_Centroids.resize(count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                XMStoreFloat3(&m_Centroids[i], XMVectorScale(
+                    XMVectorAdd(XMLoadFloat3(&m_Prims[i].min), XMLoadFloat3(&m_Prims[i].max)), 0.5f));
+            }
+
+            m_Nodes.clear();
+            m_Depth = 0;
+            if (count == 0)
+                return;
+
+            m_Nodes.reserve(2 * count);
+            Subdivide(0, count, 1);
+        }
+
+        // ĲֻиڵʱΪ1
+        uint32_t GetDepth() const { return m_Depth; }
+
+    private:
+        struct Bin
+        {
+            Bounds bounds;
+            uint32_t count = 0;
+        };
+
+        inline float TestCost(uint32_t count) const
+        {
+            return (float)((count + m_PrimsPerTest - 1) / m_PrimsPerTest);
+        }
+
+        inline int BinIndex(uint32_t prim, int axis, float lo, float scale) const
+        {
+            int bin = (int)((Axis(m_Centroids[prim], axis) - lo) * scale);
+            return (std::min)(bin, kBinCount - 1);
+        }
+
+        void Subdivide(uint32_t first, uint32_t count, uint32_t depth)
+        {
+            uint32_t nodeIndex = (uint32_t)m_Nodes.size();
+            m_Nodes.emplace_back();
+            m_Depth = (std::max)(m_Depth, depth);
+
+            Bounds bounds;
+            Bounds centroidBounds;
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                bounds.Grow(m_Prims[m_Order[i]]);
+                centroidBounds.Grow(m_Centroids[m_Order[i]]);
+            }
+            m_Nodes[nodeIndex].boundsMin = bounds.min;
+            m_Nodes[nodeIndex].boundsMax = bounds.max;
+
+            // ҴСķͰ߽
+            int bestAxis = -1;
+            int bestBin = 0;
+            float bestCost = FLT_MAX;
+            for (int axis = 0; axis < 3 && count > 1; ++axis)
+            {
+                float lo = Axis(centroidBounds.min, axis);
+                float hi = Axis(centroidBounds.max, axis);
+                if (hi <= lo)
+                    continue;
+
+                Bin bins[kBinCount];
+                float scale = kBinCount / (hi - lo);
+                for (uint32_t i = first; i < first + count; ++i)
+                {
+                    Bin& bin = bins[BinIndex(m_Order[i], axis, lo, scale)];
+                    bin.bounds.Grow(m_Prims[m_Order[i]]);
+                    ++bin.count;
+                }
+
+                // ۻõÿ߽Ҳ͸
+                float rightArea[kBinCount - 1];
+                uint32_t rightCount[kBinCount - 1];
+                Bounds acc;
+                uint32_t n = 0;
+                for (int i = kBinCount - 1; i > 0; --i)
+                {
+                    acc.Grow(bins[i].bounds);
+                    n += bins[i].count;
+                    rightArea[i - 1] = acc.Area();
+                    rightCount[i - 1] = n;
+                }
+
+                acc = Bounds();
+                n = 0;
+                for (int i = 0; i < kBinCount - 1; ++i)
+                {
+                    acc.Grow(bins[i].bounds);
+                    n += bins[i].count;
+                    float cost = acc.Area() * TestCost(n) + rightArea[i] * TestCost(rightCount[i]);
+                    if (n > 0 && rightCount[i] > 0 && cost < bestCost)
+                    {
+                        bestAxis = axis;
+                        bestBin = i;
+                        bestCost = cost;
+                    }
+                }
+            }
+
+            // һڵĴۼΪ1һͼԪĴۼΪ1
+            // ָͼԪʱҶӣĵȫغʱ޷ָֻҶ
+            float area = bounds.Area();
+            float splitCost = area > 0.0f ? 1.0f + bestCost / area : FLT_MAX;
+            if (bestAxis < 0 || (count <= m_MaxLeafSize && splitCost >= TestCost(count)))
+            {
+                m_Nodes[nodeIndex].offset = first;
+                m_Nodes[nodeIndex].count = count;
+                return;
+            }
+
+            float lo = Axis(centroidBounds.min, bestAxis);
+            float scale = kBinCount / (Axis(centroidBounds.max, bestAxis) - lo);
+            auto begin = m_Order.begin() + first;
+            auto middle = std::partition(begin, begin + count, [&](uint32_t prim)
+            {
+                return BinIndex(prim, bestAxis, lo, scale) <= bestBin;
+            });
+            uint32_t leftCount = (uint32_t)(middle - begin);
+
+            // ӽڵǰڵ֮
+            Subdivide(first, leftCount, depth + 1);
+            m_Nodes[nodeIndex].offset = (uint32_t)m_Nodes.size();
+            m_Nodes[nodeIndex].count = 0;
+            Subdivide(first + leftCount, count - leftCount, depth + 1);
+        }
+
+    private:
+        const std::vector<Bounds>& m_Prims;
+        uint32_t m_MaxLeafSize;
+        uint32_t m_PrimsPerTest;
+        std::vector<Node>& m_Nodes;
+        std::vector<uint32_t>& m_Order;
+        std::vector<XMFLOAT3> m_Centroids;
+        uint32_t m_Depth = 0;
+    };
+
+    // ڵΧеslabԣؽΧеľ룬ཻʱFLT_MAX
+    inline float IntersectNode(const Node& node, FXMVECTOR origin, FXMVECTOR invDir, float tMax)
+    {
+        XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMin), origin), invDir);
+        XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMax), origin), invDir);
+
+        XMFLOAT3 tNear, tFar;
+        XMStoreFloat3(&tNear, XMVectorMin(t0, t1));
+        XMStoreFloat3(&tFar, XMVectorMax(t0, t1));
+
+        float enter = (std::max)((std::max)(tNear.x, tNear.y), (std::max)(tNear.z, 0.0f));
+        float exit = (std::min)((std::min)(tFar.x, tFar.y), (std::min)(tFar.z, tMax));
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    // ɽԶڵ㣬leafFunc(first, count, tMax) ҶеͼԪиͼԪʱСtMax
+    // depth ΪĲʵLĽڵʱջL-1ԶӣѹӺ󲻳L+1ջĴСȡ
+    template <typename LeafFunc>
+    bool Traverse(const std::vector<Node>& nodes, uint32_t depth, FXMVECTOR origin, FXMVECTOR dir, float& tMax, LeafFunc leafFunc)
+    {
+        if (nodes.empty())
+            return false;
+
+        XMVECTOR invDir = XMVectorReciprocal(dir);
+
+        struct Entry
+        {
+            uint32_t index;
+            float t;
+        };
+        // ˻ļ(غϵ)ʱöϵջ
+        Entry localStack[kStackSize];
+        std::vector<Entry> heapStack;
+        Entry* stack = localStack;
+        if (depth > kStackSize)
+        {
+            heapStack.resize(depth);
+            stack = heapStack.data();
+        }
+        int top = 0;
+
+        float tRoot = IntersectNode(nodes[0], origin, invDir, tMax);
+        if (tRoot != FLT_MAX)
+            stack[top++] = { 0, tRoot };
+
+        bool hit = false;
+        while (top > 0)
+        {
+            Entry entry = stack[--top];
+
+            // ջ֮ҵ˸
+            if (entry.t > tMax)
+                continue;
+
+            const Node& node = nodes[entry.index];
+            if (node.count > 0)
+            {
+                hit |= leafFunc(node.offset, node.count, tMax);
+                continue;
+            }
+
+            uint32_t nearChild = entry.index + 1;
+            uint32_t farChild = node.offset;
+            float tNear = IntersectNode(nodes[nearChild], origin, invDir, tMax);
+            float tFar = IntersectNode(nodes[farChild], origin, invDir, tMax);
+            if (tNear > tFar)
+            {
+                std::swap(nearChild, farChild);
+                std::swap(tNear, tFar);
+            }
+
+            // Զĺջȷʽĺ
+            if (tFar != FLT_MAX)
+                stack[top++] = { farChild, tFar };
+            if (tNear != FLT_MAX)
+                stack[top++] = { nearChild, tNear };
+        }
+
+        return hit;
+    }
+}
+
+void MeshBVH::Build(const XMFLOAT3* positions, size_t stride, const int32_t* indices, size_t indexCount)
+{
+    auto position = [&](int32_t index) -> const XMFLOAT3&
+    {
+        return *(const XMFLOAT3*)((const uint8_t*)positions + index * stride);
+    };
+
+    size_t triCount = indexCount / 3;
+    std::vector<Bounds> triBounds(triCount);
+    for (size_t i = 0; i < triCount; ++i)
+    {
+        triBounds[i].Grow(position(indices[i * 3 + 0]));
+        triBounds[i].Grow(position(indices[i * 3 + 1]));
+        triBounds[i].Grow(position(indices[i * 3 + 2]));
+    }
+
+    std::vector<uint32_t> order;
+    Builder builder(triBounds, kMaxLeafTriangles, kPackSize, m_Nodes, order);
+    builder.Build();
+    m_Depth = builder.GetDepth();
+    m_TriangleCount = triCount;
+
+    // Ҷ˳δSoAÿҶӴµһʼҶӵƫƸΪеλ
+    uint32_t packCount = 0;
+    for (auto& node : m_Nodes)
+        packCount += (node.count + kPackSize - 1) / kPackSize;
+
+    m_Packs.assign(packCount, RayTriangle::TrianglePack4());
+    m_TriIndex.assign(packCount * kPackSize, UINT32_MAX);
+
+    uint32_t slot = 0;
+    for (auto& node : m_Nodes)
+    {
+        if (node.count == 0)
+            continue;
+
+        for (uint32_t i = 0; i < node.count; ++i)
+        {
+            uint32_t tri = order[node.offset + i];
+            RayTriangle::SetTriangle(m_Packs[(slot + i) / kPackSize], (slot + i) % kPackSize,
+                position(indices[tri * 3 + 0]), position(indices[tri * 3 + 1]), position(indices[tri * 3 + 2]));
+            m_TriIndex[slot + i] = tri;
+        }
+
+        node.offset = slot;
+        slot += (node.count + kPackSize - 1) / kPackSize * kPackSize;
+    }
+}
+
+bool MeshBVH::Intersect(FXMVECTOR origin, FXMVECTOR dir, RayHit& hit) const
+{
+    float tMax = hit.t;
+    uint32_t triangle = UINT32_MAX;
+
+    RayTriangle::RayPack4 ray = RayTriangle::MakeRay(origin, dir);
+
+    bool found = Traverse(m_Nodes, m_Depth, origin, dir, tMax, [&](uint32_t first, uint32_t count, float& tClosest)
+    {
+        bool any = false;
+        for (uint32_t slot = first; slot < first + count; slot += kPackSize)
+        {
+            float t[kPackSize];
+            int mask = RayTriangle::Intersect(ray, m_Packs[slot / kPackSize], t);
+
+            // lane˳Ƚϣʱѡеһ
+            for (uint32_t lane = 0; mask != 0; ++lane, mask >>= 1)
+            {
+                if ((mask & 1) && t[lane] < tClosest)
+                {
+                    tClosest = t[lane];
+                    triangle = m_TriIndex[slot + lane];
+                    any = true;
+                }
+            }
+        }
+        return any;
+    });
+
+    if (found)
+    {
+        hit.t = tMax;
+        hit.triangle = triangle;
+    }
+    return found;
+}
+
+void SceneBVH::Clear()
+{
+    m_Instances.clear();
+    m_Nodes.clear();
+    m_Order.clear();
+    m_Depth = 0;
+}
+
+uint32_t SceneBVH::AddInstance(const MeshBVH* mesh, FXMMATRIX world)
+{
+    Instance instance;
+    instance.mesh = mesh;
+    XMStoreFloat4x4(&instance.invWorld, XMMatrixInverse(nullptr, world));
+
+    // ģͰΧб任ռ䣺ĵֱӱ任볤Ϊ |3x3| * 볤
+    XMVECTOR boundsMin = XMLoadFloat3(&mesh->GetBoundsMin());
+    XMVECTOR boundsMax = XMLoadFloat3(&mesh->GetBoundsMax());
+    XMVECTOR center = XMVector3TransformCoord(XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f), world);
+    XMVECTOR extent = XMVectorScale(XMVectorSubtract(boundsMax, boundsMin), 0.5f);
+    XMVECTOR worldExtent = XMVectorAdd(XMVectorAdd(
+        XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorSplatX(extent)),
+        XMVectorMultiply(XMVectorAbs(world.r[1]), XMVectorSplatY(extent))),
+        XMVectorMultiply(XMVectorAbs(world.r[2]), XMVectorSplatZ(extent)));
+    XMStoreFloat3(&instance.boundsMin, XMVectorSubtract(center, worldExtent));
+    XMStoreFloat3(&instance.boundsMax, XMVectorAdd(center, worldExtent));
+
+    m_Instances.push_back(instance);
+    return (uint32_t)m_Instances.size() - 1;
+}
+
+void SceneBVH::Build()
+{
+    std::vector<Bounds> instanceBounds(m_Instances.size());
+    for (size_t i = 0; i < m_Instances.size(); ++i)
+    {
+        instanceBounds[i].min = m_Instances[i].boundsMin;
+        instanceBounds[i].max = m_Instances[i].boundsMax;
+    }
+
+    Builder builder(instanceBounds, kMaxLeafInstances, 1, m_Nodes, m_Order);
+    builder.Build();
+    m_Depth = builder.GetDepth();
+}
+
+bool SceneBVH::Intersect(FXMVECTOR origin, FXMVECTOR dir, RayHit& hit) const
+{
+    float tMax = hit.t;
+    uint32_t triangle = UINT32_MAX;
+    uint32_t instanceIndex = UINT32_MAX;
+
+    bool found = Traverse(m_Nodes, m_Depth, origin, dir, tMax, [&](uint32_t first, uint32_t count, float& tClosest)
+    {
+        bool any = false;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const Instance& instance = m_Instances[m_Order[i]];
+
+            // תģͿռ
+            XMMATRIX invWorld = XMLoadFloat4x4(&instance.invWorld);
+            XMVECTOR localOrigin = XMVector3TransformCoord(origin, invWorld);
+            XMVECTOR localDir = XMVector3TransformNormal(dir, invWorld);
+
+            // ʵʱģͿռռľ |localDir| 
+            float scale = XMVectorGetX(XMVector3Length(localDir));
+
+            RayHit local;
+            local.t = tClosest * scale;
+            if (instance.mesh->Intersect(localOrigin, XMVectorScale(localDir, 1.0f / scale), local))
+            {
+                tClosest = local.t / scale;
+                triangle = local.triangle;
+                instanceIndex = m_Order[i];
+                any = true;
+            }
+        }
+        return any;
+    });
+
+    if (found)
+    {
+        hit.t = tMax;
+        hit.triangle = triangle;
+        hit.instance = instanceIndex;
+    }
+    return found;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cfloat>
+#include <DirectXMath.h>
+#include "RayTriangle.h"
+
+// ʰȡʹõİΧвνṹ(BVH)
+// SAH(ʽ)Ͱڵ㰴˳չһУ
+// ڲڵӽԼ棬ֻ¼ҺӵλãҶӽڵ¼ͼԪʼλú͸
+//
+// MeshBVH һ(ģͿռ)SceneBVH ڶʵ(ռ)
+
+// ߲ѯĽ
+struct RayHit
+{
+    float t = FLT_MAX;                  // е = origin + t * dirΪʱʾԶ
+    uint32_t triangle = UINT32_MAX;     // ее
+    uint32_t instance = UINT32_MAX;     // еʵţֻ SceneBVH д
+};
+
+class MeshBVH
+{
+public:
+    // 32ֽڣڵһ
+    struct Node
+    {
+        DirectX::XMFLOAT3 boundsMin;
+        uint32_t offset;                // ڲڵ: Һӵλ  Ҷӽڵ: һͼԪλ
+        DirectX::XMFLOAT3 boundsMax;
+        uint32_t count;                 // ҶӽڵͼԪĸ0ʾڲڵ
+    };
+
+    // positions ָһλãstride Ϊṹֽ
+    void Build(const DirectX::XMFLOAT3* positions, size_t stride, const int32_t* indices, size_t indexCount);
+
+    // вѯdir ǵλ
+    // ֻҵ hit.t ʱŻ޸ hit true
+    bool Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, RayHit& hit) const;
+
+    bool Empty() const { return m_Nodes.empty(); }
+    size_t GetNodeCount() const { return m_Nodes.size(); }
+    size_t GetTriangleCount() const { return m_TriangleCount; }
+    uint32_t GetDepth() const { return m_Depth; }
+
+    // İΧ
+    const DirectX::XMFLOAT3& GetBoundsMin() const { return m_Nodes[0].boundsMin; }
+    const DirectX::XMFLOAT3& GetBoundsMax() const { return m_Nodes[0].boundsMax; }
+
+private:
+    std::vector<Node> m_Nodes;
+    std::vector<RayTriangle::TrianglePack4> m_Packs;    // Ҷ˳ΣÿҶӴµһʼ
+    std::vector<uint32_t> m_TriIndex;                   // еλ -> ԭ
+    size_t m_TriangleCount = 0;
+    uint32_t m_Depth = 0;                               // ĲջĴС
+};
+
+// ʵBVHҶΪʵʵתģͿռٲѯ MeshBVH
+class SceneBVH
+{
+public:
+    void Clear();
+
+    // һʵworld Ϊģ͵ľ󣬷ʵ
+    uint32_t AddInstance(const MeshBVH* mesh, DirectX::FXMMATRIX world);
+
+    // ʵ(ʵƶ)¹
+    void Build();
+
+    // ռевѯdir ǵλhit.t Ϊռľ
+    bool Intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, RayHit& hit) const;
+
+    size_t GetInstanceCount() const { return m_Instances.size(); }
+
+private:
+    struct Instance
+    {
+        DirectX::XMFLOAT4X4 invWorld;   // Ԥõ󣬲ѯʱ
+        DirectX::XMFLOAT3 boundsMin;    // ռİΧ
+        DirectX::XMFLOAT3 boundsMax;
+        const MeshBVH* mesh;
+    };
+
+    std::vector<Instance> m_Instances;
+    std::vector<MeshBVH::Node> m_Nodes;
+    std::vector<uint32_t> m_Order;      // Ҷ˳ -> ʵ
+    uint32_t m_Depth = 0;
+};
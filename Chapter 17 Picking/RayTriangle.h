@@ -0,0 +1,112 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// SIMD汾ཻ(Moller-Trumbore)һһβ4
+// ΰSoAÿһXMVECTOR4laneӦ4
+// ˳ DirectX::TriangleTests::Intersects(SSE·ʹFMA)ȫһ£λͬ
+namespace RayTriangle
+{
+    //  DirectXCollision е g_RayEpsilon һ
+    static const float kRayEpsilon = 1e-20f;
+
+    struct TrianglePack4
+    {
+        DirectX::XMVECTOR v0[3];    // һ x y z
+        DirectX::XMVECTOR e1[3];    // v1 - v0
+        DirectX::XMVECTOR e2[3];    // v2 - v0
+    };
+
+    // ÿչ4lane
+    struct RayPack4
+    {
+        DirectX::XMVECTOR origin[3];
+        DirectX::XMVECTOR dir[3];
+    };
+
+    inline RayPack4 MakeRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir)
+    {
+        using namespace DirectX;
+        RayPack4 ray;
+        ray.origin[0] = XMVectorSplatX(origin);
+        ray.origin[1] = XMVectorSplatY(origin);
+        ray.origin[2] = XMVectorSplatZ(origin);
+        ray.dir[0] = XMVectorSplatX(dir);
+        ray.dir[1] = XMVectorSplatY(dir);
+        ray.dir[2] = XMVectorSplatZ(dir);
+        return ray;
+    }
+
+    // д pack ĵ lane λ
+    // ûдlaneȫ0˻ΣԶ
+    inline void SetTriangle(TrianglePack4& pack, size_t lane,
+        const DirectX::XMFLOAT3& v0, const DirectX::XMFLOAT3& v1, const DirectX::XMFLOAT3& v2)
+    {
+        using namespace DirectX;
+        XMVECTOR p0 = XMLoadFloat3(&v0);
+        XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&v1), p0);
+        XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&v2), p0);
+        for (int i = 0; i < 3; ++i)
+        {
+            pack.v0[i] = XMVectorSetByIndex(pack.v0[i], XMVectorGetByIndex(p0, i), lane);
+            pack.e1[i] = XMVectorSetByIndex(pack.e1[i], XMVectorGetByIndex(e1, i), lane);
+            pack.e2[i] = XMVectorSetByIndex(pack.e2[i], XMVectorGetByIndex(e2, i), lane);
+        }
+    }
+
+    // SoAĵӷ˳ XMVector3Dot/XMVector3Cross ͬ: (x + y) + z
+    inline DirectX::XMVECTOR Dot3(const DirectX::XMVECTOR a[3], const DirectX::XMVECTOR b[3])
+    {
+        using namespace DirectX;
+        return XMVectorAdd(XMVectorAdd(XMVectorMultiply(a[0], b[0]), XMVectorMultiply(a[1], b[1])), XMVectorMultiply(a[2], b[2]));
+    }
+
+    inline void Cross3(const DirectX::XMVECTOR a[3], const DirectX::XMVECTOR b[3], DirectX::XMVECTOR out[3])
+    {
+        using namespace DirectX;
+        out[0] = XMVectorSubtract(XMVectorMultiply(a[1], b[2]), XMVectorMultiply(a[2], b[1]));
+        out[1] = XMVectorSubtract(XMVectorMultiply(a[2], b[0]), XMVectorMultiply(a[0], b[2]));
+        out[2] = XMVectorSubtract(XMVectorMultiply(a[0], b[1]), XMVectorMultiply(a[1], b[0]));
+    }
+
+    // еlane(iλӦi)еľд t
+    // ߷Ҫǵλ
+    inline int Intersect(const RayPack4& ray, const TrianglePack4& pack, float t[4])
+    {
+        using namespace DirectX;
+        const XMVECTOR zero = XMVectorZero();
+
+        // p = dir ^ e2  det = e1 * p
+        XMVECTOR p[3];
+        Cross3(ray.dir, pack.e2, p);
+        XMVECTOR det = Dot3(pack.e1, p);
+
+        // u = s * p  v = dir * q  t = e2 * q
+        XMVECTOR s[3] = {
+            XMVectorSubtract(ray.origin[0], pack.v0[0]),
+            XMVectorSubtract(ray.origin[1], pack.v0[1]),
+            XMVectorSubtract(ray.origin[2], pack.v0[2]) };
+        XMVECTOR q[3];
+        Cross3(s, pack.e1, q);
+        XMVECTOR u = Dot3(s, p);
+        XMVECTOR v = Dot3(ray.dir, q);
+        XMVECTOR dist = Dot3(pack.e2, q);
+        XMVECTOR uv = XMVectorAdd(u, v);
+
+        // : u < 0 || u > det || v < 0 || u + v > det || t < 0 ʱཻ
+        XMVECTOR front = XMVectorGreaterOrEqual(det, XMVectorReplicate(kRayEpsilon));
+        XMVECTOR frontMiss = XMVectorOrInt(XMVectorOrInt(XMVectorLess(u, zero), XMVectorGreater(u, det)),
+            XMVectorOrInt(XMVectorOrInt(XMVectorLess(v, zero), XMVectorGreater(uv, det)), XMVectorLess(dist, zero)));
+
+        // : ȽϷȫ෴
+        XMVECTOR back = XMVectorLessOrEqual(det, XMVectorReplicate(-kRayEpsilon));
+        XMVECTOR backMiss = XMVectorOrInt(XMVectorOrInt(XMVectorGreater(u, zero), XMVectorLess(u, det)),
+            XMVectorOrInt(XMVectorOrInt(XMVectorGreater(v, zero), XMVectorLess(uv, det)), XMVectorGreater(dist, zero)));
+
+        // Ϊƽε
+        XMVECTOR hit = XMVectorOrInt(XMVectorAndCInt(front, frontMiss), XMVectorAndCInt(back, backMiss));
+
+        XMStoreFloat4((XMFLOAT4*)t, XMVectorDivide(dist, det));
+        return _mm_movemask_ps(hit);
+    }
+}
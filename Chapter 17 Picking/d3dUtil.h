@@ -3,11 +3,14 @@
 #include <string>
 #include <unordered_map>
 #include "VectorMath.h"
+#include "MeshBVH.h"
 
 // Ũ
 static float flFrogAlpha = 0.0f;
 // Ƿ׶޳
 static bool g_openFrustumCull = true;
+// ʱУSIMDβԣʰȡܲ( vs BVH)Դ
+static bool g_pickBenchmark = false;
 
 // HLSLһ
 struct Light
@@ -119,6 +122,9 @@ public:
     {
         vecVertex = std::move(vertex);
         vecIndex = std::move(index);
+
+        // ʰȡʹõBVHֻ蹹һ
+        bvh.Build(&vecVertex[0].Pos, sizeof(Vertex), vecIndex.data(), vecIndex.size());
     }
 
     void destroy()
@@ -139,6 +145,9 @@ public:
     std::vector<Vertex> vecVertex;
     std::vector<std::int32_t> vecIndex;
 
+    // ģͿռεBVHʰȡ
+    MeshBVH bvh;
+
 private:
     StructuredBuffer vertexBuff;    // buff
     ByteAddressBuffer indexBuff;    // buff
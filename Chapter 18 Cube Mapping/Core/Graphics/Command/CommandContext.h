@@ -250,6 +250,7 @@ public:
     void SetConstants(UINT RootIndex, DWParam X, DWParam Y, DWParam Z, DWParam W);
     void SetConstantBuffer(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS CBV);
     void SetDynamicConstantBufferView(UINT RootIndex, size_t BufferSize, const void* BufferData);
+    void SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV);
     void SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0);
     void SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset = 0);
     void SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle);
@@ -508,6 +509,11 @@ inline void GraphicsContext::SetDynamicConstantBufferView(UINT RootIndex, size_t
     m_CommandList->SetGraphicsRootConstantBufferView(RootIndex, cb.GpuAddress);
 }
 
+inline void GraphicsContext::SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV)
+{
+    m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV);
+}
+
 inline void GraphicsContext::SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
     ASSERT((SRV.m_UsageState & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
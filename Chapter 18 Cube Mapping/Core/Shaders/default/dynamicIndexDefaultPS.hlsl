@@ -40,17 +40,6 @@ TextureCube gCubeMap : register(t4);
 
 SamplerState gsamLinearWrap  : register(s0);
 
-cbuffer VSConstants : register(b0)
-{
-    float4x4 modelToWorld;
-    float4x4 gTexTransform;
-    float4x4 gMatTransform;
-    uint gMaterialIndex;
-    uint vPad0;   // ռλ
-    uint vPad1;   // ռλ
-    uint vPad2;   // ռλ
-};
-
 // Constant data that varies per frame.
 cbuffer cbPass : register(b1)
 {
@@ -79,12 +68,14 @@ struct VertexOut
     float3 PosW    : POSITION;
     float3 NormalW : NORMAL;
     float2 TexC    : TEXCOORD;
+
+    nointerpolation uint MatIndex : MATINDEX;
 };
 
 float4 main(VertexOut pin) : SV_Target0
 {
     // ȡĲ
-    MaterialData matData = gMaterialData[gMaterialIndex];
+    MaterialData matData = gMaterialData[pin.MatIndex];
     float4 diffuseAlbedo = matData.DiffuseAlbedo;
     float3 fresnelR0 = matData.FresnelR0;
     float  roughness = matData.Roughness;
@@ -32,7 +32,9 @@ private:
     void buildGeo();
     void buildMaterials();
     void buildRenderItem();
-    void drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& ritems);
+    void drawRenderItems(GraphicsContext& gfxContext, std::vector<DrawBatch>& batches);
+    void buildDrawBatches();
+    void uploadObjectConstants(GraphicsContext& gfxContext);
     
     void buildCubeCamera(float x, float y, float z);
     void DrawSceneToCubeMap(GraphicsContext& gfxContext);
@@ -56,6 +58,10 @@ private:
     std::vector<RenderItem*> m_vecRenderItems[(int)RenderLayer::Count];
     std::vector<std::unique_ptr<RenderItem>> m_vecAll;
 
+    //  m_vecRenderItems ϲͬõ岻ʱһ
+    std::vector<DrawBatch> m_vecBatches[(int)RenderLayer::Count];
+    StructuredBuffer m_instances;   // t6 εʵ
+
     StructuredBuffer m_mats;    // t1 洢е
     std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_srvs;  // 洢еԴ
 
@@ -63,6 +69,9 @@ private:
     // ǩ
     RootSignature m_RootSignature;
 
+    // ֡峣GPUַÿ֡ϴһΣpass
+    D3D12_GPU_VIRTUAL_ADDRESS m_ObjectConstantsGpu = 0;
+
     // Ⱦˮ
     enum ePSOType
     {
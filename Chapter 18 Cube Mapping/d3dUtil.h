@@ -8,6 +8,8 @@
 static float flFrogAlpha = 0.0f;
 // Ƿ׶޳
 static bool g_openFrustumCull = true;
+// ѸͬϲΪһ DrawIndexedInstancedرպÿ嵥
+static bool g_instanceRenderItems = true;
 
 // HLSLһ
 struct Light
@@ -28,6 +30,10 @@ struct ObjectConstants
     Math::Matrix4 texTransform = Math::Matrix4(Math::kIdentity); // öת
     Math::Matrix4 matTransform = Math::Matrix4(Math::kIdentity);
     UINT MaterialIndex;
+    // ΪṹԪϴ뵽ɫе ObjectData ͬĴС
+    UINT ObjPad0;
+    UINT ObjPad1;
+    UINT ObjPad2;
 };
 
 struct PassConstants
@@ -146,6 +152,8 @@ struct RenderItem
     Math::Matrix4 matTransform = Math::Matrix4(Math::kIdentity);     // ƾ󣬱̬ͨƶ
 
     UINT MaterialIndex = -1;           // ĿӦ
+    UINT ObjIndex = 0;                 // ÿ֡峣еλ
+    UINT SubmeshId = 0;                // νṹ˶ͬͬԺϲΪһʵ
 
     int IndexCount = 0;             // 
     int StartIndexLocation = 0;     // ʼλ
@@ -153,4 +161,12 @@ struct RenderItem
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
     MeshGeometry* geo = nullptr;    // νṹָ룬ӦĶԼ
+};
+
+// һʵ: item ṩݣʵ [instanceBase, instanceBase + instanceCount) Ǹʵ
+struct DrawBatch
+{
+    RenderItem* item;
+    UINT instanceBase;
+    UINT instanceCount;
 };
\ No newline at end of file
@@ -1,9 +1,23 @@
-cbuffer VSConstants : register(b0)
+// ֡ĳͨʵ gInstanceIndices ѡһ
+struct ObjectData
 {
-    float4x4 modelToWorld;
-    float4x4 gTexTransform;
-    float4x4 gMatTransform;
-    uint gMaterialIndex;
+    float4x4 World;
+    float4x4 TexTransform;
+    float4x4 MatTransform;
+    uint     MaterialIndex;
+    uint     ObjPad0;   // ռλ
+    uint     ObjPad1;   // ռλ
+    uint     ObjPad2;   // ռλ
+};
+
+StructuredBuffer<ObjectData> gObjectData : register(t8);
+
+// лƵʵÿλƴ gInstanceBase ʼȡ InstanceCount 
+StructuredBuffer<uint> gInstanceIndices : register(t9);
+
+cbuffer cbObject : register(b0)
+{
+    uint gInstanceBase;
 };
 
 cbuffer PassConstants : register(b1)
@@ -26,28 +40,35 @@ struct VertexOut
     float3 NormalW : NORMAL;
     float3 TangentW : TANGENT; // ߵ
     float2 TexC    : TEXCOORD;
+
+    // ͬһʵĲʿֵܲͬ
+    nointerpolation uint MatIndex : MATINDEX;
 };
 
-VertexOut main(VertexIn vin)
+VertexOut main(VertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut vout = (VertexOut)0.0f;
 
+    ObjectData obj = gObjectData[gInstanceIndices[gInstanceBase + instanceID]];
+
     // Ѷתϵ
-    float4 posW = mul(float4(vin.PosL, 1.0f), modelToWorld);
+    float4 posW = mul(float4(vin.PosL, 1.0f), obj.World);
     vout.PosW = posW.xyz;
 
     // תϵ
-    vout.NormalW = mul(vin.NormalL, (float3x3)modelToWorld);
+    vout.NormalW = mul(vin.NormalL, (float3x3)obj.World);
 
     // תϵ
-    vout.TangentW = mul(vin.TangentU, (float3x3)modelToWorld);
+    vout.TangentW = mul(vin.TangentU, (float3x3)obj.World);
 
     // תͶӰϵ
     vout.PosH = mul(posW, gViewProj);
 
     // ֱӷ
-    float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
-    vout.TexC = mul(texC, gMatTransform).xy;
+    float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), obj.TexTransform);
+    vout.TexC = mul(texC, obj.MatTransform).xy;
+
+    vout.MatIndex = obj.MaterialIndex;
 
     return vout;
 }
\ No newline at end of file
@@ -1,9 +1,23 @@
-cbuffer VSConstants : register(b0)
+// ֡ĳͨʵ gInstanceIndices ѡһ
+struct ObjectData
 {
-    float4x4 modelToWorld;
-    float4x4 gTexTransform;
-    float4x4 gMatTransform;
-    uint gMaterialIndex;
+    float4x4 World;
+    float4x4 TexTransform;
+    float4x4 MatTransform;
+    uint     MaterialIndex;
+    uint     ObjPad0;   // ռλ
+    uint     ObjPad1;   // ռλ
+    uint     ObjPad2;   // ռλ
+};
+
+StructuredBuffer<ObjectData> gObjectData : register(t8);
+
+// лƵʵÿλƴ gInstanceBase ʼȡ InstanceCount 
+StructuredBuffer<uint> gInstanceIndices : register(t9);
+
+cbuffer cbObject : register(b0)
+{
+    uint gInstanceBase;
 };
 
 cbuffer PassConstants : register(b1)
@@ -27,15 +41,17 @@ struct VertexOut
     float3 PosL    : POSITION;
 };
 
-VertexOut main(VertexIn vin)
+VertexOut main(VertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut vout = (VertexOut)0.0f;
 
+    ObjectData obj = gObjectData[gInstanceIndices[gInstanceBase + instanceID]];
+
     // ʹģϵ
     vout.PosL = vin.PosL;
 
     // Ѷתϵ
-    float4 posW = mul(float4(vin.PosL, 1.0f), modelToWorld);
+    float4 posW = mul(float4(vin.PosL, 1.0f), obj.World);
     
     // պеʼλ
     posW.xyz += gEyePosW;
@@ -8,6 +8,8 @@
 
 #include <fstream>
 #include <sstream>
+#include <map>
+#include <tuple>
 #include "GeometryGenerator.h"
 #include <DirectXCollision.h>
 
@@ -38,7 +40,11 @@ void GameApp::Cleanup(void)
     for (auto& v : m_vecRenderItems)
         v.clear();
 
+    for (auto& v : m_vecBatches)
+        v.clear();
+
     m_mats.Destroy();
+    m_instances.Destroy();
 }
 
 void GameApp::Update(float deltaT)
@@ -76,6 +82,9 @@ void GameApp::RenderScene(void)
 {
     GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
 
+    // ϴ֡ĳͼ6passʹһ
+    uploadObjectConstants(gfxContext);
+
     // ̬պȾ => g_SceneCubeBuffer
     DrawSceneToCubeMap(gfxContext);
 
@@ -90,6 +99,8 @@ void GameApp::RenderScene(void)
     gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
 
     gfxContext.SetRootSignature(m_RootSignature);
+    gfxContext.SetShaderResourceView(4, m_ObjectConstantsGpu);
+    gfxContext.SetBufferSRV(5, m_instances);
 
     // ͨõĳ
     PassConstants psc;
@@ -111,18 +122,18 @@ void GameApp::RenderScene(void)
     gfxContext.SetDynamicDescriptors(3, 0, 7, &m_srvs[0]);
 
     gfxContext.SetPipelineState(m_mapPSO[E_EPT_DEFAULT]);
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Opaque]);
+    drawRenderItems(gfxContext, m_vecBatches[(int)RenderLayer::Opaque]);
 
     // Ⱦмˮϱ߶̬ɵպ
     // ö̬պԴ
     gfxContext.SetDynamicDescriptors(3, 6, 1, &Graphics::g_SceneCubeBuff.GetSRV());
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::OpaqueDynamicReflectors]);
+    drawRenderItems(gfxContext, m_vecBatches[(int)RenderLayer::OpaqueDynamicReflectors]);
 
     // պ
     gfxContext.SetPipelineState(m_mapPSO[E_EPT_SKY]);
     // ԭʼպԴ
     gfxContext.SetDynamicDescriptors(3, 6, 1, &m_srvs[6]);
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Sky]);
+    drawRenderItems(gfxContext, m_vecBatches[(int)RenderLayer::Sky]);
 
     gfxContext.TransitionResource(Graphics::g_SceneColorBuffer, D3D12_RESOURCE_STATE_PRESENT);
 
@@ -149,6 +160,8 @@ void GameApp::DrawSceneToCubeMap(GraphicsContext& gfxContext)
 
     // øǩ
     gfxContext.SetRootSignature(m_RootSignature);
+    gfxContext.SetShaderResourceView(4, m_ObjectConstantsGpu);
+    gfxContext.SetBufferSRV(5, m_instances);
 
     // ȫ
     gfxContext.SetBufferSRV(2, m_mats);
@@ -177,11 +190,11 @@ void GameApp::DrawSceneToCubeMap(GraphicsContext& gfxContext)
 
         // ʼ
         gfxContext.SetPipelineState(m_mapPSO[E_EPT_DEFAULT]);
-        drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Opaque]);
+        drawRenderItems(gfxContext, m_vecBatches[(int)RenderLayer::Opaque]);
 
         // պ
         gfxContext.SetPipelineState(m_mapPSO[E_EPT_SKY]);
-        drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Sky]);
+        drawRenderItems(gfxContext, m_vecBatches[(int)RenderLayer::Sky]);
     }
     
     // ı仺
@@ -193,10 +206,12 @@ void GameApp::RenderUI(class GraphicsContext& gfxContext)
     
 }
 
-void GameApp::drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem *>& ritems)
+void GameApp::drawRenderItems(GraphicsContext& gfxContext, std::vector<DrawBatch>& batches)
 {
-    for (auto& item : ritems)
+    for (auto& batch : batches)
     {
+        RenderItem* item = batch.item;
+
         // ö
         gfxContext.SetVertexBuffer(0, item->geo->vertexView);
 
@@ -206,28 +221,41 @@ void GameApp::drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderIte
         // ö˽ṹ
         gfxContext.SetPrimitiveTopology(item->PrimitiveType);
 
-        // ȾĿתƾ
-        ObjectConstants obc;
+        // һʵеʼλãɫͨʵҵԵתƾ
+        gfxContext.SetConstants(0, batch.instanceBase);
+
+        gfxContext.DrawIndexedInstanced(item->IndexCount, batch.instanceCount, item->StartIndexLocation, item->BaseVertexLocation, 0);
+    }
+}
+
+void GameApp::uploadObjectConstants(GraphicsContext& gfxContext)
+{
+    // ֱдϴѣʡȥһο
+    DynAlloc table = gfxContext.ReserveUploadMemory(sizeof(ObjectConstants) * m_vecAll.size());
+    ObjectConstants* obcs = (ObjectConstants*)table.DataPtr;
+    for (auto& item : m_vecAll)
+    {
+        ObjectConstants& obc = obcs[item->ObjIndex];
         obc.World = item->modeToWorld;
         obc.texTransform = item->texTransform;
         obc.matTransform = item->matTransform;
         obc.MaterialIndex = item->MaterialIndex;
-        gfxContext.SetDynamicConstantBufferView(0, sizeof(obc), &obc);
-
-        gfxContext.DrawIndexed(item->IndexCount, item->StartIndexLocation, item->BaseVertexLocation);
     }
+    m_ObjectConstantsGpu = table.GpuAddress;
 }
 
 void GameApp::buildPSO()
 {
     // ǩ
-    m_RootSignature.Reset(4, 2);
+    m_RootSignature.Reset(6, 2);
     m_RootSignature.InitStaticSampler(0, Graphics::SamplerLinearWrapDesc);
     m_RootSignature.InitStaticSampler(1, Graphics::SamplerAnisoWrapDesc);
-    m_RootSignature[0].InitAsConstantBuffer(0);
+    m_RootSignature[0].InitAsConstants(0, 1);
     m_RootSignature[1].InitAsConstantBuffer(1);
     m_RootSignature[2].InitAsBufferSRV(0);
     m_RootSignature[3].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 7);
+    m_RootSignature[4].InitAsBufferSRV(8);
+    m_RootSignature[5].InitAsBufferSRV(9);
     m_RootSignature.Finalize(L"18 RS", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
     // PSO
@@ -612,6 +640,72 @@ void GameApp::buildRenderItem()
         m_vecRenderItems[(int)RenderLayer::Opaque].push_back(rightSphereRitem.get());
         m_vecAll.push_back(std::move(rightSphereRitem));
     }
+
+    // ڳеλ
+    for (size_t i = 0; i < m_vecAll.size(); ++i)
+        m_vecAll[i]->ObjIndex = (UINT)i;
+
+    buildDrawBatches();
+}
+
+void GameApp::buildDrawBatches()
+{
+    // νṹ˶ͬԺϲΪһʵ
+    std::map<std::tuple<MeshGeometry*, int, int, int, int>, UINT> submeshIds;
+    for (auto& item : m_vecAll)
+    {
+        auto submesh = std::make_tuple(item->geo, item->IndexCount, item->StartIndexLocation, item->BaseVertexLocation, (int)item->PrimitiveType);
+        item->SubmeshId = submeshIds.emplace(submesh, (UINT)submeshIds.size()).first->second;
+    }
+
+    std::vector<UINT> instances;
+    std::vector<int> batchOfSubmesh;    //  -> еλ
+    for (int i = 0; i < (int)RenderLayer::Count; ++i)
+    {
+        std::vector<DrawBatch>& batches = m_vecBatches[i];
+        batches.clear();
+
+        if (!g_instanceRenderItems)
+        {
+            for (auto& item : m_vecRenderItems[i])
+            {
+                batches.push_back({ item, (UINT)instances.size(), 1 });
+                instances.push_back(item->ObjIndex);
+            }
+            continue;
+        }
+
+        // ͳÿʵΰһļ˳
+        batchOfSubmesh.assign(submeshIds.size(), -1);
+        for (auto& item : m_vecRenderItems[i])
+        {
+            int& batch = batchOfSubmesh[item->SubmeshId];
+            if (batch < 0)
+            {
+                batch = (int)batches.size();
+                batches.push_back({ item, 0, 0 });
+            }
+            ++batches[batch].instanceCount;
+        }
+
+        // ʵеλãٰ˳д
+        UINT base = (UINT)instances.size();
+        for (auto& batch : batches)
+        {
+            batch.instanceBase = base;
+            base += batch.instanceCount;
+            batch.instanceCount = 0;
+        }
+
+        instances.resize(base);
+        for (auto& item : m_vecRenderItems[i])
+        {
+            DrawBatch& batch = batches[batchOfSubmesh[item->SubmeshId]];
+            instances[batch.instanceBase + batch.instanceCount++] = item->ObjIndex;
+        }
+    }
+
+    m_instances.Create(L"instance table", (UINT)instances.size(), sizeof(UINT), instances.data());
 }
 
 void GameApp::cameraUpdate()
@@ -32,7 +32,9 @@ private:
     void buildGeo();
     void buildMaterials();
     void buildRenderItem();
-    void drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& ritems);
+    void drawRenderItems(GraphicsContext& gfxContext, std::vector<DrawBatch>& batches);
+    void buildDrawBatches();
+    void uploadObjectConstants(GraphicsContext& gfxContext);
     
     void buildCubeCamera(float x, float y, float z);
     void DrawSceneToCubeMap(GraphicsContext& gfxContext);
@@ -56,6 +58,10 @@ private:
     std::vector<RenderItem*> m_vecRenderItems[(int)RenderLayer::Count];
     std::vector<std::unique_ptr<RenderItem>> m_vecAll;
 
+    //  m_vecRenderItems ϲͬõ岻ʱһ
+    std::vector<DrawBatch> m_vecBatches[(int)RenderLayer::Count];
+    StructuredBuffer m_instances;   // t9 εʵ
+
     enum eMaterialType
     {
         bricks = 0,
@@ -71,6 +77,9 @@ private:
     // ǩ
     RootSignature m_RootSignature;
 
+    // ֡峣GPUַÿ֡ϴһΣpass
+    D3D12_GPU_VIRTUAL_ADDRESS m_ObjectConstantsGpu = 0;
+
     // Ⱦˮ
     enum ePSOType
     {
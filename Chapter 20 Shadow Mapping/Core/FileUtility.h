@@ -16,12 +16,11 @@
 #include "pch.h"
 #include <vector>
 #include <string>
-#include <ppl.h>
+#include "JobSystem.h"
 
 namespace Utility
 {
     using namespace std;
-    using namespace concurrency;
 
     typedef shared_ptr<vector<unsigned char> > ByteArray;
     extern ByteArray NullFile;
@@ -32,6 +31,6 @@ namespace Utility
     ByteArray ReadFileSync(const wstring& fileName);
 
     // Same as previous except that it does not block but instead returns a task.
-    task<ByteArray> ReadFileAsync(const wstring& fileName);
+    JobSystem::Task<ByteArray> ReadFileAsync(const wstring& fileName);
 
 } // namespace Utility
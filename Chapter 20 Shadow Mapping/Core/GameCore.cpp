@@ -18,6 +18,11 @@
 #include "GameInput.h"
 #include "BufferManager.h"
 #include "CommandContext.h"
+#include "NullDevice.h"
+#include "UploadRing.h"
+#include "JobSystem.h"
+#include "PipelineCache.h"
+#include "TextureStreamer.h"
 // #include "PostEffects.h"
 
 #pragma comment(lib, "runtimeobject.lib")
@@ -32,17 +37,27 @@ namespace GameCore
     using namespace Graphics;
     const bool TestGenerateMips = false;
 
+    // һ Present ʱ䣬ʽʱ
+    int64_t s_StartupTick = 0;
+    bool s_FirstFramePresented = false;
+
 	bool InitializeApplication(IGameApp& game)
     {
+        s_StartupTick = SystemTime::GetCurrentTick();
+
 		if (!Graphics::Initialize())
 			return false;
 
         SystemTime::Initialize();
+        JobSystem::Initialize();
         GameInput::Initialize();
         EngineTuning::Initialize();
 
         game.Startup();
 
+        // ͳPSOʱ
+        PipelineCache::PrintReport();
+
 		return true;
 	}
 
@@ -51,11 +66,15 @@ namespace GameCore
         game.Cleanup();
 
         GameInput::Shutdown();
+        // ڹ߳ϣȵʽؽ
+        TextureStreamer::Shutdown();
+        JobSystem::Shutdown();
     }
 
 	void UpdateApplication(IGameApp& game)
     {
         EngineProfiling::Update();
+        TextureStreamer::Update();
 
         float DeltaTime = Graphics::GetFrameTime();
 
@@ -84,7 +103,7 @@ namespace GameCore
 //         }
  
         GraphicsContext& UiContext = GraphicsContext::Begin(L"Render UI");
-        UiContext.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
+        UiContext.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
         UiContext.ClearColor(g_OverlayBuffer);
         UiContext.SetRenderTarget(g_OverlayBuffer.GetRTV());
         UiContext.SetViewportAndScissor(0, 0, g_OverlayBuffer.GetWidth(), g_OverlayBuffer.GetHeight());
@@ -95,6 +114,175 @@ namespace GameCore
         UiContext.Finish();
 
         Graphics::Present();
+
+        if (!s_FirstFramePresented)
+        {
+            s_FirstFramePresented = true;
+            Utility::Printf("Time to first frame: %.1f ms (%u textures still streaming)\n",
+                SystemTime::TimeBetweenTicks(s_StartupTick, SystemTime::GetCurrentTick()) * 1000.0, TextureStreamer::GetPendingCount());
+        }
+    }
+
+    namespace
+    {
+        struct HeadlessStats
+        {
+            double sceneTotal = 0.0, sceneMin = 1e9, sceneMax = 0.0, frameTotal = 0.0;
+            NullDevice::Counters sceneCounters = {};
+        };
+
+        //  warmupFrames ֡ͳƣ frameCount ֡stream Ϊʱ¼һ֡
+        HeadlessStats RunHeadlessFrames(IGameApp& app, uint32_t warmupFrames, uint32_t frameCount, std::vector<uint8_t>* stream)
+        {
+            const float kDeltaTime = 1.0f / 60.0f;
+
+            HeadlessStats stats;
+
+            for (uint32_t frame = 0; frame < warmupFrames + frameCount; ++frame)
+            {
+                bool measure = frame >= warmupFrames;
+                bool lastFrame = frame + 1 == warmupFrames + frameCount;
+
+                if (frame == warmupFrames)
+                {
+                    UploadRingAllocator::ResetStats();
+                    DynamicDescriptorHeap::ResetStats();
+                    ResourceStateTracker::ResetStats();
+                    app.ResetStats();
+                }
+
+                int64_t frameStart = SystemTime::GetCurrentTick();
+
+                EngineProfiling::Update();
+                TextureStreamer::Update();
+                app.Update(kDeltaTime);
+
+                // ֻ¼һ֡ڱȽеĽ
+                if (lastFrame && stream != nullptr)
+                    NullDevice::CaptureStream(stream);
+
+                NullDevice::Counters before = NullDevice::GetCounters();
+                int64_t sceneStart = SystemTime::GetCurrentTick();
+                app.RenderScene();
+                int64_t sceneEnd = SystemTime::GetCurrentTick();
+                NullDevice::Counters delta = NullDevice::Difference(NullDevice::GetCounters(), before);
+
+                if (lastFrame && stream != nullptr)
+                    NullDevice::CaptureStream(nullptr);
+
+                GraphicsContext& UiContext = GraphicsContext::Begin(L"Render UI");
+                UiContext.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                UiContext.ClearColor(g_OverlayBuffer);
+                UiContext.SetRenderTarget(g_OverlayBuffer.GetRTV());
+                UiContext.SetViewportAndScissor(0, 0, g_OverlayBuffer.GetWidth(), g_OverlayBuffer.GetHeight());
+                app.RenderUI(UiContext);
+                UiContext.Finish();
+
+                Graphics::Present();
+
+                if (!measure)
+                    continue;
+
+                double sceneTime = SystemTime::TimeBetweenTicks(sceneStart, sceneEnd);
+                stats.sceneTotal += sceneTime;
+                stats.sceneMin = std::min(stats.sceneMin, sceneTime);
+                stats.sceneMax = std::max(stats.sceneMax, sceneTime);
+                stats.frameTotal += SystemTime::TimeBetweenTicks(frameStart, SystemTime::GetCurrentTick());
+
+                for (int i = 0; i < NullDevice::kCounterCount; ++i)
+                    stats.sceneCounters.Value[i] += delta.Value[i];
+            }
+
+            return stats;
+        }
+    }
+
+    void RunHeadless(IGameApp& app, uint32_t frameCount, const std::vector<uint32_t>& workerCounts, bool compareDescriptorTableCache)
+    {
+        // ǰ֡״ʹʱķ䣬ͳ
+        const uint32_t kWarmupFrames = 30;
+
+        if (!Graphics::Initialize(true))
+            return;
+
+        SystemTime::Initialize();
+        JobSystem::Initialize();
+        EngineTuning::Initialize();
+
+        app.Startup();
+        PipelineCache::PrintReport();
+
+        if (compareDescriptorTableCache)
+        {
+            Utility::Printf("Null device: %u frames without and with the descriptor table cache (after %u warm-up frames)\n", frameCount, kWarmupFrames);
+            const bool cacheModes[] = { false, true };
+            for (bool enabled : cacheModes)
+            {
+                Graphics::s_EnableDescriptorTableCache = enabled;
+
+                HeadlessStats stats = RunHeadlessFrames(app, kWarmupFrames, frameCount, nullptr);
+                Utility::Printf("  cache %-3s: RenderScene avg %.3f ms  %.0f descriptors copied by the device\n", enabled ? "on" : "off",
+                    stats.sceneTotal * 1000.0 / frameCount, (double)stats.sceneCounters[NullDevice::kDescriptorCopies] / frameCount);
+                DynamicDescriptorHeap::PrintReport(frameCount);
+            }
+        }
+        else if (workerCounts.empty())
+        {
+            std::vector<uint8_t> stream;
+            HeadlessStats stats = RunHeadlessFrames(app, kWarmupFrames, frameCount, &stream);
+
+            // FNV-1a
+            uint64_t streamHash = 14695981039346656037ull;
+            for (uint8_t b : stream)
+                streamHash = (streamHash ^ b) * 1099511628211ull;
+
+            auto perFrame = [&](NullDevice::Counter c) { return (double)stats.sceneCounters[c] / frameCount; };
+
+            Utility::Printf("Null device: %u frames (after %u warm-up frames)\n", frameCount, kWarmupFrames);
+            Utility::Printf("  RenderScene CPU: avg %.3f ms  min %.3f ms  max %.3f ms\n",
+                stats.sceneTotal * 1000.0 / frameCount, stats.sceneMin * 1000.0, stats.sceneMax * 1000.0);
+            Utility::Printf("  Frame CPU:       avg %.3f ms\n", stats.frameTotal * 1000.0 / frameCount);
+            Utility::Printf("  Per RenderScene: %.0f draws  %.0f dispatches  %.0f barriers (%.0f calls)  %.0f descriptor copies\n",
+                perFrame(NullDevice::kDrawCalls), perFrame(NullDevice::kDispatches), perFrame(NullDevice::kBarriers),
+                perFrame(NullDevice::kBarrierCalls), perFrame(NullDevice::kDescriptorCopies));
+            Utility::Printf("                   %.0f PSO changes  %.0f root signatures  %.0f root arguments  %.0f copies  %.0f clears\n",
+                perFrame(NullDevice::kPipelineStates), perFrame(NullDevice::kRootSignatures), perFrame(NullDevice::kRootArguments),
+                perFrame(NullDevice::kCopies), perFrame(NullDevice::kClears));
+            Utility::Printf("                   %.0f topologies  %.0f index buffers  %.0f vertex buffers\n",
+                perFrame(NullDevice::kTopologies), perFrame(NullDevice::kIndexBuffers), perFrame(NullDevice::kVertexBuffers));
+            Utility::Printf("                   %.0f command lists  %.0f commands  %.0f stream bytes\n",
+                perFrame(NullDevice::kCommandLists), perFrame(NullDevice::kCommands), perFrame(NullDevice::kStreamBytes));
+            Utility::Printf("  Last frame stream: %zu bytes, hash %016llx\n", stream.size(), streamHash);
+            UploadRingAllocator::PrintReport();
+            DescriptorAllocator::PrintReport();
+            DynamicDescriptorHeap::PrintReport(frameCount);
+            ResourceStateTracker::PrintReport(frameCount);
+            app.PrintStats();
+        }
+        else
+        {
+            // ÿ߳ϵͳ0ʾ߳
+            Utility::Printf("Null device: %u frames per worker count (after %u warm-up frames)\n", frameCount, kWarmupFrames);
+            for (uint32_t workers : workerCounts)
+            {
+                // ܻڶ
+                TextureStreamer::WaitForAll();
+                JobSystem::Shutdown();
+                if (workers > 0)
+                    JobSystem::Initialize(workers);
+
+                HeadlessStats stats = RunHeadlessFrames(app, kWarmupFrames, frameCount, nullptr);
+                Utility::Printf("  %2u workers: RenderScene avg %.3f ms  min %.3f ms  max %.3f ms  %.0f lists  %.0f draws\n",
+                    workers, stats.sceneTotal * 1000.0 / frameCount, stats.sceneMin * 1000.0, stats.sceneMax * 1000.0,
+                    (double)stats.sceneCounters[NullDevice::kCommandLists] / frameCount,
+                    (double)stats.sceneCounters[NullDevice::kDrawCalls] / frameCount);
+            }
+        }
+
+        Graphics::Terminate();
+        app.Cleanup();
+        Graphics::Shutdown();
+        JobSystem::Shutdown();
     }
 
 
@@ -35,7 +35,17 @@ namespace GameCore
 
 		// Optional UI (overlay) rendering pass.  This is LDR.  The buffer is already cleared.
 		virtual void RenderUI(class GraphicsContext&) {};
+
+		// RunHeadless ԤȽʱաڽʱӦԼͳ
+		virtual void ResetStats(void) {};
+		virtual void PrintStats(void) {};
 	};
 
 	void RunApplication(IGameApp& app, HINSTANCE hInst, const wchar_t* className);
+
+	// ڣÿ豸Թ̶֡ʱ frameCount ֡ RenderScene CPUʱͳ
+	// workerCounts ΪʱеĹ߳ϵͳ frameCount ֻ֡ÿ߳¼ƺʱ
+	// compareDescriptorTableCache Ϊʱֱرպʹ frameCount ֡ύʱ
+	void RunHeadless(IGameApp& app, uint32_t frameCount, const std::vector<uint32_t>& workerCounts = std::vector<uint32_t>(),
+		bool compareDescriptorTableCache = false);
 }
\ No newline at end of file
@@ -69,6 +69,7 @@ void ContextManager::FreeContext(CommandContext* UsedContext)
 void CommandContext::DestroyAllContexts(void)
 {
     LinearAllocator::DestroyAll();
+    UploadRingAllocator::DestroyAll();
     DynamicDescriptorHeap::DestroyAll();
     g_ContextManager.DestroyAllContexts();
 }
@@ -77,6 +78,7 @@ CommandContext& CommandContext::Begin( const std::wstring ID )
 {
     CommandContext* NewContext = g_ContextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_DIRECT);
     NewContext->SetID(ID);
+    NewContext->m_StateTracker.SetResolveOnFirstUse(true);
     if (ID.length() > 0)
         EngineProfiling::BeginBlock(ID, NewContext);
     return *NewContext;
@@ -84,11 +86,13 @@ CommandContext& CommandContext::Begin( const std::wstring ID )
 
 uint64_t CommandContext::Flush(bool WaitForCompletion)
 {
+    m_StateTracker.EndSplitTransitions();
     FlushResourceBarriers();
 
     ASSERT(m_CurrentAllocator != nullptr);
 
-    uint64_t FenceValue = g_CommandManager.GetQueue(m_Type).ExecuteCommandList(m_CommandList);
+    CommandContext* Self = this;
+    uint64_t FenceValue = ExecuteResolved(&Self, 1);
 
     if (WaitForCompletion)
         g_CommandManager.WaitForFence(FenceValue);
@@ -98,6 +102,7 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
     //
 
     m_CommandList->Reset(m_CurrentAllocator, nullptr);
+    InvalidateInputAssembler();
 
     if (m_CurGraphicsRootSignature)
     {
@@ -117,30 +122,110 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
 
 uint64_t CommandContext::Finish( bool WaitForCompletion )
 {
-    ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+    CommandContext* Self = this;
+    return FinishBatch(&Self, 1, WaitForCompletion);
+}
 
-    FlushResourceBarriers();
+uint64_t CommandContext::FinishBatch( CommandContext* const* Contexts, UINT Count, bool WaitForCompletion )
+{
+    ASSERT(Count > 0 && Count <= kMaxBatchContexts);
 
-    if (m_ID.length() > 0)
-        EngineProfiling::EndBlock(this);
+    D3D12_COMMAND_LIST_TYPE Type = Contexts[0]->m_Type;
+    ASSERT(Type == D3D12_COMMAND_LIST_TYPE_DIRECT || Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
 
-    ASSERT(m_CurrentAllocator != nullptr);
+    for (UINT i = 0; i < Count; ++i)
+    {
+        CommandContext* Context = Contexts[i];
+        ASSERT(Context->m_Type == Type, "All contexts in a batch must share one queue");
+        ASSERT(Context->m_CurrentAllocator != nullptr);
 
-    CommandQueue& Queue = g_CommandManager.GetQueue(m_Type);
+        Context->m_StateTracker.EndSplitTransitions();
+        Context->FlushResourceBarriers();
+    }
 
-    uint64_t FenceValue = Queue.ExecuteCommandList(m_CommandList);
-    Queue.DiscardAllocator(FenceValue, m_CurrentAllocator);
-    m_CurrentAllocator = nullptr;
+    // ʱǶ׵ģʼ෴˳
+    for (UINT i = Count; i-- > 0; )
+    {
+        if (Contexts[i]->m_ID.length() > 0)
+            EngineProfiling::EndBlock(Contexts[i]);
+    }
 
-    m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
-    m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
-    m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
-    m_DynamicSamplerDescriptorHeap.CleanupUsedHeaps(FenceValue);
+    CommandQueue& Queue = g_CommandManager.GetQueue(Type);
+
+    uint64_t FenceValue = ExecuteResolved(Contexts, Count);
+
+    for (UINT i = 0; i < Count; ++i)
+    {
+        CommandContext* Context = Contexts[i];
+        Queue.DiscardAllocator(FenceValue, Context->m_CurrentAllocator);
+        Context->m_CurrentAllocator = nullptr;
+
+        Context->m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
+        Context->m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
+        Context->m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
+        Context->m_DynamicSamplerDescriptorHeap.CleanupUsedHeaps(FenceValue);
+    }
 
     if (WaitForCompletion)
         g_CommandManager.WaitForFence(FenceValue);
 
-    g_ContextManager.FreeContext(this);
+    for (UINT i = 0; i < Count; ++i)
+        g_ContextManager.FreeContext(Contexts[i]);
+
+    return FenceValue;
+}
+
+uint64_t CommandContext::ExecuteResolved( CommandContext* const* Contexts, UINT Count )
+{
+    D3D12_COMMAND_LIST_TYPE Type = Contexts[0]->m_Type;
+    CommandQueue& Queue = g_CommandManager.GetQueue(Type);
+
+    ID3D12CommandList* Lists[kMaxBatchContexts + 1];
+    UINT ListCount = 0;
+    CommandContext* FixupContext = nullptr;
+    uint64_t FenceValue;
+
+    {
+        // Ӷȫ״̬ ExecuteCommandLists ֮䲻бύȫ״̬GPUִ˳Բ
+        std::lock_guard<std::mutex> LockGuard(ResourceStateTracker::GetSubmissionMutex());
+
+        // ֻʹ
+        static std::vector<D3D12_RESOURCE_BARRIER> s_Fixups;
+
+        for (UINT i = 0; i < Count; ++i)
+        {
+            s_Fixups.clear();
+            Contexts[i]->m_StateTracker.ResolvePendingStates(s_Fixups);
+
+            if (!s_Fixups.empty())
+            {
+                // ֻ״ʹָ֮״̬ʱŻߵ
+                // ֻεĵһӳٽʱҪб
+                if (i == 0)
+                {
+                    FixupContext = g_ContextManager.AllocateContext(Type);
+                    FixupContext->m_CommandList->ResourceBarrier((UINT)s_Fixups.size(), s_Fixups.data());
+                    Lists[ListCount++] = FixupContext->m_CommandList;
+                    ResourceStateTracker::AddFixupListStat();
+                }
+                else
+                {
+                    Contexts[i - 1]->m_CommandList->ResourceBarrier((UINT)s_Fixups.size(), s_Fixups.data());
+                }
+            }
+
+            Lists[ListCount++] = Contexts[i]->m_CommandList;
+        }
+
+        FenceValue = Queue.ExecuteCommandLists(ListCount, Lists);
+    }
+
+    if (FixupContext != nullptr)
+    {
+        Queue.DiscardAllocator(FenceValue, FixupContext->m_CurrentAllocator);
+        FixupContext->m_CurrentAllocator = nullptr;
+        g_ContextManager.FreeContext(FixupContext);
+    }
 
     return FenceValue;
 }
@@ -149,7 +234,7 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_Type(Type),
     m_DynamicViewDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
     m_DynamicSamplerDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER),
-    m_CpuLinearAllocator(kCpuWritable),
+    m_CpuLinearAllocator(),
     m_GpuLinearAllocator(kGpuExclusive)
 {
     m_OwningManager = nullptr;
@@ -161,7 +246,7 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_CurGraphicsPipelineState = nullptr;
     m_CurComputeRootSignature = nullptr;
     m_CurComputePipelineState = nullptr;
-    m_NumBarriersToFlush = 0;
+    InvalidateInputAssembler();
 }
 
 CommandContext::~CommandContext( void )
@@ -187,11 +272,20 @@ void CommandContext::Reset( void )
     m_CurGraphicsPipelineState = nullptr;
     m_CurComputeRootSignature = nullptr;
     m_CurComputePipelineState = nullptr;
-    m_NumBarriersToFlush = 0;
+    InvalidateInputAssembler();
+    m_StateTracker.Reset();
 
     BindDescriptorHeaps();
 }
 
+void CommandContext::InvalidateInputAssembler( void )
+{
+    // ɲᱻõֵ
+    memset(&m_CurPrimitiveTopology, 0xFF, sizeof(m_CurPrimitiveTopology));
+    memset(&m_CurIndexBuffer, 0xFF, sizeof(m_CurIndexBuffer));
+    memset(m_CurVertexBuffers, 0xFF, sizeof(m_CurVertexBuffers));
+}
+
 void CommandContext::BindDescriptorHeaps( void )
 {
     UINT NonNullHeaps = 0;
@@ -236,6 +330,8 @@ void CommandContext::InitializeTexture(GpuResource& Dest, UINT NumSubresources,
 
     // copy data to the intermediate upload heap and then schedule a copy from the upload heap to the default texture
     DynAlloc mem = InitContext.ReserveUploadMemory(uploadBufferSize);
+    // ¼ƿ֮ǰҪڱתύʱϻŵǰ
+    InitContext.TransitionResource(Dest, D3D12_RESOURCE_STATE_COPY_DEST, true);
     UpdateSubresources(InitContext.m_CommandList, Dest.GetResource(), mem.Buffer.GetResource(), 0, 0, NumSubresources, SubData);
     InitContext.TransitionResource(Dest, D3D12_RESOURCE_STATE_GENERIC_READ);
 
@@ -338,77 +434,40 @@ void CommandContext::FillBuffer(GpuResource & Dest, size_t DestOffset, DWParam V
 
 void CommandContext::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
-    D3D12_RESOURCE_STATES OldState = Resource.m_UsageState;
-
     if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
-    {
-        ASSERT((OldState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == OldState);
         ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
-    }
 
-    if (OldState != NewState)
-    {
-        ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+    m_StateTracker.TransitionResource(Resource, NewState);
 
-        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        BarrierDesc.Transition.pResource = Resource.GetResource();
-        BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-        BarrierDesc.Transition.StateBefore = OldState;
-        BarrierDesc.Transition.StateAfter = NewState;
+    if (FlushImmediate)
+        FlushResourceBarriers();
+}
 
-        // Check to see if we already started the transition
-        if (NewState == Resource.m_TransitioningState)
-        {
-            BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-            Resource.m_TransitioningState = (D3D12_RESOURCE_STATES)-1;
-        }
-        else
-            BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+void CommandContext::TransitionSubresource(GpuResource& Resource, UINT Subresource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
+{
+    if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
+        ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
 
-        Resource.m_UsageState = NewState;
-    }
+    m_StateTracker.TransitionResource(Resource, NewState, Subresource);
 
-    if (FlushImmediate || m_NumBarriersToFlush == 16)
+    if (FlushImmediate)
         FlushResourceBarriers();
 }
 
 void CommandContext::BeginResourceTransition(GpuResource & Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
-    // If it's already transitioning, finish that transition
-    if (Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1)
-        TransitionResource(Resource, Resource.m_TransitioningState);
-
-    D3D12_RESOURCE_STATES OldState = Resource.m_UsageState;
-
-    if (OldState != NewState)
-    {
-        ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        BarrierDesc.Transition.pResource = Resource.GetResource();
-        BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-        BarrierDesc.Transition.StateBefore = OldState;
-        BarrierDesc.Transition.StateAfter = NewState;
-
-        BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
+        ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
 
-        Resource.m_TransitioningState = NewState;
-    }
+    m_StateTracker.BeginResourceTransition(Resource, NewState);
 
-    if (FlushImmediate || m_NumBarriersToFlush == 16)
+    if (FlushImmediate)
         FlushResourceBarriers();
 }
 
 void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate)
 {
-    ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-    D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-    BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    BarrierDesc.UAV.pResource = Resource.GetResource();
+    m_StateTracker.InsertUAVBarrier(Resource);
 
     if (FlushImmediate)
         FlushResourceBarriers();
@@ -416,13 +475,7 @@ void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate
 
 void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate)
 {
-    ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-    D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
-    BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    BarrierDesc.Aliasing.pResourceBefore = Before.GetResource();
-    BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
+    m_StateTracker.InsertAliasBarrier(Before, After);
 
     if (FlushImmediate)
         FlushResourceBarriers();
@@ -465,6 +518,7 @@ void GraphicsContext::SetRenderTargets(UINT NumRTVs, const D3D12_CPU_DESCRIPTOR_
 
 void GraphicsContext::ClearUAV(GpuBuffer& Target)
 {
+    FlushResourceBarriers();
     // After binding a UAV, we can get a GPU handle that is required to clear it as a UAV (because it essentially runs
     // a shader to set all of the values).
     D3D12_GPU_DESCRIPTOR_HANDLE GpuVisibleHandle = m_DynamicViewDescriptorHeap.UploadDirect(Target.GetUAV());
@@ -474,6 +528,7 @@ void GraphicsContext::ClearUAV(GpuBuffer& Target)
 
 void GraphicsContext::ClearUAV(ColorBuffer& Target)
 {
+    FlushResourceBarriers();
     // After binding a UAV, we can get a GPU handle that is required to clear it as a UAV (because it essentially runs
     // a shader to set all of the values).
     D3D12_GPU_DESCRIPTOR_HANDLE GpuVisibleHandle = m_DynamicViewDescriptorHeap.UploadDirect(Target.GetUAV());
@@ -486,27 +541,37 @@ void GraphicsContext::ClearUAV(ColorBuffer& Target)
 
 void GraphicsContext::ClearColor( ColorBuffer& Target )
 {
+    FlushResourceBarriers();
     m_CommandList->ClearRenderTargetView(Target.GetRTV(), Target.GetClearColor().GetPtr(), 0, nullptr);
 }
 
 void GraphicsContext::ClearColor(ColorCubeBuffer& Target)
 {
     for (int i = 0; i < 6; ++i)
-        m_CommandList->ClearRenderTargetView(Target.GetRTV(i), Target.GetClearColor().GetPtr(), 0, nullptr);
+        ClearColor(Target, i);
+}
+
+void GraphicsContext::ClearColor(ColorCubeBuffer& Target, int Face)
+{
+    FlushResourceBarriers();
+    m_CommandList->ClearRenderTargetView(Target.GetRTV(Face), Target.GetClearColor().GetPtr(), 0, nullptr);
 }
 
 void GraphicsContext::ClearDepth( DepthBuffer& Target )
 {
+    FlushResourceBarriers();
     m_CommandList->ClearDepthStencilView(Target.GetDSV(), D3D12_CLEAR_FLAG_DEPTH, Target.GetClearDepth(), Target.GetClearStencil(), 0, nullptr );
 }
 
 void GraphicsContext::ClearStencil( DepthBuffer& Target )
 {
+    FlushResourceBarriers();
     m_CommandList->ClearDepthStencilView(Target.GetDSV(), D3D12_CLEAR_FLAG_STENCIL, Target.GetClearDepth(), Target.GetClearStencil(), 0, nullptr);
 }
 
 void GraphicsContext::ClearDepthAndStencil( DepthBuffer& Target )
 {
+    FlushResourceBarriers();
     m_CommandList->ClearDepthStencilView(Target.GetDSV(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, Target.GetClearDepth(), Target.GetClearStencil(), 0, nullptr);
 }
 
@@ -569,7 +634,7 @@ void GraphicsContext::SetDynamicVB(UINT Slot, size_t NumVertices, size_t VertexS
     VBView.SizeInBytes = (UINT)BufferSize;
     VBView.StrideInBytes = (UINT)VertexStride;
 
-    m_CommandList->IASetVertexBuffers(Slot, 1, &VBView);
+    SetVertexBuffer(Slot, VBView);
 }
 
 inline void GraphicsContext::SetDynamicIB(size_t IndexCount, const uint16_t * IndexData)
@@ -586,7 +651,7 @@ inline void GraphicsContext::SetDynamicIB(size_t IndexCount, const uint16_t * In
     IBView.SizeInBytes = (UINT)(IndexCount * sizeof(uint16_t));
     IBView.Format = DXGI_FORMAT_R16_UINT;
 
-    m_CommandList->IASetIndexBuffer(&IBView);
+    SetIndexBuffer(IBView);
 }
 
 
@@ -603,6 +668,7 @@ ComputeContext& ComputeContext::Begin(const std::wstring& ID, bool Async)
 
 void ComputeContext::ClearUAV(GpuBuffer& Target)
 {
+    FlushResourceBarriers();
     // After binding a UAV, we can get a GPU handle that is required to clear it as a UAV (because it essentially runs
     // a shader to set all of the values).
     D3D12_GPU_DESCRIPTOR_HANDLE GpuVisibleHandle = m_DynamicViewDescriptorHeap.UploadDirect(Target.GetUAV());
@@ -612,6 +678,7 @@ void ComputeContext::ClearUAV(GpuBuffer& Target)
 
 void ComputeContext::ClearUAV(ColorBuffer& Target)
 {
+    FlushResourceBarriers();
     // After binding a UAV, we can get a GPU handle that is required to clear it as a UAV (because it essentially runs
     // a shader to set all of the values).
     D3D12_GPU_DESCRIPTOR_HANDLE GpuVisibleHandle = m_DynamicViewDescriptorHeap.UploadDirect(Target.GetUAV());
@@ -23,7 +23,9 @@
 #include "PixelBuffer.h"
 #include "DynamicDescriptorHeap.h"
 #include "LinearAllocator.h"
+#include "UploadRing.h"
 #include "CommandSignature.h"
+#include "ResourceStateTracker.h"
 #include "GraphicsCore.h"
 #include <vector>
 
@@ -96,15 +98,24 @@ public:
     // ݻ
     static void DestroyAllContexts(void);
 
-    // ʼһ
+    // ʼһԴһʹʱȫ״̬
     static CommandContext& Begin(const std::wstring ID = L"");
 
+    // ΪύʱŽԴʼ״̬ںĲ¼ơ FinishBatch һύ
+    // Ҫ¼κת֮ǰ
+    void DeferStateResolution( void ) { m_StateTracker.SetResolveOnFirstUse(false); }
+
     // Flush existing commands to the GPU but keep the context alive
     uint64_t Flush( bool WaitForCompletion = false );
 
     // Flush existing commands and release the current context
     uint64_t Finish( bool WaitForCompletion = false );
 
+    // Ѷͬ͵İ˳һ ExecuteCommandLists ύȻȫͷţعõΧֵ
+    // Ŀڲͬ߳С˳¼ƣԴ״̬˳Ҫ¼ƽ֮
+    static const UINT kMaxBatchContexts = 32;
+    static uint64_t FinishBatch( CommandContext* const* Contexts, UINT Count, bool WaitForCompletion = false );
+
     // Prepare to render by reserving a command list and command allocator
     void Initialize(void);
 
@@ -147,12 +158,15 @@ public:
     // 䵽DestԴ
     void FillBuffer(GpuResource& Dest, size_t DestOffset, DWParam Value, size_t NumBytes);
 
-    // ޸һԴ״̬
+    // ޸һԴ״̬״ֻ̬¼ڱύʱٺԴȫ״̬˶( ResourceStateTracker)
     void TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
+    void TransitionSubresource(GpuResource& Resource, UINT Subresource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
+    // ϣ֮ TransitionResource תͬһ״̬ʱ
     void BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
     void InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate = false);
     void InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate = false);
     // ޸Դ״̬ʵǷһУǰԴ״̬޸ֱӷ͸gpu
+    // ơɡ֮ǰԶãгȲ
     inline void FlushResourceBarriers(void);
 
     void InsertTimeStamp(ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx);
@@ -171,6 +185,13 @@ protected:
 
     void BindDescriptorHeaps( void );
 
+    // ύڰ˳ĵԴ״̬ύϷǰһбĩβ
+    // һĵϷڶбִ
+    static uint64_t ExecuteResolved( CommandContext* const* Contexts, UINT Count );
+
+    // бResetIA״̬صĬֵҲҪ
+    void InvalidateInputAssembler( void );
+
     CommandListManager* m_OwningManager;
     ID3D12GraphicsCommandList* m_CommandList;
     ID3D12CommandAllocator* m_CurrentAllocator;
@@ -180,15 +201,20 @@ protected:
     ID3D12RootSignature* m_CurComputeRootSignature;
     ID3D12PipelineState* m_CurComputePipelineState;
 
+    // õIA״̬֮ͬòдб
+    static const UINT kCachedVertexBuffers = 4;
+    D3D12_PRIMITIVE_TOPOLOGY m_CurPrimitiveTopology;
+    D3D12_INDEX_BUFFER_VIEW m_CurIndexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW m_CurVertexBuffers[kCachedVertexBuffers];
+
     DynamicDescriptorHeap m_DynamicViewDescriptorHeap;        // HEAP_TYPE_CBV_SRV_UAV
     DynamicDescriptorHeap m_DynamicSamplerDescriptorHeap;    // HEAP_TYPE_SAMPLER
 
-    D3D12_RESOURCE_BARRIER m_ResourceBarrierBuffer[16];
-    UINT m_NumBarriersToFlush;
+    ResourceStateTracker m_StateTracker;
 
     ID3D12DescriptorHeap* m_CurrentDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
-    LinearAllocator m_CpuLinearAllocator;
+    UploadRingAllocator m_CpuLinearAllocator;
     LinearAllocator m_GpuLinearAllocator;
 
     std::wstring m_ID;
@@ -211,6 +237,7 @@ public:
     void ClearUAV(ColorBuffer& Target);
     void ClearColor( ColorBuffer& Target );
     void ClearColor(ColorCubeBuffer& Target);
+    void ClearColor(ColorCubeBuffer& Target, int Face);
     void ClearDepth( DepthBuffer& Target );
     void ClearStencil( DepthBuffer& Target );
     void ClearDepthAndStencil( DepthBuffer& Target );
@@ -250,6 +277,7 @@ public:
     void SetConstants(UINT RootIndex, DWParam X, DWParam Y, DWParam Z, DWParam W);
     void SetConstantBuffer(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS CBV);
     void SetDynamicConstantBufferView(UINT RootIndex, size_t BufferSize, const void* BufferData);
+    void SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV);
     void SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0);
     void SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset = 0);
     void SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle);
@@ -362,11 +390,7 @@ inline void CommandContext::ResetCounter(StructuredBuffer& Buf, uint32_t Value)
 
 inline void CommandContext::FlushResourceBarriers( void )
 {
-    if (m_NumBarriersToFlush > 0)
-    {
-        m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-        m_NumBarriersToFlush = 0;
-    }
+    m_StateTracker.FlushBarriers(m_CommandList);
 }
 
 inline void CommandContext::InsertTimeStamp(ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx)
@@ -445,7 +469,10 @@ inline void GraphicsContext::SetBlendFactor(Color BlendFactor)
 
 inline void GraphicsContext::SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology)
 {
-    m_CommandList->IASetPrimitiveTopology(Topology);
+    if (Topology == m_CurPrimitiveTopology)
+        return;
+
+    m_CommandList->IASetPrimitiveTopology(m_CurPrimitiveTopology = Topology);
 }
 
 inline void GraphicsContext::SetPipelineState(const GraphicsPSO& PSO)
@@ -508,15 +535,20 @@ inline void GraphicsContext::SetDynamicConstantBufferView(UINT RootIndex, size_t
     m_CommandList->SetGraphicsRootConstantBufferView(RootIndex, cb.GpuAddress);
 }
 
+inline void GraphicsContext::SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV)
+{
+    m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV);
+}
+
 inline void GraphicsContext::SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
-    ASSERT((SRV.m_UsageState & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
+    ASSERT((m_StateTracker.GetState(SRV) & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
     m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void GraphicsContext::SetBufferUAV(UINT RootIndex, const GpuBuffer & UAV, UINT64 Offset)
 {
-    ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+    ASSERT((m_StateTracker.GetState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
     m_CommandList->SetGraphicsRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
@@ -546,6 +578,10 @@ inline void GraphicsContext::SetDynamicSamplers(UINT RootIndex, UINT Offset, UIN
 
 inline void GraphicsContext::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& IBView)
 {
+    if (memcmp(&IBView, &m_CurIndexBuffer, sizeof(IBView)) == 0)
+        return;
+
+    m_CurIndexBuffer = IBView;
     m_CommandList->IASetIndexBuffer(&IBView);
 }
 
@@ -556,6 +592,20 @@ inline void GraphicsContext::SetVertexBuffer(UINT Slot, const D3D12_VERTEX_BUFFE
 
 inline void GraphicsContext::SetVertexBuffers(UINT StartSlot, UINT Count, const D3D12_VERTEX_BUFFER_VIEW VBViews[])
 {
+    // ֻȫڻλڵ
+    if (StartSlot + Count <= kCachedVertexBuffers)
+    {
+        if (memcmp(VBViews, m_CurVertexBuffers + StartSlot, Count * sizeof(D3D12_VERTEX_BUFFER_VIEW)) == 0)
+            return;
+
+        memcpy(m_CurVertexBuffers + StartSlot, VBViews, Count * sizeof(D3D12_VERTEX_BUFFER_VIEW));
+    }
+    else
+    {
+        for (UINT Slot = StartSlot; Slot < kCachedVertexBuffers; ++Slot)
+            m_CurVertexBuffers[Slot] = VBViews[Slot - StartSlot];
+    }
+
     m_CommandList->IASetVertexBuffers(StartSlot, Count, VBViews);
 }
 
@@ -682,13 +732,13 @@ inline void ComputeContext::SetDynamicSRV(UINT RootIndex, size_t BufferSize, con
 
 inline void ComputeContext::SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
-    ASSERT((SRV.m_UsageState & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
+    ASSERT((m_StateTracker.GetState(SRV) & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
     m_CommandList->SetComputeRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void ComputeContext::SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset)
 {
-    ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+    ASSERT((m_StateTracker.GetState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
     m_CommandList->SetComputeRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
@@ -79,14 +79,20 @@ void CommandQueue::Create(ID3D12Device* pDevice)
 }
 
 uint64_t CommandQueue::ExecuteCommandList( ID3D12CommandList* List )
+{
+    return ExecuteCommandLists(1, &List);
+}
+
+uint64_t CommandQueue::ExecuteCommandLists( UINT Count, ID3D12CommandList* const* Lists )
 {
     std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
 
-    ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)List)->Close());
+    for (UINT i = 0; i < Count; ++i)
+        ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)Lists[i])->Close());
 
 	// listеgpu
     // Kickoff the command list
-    m_CommandQueue->ExecuteCommandLists(1, &List);
+    m_CommandQueue->ExecuteCommandLists(Count, Lists);
 
 	// ൱ڸgpuһضΧֵListִнִһm_pFenceµΧֵ
 	// ݳʼԿ3ֶУÿʼΧֵǲͬ
@@ -30,6 +30,7 @@ class CommandQueue
 {
     friend class CommandListManager;
     friend class CommandContext;
+    friend class TextureStreamer;
 
 public:
     CommandQueue(D3D12_COMMAND_LIST_TYPE Type);
@@ -64,6 +65,8 @@ public:
 private:
 	// бݲgpu
     uint64_t ExecuteCommandList(ID3D12CommandList* List);
+    // رնб˳һύعõΧֵ
+    uint64_t ExecuteCommandLists(UINT Count, ID3D12CommandList* const* Lists);
 	// һõĸе
     ID3D12CommandAllocator* RequestAllocator(void);
 	// һִExecuteCommandList󣬲һΧֵñ¼key
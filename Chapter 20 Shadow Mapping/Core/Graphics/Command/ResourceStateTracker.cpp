@@ -0,0 +1,751 @@
+#include "pch.h"
+#include "ResourceStateTracker.h"
+#include "GpuResource.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "NullDevice.h"
+
+using Microsoft::WRL::ComPtr;
+
+std::mutex ResourceStateTracker::sm_SubmissionMutex;
+std::atomic<uint64_t> ResourceStateTracker::sm_Stats[ResourceStateTracker::kStatCount];
+
+namespace
+{
+    // Ƿ漰ԴָUAV/漰Դ
+    bool BarrierTouches( const D3D12_RESOURCE_BARRIER& Barrier, ID3D12Resource* Resource )
+    {
+        switch (Barrier.Type)
+        {
+        case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+            return Barrier.Transition.pResource == Resource;
+        case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            return Barrier.UAV.pResource == nullptr || Barrier.UAV.pResource == Resource;
+        default:
+            return Barrier.Aliasing.pResourceBefore == nullptr || Barrier.Aliasing.pResourceAfter == nullptr ||
+                Barrier.Aliasing.pResourceBefore == Resource || Barrier.Aliasing.pResourceAfter == Resource;
+        }
+    }
+
+    D3D12_RESOURCE_BARRIER MakeTransition( ID3D12Resource* Resource, UINT Subresource, D3D12_RESOURCE_STATES Before,
+        D3D12_RESOURCE_STATES After, D3D12_RESOURCE_BARRIER_FLAGS Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE )
+    {
+        D3D12_RESOURCE_BARRIER Barrier;
+        Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        Barrier.Flags = Flags;
+        Barrier.Transition.pResource = Resource;
+        Barrier.Transition.Subresource = Subresource;
+        Barrier.Transition.StateBefore = Before;
+        Barrier.Transition.StateAfter = After;
+        return Barrier;
+    }
+}
+
+void ResourceStateTracker::StateSet::Set( UINT Subresource, D3D12_RESOURCE_STATES State, UINT SubresourceCount )
+{
+    if (IsUniform())
+    {
+        if (Uniform == State)
+            return;
+        PerSubresource.assign(SubresourceCount, Uniform);
+    }
+
+    PerSubresource[Subresource] = State;
+
+    // Դһʱ˻ص Uniform
+    for (D3D12_RESOURCE_STATES Other : PerSubresource)
+    {
+        if (Other != State)
+            return;
+    }
+    SetAll(State);
+}
+
+ResourceStateTracker::ResourceStateTracker() : m_ResolveOnFirstUse(false)
+{
+    ZeroMemory(m_Stats, sizeof(m_Stats));
+}
+
+ResourceStateTracker::TrackedResource& ResourceStateTracker::Track( GpuResource& Resource )
+{
+    auto Result = m_Resources.emplace(&Resource, TrackedResource());
+    TrackedResource& Tracked = Result.first->second;
+    if (Result.second)
+    {
+        Tracked.SubresourceCount = 0;
+        Tracked.SplitBefore = kUnknownState;
+        Tracked.SplitAfter = kUnknownState;
+    }
+    return Tracked;
+}
+
+UINT ResourceStateTracker::GetSubresourceCount( GpuResource& Resource, TrackedResource& Tracked )
+{
+    if (Tracked.SubresourceCount == 0)
+    {
+        D3D12_RESOURCE_DESC Desc = Resource->GetDesc();
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            Tracked.SubresourceCount = 1;
+        else if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+            Tracked.SubresourceCount = Desc.MipLevels;
+        else
+            Tracked.SubresourceCount = Desc.MipLevels * Desc.DepthOrArraySize;
+    }
+    return Tracked.SubresourceCount;
+}
+
+void ResourceStateTracker::TransitionResource( GpuResource& Resource, D3D12_RESOURCE_STATES NewState, UINT Subresource )
+{
+    ++m_Stats[kTransitions];
+
+    TrackedResource& Tracked = Track(Resource);
+
+    // ڲתʱתĿ״̬ǽת״̬ҪȽ
+    if (Tracked.SplitAfter != kUnknownState)
+    {
+        bool Completes = Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && NewState == Tracked.SplitAfter;
+        EndSplit(Resource, Tracked);
+        if (Completes)
+            return;
+    }
+
+    if (Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        UINT Count = GetSubresourceCount(Resource, Tracked);
+        ASSERT(Subresource < Count);
+        TransitionSubresource(Resource, Tracked, Subresource, NewState);
+    }
+    else if (!Tracked.Current.IsUniform())
+    {
+        // Դ״̬һ£ֻת
+        UINT Count = GetSubresourceCount(Resource, Tracked);
+        for (UINT i = 0; i < Count; ++i)
+            TransitionSubresource(Resource, Tracked, i, NewState);
+    }
+    else
+    {
+        TransitionSubresource(Resource, Tracked, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, NewState);
+    }
+}
+
+bool ResourceStateTracker::ReadGlobalState( const GpuResource& Resource, UINT Subresource, D3D12_RESOURCE_STATES& State )
+{
+    std::lock_guard<std::mutex> LockGuard(sm_SubmissionMutex);
+    if (Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !Resource.m_SubresourceStates.empty())
+        return false;
+
+    State = GetGlobalState(Resource, Subresource);
+    return true;
+}
+
+void ResourceStateTracker::TransitionSubresource( GpuResource& Resource, TrackedResource& Tracked, UINT Subresource, D3D12_RESOURCE_STATES NewState )
+{
+    const bool AllSubresources = Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    D3D12_RESOURCE_STATES OldState = AllSubresources ? Tracked.Current.Uniform : Tracked.Current.Get(Subresource);
+
+    if (OldState == kUnknownState && m_ResolveOnFirstUse)
+    {
+        // һʹãڵȫ״̬¼ʱͷϣύʱȫ״̬ûĸĹͲҪ
+        if (!ReadGlobalState(Resource, Subresource, OldState))
+        {
+            // ȫ״̬Դһ£ת
+            UINT Count = GetSubresourceCount(Resource, Tracked);
+            for (UINT i = 0; i < Count; ++i)
+                TransitionSubresource(Resource, Tracked, i, NewState);
+            return;
+        }
+
+        if (AllSubresources)
+        {
+            Tracked.Pending.SetAll(OldState);
+            Tracked.Current.SetAll(OldState);
+        }
+        else
+        {
+            Tracked.Pending.Set(Subresource, OldState, Tracked.SubresourceCount);
+            Tracked.Current.Set(Subresource, OldState, Tracked.SubresourceCount);
+        }
+    }
+
+    if (OldState == NewState)
+    {
+        ++m_Stats[kRedundant];
+        return;
+    }
+
+    if (OldState == kUnknownState)
+    {
+        // һʹãύʱٺȫ״̬Ƚ
+        if (AllSubresources)
+            Tracked.Pending.SetAll(NewState);
+        else
+            Tracked.Pending.Set(Subresource, NewState, Tracked.SubresourceCount);
+    }
+    else
+    {
+        AddTransition(Resource.GetResource(), Subresource, OldState, NewState);
+    }
+
+    if (AllSubresources)
+        Tracked.Current.SetAll(NewState);
+    else
+        Tracked.Current.Set(Subresource, NewState, Tracked.SubresourceCount);
+}
+
+void ResourceStateTracker::BeginResourceTransition( GpuResource& Resource, D3D12_RESOURCE_STATES NewState )
+{
+    TrackedResource& Tracked = Track(Resource);
+
+    if (Tracked.SplitAfter != kUnknownState)
+        EndSplit(Resource, Tracked);
+
+    // ʼ״̬δ֪߸Դһʱ
+    if (!Tracked.Current.IsUniform() || Tracked.Current.Uniform == kUnknownState)
+    {
+        TransitionResource(Resource, NewState);
+        return;
+    }
+
+    ++m_Stats[kTransitions];
+
+    if (Tracked.Current.Uniform == NewState)
+    {
+        ++m_Stats[kRedundant];
+        return;
+    }
+
+    AddTransition(Resource.GetResource(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, Tracked.Current.Uniform, NewState,
+        D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    ++m_Stats[kSplitBarriers];
+
+    Tracked.SplitBefore = Tracked.Current.Uniform;
+    Tracked.SplitAfter = NewState;
+}
+
+void ResourceStateTracker::EndSplit( GpuResource& Resource, TrackedResource& Tracked )
+{
+    ID3D12Resource* pResource = Resource.GetResource();
+
+    // BEGIN_ONLY ûȥʱֱӸĳͨ
+    bool StillQueued = false;
+    for (size_t i = m_Barriers.size(); i-- > 0; )
+    {
+        D3D12_RESOURCE_BARRIER& Queued = m_Barriers[i];
+        if (!BarrierTouches(Queued, pResource))
+            continue;
+
+        if (Queued.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && Queued.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+        {
+            Queued.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            --m_Stats[kSplitBarriers];
+            StillQueued = true;
+        }
+        break;
+    }
+
+    if (!StillQueued)
+        AddTransition(pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, Tracked.SplitBefore, Tracked.SplitAfter,
+            D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+
+    Tracked.Current.SetAll(Tracked.SplitAfter);
+    Tracked.SplitBefore = kUnknownState;
+    Tracked.SplitAfter = kUnknownState;
+}
+
+void ResourceStateTracker::EndSplitTransitions( void )
+{
+    for (auto& Entry : m_Resources)
+    {
+        if (Entry.second.SplitAfter != kUnknownState)
+            EndSplit(*Entry.first, Entry.second);
+    }
+}
+
+void ResourceStateTracker::AddTransition( ID3D12Resource* Resource, UINT Subresource, D3D12_RESOURCE_STATES Before,
+    D3D12_RESOURCE_STATES After, D3D12_RESOURCE_BARRIER_FLAGS Flags )
+{
+    if (Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE)
+    {
+        // ӶβԴϣֻͬһԴͨתܺϲмԴϾͲ
+        for (size_t i = m_Barriers.size(); i-- > 0; )
+        {
+            D3D12_RESOURCE_BARRIER& Queued = m_Barriers[i];
+            if (!BarrierTouches(Queued, Resource))
+                continue;
+
+            if (Queued.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && Queued.Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE &&
+                Queued.Transition.Subresource == Subresource)
+            {
+                ASSERT(Queued.Transition.StateAfter == Before);
+                if (Queued.Transition.StateBefore == After)
+                {
+                    m_Barriers.erase(m_Barriers.begin() + i);
+                    m_Stats[kCoalesced] += 2;
+                }
+                else
+                {
+                    Queued.Transition.StateAfter = After;
+                    ++m_Stats[kCoalesced];
+                }
+                return;
+            }
+            break;
+        }
+    }
+
+    m_Barriers.push_back(MakeTransition(Resource, Subresource, Before, After, Flags));
+}
+
+void ResourceStateTracker::InsertUAVBarrier( GpuResource& Resource )
+{
+    D3D12_RESOURCE_BARRIER Barrier;
+    Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    Barrier.UAV.pResource = Resource.GetResource();
+    m_Barriers.push_back(Barrier);
+}
+
+void ResourceStateTracker::InsertAliasBarrier( GpuResource& Before, GpuResource& After )
+{
+    D3D12_RESOURCE_BARRIER Barrier;
+    Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    Barrier.Aliasing.pResourceBefore = Before.GetResource();
+    Barrier.Aliasing.pResourceAfter = After.GetResource();
+    m_Barriers.push_back(Barrier);
+}
+
+void ResourceStateTracker::FlushBarriers( ID3D12GraphicsCommandList* CmdList )
+{
+    if (m_Barriers.empty())
+        return;
+
+    CmdList->ResourceBarrier((UINT)m_Barriers.size(), m_Barriers.data());
+    m_Stats[kBarriersIssued] += m_Barriers.size();
+    ++m_Stats[kBarrierCalls];
+    m_Barriers.clear();
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::GetState( const GpuResource& Resource, UINT Subresource ) const
+{
+    auto It = m_Resources.find(const_cast<GpuResource*>(&Resource));
+    if (It == m_Resources.end())
+        return GetGlobalState(Resource, Subresource);
+
+    const TrackedResource& Tracked = It->second;
+    auto StateOf = [&]( UINT Index )
+    {
+        D3D12_RESOURCE_STATES State = Tracked.Current.Get(Index);
+        return State != kUnknownState ? State : GetGlobalState(Resource, Index);
+    };
+
+    if (Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+        return StateOf(Subresource);
+
+    if (Tracked.Current.IsUniform())
+        return Tracked.Current.Uniform != kUnknownState ? Tracked.Current.Uniform : GetGlobalState(Resource);
+
+    D3D12_RESOURCE_STATES Common = StateOf(0);
+    for (UINT i = 1; i < Tracked.SubresourceCount; ++i)
+        Common = (D3D12_RESOURCE_STATES)(Common & StateOf(i));
+    return Common;
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::GetGlobalState( const GpuResource& Resource, UINT Subresource )
+{
+    const std::vector<D3D12_RESOURCE_STATES>& States = Resource.m_SubresourceStates;
+    if (States.empty())
+        return Resource.m_UsageState;
+
+    if (Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+        return States[Subresource];
+
+    D3D12_RESOURCE_STATES Common = States[0];
+    for (D3D12_RESOURCE_STATES State : States)
+        Common = (D3D12_RESOURCE_STATES)(Common & State);
+    return Common;
+}
+
+void ResourceStateTracker::ResolvePendingStates( std::vector<D3D12_RESOURCE_BARRIER>& Fixups )
+{
+    for (auto& Entry : m_Resources)
+    {
+        GpuResource& Resource = *Entry.first;
+        TrackedResource& Tracked = Entry.second;
+        std::vector<D3D12_RESOURCE_STATES>& Global = Resource.m_SubresourceStates;
+
+        ASSERT(Tracked.SplitAfter == kUnknownState, "Split transitions must end before submission");
+        ASSERT(Global.empty() || Tracked.SubresourceCount == 0 || Global.size() == Tracked.SubresourceCount);
+
+        auto Fixup = [&]( UINT Subresource, D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After )
+        {
+            if (Before == After)
+            {
+                ++m_Stats[kFixupsAvoided];
+                return;
+            }
+            Fixups.push_back(MakeTransition(Resource.GetResource(), Subresource, Before, After));
+            ++m_Stats[kFixups];
+        };
+
+        // ʼ״̬
+        const StateSet& Pending = Tracked.Pending;
+        if (Pending.IsUniform())
+        {
+            if (Pending.Uniform != kUnknownState)
+            {
+                if (Global.empty())
+                    Fixup(D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, Resource.m_UsageState, Pending.Uniform);
+                else
+                {
+                    for (UINT i = 0; i < (UINT)Global.size(); ++i)
+                        Fixup(i, Global[i], Pending.Uniform);
+                }
+            }
+        }
+        else
+        {
+            for (UINT i = 0; i < (UINT)Pending.PerSubresource.size(); ++i)
+            {
+                if (Pending.PerSubresource[i] != kUnknownState)
+                    Fixup(i, Global.empty() ? Resource.m_UsageState : Global[i], Pending.PerSubresource[i]);
+            }
+        }
+
+        // д״̬
+        const StateSet& Current = Tracked.Current;
+        if (Current.IsUniform())
+        {
+            if (Current.Uniform != kUnknownState)
+            {
+                Resource.m_UsageState = Current.Uniform;
+                Global.clear();
+            }
+        }
+        else
+        {
+            if (Global.empty())
+                Global.assign(Current.PerSubresource.size(), Resource.m_UsageState);
+
+            bool Uniform = true;
+            for (UINT i = 0; i < (UINT)Global.size(); ++i)
+            {
+                if (Current.PerSubresource[i] != kUnknownState)
+                    Global[i] = Current.PerSubresource[i];
+                Uniform = Uniform && Global[i] == Global[0];
+            }
+
+            if (Uniform)
+            {
+                Resource.m_UsageState = Global[0];
+                Global.clear();
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < kStatCount; ++i)
+    {
+        if (m_Stats[i] > 0)
+            sm_Stats[i].fetch_add(m_Stats[i], std::memory_order_relaxed);
+    }
+    ZeroMemory(m_Stats, sizeof(m_Stats));
+
+    Reset();
+}
+
+void ResourceStateTracker::Reset( void )
+{
+    m_Barriers.clear();
+    m_Resources.clear();
+}
+
+void ResourceStateTracker::ResetStats( void )
+{
+    for (uint32_t i = 0; i < kStatCount; ++i)
+        sm_Stats[i].store(0, std::memory_order_relaxed);
+}
+
+void ResourceStateTracker::PrintReport( uint64_t FrameCount )
+{
+    double Frames = (double)std::max<uint64_t>(FrameCount, 1);
+    auto PerFrame = [Frames]( Stat S ) { return (double)sm_Stats[S].load() / Frames; };
+
+    double Eliminated = PerFrame(kRedundant) + PerFrame(kCoalesced) + PerFrame(kFixupsAvoided);
+
+    Utility::Printf("Resource barriers: %.1f transitions/frame  %.1f barriers in %.1f calls/frame  %.1f split/frame\n",
+        PerFrame(kTransitions), PerFrame(kBarriersIssued), PerFrame(kBarrierCalls), PerFrame(kSplitBarriers));
+    Utility::Printf("                   %.1f eliminated/frame (%.1f redundant, %.1f coalesced, %.1f resolved without fixup)  %.1f fixups in %.1f extra lists/frame\n",
+        Eliminated, PerFrame(kRedundant), PerFrame(kCoalesced), PerFrame(kFixupsAvoided), PerFrame(kFixups), PerFrame(kFixupLists));
+}
+
+bool ResourceStateTracker::SelfTest( void )
+{
+    if (!Graphics::Initialize(true))
+        return false;
+
+    bool AllPassed = true;
+    auto Report = [&AllPassed]( const char* Name, bool Passed )
+    {
+        Utility::Printf("  %-40s %s\n", Name, Passed ? "ok" : "FAILED");
+        AllPassed = AllPassed && Passed;
+    };
+
+    Utility::Printf("Resource state tracker self test\n");
+
+    const D3D12_RESOURCE_STATES RT = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    const D3D12_RESOURCE_STATES SRV = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    const D3D12_RESOURCE_STATES CopyDest = D3D12_RESOURCE_STATE_COPY_DEST;
+    const D3D12_RESOURCE_STATES CopySource = D3D12_RESOURCE_STATE_COPY_SOURCE;
+
+    {
+        // 豸ϵʼΪ COMMON
+        auto CreateTexture = []( UINT16 MipLevels )
+        {
+            ComPtr<ID3D12Resource> Resource;
+            CD3DX12_HEAP_PROPERTIES HeapProps(D3D12_HEAP_TYPE_DEFAULT);
+            CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, MipLevels, 1, 0,
+                D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+            ASSERT_SUCCEEDED(Graphics::g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &Desc,
+                D3D12_RESOURCE_STATE_COMMON, nullptr, MY_IID_PPV_ARGS(&Resource)));
+            return GpuResource(Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+        };
+
+        auto IsTransition = []( const D3D12_RESOURCE_BARRIER& Barrier, D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After,
+            D3D12_RESOURCE_BARRIER_FLAGS Flags, UINT Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES )
+        {
+            return Barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && Barrier.Flags == Flags &&
+                Barrier.Transition.StateBefore == Before && Barrier.Transition.StateAfter == After &&
+                Barrier.Transition.Subresource == Subresource;
+        };
+
+        std::vector<D3D12_RESOURCE_BARRIER> Fixups;
+
+        // һתֻ¼ʼ״̬ظת
+        {
+            GpuResource A = CreateTexture(1);
+            ResourceStateTracker Tracker;
+            Tracker.TransitionResource(A, RT);
+            bool Passed = Tracker.GetQueuedBarrierCount() == 0 && Tracker.GetState(A) == RT;
+            Tracker.TransitionResource(A, RT);
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 0 && Tracker.GetStat(kRedundant) == 1;
+            Report("first use deferred, redundant dropped", Passed);
+
+            // A->BB->C ϲ A->C
+            Tracker.TransitionResource(A, SRV);
+            Tracker.TransitionResource(A, CopySource);
+            Passed = Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], RT, CopySource, D3D12_RESOURCE_BARRIER_FLAG_NONE) &&
+                Tracker.GetStat(kCoalesced) == 1;
+            Report("A->B->C coalesced into A->C", Passed);
+
+            // صԭ״̬ʱ϶Ҫ
+            Tracker.TransitionResource(A, RT);
+            Passed = Tracker.GetQueuedBarrierCount() == 0 && Tracker.GetStat(kCoalesced) == 3;
+            Report("A->B->A cancelled", Passed);
+
+            // UAVϸʱܺϲ
+            Tracker.TransitionResource(A, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            Tracker.InsertUAVBarrier(A);
+            Tracker.TransitionResource(A, RT);
+            Report("no coalescing across a UAV barrier", Tracker.GetQueuedBarrierCount() == 3);
+            Tracker.Reset();
+        }
+
+        // 16һε﷢
+        {
+            const UINT kResourceCount = 40;
+            std::vector<GpuResource> Resources;
+            Resources.reserve(kResourceCount);
+            for (UINT i = 0; i < kResourceCount; ++i)
+                Resources.push_back(CreateTexture(1));
+
+            ResourceStateTracker Tracker;
+            for (GpuResource& Resource : Resources)
+                Tracker.TransitionResource(Resource, RT);
+            for (GpuResource& Resource : Resources)
+                Tracker.TransitionResource(Resource, SRV);
+
+            NullDevice::Counters Before = NullDevice::GetCounters();
+            CommandContext& Context = CommandContext::Begin();
+            Tracker.FlushBarriers(Context.GetCommandList());
+            Context.Finish();
+            NullDevice::Counters Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+
+            Report("40 barriers in one ResourceBarrier call", Delta[NullDevice::kBarrierCalls] == 1 &&
+                Delta[NullDevice::kBarriers] == kResourceCount);
+            Tracker.Reset();
+        }
+
+        // ύʱȫ״̬Ƚϣһ²
+        {
+            GpuResource B = CreateTexture(1);
+            std::lock_guard<std::mutex> LockGuard(sm_SubmissionMutex);
+
+            ResourceStateTracker Tracker;
+            Tracker.TransitionResource(B, CopyDest);
+            Tracker.TransitionResource(B, SRV);
+            Tracker.m_Barriers.clear();
+            Fixups.clear();
+            Tracker.ResolvePendingStates(Fixups);
+            bool Passed = Fixups.size() == 1 && IsTransition(Fixups[0], D3D12_RESOURCE_STATE_COMMON, CopyDest, D3D12_RESOURCE_BARRIER_FLAG_NONE) &&
+                GetGlobalState(B) == SRV;
+
+            Tracker.TransitionResource(B, SRV);
+            Fixups.clear();
+            Tracker.ResolvePendingStates(Fixups);
+            Passed = Passed && Fixups.empty() && GetGlobalState(B) == SRV;
+            Report("pending state resolved against global", Passed);
+        }
+
+        // ¼˳ύ˳෴԰ύ˳
+        {
+            GpuResource C = CreateTexture(1);
+
+            CommandContext& First = CommandContext::Begin();
+            CommandContext& Second = CommandContext::Begin();
+            First.DeferStateResolution();
+            Second.DeferStateResolution();
+            Second.TransitionResource(C, SRV);
+            First.TransitionResource(C, RT);
+
+            NullDevice::Counters Before = NullDevice::GetCounters();
+            CommandContext* Batch[] = { &First, &Second };
+            CommandContext::FinishBatch(Batch, 2);
+            NullDevice::Counters Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+
+            // һĵڶбڶ׷ڵһбĩβ
+            bool Passed = Delta[NullDevice::kCommandLists] == 3 && Delta[NullDevice::kBarriers] == 2 && GetGlobalState(C) == SRV;
+
+            CommandContext& Third = CommandContext::Begin();
+            Third.TransitionResource(C, SRV);
+            Before = NullDevice::GetCounters();
+            Third.Finish();
+            Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+            Passed = Passed && Delta[NullDevice::kCommandLists] == 1 && Delta[NullDevice::kBarriers] == 0;
+            Report("out-of-order recording, in-order submit", Passed);
+        }
+
+        // ύ¼ʱͰȫ״̬תҪϺͶб
+        {
+            GpuResource F = CreateTexture(1);
+            ResetStats();
+
+            CommandContext& Lone = CommandContext::Begin();
+            Lone.TransitionResource(F, RT);
+
+            NullDevice::Counters Before = NullDevice::GetCounters();
+            Lone.Finish();
+            NullDevice::Counters Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+            bool Passed = Delta[NullDevice::kCommandLists] == 1 && Delta[NullDevice::kBarriers] == 1 &&
+                sm_Stats[kFixups].load() == 0 && sm_Stats[kFixupLists].load() == 0 && GetGlobalState(F) == RT;
+
+            // εĵһʱӳٽĵ׷бĩβ
+            CommandContext& Setup = CommandContext::Begin();
+            CommandContext& Pass = CommandContext::Begin();
+            Pass.DeferStateResolution();
+            Setup.TransitionResource(F, CopyDest);
+            Pass.TransitionResource(F, SRV);
+
+            Before = NullDevice::GetCounters();
+            CommandContext* Batch[] = { &Setup, &Pass };
+            CommandContext::FinishBatch(Batch, 2);
+            Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+            Passed = Passed && Delta[NullDevice::kCommandLists] == 2 && Delta[NullDevice::kBarriers] == 2 &&
+                sm_Stats[kFixupLists].load() == 0 && GetGlobalState(F) == SRV;
+
+            // ״ʹ֮ĸȫ״̬ύʱԻ
+            CommandContext& Stale = CommandContext::Begin();
+            Stale.TransitionResource(F, RT);
+            CommandContext& Other = CommandContext::Begin();
+            Other.TransitionResource(F, CopySource);
+            Other.Finish();
+
+            Before = NullDevice::GetCounters();
+            Stale.Finish();
+            Delta = NullDevice::Difference(NullDevice::GetCounters(), Before);
+            Passed = Passed && Delta[NullDevice::kCommandLists] == 2 && Delta[NullDevice::kBarriers] == 2 &&
+                sm_Stats[kFixupLists].load() == 1 && GetGlobalState(F) == RT;
+            ResetStats();
+            Report("lone context resolved at first use", Passed);
+        }
+
+        // Դ
+        {
+            GpuResource D = CreateTexture(4);
+            std::lock_guard<std::mutex> LockGuard(sm_SubmissionMutex);
+
+            ResourceStateTracker Tracker;
+            Tracker.TransitionResource(D, CopyDest, 2);
+            Tracker.TransitionResource(D, SRV);
+            bool Passed = Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], CopyDest, SRV, D3D12_RESOURCE_BARRIER_FLAG_NONE, 2);
+
+            Tracker.m_Barriers.clear();
+            Fixups.clear();
+            Tracker.ResolvePendingStates(Fixups);
+            Passed = Passed && Fixups.size() == 4 && GetGlobalState(D) == SRV && D.m_SubresourceStates.empty();
+
+            Tracker.TransitionResource(D, RT, 1);
+            Fixups.clear();
+            Tracker.ResolvePendingStates(Fixups);
+            Passed = Passed && Fixups.size() == 1 && IsTransition(Fixups[0], SRV, RT, D3D12_RESOURCE_BARRIER_FLAG_NONE, 1) &&
+                GetGlobalState(D, 1) == RT && GetGlobalState(D, 0) == SRV && GetGlobalState(D, 3) == SRV;
+
+            // Դһʱתֻ֪״̬Դ¼ʱϣύʱ
+            Tracker.TransitionResource(D, SRV, 0);
+            Tracker.TransitionResource(D, CopySource);
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], SRV, CopySource, D3D12_RESOURCE_BARRIER_FLAG_NONE, 0) &&
+                Tracker.GetState(D) == CopySource;
+
+            Tracker.m_Barriers.clear();
+            Fixups.clear();
+            Tracker.ResolvePendingStates(Fixups);
+            Passed = Passed && Fixups.size() == 3 && GetGlobalState(D) == CopySource && D.m_SubresourceStates.empty();
+            Report("per-subresource states", Passed);
+        }
+
+        // 
+        {
+            GpuResource E = CreateTexture(1);
+            CommandContext& Context = CommandContext::Begin();
+            ResourceStateTracker Tracker;
+
+            // ʼ״̬δ֪ʱ˻ͨת
+            Tracker.BeginResourceTransition(E, RT);
+            bool Passed = Tracker.GetQueuedBarrierCount() == 0;
+
+            Tracker.BeginResourceTransition(E, SRV);
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], RT, SRV, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+            Tracker.FlushBarriers(Context.GetCommandList());
+
+            Tracker.TransitionResource(E, SRV);
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], RT, SRV, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+            Tracker.FlushBarriers(Context.GetCommandList());
+
+            // ûύǰ
+            Tracker.BeginResourceTransition(E, RT);
+            Tracker.FlushBarriers(Context.GetCommandList());
+            Tracker.EndSplitTransitions();
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], SRV, RT, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+            Tracker.FlushBarriers(Context.GetCommandList());
+
+            // ʼͽ֮ûˢʱͨ
+            Tracker.BeginResourceTransition(E, SRV);
+            Tracker.TransitionResource(E, SRV);
+            Passed = Passed && Tracker.GetQueuedBarrierCount() == 1 &&
+                IsTransition(Tracker.GetQueuedBarriers()[0], RT, SRV, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+            Tracker.Reset();
+            Context.Finish();
+            Report("split BEGIN_ONLY/END_ONLY barriers", Passed);
+        }
+    }
+
+    Utility::Printf("Resource state tracker self test %s\n", AllPassed ? "passed" : "FAILED");
+
+    Graphics::Shutdown();
+    return AllPassed;
+}
@@ -0,0 +1,131 @@
+/*
+	ÿһԴ״̬ԭֱӶд GpuResource::m_UsageState 
+	- ¼ʱֻ״̬Դ¼Դڱһתʱ:
+	  (CommandContext::Begin Ĭ): ڶԴȫ״̬Ϊ"ʼ״̬"(Pending)¼ʱͷ
+	  ӳٽ(¼Ƶ): ֪ύʱ״ֻ̬Ŀ״̬Ϊ Pending
+	- ύʱȫڰύ˳ Pending Դȫ״̬Ƚϣһµϣٰ״̬дԴ
+	  ԸĿ̡߳˳¼ƣֻҪύ˳GPUִ˳ֻ
+	  ״ʹ֮ύ֮ǰбĸԴ״̬ʱҪ
+	- Ϸڲ޳ȵĶͬһԴͬһԴڵתϲ: A->BB->C ϳ A->CA->BB->A ֱӵ
+	  ˢʱһ ResourceBarrier 
+	- BeginResourceTransition ʼ״̬֪Դ״̬һʱ BEGIN_ONLY֮ TransitionResource  END_ONLY
+	  ύǰûĲתԶʼ״̬δ֪ʱ˻ͨת
+	- ƽƬ(plane slice)ģʽģƽƽ水ͬһԴ
+*/
+
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+class GpuResource;
+
+class ResourceStateTracker
+{
+public:
+    static const D3D12_RESOURCE_STATES kUnknownState = (D3D12_RESOURCE_STATES)-1;
+
+    enum Stat
+    {
+        kTransitions,           // ת
+        kRedundant,             // ״̬Ѿһ¶ʡת
+        kCoalesced,             // ͶеϺϲʡ
+        kBarriersIssued,        // ¼ʱϣ
+        kBarrierCalls,          // ResourceBarrier ĵô
+        kSplitBarriers,         //  BEGIN_ONLY 
+        kFixups,                // ύʱɵ
+        kFixupsAvoided,         // ύʱ Pending ȫ״̬һ£Ҫ
+        kFixupLists,            // Ϊеһĵ϶ύб
+        kStatCount
+    };
+
+    ResourceStateTracker();
+
+    // һʹԴʱǷȫ״̬ϣĬΪ(ӳٵύʱ)
+    // 򿪺ڳ GetSubmissionMutex ʱ¼ת
+    void SetResolveOnFirstUse( bool Resolve ) { m_ResolveOnFirstUse = Resolve; }
+
+    void TransitionResource( GpuResource& Resource, D3D12_RESOURCE_STATES NewState, UINT Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES );
+    void BeginResourceTransition( GpuResource& Resource, D3D12_RESOURCE_STATES NewState );
+    void InsertUAVBarrier( GpuResource& Resource );
+    void InsertAliasBarrier( GpuResource& Before, GpuResource& After );
+
+    // лڽеĲת
+    void EndSplitTransitions( void );
+
+    // Ѷһдб
+    void FlushBarriers( ID3D12GraphicsCommandList* CmdList );
+
+    UINT GetQueuedBarrierCount( void ) const { return (UINT)m_Barriers.size(); }
+    const D3D12_RESOURCE_BARRIER* GetQueuedBarriers( void ) const { return m_Barriers.data(); }
+
+    // ¼ƵǰλʱԴ״̬ûתʱȫ״̬(ֻڶ)
+    //  ALL_SUBRESOURCES ҸԴ״̬һʱԴе״̬λ
+    D3D12_RESOURCE_STATES GetState( const GpuResource& Resource, UINT Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ) const;
+
+    // ύʱãҪס GetSubmissionMutex ύ˳á
+    // Ҫ׷ӵ Fixupsд״̬Ȼո
+    void ResolvePendingStates( std::vector<D3D12_RESOURCE_BARRIER>& Fixups );
+
+    // ¼״̬
+    void Reset( void );
+
+    uint64_t GetStat( Stat S ) const { return m_Stats[S]; }
+
+    // Դȫ״̬ӽ ExecuteCommandLists Ҫ
+    static std::mutex& GetSubmissionMutex( void ) { return sm_SubmissionMutex; }
+
+    // Դύȫ״̬
+    static D3D12_RESOURCE_STATES GetGlobalState( const GpuResource& Resource, UINT Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES );
+
+    static void AddFixupListStat( void ) { sm_Stats[kFixupLists].fetch_add(1, std::memory_order_relaxed); }
+    static void ResetStats( void );
+    static void PrintReport( uint64_t FrameCount );
+
+    // ڿ豸ϼϲ˳ԴͲϣ -selftest resourcestatetracker ( HeadlessTests.h)
+    static bool SelfTest( void );
+
+private:
+    // һԴԴ״̬ȫͬʱֻ Uniform
+    struct StateSet
+    {
+        D3D12_RESOURCE_STATES Uniform;
+        std::vector<D3D12_RESOURCE_STATES> PerSubresource;
+
+        StateSet() : Uniform(kUnknownState) {}
+
+        bool IsUniform( void ) const { return PerSubresource.empty(); }
+        D3D12_RESOURCE_STATES Get( UINT Subresource ) const { return IsUniform() ? Uniform : PerSubresource[Subresource]; }
+        void SetAll( D3D12_RESOURCE_STATES State ) { Uniform = State; PerSubresource.clear(); }
+        void Set( UINT Subresource, D3D12_RESOURCE_STATES State, UINT SubresourceCount );
+    };
+
+    struct TrackedResource
+    {
+        StateSet Current;       // ¼Ƶǰλõ״̬kUnknownState ʾĻû
+        StateSet Pending;       // ύʱҪʼ״̬kUnknownState ʾҪ
+        UINT SubresourceCount;  // 0 ʾûѯ
+        D3D12_RESOURCE_STATES SplitBefore;
+        D3D12_RESOURCE_STATES SplitAfter;   // ڽеĲתkUnknownState ʾû
+    };
+
+    TrackedResource& Track( GpuResource& Resource );
+    // ڶȡȫ״̬ALL_SUBRESOURCES ҸԴ״̬һʱ false
+    static bool ReadGlobalState( const GpuResource& Resource, UINT Subresource, D3D12_RESOURCE_STATES& State );
+    UINT GetSubresourceCount( GpuResource& Resource, TrackedResource& Tracked );
+    void TransitionSubresource( GpuResource& Resource, TrackedResource& Tracked, UINT Subresource, D3D12_RESOURCE_STATES NewState );
+    void EndSplit( GpuResource& Resource, TrackedResource& Tracked );
+    void AddTransition( ID3D12Resource* Resource, UINT Subresource, D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After,
+        D3D12_RESOURCE_BARRIER_FLAGS Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE );
+
+    std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+    std::unordered_map<GpuResource*, TrackedResource> m_Resources;
+    uint64_t m_Stats[kStatCount];
+    bool m_ResolveOnFirstUse;
+
+    static std::mutex sm_SubmissionMutex;
+    static std::atomic<uint64_t> sm_Stats[kStatCount];
+};
@@ -0,0 +1,414 @@
+#include "pch.h"
+#include "DescriptorFreeList.h"
+#include "SystemTime.h"
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    uint32_t FloorLog2( uint32_t Value )
+    {
+        unsigned long Bit;
+        _BitScanReverse(&Bit, Value);
+        return (uint32_t)Bit;
+    }
+
+    uint32_t CeilLog2( uint32_t Value )
+    {
+        return Value <= 1 ? 0 : FloorLog2(Value - 1) + 1;
+    }
+}
+
+DescriptorFreeList::DescriptorFreeList( uint32_t HeapSize )
+    : m_HeapSize(HeapSize), m_Capacity(0), m_Allocated(0), m_PendingCount(0),
+    m_AllocCount(0), m_FreeCount(0), m_SizeClassMask(0)
+{
+    ASSERT(HeapSize > 0, "Descriptor heap size must be positive");
+}
+
+uint32_t DescriptorFreeList::AddHeap( void )
+{
+    uint32_t Start = m_Capacity;
+    m_Capacity += m_HeapSize;
+    LinkBlock(Start, m_HeapSize);
+    return Start;
+}
+
+void DescriptorFreeList::LinkBlock( uint32_t Index, uint32_t Count )
+{
+    uint32_t SizeClass = FloorLog2(Count);
+    m_FreeBlocks[Index] = Count;
+    m_SizeClasses[SizeClass].insert(Index);
+    m_SizeClassMask |= 1u << SizeClass;
+}
+
+void DescriptorFreeList::UnlinkBlock( uint32_t Index, uint32_t Count )
+{
+    uint32_t SizeClass = FloorLog2(Count);
+    m_FreeBlocks.erase(Index);
+    m_SizeClasses[SizeClass].erase(Index);
+    if (m_SizeClasses[SizeClass].empty())
+        m_SizeClassMask &= ~(1u << SizeClass);
+}
+
+uint32_t DescriptorFreeList::Allocate( uint32_t Count )
+{
+    ASSERT(Count > 0 && Count <= m_HeapSize, "Descriptor allocation does not fit in one heap");
+
+    uint32_t Index = kInvalidIndex;
+    uint32_t BlockSize = 0;
+
+    // С 2^ceil(log2(Count)) κһ鶼
+    uint32_t MinClass = CeilLog2(Count);
+    uint32_t Mask = MinClass < kSizeClassCount ? m_SizeClassMask & (~0u << MinClass) : 0;
+    if (Mask != 0)
+    {
+        unsigned long SizeClass;
+        _BitScanForward(&SizeClass, Mask);
+        Index = *m_SizeClasses[SizeClass].begin();
+        BlockSize = m_FreeBlocks[Index];
+    }
+    else if (MinClass != FloorLog2(Count))
+    {
+        // Count 2ʱfloor ҲйĿ
+        for (uint32_t Candidate : m_SizeClasses[FloorLog2(Count)])
+        {
+            uint32_t Size = m_FreeBlocks[Candidate];
+            if (Size >= Count)
+            {
+                Index = Candidate;
+                BlockSize = Size;
+                break;
+            }
+        }
+    }
+
+    if (Index == kInvalidIndex)
+        return kInvalidIndex;
+
+    // ʣಿַŻأڵĶѷ䣬Ҫϲ
+    UnlinkBlock(Index, BlockSize);
+    if (BlockSize > Count)
+        LinkBlock(Index + Count, BlockSize - Count);
+
+    m_Allocated += Count;
+    ++m_AllocCount;
+    return Index;
+}
+
+void DescriptorFreeList::Free( uint32_t Index, uint32_t Count, uint64_t FenceValue )
+{
+    ASSERT(Count > 0 && Index + Count <= m_Capacity, "Freeing descriptors outside of the heaps");
+    ASSERT(Count <= m_Allocated, "Freeing more descriptors than were allocated");
+
+    m_Allocated -= Count;
+    ++m_FreeCount;
+
+    if (FenceValue == 0)
+    {
+        InsertFreeBlock(Index, Count);
+        return;
+    }
+
+    ASSERT(m_Pending.empty() || m_Pending.back().FenceValue <= FenceValue, "Descriptor frees must use monotonic fence values");
+    m_Pending.push_back({ FenceValue, Index, Count });
+    m_PendingCount += Count;
+}
+
+void DescriptorFreeList::Reclaim( uint64_t CompletedFenceValue )
+{
+    while (!m_Pending.empty() && m_Pending.front().FenceValue <= CompletedFenceValue)
+    {
+        const PendingFree& Entry = m_Pending.front();
+        InsertFreeBlock(Entry.Index, Entry.Count);
+        m_PendingCount -= Entry.Count;
+        m_Pending.pop_front();
+    }
+}
+
+void DescriptorFreeList::InsertFreeBlock( uint32_t Index, uint32_t Count )
+{
+    uint32_t End = Index + Count;
+
+    auto Next = m_FreeBlocks.lower_bound(Index);
+    ASSERT(Next == m_FreeBlocks.end() || Next->first >= End, "Descriptor range freed twice");
+
+    // ͺһϲڶѱ߽ϵĿһ
+    if (Next != m_FreeBlocks.end() && Next->first == End && End % m_HeapSize != 0)
+    {
+        uint32_t NextSize = Next->second;
+        UnlinkBlock(End, NextSize);
+        End += NextSize;
+    }
+
+    // ǰһϲ
+    auto Prev = m_FreeBlocks.lower_bound(Index);
+    if (Prev != m_FreeBlocks.begin())
+    {
+        --Prev;
+        ASSERT(Prev->first + Prev->second <= Index, "Descriptor range freed twice");
+        if (Prev->first + Prev->second == Index && Index % m_HeapSize != 0)
+        {
+            uint32_t PrevStart = Prev->first;
+            UnlinkBlock(PrevStart, Prev->second);
+            Index = PrevStart;
+        }
+    }
+
+    LinkBlock(Index, End - Index);
+}
+
+DescriptorFreeList::Stats DescriptorFreeList::GetStats( void ) const
+{
+    Stats Result = {};
+    Result.Capacity = m_Capacity;
+    Result.Allocated = m_Allocated;
+    Result.Pending = m_PendingCount;
+    Result.FreeBlocks = (uint32_t)m_FreeBlocks.size();
+    Result.AllocCount = m_AllocCount;
+    Result.FreeCount = m_FreeCount;
+
+    uint32_t TotalFree = 0;
+    for (auto& Block : m_FreeBlocks)
+    {
+        TotalFree += Block.second;
+        Result.LargestFreeBlock = max(Result.LargestFreeBlock, Block.second);
+    }
+    Result.Fragmentation = TotalFree == 0 ? 0.0f : 1.0f - (float)Result.LargestFreeBlock / TotalFree;
+    return Result;
+}
+
+bool DescriptorFreeList::SelfTest( void )
+{
+    bool AllPassed = true;
+    auto Report = [&AllPassed]( const char* Name, bool Passed )
+    {
+        Utility::Printf("  %-40s %s\n", Name, Passed ? "ok" : "FAILED");
+        AllPassed = AllPassed && Passed;
+    };
+
+    Utility::Printf("Descriptor free list self test\n");
+
+    // ûжʱʧܣ׷ӶѺͷ˳
+    {
+        DescriptorFreeList List(16);
+        bool Passed = List.Allocate(1) == kInvalidIndex;
+        Passed = Passed && List.AddHeap() == 0;
+        Passed = Passed && List.Allocate(1) == 0 && List.Allocate(4) == 1 && List.Allocate(3) == 5;
+        Passed = Passed && List.Allocate(9) == kInvalidIndex && List.Allocate(8) == 8;
+        Passed = Passed && List.GetStats().Allocated == 16 && List.GetStats().FreeBlocks == 0;
+        Report("sequential allocation", Passed);
+    }
+
+    // ͷźͬһλãȫͷźϲһ
+    {
+        DescriptorFreeList List(16);
+        List.AddHeap();
+        uint32_t A = List.Allocate(4), B = List.Allocate(4), C = List.Allocate(4);
+        List.Free(B, 4);
+        bool Passed = List.Allocate(4) == B;
+        List.Free(B, 4);
+        List.Free(A, 4);
+        List.Free(C, 4);
+        Stats S = List.GetStats();
+        Passed = Passed && S.FreeBlocks == 1 && S.LargestFreeBlock == 16 && S.Allocated == 0 && S.Fragmentation == 0.0f;
+        Report("reuse and coalescing", Passed);
+    }
+
+    // ڵѲܺϲѵķʧ
+    {
+        DescriptorFreeList List(8);
+        List.AddHeap();
+        List.AddHeap();
+        uint32_t A = List.Allocate(8), B = List.Allocate(8);
+        List.Free(A, 8);
+        List.Free(B, 8);
+        Stats S = List.GetStats();
+        bool Passed = A == 0 && B == 8 && S.FreeBlocks == 2 && S.LargestFreeBlock == 8;
+        List.Allocate(4);
+        Passed = Passed && List.Allocate(8) == 8 && List.Allocate(5) == kInvalidIndex;
+        Report("heap boundaries", Passed);
+    }
+
+    // ΧͷΧǰܱ
+    {
+        DescriptorFreeList List(4);
+        List.AddHeap();
+        uint32_t A = List.Allocate(2), B = List.Allocate(2);
+        List.Free(A, 2, 5);
+        List.Free(B, 2, 7);
+        bool Passed = List.Allocate(1) == kInvalidIndex && List.GetStats().Pending == 4;
+        Passed = Passed && List.GetOldestPendingFence() == 5;
+        List.Reclaim(4);
+        Passed = Passed && List.Allocate(1) == kInvalidIndex;
+        List.Reclaim(6);
+        Passed = Passed && List.GetStats().Pending == 2 && List.GetOldestPendingFence() == 7;
+        Passed = Passed && List.Allocate(2) == A && List.Allocate(1) == kInvalidIndex;
+        List.Reclaim(7);
+        Passed = Passed && List.GetOldestPendingFence() == 0 && List.Allocate(2) == B;
+        Report("fence deferred reclamation", Passed);
+    }
+
+    // 2ݵĴСֻ floor ҵ
+    {
+        DescriptorFreeList List(32);
+        List.AddHeap();
+        uint32_t A = List.Allocate(5);
+        List.Allocate(1);
+        List.Allocate(26);
+        List.Free(A, 5);
+        bool Passed = List.Allocate(5) == A;
+        Report("floor size class fallback", Passed);
+    }
+
+    // ͷţռñûصÿѻָһ
+    {
+        const uint32_t kHeapSize = 64;
+        DescriptorFreeList List(kHeapSize);
+        vector<bool> Used;
+        vector<pair<uint32_t, uint32_t>> Live;
+        mt19937 Rng(1234);
+        uint64_t Fence = 0;
+
+        bool Passed = true;
+        for (uint32_t Step = 0; Step < 20000 && Passed; ++Step)
+        {
+            if (Live.empty() || Rng() % 3 != 0)
+            {
+                uint32_t Count = 1 + Rng() % 8;
+                uint32_t Index = List.Allocate(Count);
+                if (Index == kInvalidIndex)
+                {
+                    List.AddHeap();
+                    Used.resize(List.GetStats().Capacity, false);
+                    Index = List.Allocate(Count);
+                }
+                Passed = Index != kInvalidIndex && Index / kHeapSize == (Index + Count - 1) / kHeapSize;
+                for (uint32_t i = 0; i < Count && Passed; ++i)
+                {
+                    Passed = !Used[Index + i];
+                    Used[Index + i] = true;
+                }
+                Live.emplace_back(Index, Count);
+            }
+            else
+            {
+                size_t Victim = Rng() % Live.size();
+                for (uint32_t i = 0; i < Live[Victim].second; ++i)
+                    Used[Live[Victim].first + i] = false;
+                List.Free(Live[Victim].first, Live[Victim].second, ++Fence);
+                Live[Victim] = Live.back();
+                Live.pop_back();
+            }
+            if (Step % 16 == 0)
+                List.Reclaim(Fence);
+        }
+
+        for (auto& Alloc : Live)
+            List.Free(Alloc.first, Alloc.second);
+        List.Reclaim(Fence);
+
+        Stats S = List.GetStats();
+        Passed = Passed && S.Allocated == 0 && S.Pending == 0 && S.FreeBlocks == S.Capacity / kHeapSize;
+        Report("random churn against occupancy map", Passed);
+    }
+
+    Utility::Printf(AllPassed ? "All descriptor free list tests passed\n" : "Descriptor free list tests FAILED\n");
+    return AllPassed;
+}
+
+namespace
+{
+    const uint32_t kChurnHeapSize = 256;
+    const uint32_t kChurnCycles = 1000000;
+    const uint32_t kChurnLiveCount = 2000;
+    const uint32_t kChurnCyclesPerFrame = 1000;
+    const uint32_t kChurnFramesInFlight = 3;
+
+    // 󲿷ǵSRVżһ
+    uint32_t ChurnAllocationSize( mt19937& Rng )
+    {
+        uint32_t Roll = Rng() % 100;
+        return Roll < 80 ? 1 : Roll < 95 ? 1 + Rng() % 4 : 8 + Rng() % 9;
+    }
+}
+
+void DescriptorFreeList::Benchmark( void )
+{
+    SystemTime::Initialize();
+
+    Utility::Printf("Descriptor churn: %u alloc/free cycles, %u live allocations, %u descriptors per heap, %u frames in flight\n",
+        kChurnCycles, kChurnLiveCount, kChurnHeapSize, kChurnFramesInFlight);
+
+    // ԭԷ: ֻǰգŲʱѻ
+    {
+        mt19937 Rng(42);
+        uint32_t HeapCount = 0, Remaining = 0;
+        uint64_t Descriptors = 0;
+
+        int64_t Start = SystemTime::GetCurrentTick();
+        for (uint32_t Cycle = 0; Cycle < kChurnLiveCount + kChurnCycles; ++Cycle)
+        {
+            uint32_t Count = ChurnAllocationSize(Rng);
+            if (Remaining < Count)
+            {
+                ++HeapCount;
+                Remaining = kChurnHeapSize;
+            }
+            Remaining -= Count;
+            Descriptors += Count;
+        }
+        double Ms = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - Start);
+
+        Utility::Printf("  bump       %8.2f ms  %6u heaps  %10llu descriptors (%.1f MB of CPU heaps at 32 B each)\n",
+            Ms, HeapCount, Descriptors, HeapCount * kChurnHeapSize * 32.0 / (1024.0 * 1024.0));
+    }
+
+    // : ͷƳ kChurnFramesInFlight ֡
+    {
+        mt19937 Rng(42);
+        DescriptorFreeList List(kChurnHeapSize);
+        vector<pair<uint32_t, uint32_t>> Live;
+        Live.reserve(kChurnLiveCount);
+
+        auto AllocateOne = [&]()
+        {
+            uint32_t Count = ChurnAllocationSize(Rng);
+            uint32_t Index = List.Allocate(Count);
+            if (Index == kInvalidIndex)
+            {
+                List.AddHeap();
+                Index = List.Allocate(Count);
+            }
+            return make_pair(Index, Count);
+        };
+
+        int64_t Start = SystemTime::GetCurrentTick();
+        for (uint32_t i = 0; i < kChurnLiveCount; ++i)
+            Live.push_back(AllocateOne());
+
+        uint64_t Frame = 1;
+        for (uint32_t Cycle = 0; Cycle < kChurnCycles; ++Cycle)
+        {
+            if (Cycle % kChurnCyclesPerFrame == 0)
+            {
+                ++Frame;
+                if (Frame > kChurnFramesInFlight)
+                    List.Reclaim(Frame - kChurnFramesInFlight);
+            }
+
+            size_t Victim = Rng() % Live.size();
+            List.Free(Live[Victim].first, Live[Victim].second, Frame);
+            Live[Victim] = AllocateOne();
+        }
+        double Ms = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - Start);
+
+        Stats S = List.GetStats();
+        Utility::Printf("  free list  %8.2f ms  %6u heaps  %.1f ns per alloc+free\n",
+            Ms, List.GetHeapCount(), Ms * 1e6 / kChurnCycles);
+        Utility::Printf("             occupancy %u/%u allocated, %u pending, %u free blocks, largest %u, fragmentation %.1f%%\n",
+            S.Allocated, S.Capacity, S.Pending, S.FreeBlocks, S.LargestFreeBlock, S.Fragmentation * 100.0f);
+    }
+}
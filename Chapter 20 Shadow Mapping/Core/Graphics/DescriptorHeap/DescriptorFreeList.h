@@ -0,0 +1,86 @@
+/*
+	ֻ±꣬ӴD3D󣬿豸
+	- ±갴:  n ռ [n * HeapSize, (n + 1) * HeapSize)
+	- п鰴ͷʱڿϲԽѵı߽
+	- С floor(log2) ֳɳߴ࣬ʱ ceil(log2(Count)) ʼλҵһǿ࣬
+	  κһ鶼ŵ£Ҳɨ floor(log2(Count)) һ
+	- ΧֵͷȽȴУΧɺ Reclaim ŻؿGPUڶд
+*/
+
+#pragma once
+
+#include "pch.h"
+#include <map>
+#include <set>
+#include <deque>
+
+class DescriptorFreeList
+{
+public:
+    static const uint32_t kInvalidIndex = 0xFFFFFFFF;
+    static const uint32_t kSizeClassCount = 32;
+
+    struct Stats
+    {
+        uint32_t Capacity;          // жѵ
+        uint32_t Allocated;         // ѷδͷ
+        uint32_t Pending;           // ͷŵΧδ
+        uint32_t FreeBlocks;
+        uint32_t LargestFreeBlock;
+        uint64_t AllocCount;
+        uint64_t FreeCount;
+        float Fragmentation;        // 1 - п / 0 ʾпռȫ
+    };
+
+    explicit DescriptorFreeList( uint32_t HeapSize );
+
+    uint32_t GetHeapSize( void ) const { return m_HeapSize; }
+    uint32_t GetHeapCount( void ) const { return m_Capacity / m_HeapSize; }
+
+    // ׷һѵ±귶Χʼ±
+    uint32_t AddHeap( void );
+
+    //  Count ʼ±꣬Ųʱ kInvalidIndexɵ׷¶
+    uint32_t Allocate( uint32_t Count );
+
+    // FenceValue Ϊ0ʱգȵ Reclaim ֵС
+    void Free( uint32_t Index, uint32_t Count, uint64_t FenceValue = 0 );
+
+    // ȴΧֵΪʱ0
+    uint64_t GetOldestPendingFence( void ) const { return m_Pending.empty() ? 0 : m_Pending.front().FenceValue; }
+    void Reclaim( uint64_t CompletedFenceValue );
+
+    Stats GetStats( void ) const;
+
+    // CPUȷԼͷ/ͷѭܶԱȣ -selftest descriptorfreelist  -benchmark descriptorchurn ( HeadlessTests.h)
+    static bool SelfTest( void );
+    static void Benchmark( void );
+
+private:
+    struct PendingFree
+    {
+        uint64_t FenceValue;
+        uint32_t Index;
+        uint32_t Count;
+    };
+
+    void InsertFreeBlock( uint32_t Index, uint32_t Count );
+    void LinkBlock( uint32_t Index, uint32_t Count );
+    void UnlinkBlock( uint32_t Index, uint32_t Count );
+
+    uint32_t m_HeapSize;
+    uint32_t m_Capacity;
+    uint32_t m_Allocated;
+    uint32_t m_PendingCount;
+    uint64_t m_AllocCount;
+    uint64_t m_FreeCount;
+
+    //  -> С
+    std::map<uint32_t, uint32_t> m_FreeBlocks;
+    // ÿߴĿ㣬ͬõ͵ַĿ
+    std::set<uint32_t> m_SizeClasses[kSizeClassCount];
+    uint32_t m_SizeClassMask;
+
+    // ΧֵУͬһеΧǵ
+    std::deque<PendingFree> m_Pending;
+};
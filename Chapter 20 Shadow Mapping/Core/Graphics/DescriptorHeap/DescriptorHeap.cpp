@@ -27,12 +27,33 @@ std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DescriptorAllocator::s
 void DescriptorAllocator::DestroyAll(void)
 {
     sm_DescriptorHeapPool.clear();
+
+    for (uint32_t i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+    {
+        DescriptorAllocator& Allocator = g_DescriptorAllocator[i];
+        Allocator.m_HeapStarts.clear();
+        Allocator.m_FreeList = DescriptorFreeList(sm_NumDescriptorsPerHeap);
+    }
 }
 
-ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+void DescriptorAllocator::PrintReport(void)
 {
+    static const char* TypeNames[] = { "CBV_SRV_UAV", "SAMPLER", "RTV", "DSV" };
+
     std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
 
+    Utility::Printf("Descriptor allocators:\n");
+    for (uint32_t i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+    {
+        DescriptorFreeList::Stats S = g_DescriptorAllocator[i].m_FreeList.GetStats();
+        Utility::Printf("  %-12s %3u heaps  %5u/%5u allocated  %4u pending  %4u free blocks (largest %u, %.1f%% fragmented)  %llu allocs  %llu frees\n",
+            TypeNames[i], g_DescriptorAllocator[i].m_FreeList.GetHeapCount(), S.Allocated, S.Capacity, S.Pending,
+            S.FreeBlocks, S.LargestFreeBlock, S.Fragmentation * 100.0f, S.AllocCount, S.FreeCount);
+    }
+}
+
+ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+{
     D3D12_DESCRIPTOR_HEAP_DESC Desc;
     Desc.Type = Type;
     Desc.NumDescriptors = sm_NumDescriptorsPerHeap;
@@ -45,24 +66,58 @@ ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_
     return pHeap.Get();
 }
 
+void DescriptorAllocator::ReclaimCompleted(void)
+{
+    uint64_t FenceValue = m_FreeList.GetOldestPendingFence();
+    while (FenceValue != 0 && g_CommandManager.IsFenceComplete(FenceValue))
+    {
+        m_FreeList.Reclaim(FenceValue);
+        FenceValue = m_FreeList.GetOldestPendingFence();
+    }
+}
+
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::Allocate( uint32_t Count )
 {
-    if (m_CurrentHeap == nullptr || m_RemainingFreeHandles < Count)
+    std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
+
+    ReclaimCompleted();
+
+    uint32_t Index = m_FreeList.Allocate(Count);
+    if (Index == DescriptorFreeList::kInvalidIndex)
     {
-        m_CurrentHeap = RequestNewHeap(m_Type);
-        m_CurrentHandle = m_CurrentHeap->GetCPUDescriptorHandleForHeapStart();
-        m_RemainingFreeHandles = sm_NumDescriptorsPerHeap;
+        ID3D12DescriptorHeap* Heap = RequestNewHeap(m_Type);
+        m_HeapStarts.push_back(Heap->GetCPUDescriptorHandleForHeapStart());
+        m_FreeList.AddHeap();
 
         if (m_DescriptorSize == 0)
             m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(m_Type);
+
+        Index = m_FreeList.Allocate(Count);
     }
 
-    D3D12_CPU_DESCRIPTOR_HANDLE ret = m_CurrentHandle;
-    m_CurrentHandle.ptr += Count * m_DescriptorSize;
-    m_RemainingFreeHandles -= Count;
+    D3D12_CPU_DESCRIPTOR_HANDLE ret = m_HeapStarts[Index / sm_NumDescriptorsPerHeap];
+    ret.ptr += (Index % sm_NumDescriptorsPerHeap) * m_DescriptorSize;
     return ret;
 }
 
+bool DescriptorAllocator::Free( D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count )
+{
+    std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
+
+    // ѵ٣ԲҼ
+    for (size_t i = 0; i < m_HeapStarts.size(); ++i)
+    {
+        size_t Start = m_HeapStarts[i].ptr;
+        if (Handle.ptr < Start || Handle.ptr >= Start + sm_NumDescriptorsPerHeap * m_DescriptorSize)
+            continue;
+
+        uint32_t Index = (uint32_t)(i * sm_NumDescriptorsPerHeap + (Handle.ptr - Start) / m_DescriptorSize);
+        m_FreeList.Free(Index, Count, g_CommandManager.GetGraphicsQueue().GetNextFenceValue());
+        return true;
+    }
+    return false;
+}
+
 //
 // UserDescriptorHeap implementation
 //
@@ -21,6 +21,7 @@
 #include <vector>
 #include <queue>
 #include <string>
+#include "DescriptorFreeList.h"
 
 
 // This is an unbounded resource descriptor allocator.  It is intended to provide space for CPU-visible resource descriptors
@@ -29,14 +30,22 @@
 class DescriptorAllocator
 {
 public:
-    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE Type) : m_Type(Type), m_CurrentHeap(nullptr) {}
+    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+        : m_Type(Type), m_DescriptorSize(0), m_FreeList(sm_NumDescriptorsPerHeap) {}
 
-	// Countصһľ
+	// Countصһľȸѻյ
     D3D12_CPU_DESCRIPTOR_HANDLE Allocate( uint32_t Count );
 
+	// 黹ͼζύִŻᱻ
+	// ʱfalse
+    bool Free( D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count );
+
 	// 
     static void DestroyAll(void);
 
+	// ͵ռúƬͳ
+    static void PrintReport(void);
+
 protected:
 
     static const uint32_t sm_NumDescriptorsPerHeap = 256;
@@ -44,16 +53,17 @@ protected:
     static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool;
     static ID3D12DescriptorHeap* RequestNewHeap( D3D12_DESCRIPTOR_HEAP_TYPE Type );
 
+	// ΧɵͷŷŻؿ
+    void ReclaimCompleted(void);
+
 	// 
     D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
-	// ǰָ
-    ID3D12DescriptorHeap* m_CurrentHeap;
-	// ǰ
-    D3D12_CPU_DESCRIPTOR_HANDLE m_CurrentHandle;
 	// ṹС
     uint32_t m_DescriptorSize;
-	// ùʣɷ
-    uint32_t m_RemainingFreeHandles;
+	// ÿѵʼ± i ڵ i / sm_NumDescriptorsPerHeap 
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_HeapStarts;
+	// ±Ŀ
+    DescriptorFreeList m_FreeList;
 };
 
 
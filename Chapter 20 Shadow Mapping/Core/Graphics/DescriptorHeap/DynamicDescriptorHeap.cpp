@@ -17,9 +17,16 @@
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
 #include "RootSignature.h"
+#include "SystemTime.h"
+#include "Hash.h"
 
 using namespace Graphics;
 
+namespace Graphics
+{
+    BoolVar s_EnableDescriptorTableCache("Graphics/Descriptor Table Cache", true);
+}
+
 //
 // DynamicDescriptorHeap Implementation
 //
@@ -28,6 +35,8 @@ std::mutex DynamicDescriptorHeap::sm_Mutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DynamicDescriptorHeap::sm_DescriptorHeapPool[2];
 std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> DynamicDescriptorHeap::sm_RetiredDescriptorHeaps[2];
 std::queue<ID3D12DescriptorHeap*> DynamicDescriptorHeap::sm_AvailableDescriptorHeaps[2];
+std::atomic<uint64_t> DynamicDescriptorHeap::sm_Stats[kTableCacheStatCount];
+std::atomic<uint32_t> DynamicDescriptorHeap::sm_SourceGeneration(0);
 
 ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType)
 {
@@ -82,6 +91,9 @@ void DynamicDescriptorHeap::RetireCurrentHeap( void )
     m_RetiredHeaps.push_back(m_CurrentHeapPtr);
     m_CurrentHeapPtr = nullptr;
     m_CurrentOffset = 0;
+
+    // λö
+    m_TableCache.clear();
 }
 
 void DynamicDescriptorHeap::RetireUsedHeaps( uint64_t fenceValue )
@@ -96,6 +108,10 @@ DynamicDescriptorHeap::DynamicDescriptorHeap(CommandContext& OwningContext, D3D1
     m_CurrentHeapPtr = nullptr;
     m_CurrentOffset = 0;
     m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(HeapType);
+    m_TableCacheGeneration = sm_SourceGeneration.load(std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < kTableCacheStatCount; ++i)
+        m_Stats[i] = 0;
 }
 
 DynamicDescriptorHeap::~DynamicDescriptorHeap()
@@ -108,6 +124,29 @@ void DynamicDescriptorHeap::CleanupUsedHeaps( uint64_t fenceValue )
     RetireUsedHeaps(fenceValue);
     m_GraphicsHandleCache.ClearCache();
     m_ComputeHandleCache.ClearCache();
+
+    for (uint32_t i = 0; i < kTableCacheStatCount; ++i)
+    {
+        sm_Stats[i].fetch_add(m_Stats[i], std::memory_order_relaxed);
+        m_Stats[i] = 0;
+    }
+}
+
+void DynamicDescriptorHeap::ResetStats( void )
+{
+    for (uint32_t i = 0; i < kTableCacheStatCount; ++i)
+        sm_Stats[i].store(0, std::memory_order_relaxed);
+}
+
+void DynamicDescriptorHeap::PrintReport( uint32_t FrameCount )
+{
+    double Commits = (double)sm_Stats[kTableCommits].load();
+    double Hits = (double)sm_Stats[kTableHits].load();
+    double Frames = (double)std::max(FrameCount, 1u);
+
+    Utility::Printf("Descriptor tables (cache %s): %.0f tables/frame  %.0f hits (%.1f%%)  %.0f descriptors copied/frame  %.3f ms commit CPU/frame\n",
+        s_EnableDescriptorTableCache ? "on" : "off", Commits / Frames, Hits / Frames, Commits > 0.0 ? Hits * 100.0 / Commits : 0.0,
+        sm_Stats[kDescriptorsCopied].load() / Frames, SystemTime::TicksToMillisecs((int64_t)sm_Stats[kCommitTicks].load()) / Frames);
 }
 
 inline ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer()
@@ -249,17 +288,125 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
 void DynamicDescriptorHeap::CopyAndBindStagedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
     void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
 {
-    uint32_t NeededSize = HandleCache.ComputeStagedSize();
-    if (!HasSpace(NeededSize))
+    int64_t StartTick = SystemTime::GetCurrentTick();
+    m_Stats[kTableCommits] += __popcnt(HandleCache.m_StaleRootParamsBitMap);
+
+    if (s_EnableDescriptorTableCache)
     {
-        RetireCurrentHeap();
-        UnbindAllValid();
-        NeededSize = HandleCache.ComputeStagedSize();
+        // CPUԭλдֵıѹ
+        uint32_t Generation = sm_SourceGeneration.load(std::memory_order_acquire);
+        if (m_TableCacheGeneration != Generation)
+        {
+            m_TableCache.clear();
+            m_TableCacheGeneration = Generation;
+        }
+        BindCachedTables(HandleCache, CmdList, SetFunc);
     }
 
-    // This can trigger the creation of a new heap
-    m_OwningContext.SetDescriptorHeap(m_DescriptorType, GetHeapPointer());
-    HandleCache.CopyAndBindStaleTables(m_DescriptorType, m_DescriptorSize, Allocate(NeededSize), CmdList, SetFunc);
+    if (HandleCache.m_StaleRootParamsBitMap != 0)
+    {
+        uint32_t NeededSize = HandleCache.ComputeStagedSize();
+        if (!HasSpace(NeededSize))
+        {
+            RetireCurrentHeap();
+            UnbindAllValid();
+            NeededSize = HandleCache.ComputeStagedSize();
+        }
+
+        // This can trigger the creation of a new heap
+        m_OwningContext.SetDescriptorHeap(m_DescriptorType, GetHeapPointer());
+
+        uint32_t UploadedParams = HandleCache.m_StaleRootParamsBitMap;
+        uint32_t Offset = m_CurrentOffset;
+        HandleCache.CopyAndBindStaleTables(m_DescriptorType, m_DescriptorSize, Allocate(NeededSize), CmdList, SetFunc);
+        RecordUploadedTables(HandleCache, UploadedParams, Offset);
+    }
+
+    m_Stats[kCommitTicks] += SystemTime::GetCurrentTick() - StartTick;
+}
+
+size_t DynamicDescriptorHeap::DescriptorHandleCache::HashTable( uint32_t RootIndex ) const
+{
+    const DescriptorTableCache& Table = m_RootDescriptorTable[RootIndex];
+
+    size_t Hash = Utility::HashState(&Table.AssignedHandlesBitMap);
+    unsigned long Slot;
+    uint32_t SetHandles = Table.AssignedHandlesBitMap;
+    while (_BitScanForward(&Slot, SetHandles))
+    {
+        SetHandles ^= (1 << Slot);
+        Hash = Utility::HashState(&Table.TableStart[Slot], 1, Hash);
+    }
+    return Hash;
+}
+
+void DynamicDescriptorHeap::BindCachedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
+    void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
+{
+    if (m_TableCache.empty())
+        return;
+
+    unsigned long RootIndex;
+    uint32_t StaleParams = HandleCache.m_StaleRootParamsBitMap;
+    while (_BitScanForward(&RootIndex, StaleParams))
+    {
+        StaleParams ^= (1 << RootIndex);
+
+        auto Iter = m_TableCache.find(HandleCache.HashTable(RootIndex));
+        if (Iter == m_TableCache.end())
+            continue;
+
+        // ϣͬʱȶԾ
+        const DescriptorTableCache& Table = HandleCache.m_RootDescriptorTable[RootIndex];
+        const UploadedTable& Uploaded = Iter->second;
+        if (Uploaded.AssignedHandlesBitMap != Table.AssignedHandlesBitMap)
+            continue;
+
+        bool Match = true;
+        unsigned long Slot;
+        uint32_t SetHandles = Table.AssignedHandlesBitMap;
+        while (Match && _BitScanForward(&Slot, SetHandles))
+        {
+            SetHandles ^= (1 << Slot);
+            Match = m_SourceHandles[Uploaded.Offset + Slot].ptr == Table.TableStart[Slot].ptr;
+        }
+        if (!Match)
+            continue;
+
+        // Ŀܱⲿ
+        m_OwningContext.SetDescriptorHeap(m_DescriptorType, m_CurrentHeapPtr);
+        (CmdList->*SetFunc)(RootIndex, (m_FirstDescriptor + Uploaded.Offset * m_DescriptorSize).GetGpuHandle());
+
+        HandleCache.m_StaleRootParamsBitMap ^= (1 << RootIndex);
+        ++m_Stats[kTableHits];
+    }
+}
+
+void DynamicDescriptorHeap::RecordUploadedTables( const DescriptorHandleCache& HandleCache, uint32_t UploadedParams, uint32_t Offset )
+{
+    //  CopyAndBindStaleTables ͬ˳ʹС
+    unsigned long RootIndex;
+    while (_BitScanForward(&RootIndex, UploadedParams))
+    {
+        UploadedParams ^= (1 << RootIndex);
+
+        const DescriptorTableCache& Table = HandleCache.m_RootDescriptorTable[RootIndex];
+        unsigned long MaxSetHandle;
+        _BitScanReverse(&MaxSetHandle, Table.AssignedHandlesBitMap);
+        m_Stats[kDescriptorsCopied] += __popcnt(Table.AssignedHandlesBitMap);
+
+        if (s_EnableDescriptorTableCache)
+        {
+            for (uint32_t i = 0; i <= MaxSetHandle; ++i)
+                m_SourceHandles[Offset + i] = Table.TableStart[i];
+
+            UploadedTable& Uploaded = m_TableCache[HandleCache.HashTable(RootIndex)];
+            Uploaded.Offset = Offset;
+            Uploaded.AssignedHandlesBitMap = Table.AssignedHandlesBitMap;
+        }
+
+        Offset += MaxSetHandle + 1;
+    }
 }
 
 void DynamicDescriptorHeap::UnbindAllValid( void )
@@ -15,17 +15,26 @@
 
 #include "DescriptorHeap.h"
 #include "RootSignature.h"
+#include "EngineTuning.h"
 #include <vector>
 #include <queue>
+#include <atomic>
+#include <unordered_map>
 
 namespace Graphics
 {
     extern ID3D12Device* g_Device;
+    extern BoolVar s_EnableDescriptorTableCache;
 }
 
 // This class is a linear allocation system for dynamically generated descriptor tables.  It internally caches
 // CPU descriptor handles so that when not enough space is available in the current heap, necessary descriptors
 // can be re-copied to the new heap.
+//
+// ϴ(õľλ)ϣ棬ͬһٴύͬıʱֱӰ֮ǰGPU
+//  CopyDescriptors浱ǰһʧЧ: ѻбʱա
+// Ҫ¼ڼ䲻ԭλдύCPUDescriptorAllocator ӳٻձ֤ͷŵľᱻá
+// ȷʵҪԭλдʱ(ʽɺ滻ռλSRV) InvalidateTableCaches´ύǰջ档
 class DynamicDescriptorHeap
 {
 public:
@@ -40,6 +49,13 @@ public:
 
     void CleanupUsedHeaps( uint64_t fenceValue );
 
+    // ʡʵʿύʱĻ
+    static void ResetStats( void );
+    static void PrintReport( uint32_t FrameCount );
+
+    // ԭλд˿ѱCPU
+    static void InvalidateTableCaches( void ) { sm_SourceGeneration.fetch_add(1, std::memory_order_release); }
+
     // Copy multiple handles into the cache area reserved for the specified root parameter.
     void SetGraphicsDescriptorHandles( UINT RootIndex, UINT Offset, UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] )
     {
@@ -87,6 +103,10 @@ private:
     static std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> sm_RetiredDescriptorHeaps[2];
     static std::queue<ID3D12DescriptorHeap*> sm_AvailableDescriptorHeaps[2];
 
+    enum TableCacheStat { kTableCommits, kTableHits, kDescriptorsCopied, kCommitTicks, kTableCacheStatCount };
+    static std::atomic<uint64_t> sm_Stats[kTableCacheStatCount];
+    static std::atomic<uint32_t> sm_SourceGeneration;
+
     // Static methods
     static ID3D12DescriptorHeap* RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType);
     static void DiscardDescriptorHeaps( D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValueForReset, const std::vector<ID3D12DescriptorHeap*>& UsedHeaps );
@@ -100,6 +120,19 @@ private:
     DescriptorHandle m_FirstDescriptor;
     std::vector<ID3D12DescriptorHeap*> m_RetiredHeaps;
 
+    // ǰϴı: ݹϣ -> λám_SourceHandles ¼ÿλĸCPUʱȶųϣͻ
+    struct UploadedTable
+    {
+        uint32_t Offset;
+        uint32_t AssignedHandlesBitMap;
+    };
+    std::unordered_map<size_t, UploadedTable> m_TableCache;
+    uint32_t m_TableCacheGeneration;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_SourceHandles[kNumDescriptorsPerHeap];
+
+    // ĵͳƣCleanupUsedHeaps ʱۼӵ sm_Stats
+    uint64_t m_Stats[kTableCacheStatCount];
+
     // Describes a descriptor table entry:  a region of the handle cache and which handles have been set
     struct DescriptorTableCache
     {
@@ -139,6 +172,9 @@ private:
         void UnbindAllValid();
         void StageDescriptorHandles( UINT RootIndex, UINT Offset, UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
         void ParseRootSignature( D3D12_DESCRIPTOR_HEAP_TYPE Type, const RootSignature& RootSig );
+
+        // þݹϣ
+        size_t HashTable( uint32_t RootIndex ) const;
     };
 
     DescriptorHandleCache m_GraphicsHandleCache;
@@ -163,6 +199,13 @@ private:
     void CopyAndBindStagedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
         void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) );
 
+    // ڵǰͬݵıǴӴύλͼȥ
+    void BindCachedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
+        void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) );
+
+    // ¼մ Offset ʼοı
+    void RecordUploadedTables( const DescriptorHandleCache& HandleCache, uint32_t UploadedParams, uint32_t Offset );
+
     // Mark all descriptors in the cache as stale and in need of re-uploading.
     void UnbindAllValid( void );
 
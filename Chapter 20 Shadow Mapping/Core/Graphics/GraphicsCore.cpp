@@ -29,6 +29,10 @@
 #include "CommandSignature.h"
 // #include "ParticleEffectManager.h"
 #include "GraphRenderer.h"
+#include "NullDevice.h"
+#include "PipelineCache.h"
+#include "UploadRing.h"
+#include "TextureStreamer.h"
 // #include "TemporalEffects.h"
 
 // This macro determines whether to detect if there is an HDR display and enable HDR10 output.
@@ -102,6 +106,8 @@ namespace Graphics
     void PreparePresentLDR();
     void PreparePresentHDR();
     void CompositeOverlays( GraphicsContext& Context );
+    bool CreateHardwareDevice(void);
+    void CreateNullDevice(void);
 
 // #ifndef RELEASE
 //     const GUID WKPDID_D3DDebugObjectName = { 0x429b8c22,0x9188,0x4b0c, { 0x87,0x42,0xac,0xb0,0xbf,0x85,0xc2,0x00 } };
@@ -263,11 +269,9 @@ void Graphics::Resize(uint32_t width, uint32_t height)
     ResizeDisplayDependentBuffers(g_NativeWidth, g_NativeHeight);
 }
 
-// Initialize the DirectX resources required to run.
-bool Graphics::Initialize(void)
+// Ӳ豸ͽ
+bool Graphics::CreateHardwareDevice(void)
 {
-    ASSERT(s_SwapChain1 == nullptr, "Graphics has already been initialized");
-
     Microsoft::WRL::ComPtr<ID3D12Device> pDevice;
 
 	// debug
@@ -446,6 +450,44 @@ bool Graphics::Initialize(void)
         g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
     }
 
+    return true;
+}
+
+// 豸ҪDXGIʹڡʾƽͨȾĿ꣬Present ʱᷭת
+void Graphics::CreateNullDevice(void)
+{
+    g_Device = NullDevice::CreateDevice();
+
+    g_CommandManager.Create(g_Device);
+
+    D3D12_RESOURCE_DESC DisplayDesc = CD3DX12_RESOURCE_DESC::Tex2D(SwapChainFormat, g_DisplayWidth, g_DisplayHeight, 1, 1, 1, 0,
+        D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+    for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+    {
+        ComPtr<ID3D12Resource> DisplayPlane;
+        ASSERT_SUCCEEDED(g_Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+            &DisplayDesc, D3D12_RESOURCE_STATE_PRESENT, nullptr, MY_IID_PPV_ARGS(&DisplayPlane)));
+        g_DisplayPlane[i].CreateFromSwapChain(L"Null Display Buffer", DisplayPlane.Detach());
+    }
+}
+
+// Initialize the DirectX resources required to run.
+bool Graphics::Initialize(bool UseNullDevice)
+{
+    ASSERT(g_Device == nullptr, "Graphics has already been initialized");
+
+    if (UseNullDevice)
+        CreateNullDevice();
+    else if (!CreateHardwareDevice())
+        return false;
+
+    // ֮󴴽PSOȲ̻
+    PipelineCache::Initialize(L"PipelineCache.bin");
+
+    // ÿ̬֡Ͷϴһ֡Լ2MB
+    UploadRingAllocator::Initialize(0x200000);
+
     // Common state was moved to GraphicsCommon.*
     InitializeCommonState();
 
@@ -538,16 +580,20 @@ void Graphics::Terminate( void )
 {
     g_CommandManager.IdleGPU();
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
-    s_SwapChain1->SetFullscreenState(FALSE, nullptr);
+    if (s_SwapChain1 != nullptr)
+        s_SwapChain1->SetFullscreenState(FALSE, nullptr);
 #endif
 }
 
 void Graphics::Shutdown( void )
 {
+    // ϴ̻߳ÿк
+    TextureStreamer::Shutdown();
     CommandContext::DestroyAllContexts();
     g_CommandManager.Shutdown();
     GpuTimeManager::Shutdown();
-    s_SwapChain1->Release();
+    SAFE_RELEASE(s_SwapChain1);
+    PipelineCache::Shutdown();
     PSO::DestroyAll();
     RootSignature::DestroyAll();
     DescriptorAllocator::DestroyAll();
@@ -725,11 +771,16 @@ void Graphics::Present(void)
     else
         PreparePresentLDR();
 
+    // ֡ĶѾύϴϱ֡ĿռGPUִ
+    UploadRingAllocator::EndFrame();
+
     g_CurrentBuffer = (g_CurrentBuffer + 1) % SWAP_CHAIN_BUFFER_COUNT;
 
     UINT PresentInterval = s_EnableVSync ? std::min(4, (int)Round(s_FrameTime * 60.0f)) : 0;
 
-    s_SwapChain1->Present(PresentInterval, 0);
+    // 豸ûн
+    if (s_SwapChain1 != nullptr)
+        s_SwapChain1->Present(PresentInterval, 0);
 
     // Test robustness to handle spikes in CPU time
     //if (s_DropRandomFrames)
@@ -35,7 +35,8 @@ namespace Graphics
 
     using namespace Microsoft::WRL;
 
-    bool Initialize(void);
+    // UseNullDevice ΪtrueʱʹòҪGPUʹڵĿ豸 NullDevice.h
+    bool Initialize(bool UseNullDevice = false);
     void Resize(uint32_t width, uint32_t height);
     void Terminate(void);
     void Shutdown(void);
@@ -68,6 +69,10 @@ namespace Graphics
     {
         return g_DescriptorAllocator[Type].Allocate(Count);
     }
+    inline bool FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE Type, D3D12_CPU_DESCRIPTOR_HANDLE Handle, UINT Count = 1 )
+    {
+        return g_DescriptorAllocator[Type].Free(Handle, Count);
+    }
 
     extern RootSignature g_GenerateMipsRS;
     extern ComputePSO g_GenerateMipsLinearPSO[4];
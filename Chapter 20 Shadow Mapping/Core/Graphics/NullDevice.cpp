@@ -0,0 +1,1283 @@
+#include "pch.h"
+#include "NullDevice.h"
+
+#include <algorithm>
+#include <atomic>
+#include <malloc.h>
+#include <mutex>
+
+namespace NullDevice
+{
+    namespace
+    {
+        // ÿռõַС
+        const UINT kDescriptorSize = 32;
+
+        // Դѷַռ䣬64KB룬ַֻ
+        std::atomic<uint64_t> s_NextGpuAddress(0x100000000ull);
+        std::atomic<uint64_t> s_NextDescriptorAddress(0x10000000ull);
+
+        // ţŴָ룬ʹͬĵ˳õͬ
+        std::atomic<uint32_t> s_NextObjectId(1);
+
+        uint64_t AllocateAddressRange(std::atomic<uint64_t>& Next, uint64_t Size)
+        {
+            return Next.fetch_add(Math::AlignUp(std::max<uint64_t>(Size, 1), 0x10000));
+        }
+
+        uint32_t BitsPerPixel(DXGI_FORMAT Format)
+        {
+            switch (Format)
+            {
+            case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            case DXGI_FORMAT_R32G32B32A32_UINT:
+            case DXGI_FORMAT_R32G32B32A32_SINT:
+                return 128;
+
+            case DXGI_FORMAT_R32G32B32_TYPELESS:
+            case DXGI_FORMAT_R32G32B32_FLOAT:
+            case DXGI_FORMAT_R32G32B32_UINT:
+            case DXGI_FORMAT_R32G32B32_SINT:
+                return 96;
+
+            case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            case DXGI_FORMAT_R16G16B16A16_UNORM:
+            case DXGI_FORMAT_R16G16B16A16_UINT:
+            case DXGI_FORMAT_R16G16B16A16_SNORM:
+            case DXGI_FORMAT_R16G16B16A16_SINT:
+            case DXGI_FORMAT_R32G32_TYPELESS:
+            case DXGI_FORMAT_R32G32_FLOAT:
+            case DXGI_FORMAT_R32G32_UINT:
+            case DXGI_FORMAT_R32G32_SINT:
+            case DXGI_FORMAT_R32G8X24_TYPELESS:
+            case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+            case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+                return 64;
+
+            case DXGI_FORMAT_R16_TYPELESS:
+            case DXGI_FORMAT_R16_FLOAT:
+            case DXGI_FORMAT_D16_UNORM:
+            case DXGI_FORMAT_R16_UNORM:
+            case DXGI_FORMAT_R16_UINT:
+            case DXGI_FORMAT_R16_SNORM:
+            case DXGI_FORMAT_R16_SINT:
+            case DXGI_FORMAT_R8G8_TYPELESS:
+            case DXGI_FORMAT_R8G8_UNORM:
+            case DXGI_FORMAT_R8G8_UINT:
+            case DXGI_FORMAT_R8G8_SNORM:
+            case DXGI_FORMAT_R8G8_SINT:
+            case DXGI_FORMAT_B5G6R5_UNORM:
+            case DXGI_FORMAT_B5G5R5A1_UNORM:
+                return 16;
+
+            case DXGI_FORMAT_R8_TYPELESS:
+            case DXGI_FORMAT_R8_UNORM:
+            case DXGI_FORMAT_R8_UINT:
+            case DXGI_FORMAT_R8_SNORM:
+            case DXGI_FORMAT_R8_SINT:
+            case DXGI_FORMAT_A8_UNORM:
+                return 8;
+
+            case DXGI_FORMAT_BC1_TYPELESS:
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC4_TYPELESS:
+            case DXGI_FORMAT_BC4_UNORM:
+            case DXGI_FORMAT_BC4_SNORM:
+                return 4;
+
+            case DXGI_FORMAT_BC2_TYPELESS:
+            case DXGI_FORMAT_BC2_UNORM:
+            case DXGI_FORMAT_BC2_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_TYPELESS:
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+            case DXGI_FORMAT_BC5_TYPELESS:
+            case DXGI_FORMAT_BC5_UNORM:
+            case DXGI_FORMAT_BC5_SNORM:
+            case DXGI_FORMAT_BC6H_TYPELESS:
+            case DXGI_FORMAT_BC6H_UF16:
+            case DXGI_FORMAT_BC6H_SF16:
+            case DXGI_FORMAT_BC7_TYPELESS:
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+                return 8;
+
+            // ೣøʽ(RGBA8R10G10B10A2R11G11B10R32D24S8 )32λ
+            default:
+                return 32;
+            }
+        }
+
+        bool IsBlockCompressed(DXGI_FORMAT Format)
+        {
+            return (Format >= DXGI_FORMAT_BC1_TYPELESS && Format <= DXGI_FORMAT_BC5_SNORM) ||
+                (Format >= DXGI_FORMAT_BC6H_TYPELESS && Format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+        }
+
+        bool HasStencilPlane(DXGI_FORMAT Format)
+        {
+            switch (Format)
+            {
+            case DXGI_FORMAT_R32G8X24_TYPELESS:
+            case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+            case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+            case DXGI_FORMAT_R24G8_TYPELESS:
+            case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+            case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        class Device;
+        Device* s_Device = nullptr;
+
+        // IUnknown  ID3D12Object Ĺʵ
+        template <typename Interface>
+        class Object : public Interface
+        {
+        public:
+            Object() : m_RefCount(1), m_Id(s_NextObjectId++) {}
+            virtual ~Object() {}
+
+            uint32_t GetId() const { return m_Id; }
+
+            HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+            {
+                if (ppvObject == nullptr)
+                    return E_POINTER;
+
+                if (riid == __uuidof(Interface) || riid == __uuidof(IUnknown) || riid == __uuidof(ID3D12Object) || IsBaseInterface(riid))
+                {
+                    AddRef();
+                    *ppvObject = static_cast<Interface*>(this);
+                    return S_OK;
+                }
+
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            ULONG STDMETHODCALLTYPE AddRef(void) override
+            {
+                return ++m_RefCount;
+            }
+
+            ULONG STDMETHODCALLTYPE Release(void) override
+            {
+                ULONG RefCount = --m_RefCount;
+                if (RefCount == 0)
+                    delete this;
+                return RefCount;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) override { return DXGI_ERROR_NOT_FOUND; }
+            HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+
+        protected:
+            virtual bool IsBaseInterface(REFIID) const { return false; }
+
+        private:
+            std::atomic<ULONG> m_RefCount;
+            const uint32_t m_Id;
+        };
+
+        // м¼ţnullptrΪ0
+        template <typename Interface>
+        uint32_t IdOf(Interface* p)
+        {
+            return p == nullptr ? 0 : static_cast<Object<Interface>*>(p)->GetId();
+        }
+
+        // ID3D12DeviceChild Ĺʵ֡Ӷ󲻳豸ã豸ͷ
+        template <typename Interface>
+        class DeviceChild : public Object<Interface>
+        {
+        public:
+            explicit DeviceChild(Device* pDevice) : m_Device(pDevice) {}
+
+            HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override;
+
+        protected:
+            bool IsBaseInterface(REFIID riid) const override
+            {
+                return riid == __uuidof(ID3D12DeviceChild) || riid == __uuidof(ID3D12Pageable);
+            }
+
+            Device* m_Device;
+        };
+
+        class RootSignature : public DeviceChild<ID3D12RootSignature>
+        {
+        public:
+            using DeviceChild::DeviceChild;
+        };
+
+        class PipelineState : public DeviceChild<ID3D12PipelineState>
+        {
+        public:
+            using DeviceChild::DeviceChild;
+
+            HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) override
+            {
+                *ppBlob = nullptr;
+                return DXGI_ERROR_UNSUPPORTED;
+            }
+        };
+
+        class CommandAllocator : public DeviceChild<ID3D12CommandAllocator>
+        {
+        public:
+            using DeviceChild::DeviceChild;
+
+            HRESULT STDMETHODCALLTYPE Reset(void) override { return S_OK; }
+        };
+
+        class QueryHeap : public DeviceChild<ID3D12QueryHeap>
+        {
+        public:
+            using DeviceChild::DeviceChild;
+        };
+
+        class CommandSignature : public DeviceChild<ID3D12CommandSignature>
+        {
+        public:
+            using DeviceChild::DeviceChild;
+        };
+
+        // ύĹɣ Signal ֵ֮ɵֵ
+        class Fence : public DeviceChild<ID3D12Fence>
+        {
+        public:
+            Fence(Device* pDevice, UINT64 InitialValue) : DeviceChild(pDevice), m_Value(InitialValue) {}
+
+            UINT64 STDMETHODCALLTYPE GetCompletedValue(void) override { return m_Value; }
+
+            HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64, HANDLE hEvent) override
+            {
+                if (hEvent != nullptr)
+                    SetEvent(hEvent);
+                return S_OK;
+            }
+
+            HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+            {
+                m_Value = Value;
+                return S_OK;
+            }
+
+        private:
+            std::atomic<UINT64> m_Value;
+        };
+
+        class DescriptorHeap : public DeviceChild<ID3D12DescriptorHeap>
+        {
+        public:
+            DescriptorHeap(Device* pDevice, const D3D12_DESCRIPTOR_HEAP_DESC& Desc) : DeviceChild(pDevice), m_Desc(Desc)
+            {
+                m_Start = AllocateAddressRange(s_NextDescriptorAddress, (uint64_t)Desc.NumDescriptors * kDescriptorSize);
+            }
+
+            D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc(void) override { return m_Desc; }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart(void) override
+            {
+                D3D12_CPU_DESCRIPTOR_HANDLE Handle = { (SIZE_T)m_Start };
+                return Handle;
+            }
+
+            D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart(void) override
+            {
+                D3D12_GPU_DESCRIPTOR_HANDLE Handle = { (m_Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) ? m_Start : 0 };
+                return Handle;
+            }
+
+        private:
+            D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+            uint64_t m_Start;
+        };
+
+        class Resource : public DeviceChild<ID3D12Resource>
+        {
+        public:
+            Resource(Device* pDevice, const D3D12_HEAP_PROPERTIES& HeapProps, const D3D12_RESOURCE_DESC& Desc)
+                : DeviceChild(pDevice), m_HeapProps(HeapProps), m_Desc(Desc), m_GpuAddress(0), m_CpuMemory(nullptr)
+            {
+                if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                {
+                    m_GpuAddress = AllocateAddressRange(s_NextGpuAddress, Desc.Width);
+
+                    // ֻCPUɼĶҪʵڴ
+                    if (HeapProps.Type == D3D12_HEAP_TYPE_UPLOAD || HeapProps.Type == D3D12_HEAP_TYPE_READBACK ||
+                        (HeapProps.Type == D3D12_HEAP_TYPE_CUSTOM && HeapProps.CPUPageProperty != D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE))
+                    {
+                        m_CpuMemory = _aligned_malloc((size_t)Desc.Width, 256);
+                        ZeroMemory(m_CpuMemory, (size_t)Desc.Width);
+                    }
+                }
+            }
+
+            ~Resource()
+            {
+                if (m_CpuMemory != nullptr)
+                    _aligned_free(m_CpuMemory);
+            }
+
+            HRESULT STDMETHODCALLTYPE Map(UINT Subresource, const D3D12_RANGE*, void** ppData) override
+            {
+                if (Subresource != 0 || m_CpuMemory == nullptr)
+                    return E_INVALIDARG;
+                if (ppData != nullptr)
+                    *ppData = m_CpuMemory;
+                return S_OK;
+            }
+
+            void STDMETHODCALLTYPE Unmap(UINT, const D3D12_RANGE*) override {}
+
+            D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc(void) override { return m_Desc; }
+
+            D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress(void) override { return m_GpuAddress; }
+
+            HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT, const D3D12_BOX*, const void*, UINT, UINT) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE ReadFromSubresource(void*, UINT, UINT, UINT, const D3D12_BOX*) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) override
+            {
+                if (pHeapProperties != nullptr)
+                    *pHeapProperties = m_HeapProps;
+                if (pHeapFlags != nullptr)
+                    *pHeapFlags = D3D12_HEAP_FLAG_NONE;
+                return S_OK;
+            }
+
+        private:
+            D3D12_HEAP_PROPERTIES m_HeapProps;
+            D3D12_RESOURCE_DESC m_Desc;
+            D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress;
+            void* m_CpuMemory;
+        };
+
+        // Ĳ룬ÿ1ֽڲϰ˳дĲ
+        enum Opcode : uint8_t
+        {
+            kOpClearState,
+            kOpDraw,
+            kOpDrawIndexed,
+            kOpDispatch,
+            kOpCopyBufferRegion,
+            kOpCopyTextureRegion,
+            kOpCopyResource,
+            kOpCopyTiles,
+            kOpResolveSubresource,
+            kOpPrimitiveTopology,
+            kOpViewports,
+            kOpScissorRects,
+            kOpBlendFactor,
+            kOpStencilRef,
+            kOpPipelineState,
+            kOpResourceBarrier,
+            kOpExecuteBundle,
+            kOpDescriptorHeaps,
+            kOpComputeRootSignature,
+            kOpGraphicsRootSignature,
+            kOpComputeDescriptorTable,
+            kOpGraphicsDescriptorTable,
+            kOpComputeConstants,
+            kOpGraphicsConstants,
+            kOpComputeCBV,
+            kOpGraphicsCBV,
+            kOpComputeSRV,
+            kOpGraphicsSRV,
+            kOpComputeUAV,
+            kOpGraphicsUAV,
+            kOpIndexBuffer,
+            kOpVertexBuffers,
+            kOpStreamOutput,
+            kOpRenderTargets,
+            kOpClearDepthStencil,
+            kOpClearRenderTarget,
+            kOpClearUAVUint,
+            kOpClearUAVFloat,
+            kOpDiscardResource,
+            kOpBeginQuery,
+            kOpEndQuery,
+            kOpResolveQueryData,
+            kOpPredication,
+            kOpMarker,
+            kOpBeginEvent,
+            kOpEndEvent,
+            kOpExecuteIndirect,
+        };
+
+        class CommandList : public DeviceChild<ID3D12GraphicsCommandList>
+        {
+        public:
+            CommandList(Device* pDevice, D3D12_COMMAND_LIST_TYPE Type) : DeviceChild(pDevice), m_Type(Type)
+            {
+                ClearCounters();
+            }
+
+            const std::vector<uint8_t>& GetStream() const { return m_Stream; }
+            uint64_t GetCounter(Counter c) const { return m_Counters[c]; }
+
+            D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType(void) override { return m_Type; }
+
+            HRESULT STDMETHODCALLTYPE Close(void) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator*, ID3D12PipelineState* pInitialState) override
+            {
+                m_Stream.clear();
+                ClearCounters();
+                if (pInitialState != nullptr)
+                    SetPipelineState(pInitialState);
+                return S_OK;
+            }
+
+            void STDMETHODCALLTYPE ClearState(ID3D12PipelineState* pPipelineState) override
+            {
+                Begin(kOpClearState);
+                Write(IdOf(pPipelineState));
+            }
+
+            void STDMETHODCALLTYPE DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation) override
+            {
+                Begin(kOpDraw);
+                Write(VertexCountPerInstance);
+                Write(InstanceCount);
+                Write(StartVertexLocation);
+                Write(StartInstanceLocation);
+                ++m_Counters[kDrawCalls];
+            }
+
+            void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) override
+            {
+                Begin(kOpDrawIndexed);
+                Write(IndexCountPerInstance);
+                Write(InstanceCount);
+                Write(StartIndexLocation);
+                Write(BaseVertexLocation);
+                Write(StartInstanceLocation);
+                ++m_Counters[kDrawCalls];
+            }
+
+            void STDMETHODCALLTYPE Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override
+            {
+                Begin(kOpDispatch);
+                Write(ThreadGroupCountX);
+                Write(ThreadGroupCountY);
+                Write(ThreadGroupCountZ);
+                ++m_Counters[kDispatches];
+            }
+
+            void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes) override
+            {
+                Begin(kOpCopyBufferRegion);
+                Write(IdOf(pDstBuffer));
+                Write(DstOffset);
+                Write(IdOf(pSrcBuffer));
+                Write(SrcOffset);
+                Write(NumBytes);
+                ++m_Counters[kCopies];
+            }
+
+            void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ, const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox) override
+            {
+                Begin(kOpCopyTextureRegion);
+                WriteCopyLocation(*pDst);
+                Write(DstX);
+                Write(DstY);
+                Write(DstZ);
+                WriteCopyLocation(*pSrc);
+                Write((uint8_t)(pSrcBox != nullptr));
+                if (pSrcBox != nullptr)
+                    Write(*pSrcBox);
+                ++m_Counters[kCopies];
+            }
+
+            void STDMETHODCALLTYPE CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource) override
+            {
+                Begin(kOpCopyResource);
+                Write(IdOf(pDstResource));
+                Write(IdOf(pSrcResource));
+                ++m_Counters[kCopies];
+            }
+
+            void STDMETHODCALLTYPE CopyTiles(ID3D12Resource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate,
+                const D3D12_TILE_REGION_SIZE* pTileRegionSize, ID3D12Resource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags) override
+            {
+                Begin(kOpCopyTiles);
+                Write(IdOf(pTiledResource));
+                Write(*pTileRegionStartCoordinate);
+                Write(*pTileRegionSize);
+                Write(IdOf(pBuffer));
+                Write(BufferStartOffsetInBytes);
+                Write(Flags);
+                ++m_Counters[kCopies];
+            }
+
+            void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource* pDstResource, UINT DstSubresource, ID3D12Resource* pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format) override
+            {
+                Begin(kOpResolveSubresource);
+                Write(IdOf(pDstResource));
+                Write(DstSubresource);
+                Write(IdOf(pSrcResource));
+                Write(SrcSubresource);
+                Write(Format);
+                ++m_Counters[kCopies];
+            }
+
+            void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology) override
+            {
+                Begin(kOpPrimitiveTopology);
+                Write((uint8_t)PrimitiveTopology);
+                ++m_Counters[kTopologies];
+            }
+
+            void STDMETHODCALLTYPE RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports) override
+            {
+                Begin(kOpViewports);
+                WriteArray(NumViewports, pViewports);
+            }
+
+            void STDMETHODCALLTYPE RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects) override
+            {
+                Begin(kOpScissorRects);
+                WriteArray(NumRects, pRects);
+            }
+
+            void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT BlendFactor[4]) override
+            {
+                Begin(kOpBlendFactor);
+                WriteArray(4, BlendFactor);
+            }
+
+            void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override
+            {
+                Begin(kOpStencilRef);
+                Write(StencilRef);
+            }
+
+            void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState* pPipelineState) override
+            {
+                Begin(kOpPipelineState);
+                Write(IdOf(pPipelineState));
+                ++m_Counters[kPipelineStates];
+            }
+
+            void STDMETHODCALLTYPE ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) override
+            {
+                Begin(kOpResourceBarrier);
+                Write(NumBarriers);
+                for (UINT i = 0; i < NumBarriers; ++i)
+                {
+                    const D3D12_RESOURCE_BARRIER& Barrier = pBarriers[i];
+                    Write((uint8_t)Barrier.Type);
+                    Write((uint8_t)Barrier.Flags);
+                    switch (Barrier.Type)
+                    {
+                    case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+                        Write(IdOf(Barrier.Transition.pResource));
+                        Write(Barrier.Transition.Subresource);
+                        Write((uint32_t)Barrier.Transition.StateBefore);
+                        Write((uint32_t)Barrier.Transition.StateAfter);
+                        break;
+                    case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+                        Write(IdOf(Barrier.Aliasing.pResourceBefore));
+                        Write(IdOf(Barrier.Aliasing.pResourceAfter));
+                        break;
+                    case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+                        Write(IdOf(Barrier.UAV.pResource));
+                        break;
+                    }
+                }
+                m_Counters[kBarriers] += NumBarriers;
+                ++m_Counters[kBarrierCalls];
+            }
+
+            void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList* pCommandList) override
+            {
+                Begin(kOpExecuteBundle);
+                Write(IdOf(pCommandList));
+            }
+
+            void STDMETHODCALLTYPE SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps) override
+            {
+                Begin(kOpDescriptorHeaps);
+                Write(NumDescriptorHeaps);
+                for (UINT i = 0; i < NumDescriptorHeaps; ++i)
+                    Write(IdOf(ppDescriptorHeaps[i]));
+            }
+
+            void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override
+            {
+                Begin(kOpComputeRootSignature);
+                Write(IdOf(pRootSignature));
+                ++m_Counters[kRootSignatures];
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override
+            {
+                Begin(kOpGraphicsRootSignature);
+                Write(IdOf(pRootSignature));
+                ++m_Counters[kRootSignatures];
+            }
+
+            void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+            {
+                RootArgument(kOpComputeDescriptorTable, RootParameterIndex, BaseDescriptor.ptr);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+            {
+                RootArgument(kOpGraphicsDescriptorTable, RootParameterIndex, BaseDescriptor.ptr);
+            }
+
+            void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+            {
+                SetComputeRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+            {
+                SetGraphicsRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+            }
+
+            void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues) override
+            {
+                RootConstants(kOpComputeConstants, RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues) override
+            {
+                RootConstants(kOpGraphicsConstants, RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
+            }
+
+            void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpComputeCBV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpGraphicsCBV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpComputeSRV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpGraphicsSRV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpComputeUAV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+            {
+                RootArgument(kOpGraphicsUAV, RootParameterIndex, BufferLocation);
+            }
+
+            void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) override
+            {
+                Begin(kOpIndexBuffer);
+                Write((uint8_t)(pView != nullptr));
+                if (pView != nullptr)
+                    Write(*pView);
+                ++m_Counters[kIndexBuffers];
+            }
+
+            void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) override
+            {
+                Begin(kOpVertexBuffers);
+                Write(StartSlot);
+                WriteArray(pViews != nullptr ? NumViews : 0, pViews);
+                ++m_Counters[kVertexBuffers];
+            }
+
+            void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews) override
+            {
+                Begin(kOpStreamOutput);
+                Write(StartSlot);
+                WriteArray(pViews != nullptr ? NumViews : 0, pViews);
+            }
+
+            void STDMETHODCALLTYPE OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+                BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor) override
+            {
+                Begin(kOpRenderTargets);
+                Write((uint8_t)RTsSingleHandleToDescriptorRange);
+                WriteArray(RTsSingleHandleToDescriptorRange ? std::min(NumRenderTargetDescriptors, 1u) : NumRenderTargetDescriptors, pRenderTargetDescriptors);
+                Write((uint64_t)(pDepthStencilDescriptor != nullptr ? pDepthStencilDescriptor->ptr : 0));
+            }
+
+            void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects) override
+            {
+                Begin(kOpClearDepthStencil);
+                Write((uint64_t)DepthStencilView.ptr);
+                Write((uint8_t)ClearFlags);
+                Write(Depth);
+                Write(Stencil);
+                WriteArray(NumRects, pRects);
+                ++m_Counters[kClears];
+            }
+
+            void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects, const D3D12_RECT* pRects) override
+            {
+                Begin(kOpClearRenderTarget);
+                Write((uint64_t)RenderTargetView.ptr);
+                WriteArray(4, ColorRGBA);
+                WriteArray(NumRects, pRects);
+                ++m_Counters[kClears];
+            }
+
+            void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+                ID3D12Resource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects) override
+            {
+                Begin(kOpClearUAVUint);
+                Write((uint64_t)ViewGPUHandleInCurrentHeap.ptr);
+                Write((uint64_t)ViewCPUHandle.ptr);
+                Write(IdOf(pResource));
+                WriteArray(4, Values);
+                WriteArray(NumRects, pRects);
+                ++m_Counters[kClears];
+            }
+
+            void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+                ID3D12Resource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects) override
+            {
+                Begin(kOpClearUAVFloat);
+                Write((uint64_t)ViewGPUHandleInCurrentHeap.ptr);
+                Write((uint64_t)ViewCPUHandle.ptr);
+                Write(IdOf(pResource));
+                WriteArray(4, Values);
+                WriteArray(NumRects, pRects);
+                ++m_Counters[kClears];
+            }
+
+            void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION*) override
+            {
+                Begin(kOpDiscardResource);
+                Write(IdOf(pResource));
+            }
+
+            void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+            {
+                Begin(kOpBeginQuery);
+                Write(IdOf(pQueryHeap));
+                Write((uint8_t)Type);
+                Write(Index);
+            }
+
+            void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+            {
+                Begin(kOpEndQuery);
+                Write(IdOf(pQueryHeap));
+                Write((uint8_t)Type);
+                Write(Index);
+            }
+
+            void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries,
+                ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset) override
+            {
+                Begin(kOpResolveQueryData);
+                Write(IdOf(pQueryHeap));
+                Write((uint8_t)Type);
+                Write(StartIndex);
+                Write(NumQueries);
+                Write(IdOf(pDestinationBuffer));
+                Write(AlignedDestinationBufferOffset);
+            }
+
+            void STDMETHODCALLTYPE SetPredication(ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation) override
+            {
+                Begin(kOpPredication);
+                Write(IdOf(pBuffer));
+                Write(AlignedBufferOffset);
+                Write((uint8_t)Operation);
+            }
+
+            // PIX ¼ͱǲֻ
+            void STDMETHODCALLTYPE SetMarker(UINT, const void*, UINT) override { Begin(kOpMarker); }
+            void STDMETHODCALLTYPE BeginEvent(UINT, const void*, UINT) override { Begin(kOpBeginEvent); }
+            void STDMETHODCALLTYPE EndEvent(void) override { Begin(kOpEndEvent); }
+
+            void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature* pCommandSignature, UINT MaxCommandCount, ID3D12Resource* pArgumentBuffer,
+                UINT64 ArgumentBufferOffset, ID3D12Resource* pCountBuffer, UINT64 CountBufferOffset) override
+            {
+                Begin(kOpExecuteIndirect);
+                Write(IdOf(pCommandSignature));
+                Write(MaxCommandCount);
+                Write(IdOf(pArgumentBuffer));
+                Write(ArgumentBufferOffset);
+                Write(IdOf(pCountBuffer));
+                Write(CountBufferOffset);
+                ++m_Counters[kDrawCalls];
+            }
+
+        private:
+            void ClearCounters(void)
+            {
+                for (uint64_t& Value : m_Counters)
+                    Value = 0;
+            }
+
+            void Begin(Opcode Op)
+            {
+                m_Stream.push_back(Op);
+                ++m_Counters[kCommands];
+            }
+
+            void Write(const void* pData, size_t Size)
+            {
+                const uint8_t* pBytes = (const uint8_t*)pData;
+                m_Stream.insert(m_Stream.end(), pBytes, pBytes + Size);
+            }
+
+            template <typename T>
+            void Write(const T& Value)
+            {
+                Write(&Value, sizeof(T));
+            }
+
+            template <typename T>
+            void WriteArray(UINT Count, const T* pValues)
+            {
+                Write(Count);
+                Write(pValues, Count * sizeof(T));
+            }
+
+            void WriteCopyLocation(const D3D12_TEXTURE_COPY_LOCATION& Location)
+            {
+                Write(IdOf(Location.pResource));
+                Write((uint8_t)Location.Type);
+                if (Location.Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
+                    Write(Location.SubresourceIndex);
+                else
+                    Write(Location.PlacedFootprint);
+            }
+
+            void RootArgument(Opcode Op, UINT RootParameterIndex, UINT64 Value)
+            {
+                Begin(Op);
+                Write((uint8_t)RootParameterIndex);
+                Write(Value);
+                ++m_Counters[kRootArguments];
+            }
+
+            void RootConstants(Opcode Op, UINT RootParameterIndex, UINT Num32BitValues, const void* pSrcData, UINT DestOffset)
+            {
+                Begin(Op);
+                Write((uint8_t)RootParameterIndex);
+                Write(DestOffset);
+                WriteArray(Num32BitValues, (const uint32_t*)pSrcData);
+                ++m_Counters[kRootArguments];
+            }
+
+            const D3D12_COMMAND_LIST_TYPE m_Type;
+            std::vector<uint8_t> m_Stream;
+            uint64_t m_Counters[kCounterCount];
+        };
+
+        class CommandQueue : public DeviceChild<ID3D12CommandQueue>
+        {
+        public:
+            CommandQueue(Device* pDevice, const D3D12_COMMAND_QUEUE_DESC& Desc) : DeviceChild(pDevice), m_Desc(Desc) {}
+
+            void STDMETHODCALLTYPE UpdateTileMappings(ID3D12Resource*, UINT, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*,
+                ID3D12Heap*, UINT, const D3D12_TILE_RANGE_FLAGS*, const UINT*, const UINT*, D3D12_TILE_MAPPING_FLAGS) override {}
+
+            void STDMETHODCALLTYPE CopyTileMappings(ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, ID3D12Resource*,
+                const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, D3D12_TILE_MAPPING_FLAGS) override {}
+
+            void STDMETHODCALLTYPE ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) override;
+
+            void STDMETHODCALLTYPE SetMarker(UINT, const void*, UINT) override {}
+            void STDMETHODCALLTYPE BeginEvent(UINT, const void*, UINT) override {}
+            void STDMETHODCALLTYPE EndEvent(void) override {}
+
+            HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 Value) override
+            {
+                return pFence->Signal(Value);
+            }
+
+            HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence*, UINT64) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64* pFrequency) override
+            {
+                *pFrequency = 1000000;
+                return S_OK;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64* pGpuTimestamp, UINT64* pCpuTimestamp) override
+            {
+                *pGpuTimestamp = 0;
+                *pCpuTimestamp = 0;
+                return S_OK;
+            }
+
+            D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc(void) override { return m_Desc; }
+
+        private:
+            D3D12_COMMAND_QUEUE_DESC m_Desc;
+        };
+
+        // ӿڴӶ󲢷Ľӿ
+        template <typename T>
+        HRESULT ReturnObject(T* pObject, REFIID riid, void** ppvObject)
+        {
+            if (ppvObject == nullptr)
+            {
+                // ֻʱض
+                pObject->Release();
+                return S_FALSE;
+            }
+
+            HRESULT hr = pObject->QueryInterface(riid, ppvObject);
+            pObject->Release();
+            return hr;
+        }
+
+        class Device : public Object<ID3D12Device>
+        {
+        public:
+            Device() : m_Capture(nullptr)
+            {
+                for (auto& Value : m_Counters)
+                    Value = 0;
+            }
+
+            ~Device()
+            {
+                s_Device = nullptr;
+            }
+
+            Counters GetCounters(void) const
+            {
+                Counters Result;
+                for (int i = 0; i < kCounterCount; ++i)
+                    Result.Value[i] = m_Counters[i];
+                return Result;
+            }
+
+            void CaptureStream(std::vector<uint8_t>* Stream)
+            {
+                std::lock_guard<std::mutex> LockGuard(m_CaptureMutex);
+                m_Capture = Stream;
+            }
+
+            void Submit(const CommandList& List)
+            {
+                for (int i = 0; i < kCounterCount; ++i)
+                    m_Counters[i] += List.GetCounter((Counter)i);
+                ++m_Counters[kCommandLists];
+                m_Counters[kStreamBytes] += List.GetStream().size();
+
+                std::lock_guard<std::mutex> LockGuard(m_CaptureMutex);
+                if (m_Capture != nullptr)
+                    m_Capture->insert(m_Capture->end(), List.GetStream().begin(), List.GetStream().end());
+            }
+
+            UINT STDMETHODCALLTYPE GetNodeCount(void) override { return 1; }
+
+            HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override
+            {
+                return ReturnObject(new CommandQueue(this, *pDesc), riid, ppCommandQueue);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID riid, void** ppCommandAllocator) override
+            {
+                return ReturnObject(new CommandAllocator(this), riid, ppCommandAllocator);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState) override
+            {
+                return ReturnObject(new PipelineState(this), riid, ppPipelineState);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState) override
+            {
+                return ReturnObject(new PipelineState(this), riid, ppPipelineState);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE Type, ID3D12CommandAllocator*, ID3D12PipelineState* pInitialState,
+                REFIID riid, void** ppCommandList) override
+            {
+                CommandList* pList = new CommandList(this, Type);
+                pList->Reset(nullptr, pInitialState);
+                return ReturnObject(pList, riid, ppCommandList);
+            }
+
+            HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize) override
+            {
+                switch (Feature)
+                {
+                case D3D12_FEATURE_D3D12_OPTIONS:
+                    // κοѡ
+                    ZeroMemory(pFeatureSupportData, FeatureSupportDataSize);
+                    return S_OK;
+
+                case D3D12_FEATURE_FORMAT_INFO:
+                {
+                    D3D12_FEATURE_DATA_FORMAT_INFO* pInfo = (D3D12_FEATURE_DATA_FORMAT_INFO*)pFeatureSupportData;
+                    pInfo->PlaneCount = HasStencilPlane(pInfo->Format) ? 2 : 1;
+                    return S_OK;
+                }
+
+                default:
+                    return E_INVALIDARG;
+                }
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap) override
+            {
+                return ReturnObject(new DescriptorHeap(this, *pDescriptorHeapDesc), riid, ppvHeap);
+            }
+
+            UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override
+            {
+                return kDescriptorSize;
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateRootSignature(UINT, const void*, SIZE_T, REFIID riid, void** ppvRootSignature) override
+            {
+                return ReturnObject(new RootSignature(this), riid, ppvRootSignature);
+            }
+
+            // ַֻͼҪдκ
+            void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+            void STDMETHODCALLTYPE CreateShaderResourceView(ID3D12Resource*, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+            void STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D12Resource*, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+            void STDMETHODCALLTYPE CreateRenderTargetView(ID3D12Resource*, const D3D12_RENDER_TARGET_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+            void STDMETHODCALLTYPE CreateDepthStencilView(ID3D12Resource*, const D3D12_DEPTH_STENCIL_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+            void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+
+            void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT* pDestDescriptorRangeSizes,
+                UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, D3D12_DESCRIPTOR_HEAP_TYPE) override
+            {
+                uint64_t Count = 0;
+                for (UINT i = 0; i < NumDestDescriptorRanges; ++i)
+                    Count += pDestDescriptorRangeSizes != nullptr ? pDestDescriptorRangeSizes[i] : 1;
+                m_Counters[kDescriptorCopies] += Count;
+            }
+
+            void STDMETHODCALLTYPE CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE) override
+            {
+                m_Counters[kDescriptorCopies] += NumDescriptors;
+            }
+
+            D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT, UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) override
+            {
+                D3D12_RESOURCE_ALLOCATION_INFO Info = { 0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+                for (UINT i = 0; i < numResourceDescs; ++i)
+                {
+                    const D3D12_RESOURCE_DESC& Desc = pResourceDescs[i];
+                    UINT NumSubresources = Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? 1 :
+                        std::max<UINT>(Desc.MipLevels, 1) * (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : Desc.DepthOrArraySize);
+                    UINT64 Size = 0;
+                    GetCopyableFootprints(&Desc, 0, NumSubresources, 0, nullptr, nullptr, nullptr, &Size);
+                    Info.SizeInBytes = Math::AlignUp(Info.SizeInBytes, Info.Alignment) + Math::AlignUp(Size, Info.Alignment);
+                }
+                return Info;
+            }
+
+            D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT, D3D12_HEAP_TYPE heapType) override
+            {
+                D3D12_HEAP_PROPERTIES Props = { D3D12_HEAP_TYPE_CUSTOM, D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE, D3D12_MEMORY_POOL_L1, 1, 1 };
+                if (heapType == D3D12_HEAP_TYPE_UPLOAD)
+                    Props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+                else if (heapType == D3D12_HEAP_TYPE_READBACK)
+                    Props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+                if (heapType != D3D12_HEAP_TYPE_DEFAULT)
+                    Props.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+                return Props;
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* pDesc,
+                D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID riidResource, void** ppvResource) override
+            {
+                return ReturnObject(new Resource(this, *pHeapProperties, *pDesc), riidResource, ppvResource);
+            }
+
+            // ֧ʽĶѣԴԴ
+            HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC*, REFIID, void** ppvHeap) override
+            {
+                if (ppvHeap != nullptr)
+                    *ppvHeap = nullptr;
+                return E_NOTIMPL;
+            }
+
+            HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap*, UINT64, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES,
+                const D3D12_CLEAR_VALUE*, REFIID riid, void** ppvResource) override
+            {
+                return ReturnObject(new Resource(this, CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), *pDesc), riid, ppvResource);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateReservedResource(const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*,
+                REFIID riid, void** ppvResource) override
+            {
+                return ReturnObject(new Resource(this, CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), *pDesc), riid, ppvResource);
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateSharedHandle(ID3D12DeviceChild*, const SECURITY_ATTRIBUTES*, DWORD, LPCWSTR, HANDLE*) override { return E_NOTIMPL; }
+            HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE, REFIID, void**) override { return E_NOTIMPL; }
+            HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR, DWORD, HANDLE*) override { return E_NOTIMPL; }
+            HRESULT STDMETHODCALLTYPE MakeResident(UINT, ID3D12Pageable* const*) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE Evict(UINT, ID3D12Pageable* const*) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS, REFIID riid, void** ppFence) override
+            {
+                return ReturnObject(new Fence(this, InitialValue), riid, ppFence);
+            }
+
+            HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason(void) override { return S_OK; }
+
+            // Ӳһ£ÿа D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 룬ÿԴ D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 
+            void STDMETHODCALLTYPE GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources, UINT64 BaseOffset,
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes) override
+            {
+                const D3D12_RESOURCE_DESC& Desc = *pResourceDesc;
+                const UINT MipLevels = std::max<UINT>(Desc.MipLevels, 1);
+                UINT64 Offset = BaseOffset;
+                UINT64 End = BaseOffset;
+
+                for (UINT i = 0; i < NumSubresources; ++i)
+                {
+                    D3D12_SUBRESOURCE_FOOTPRINT Footprint = {};
+                    UINT NumRows = 1;
+                    UINT64 RowSize = 0;
+
+                    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                    {
+                        Footprint.Format = DXGI_FORMAT_UNKNOWN;
+                        Footprint.Width = (UINT)Desc.Width;
+                        Footprint.Height = 1;
+                        Footprint.Depth = 1;
+                        RowSize = Desc.Width;
+                    }
+                    else
+                    {
+                        UINT Mip = (FirstSubresource + i) % MipLevels;
+                        UINT Block = IsBlockCompressed(Desc.Format) ? 4 : 1;
+                        Footprint.Format = Desc.Format;
+                        Footprint.Width = std::max<UINT>((UINT)(Desc.Width >> Mip), 1);
+                        Footprint.Height = std::max<UINT>(Desc.Height >> Mip, 1);
+                        Footprint.Depth = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? std::max<UINT>(Desc.DepthOrArraySize >> Mip, 1) : 1;
+                        NumRows = (Footprint.Height + Block - 1) / Block;
+                        RowSize = (UINT64)(Footprint.Width + Block - 1) / Block * BitsPerPixel(Desc.Format) * Block * Block / 8;
+                    }
+
+                    Footprint.RowPitch = (UINT)Math::AlignUp(RowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+                    Offset = Math::AlignUp(Offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+                    if (pLayouts != nullptr)
+                    {
+                        pLayouts[i].Offset = Offset;
+                        pLayouts[i].Footprint = Footprint;
+                    }
+                    if (pNumRows != nullptr)
+                        pNumRows[i] = NumRows;
+                    if (pRowSizeInBytes != nullptr)
+                        pRowSizeInBytes[i] = RowSize;
+
+                    // һвҪ
+                    End = Offset + (UINT64)Footprint.RowPitch * (NumRows * Footprint.Depth - 1) + RowSize;
+                    Offset = End;
+                }
+
+                if (pTotalBytes != nullptr)
+                    *pTotalBytes = End - BaseOffset;
+            }
+
+            HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC*, REFIID riid, void** ppvHeap) override
+            {
+                return ReturnObject(new QueryHeap(this), riid, ppvHeap);
+            }
+
+            HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL) override { return S_OK; }
+
+            HRESULT STDMETHODCALLTYPE CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC*, ID3D12RootSignature*, REFIID riid, void** ppvCommandSignature) override
+            {
+                return ReturnObject(new CommandSignature(this), riid, ppvCommandSignature);
+            }
+
+            void STDMETHODCALLTYPE GetResourceTiling(ID3D12Resource*, UINT* pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+                D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips, UINT* pNumSubresourceTilings, UINT, D3D12_SUBRESOURCE_TILING*) override
+            {
+                if (pNumTilesForEntireResource != nullptr)
+                    *pNumTilesForEntireResource = 0;
+                if (pPackedMipDesc != nullptr)
+                    *pPackedMipDesc = {};
+                if (pStandardTileShapeForNonPackedMips != nullptr)
+                    *pStandardTileShapeForNonPackedMips = {};
+                if (pNumSubresourceTilings != nullptr)
+                    *pNumSubresourceTilings = 0;
+            }
+
+            LUID STDMETHODCALLTYPE GetAdapterLuid(void) override
+            {
+                LUID Luid = {};
+                return Luid;
+            }
+
+        private:
+            std::atomic<uint64_t> m_Counters[kCounterCount];
+
+            std::mutex m_CaptureMutex;
+            std::vector<uint8_t>* m_Capture;
+        };
+
+        template <typename Interface>
+        HRESULT STDMETHODCALLTYPE DeviceChild<Interface>::GetDevice(REFIID riid, void** ppvDevice)
+        {
+            return m_Device->QueryInterface(riid, ppvDevice);
+        }
+
+        void STDMETHODCALLTYPE CommandQueue::ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists)
+        {
+            for (UINT i = 0; i < NumCommandLists; ++i)
+                m_Device->Submit(*static_cast<CommandList*>(ppCommandLists[i]));
+        }
+    }
+
+    ID3D12Device* CreateDevice(void)
+    {
+        ASSERT(s_Device == nullptr, "Only one null device may exist at a time");
+        s_Device = new Device();
+        return s_Device;
+    }
+
+    Counters GetCounters(void)
+    {
+        ASSERT(s_Device != nullptr);
+        return s_Device->GetCounters();
+    }
+
+    Counters Difference(const Counters& After, const Counters& Before)
+    {
+        Counters Result;
+        for (int i = 0; i < kCounterCount; ++i)
+            Result.Value[i] = After.Value[i] - Before.Value[i];
+        return Result;
+    }
+
+    void CaptureStream(std::vector<uint8_t>* Stream)
+    {
+        ASSERT(s_Device != nullptr);
+        s_Device->CaptureStream(Stream);
+    }
+}
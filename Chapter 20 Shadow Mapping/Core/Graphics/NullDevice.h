@@ -0,0 +1,58 @@
+/*
+	GPUĿ豸
+	ʵõȫD3D12ӿ(豸СбԴѵ)κȾ
+	- бÿñɽյύʱۼӵ豸ͳ
+	- ΧSignalʱɣCPUԶȴGPU
+	- ϴ/ضѵĻʵCPUڴ棬MapԴֻGPUַ
+	- ַܽ(汾Ҳ)
+
+	ûԿĻϲȾCPU GameCore::RunHeadless
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace NullDevice
+{
+    enum Counter
+    {
+        kCommandLists,      // ύб
+        kCommands,          // ¼Ƶ
+        kStreamBytes,       // ֽ
+        kDrawCalls,
+        kDispatches,
+        kBarriers,          // Դϵ
+        kBarrierCalls,      // ResourceBarrier ĵô
+        kDescriptorCopies,  // CopyDescriptors/CopyDescriptorsSimple 
+        kPipelineStates,    // SetPipelineState
+        kRootSignatures,    // Set*RootSignature
+        kRootArguments,     // 
+        kTopologies,        // IASetPrimitiveTopology
+        kIndexBuffers,      // IASetIndexBuffer
+        kVertexBuffers,     // IASetVertexBuffers
+        kCopies,
+        kClears,
+
+        kCounterCount
+    };
+
+    struct Counters
+    {
+        uint64_t Value[kCounterCount];
+
+        uint64_t operator[](Counter c) const { return Value[c]; }
+    };
+
+    // 豸üΪ1ͬʱֻܴһ豸
+    ID3D12Device* CreateDevice(void);
+
+    // 豸ۼֵбڵļύʱŻۼӣڵʱۼ
+    Counters GetCounters(void);
+
+    Counters Difference(const Counters& After, const Counters& Before);
+
+    // Stream Ϊʱ֮ύб׷ӵУnullptrֹͣ
+    void CaptureStream(std::vector<uint8_t>* Stream);
+}
@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "PipelineCache.h"
+#include "GraphicsCore.h"
+#include "FileUtility.h"
+#include "SystemTime.h"
+#include "Hash.h"
+#include <dxgi1_4.h>
+#include <map>
+#include <mutex>
+#include <fstream>
+
+using Microsoft::WRL::ComPtr;
+
+namespace PipelineCache
+{
+    // ļʽıʱӰ汾ţļ
+    static const uint32_t kMagic = 0x434F5350;     // "PSOC"
+    static const uint32_t kVersion = 1;
+
+    struct FileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t AdapterKey;
+        uint32_t EntryCount;
+        uint32_t Pad;
+    };
+
+    // ֮ Size ֽڵĻ
+    struct EntryHeader
+    {
+        uint64_t Key;
+        uint64_t Size;
+        uint64_t Checksum;
+    };
+
+    enum Stat
+    {
+        kHits,          // ûݴɹ
+        kMisses,        // ûл棬
+        kRejected,      // ܾ˻ݣ˻
+
+        kStatCount
+    };
+
+    static std::wstring s_FileName;
+    static uint64_t s_AdapterKey = 0;
+    static std::map<uint64_t, std::vector<uint8_t>> s_Entries;
+    static bool s_Dirty = false;
+    static std::mutex s_Mutex;
+
+    static const char* s_LoadResult = "not initialized";
+    static size_t s_LoadedCount = 0;
+    static uint64_t s_Counts[kStatCount];
+    static int64_t s_Ticks[kStatCount];
+
+    // FNV-1aݺֽĳȲһ4ı Utility::HashRange
+    static uint64_t HashBytes( const void* Data, size_t Size, uint64_t Hash = 14695981039346656037ull )
+    {
+        const uint8_t* Bytes = (const uint8_t*)Data;
+        for (size_t i = 0; i < Size; ++i)
+            Hash = (Hash ^ Bytes[i]) * 1099511628211ull;
+        return Hash;
+    }
+
+    static uint64_t HashShader( const D3D12_SHADER_BYTECODE& Code, uint64_t Hash )
+    {
+        Hash = HashBytes(&Code.BytecodeLength, sizeof(Code.BytecodeLength), Hash);
+        return HashBytes(Code.pShaderBytecode, Code.BytecodeLength, Hash);
+    }
+
+    static uint64_t HashString( const char* String, uint64_t Hash )
+    {
+        return String == nullptr ? Hash : HashBytes(String, strlen(String) + 1, Hash);
+    }
+
+    // ͬһͺŵԿͬһ汾ʹû
+    static uint64_t ComputeAdapterKey( void )
+    {
+        ComPtr<IDXGIFactory4> Factory;
+        ComPtr<IDXGIAdapter1> Adapter;
+        if (FAILED(CreateDXGIFactory2(0, MY_IID_PPV_ARGS(&Factory))) ||
+            FAILED(Factory->EnumAdapterByLuid(Graphics::g_Device->GetAdapterLuid(), MY_IID_PPV_ARGS(&Adapter))))
+            return 0;
+
+        DXGI_ADAPTER_DESC1 Desc;
+        Adapter->GetDesc1(&Desc);
+        LARGE_INTEGER DriverVersion = {};
+        Adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &DriverVersion);
+
+        const uint32_t Ids[] = { Desc.VendorId, Desc.DeviceId, Desc.SubSysId, Desc.Revision };
+        uint64_t Key = HashBytes(Ids, sizeof(Ids));
+        return HashBytes(&DriverVersion, sizeof(DriverVersion), Key);
+    }
+
+    static uint64_t ComputeKey( const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash )
+    {
+        // ȥָ룬ָݵ
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC Stripped = Desc;
+        Stripped.pRootSignature = nullptr;
+        Stripped.VS = Stripped.PS = Stripped.DS = Stripped.HS = Stripped.GS = D3D12_SHADER_BYTECODE();
+        Stripped.StreamOutput.pSODeclaration = nullptr;
+        Stripped.StreamOutput.pBufferStrides = nullptr;
+        Stripped.InputLayout.pInputElementDescs = nullptr;
+        Stripped.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+
+        uint64_t Key = Utility::HashState(&Stripped, 1, RootSignatureHash);
+        for (const D3D12_SHADER_BYTECODE* Code : { &Desc.VS, &Desc.PS, &Desc.DS, &Desc.HS, &Desc.GS })
+            Key = HashShader(*Code, Key);
+
+        for (UINT i = 0; i < Desc.InputLayout.NumElements; ++i)
+        {
+            D3D12_INPUT_ELEMENT_DESC Element = Desc.InputLayout.pInputElementDescs[i];
+            Key = HashString(Element.SemanticName, Key);
+            Element.SemanticName = nullptr;
+            Key = Utility::HashState(&Element, 1, Key);
+        }
+
+        for (UINT i = 0; i < Desc.StreamOutput.NumEntries; ++i)
+        {
+            D3D12_SO_DECLARATION_ENTRY Entry = Desc.StreamOutput.pSODeclaration[i];
+            Key = HashString(Entry.SemanticName, Key);
+            Entry.SemanticName = nullptr;
+            Key = Utility::HashState(&Entry, 1, Key);
+        }
+        if (Desc.StreamOutput.NumStrides > 0)
+            Key = Utility::HashState(Desc.StreamOutput.pBufferStrides, Desc.StreamOutput.NumStrides, Key);
+
+        return Key;
+    }
+
+    static uint64_t ComputeKey( const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash )
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC Stripped = Desc;
+        Stripped.pRootSignature = nullptr;
+        Stripped.CS = D3D12_SHADER_BYTECODE();
+        Stripped.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+
+        uint64_t Key = Utility::HashState(&Stripped, 1, RootSignatureHash);
+        return HashShader(Desc.CS, Key);
+    }
+
+    static void Store( uint64_t Key, ID3D12PipelineState* PSO )
+    {
+        ComPtr<ID3DBlob> Blob;
+        if (FAILED(PSO->GetCachedBlob(&Blob)) || Blob->GetBufferSize() == 0)
+            return;
+
+        const uint8_t* Data = (const uint8_t*)Blob->GetBufferPointer();
+        std::lock_guard<std::mutex> Lock(s_Mutex);
+        s_Entries[Key].assign(Data, Data + Blob->GetBufferSize());
+        s_Dirty = true;
+    }
+
+    template <typename DescType, typename CreateFunc>
+    static HRESULT CreateCached( DescType& Desc, uint64_t Key, CreateFunc Create, ID3D12PipelineState** PSO )
+    {
+        int64_t Start = SystemTime::GetCurrentTick();
+
+        // ͬڴϣܶӦͬһһ
+        std::vector<uint8_t> Cached;
+        {
+            std::lock_guard<std::mutex> Lock(s_Mutex);
+            auto Iter = s_Entries.find(Key);
+            if (Iter != s_Entries.end())
+                Cached = Iter->second;
+        }
+
+        HRESULT hr = E_FAIL;
+        Stat Result = kMisses;
+        if (!Cached.empty())
+        {
+            Desc.CachedPSO.pCachedBlob = Cached.data();
+            Desc.CachedPSO.CachedBlobSizeInBytes = Cached.size();
+            hr = Create(Desc, PSO);
+            Desc.CachedPSO = D3D12_CACHED_PIPELINE_STATE();
+            Result = SUCCEEDED(hr) ? kHits : kRejected;
+        }
+
+        // ܾ Store б±Ľ滻
+        if (FAILED(hr))
+        {
+            hr = Create(Desc, PSO);
+            if (SUCCEEDED(hr))
+                Store(Key, *PSO);
+        }
+
+        std::lock_guard<std::mutex> Lock(s_Mutex);
+        ++s_Counts[Result];
+        s_Ticks[Result] += SystemTime::GetCurrentTick() - Start;
+        return hr;
+    }
+}
+
+void PipelineCache::Initialize( const std::wstring& FileName )
+{
+    s_FileName = FileName;
+    s_AdapterKey = ComputeAdapterKey();
+    s_Entries.clear();
+    s_Dirty = false;
+    s_LoadedCount = 0;
+    ResetStats();
+
+    Utility::ByteArray File = Utility::ReadFileSync(FileName);
+    const uint8_t* Data = File->data();
+    const size_t Size = File->size();
+
+    // ļͷʱأ±PSOʱļ
+    FileHeader Header;
+    if (Size == 0)
+    {
+        s_LoadResult = "no cache file";
+        return;
+    }
+    if (Size < sizeof(Header))
+    {
+        s_LoadResult = "truncated header, ignored";
+        return;
+    }
+    memcpy(&Header, Data, sizeof(Header));
+    if (Header.Magic != kMagic || Header.Version != kVersion)
+    {
+        s_LoadResult = "format version mismatch, ignored";
+        return;
+    }
+    if (Header.AdapterKey != s_AdapterKey)
+    {
+        s_LoadResult = "adapter or driver changed, ignored";
+        return;
+    }
+
+    size_t Offset = sizeof(Header);
+    for (uint32_t i = 0; i < Header.EntryCount; ++i)
+    {
+        EntryHeader Entry;
+        if (Size - Offset < sizeof(Entry))
+            break;
+        memcpy(&Entry, Data + Offset, sizeof(Entry));
+        Offset += sizeof(Entry);
+
+        if (Size - Offset < Entry.Size)
+            break;
+        if (HashBytes(Data + Offset, (size_t)Entry.Size) == Entry.Checksum)
+            s_Entries[Entry.Key].assign(Data + Offset, Data + Offset + Entry.Size);
+        Offset += (size_t)Entry.Size;
+    }
+
+    // 𻵵Ŀ˳ʱдļ
+    s_LoadedCount = s_Entries.size();
+    s_Dirty = s_LoadedCount != Header.EntryCount;
+    s_LoadResult = s_Dirty ? "loaded, corrupt entries dropped" : "loaded";
+}
+
+void PipelineCache::Shutdown( void )
+{
+    if (s_Dirty && !s_FileName.empty())
+    {
+        std::ofstream OutFile(s_FileName, std::ios::out | std::ios::binary);
+
+        FileHeader Header = { kMagic, kVersion, s_AdapterKey, (uint32_t)s_Entries.size(), 0 };
+        OutFile.write((const char*)&Header, sizeof(Header));
+        for (auto& Iter : s_Entries)
+        {
+            EntryHeader Entry = { Iter.first, Iter.second.size(), HashBytes(Iter.second.data(), Iter.second.size()) };
+            OutFile.write((const char*)&Entry, sizeof(Entry));
+            OutFile.write((const char*)Iter.second.data(), Iter.second.size());
+        }
+        OutFile.close();
+    }
+
+    s_Entries.clear();
+    s_Dirty = false;
+}
+
+HRESULT PipelineCache::CreateGraphicsPipelineState( D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash, ID3D12PipelineState** PSO )
+{
+    return CreateCached(Desc, ComputeKey(Desc, RootSignatureHash),
+        []( const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO )
+        {
+            return Graphics::g_Device->CreateGraphicsPipelineState(&Desc, MY_IID_PPV_ARGS(PSO));
+        }, PSO);
+}
+
+HRESULT PipelineCache::CreateComputePipelineState( D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash, ID3D12PipelineState** PSO )
+{
+    return CreateCached(Desc, ComputeKey(Desc, RootSignatureHash),
+        []( const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO )
+        {
+            return Graphics::g_Device->CreateComputePipelineState(&Desc, MY_IID_PPV_ARGS(PSO));
+        }, PSO);
+}
+
+void PipelineCache::ResetStats( void )
+{
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+    memset(s_Counts, 0, sizeof(s_Counts));
+    memset(s_Ticks, 0, sizeof(s_Ticks));
+}
+
+void PipelineCache::PrintReport( void )
+{
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+    auto Millisecs = []( Stat s ) { return SystemTime::TicksToMillisecs(s_Ticks[s]); };
+
+    Utility::Printf("Pipeline cache: %s (%zu entries)\n", s_LoadResult, s_LoadedCount);
+    Utility::Printf("  %llu hits %.2f ms  %llu misses %.2f ms  %llu rejected %.2f ms  total %.2f ms\n",
+        s_Counts[kHits], Millisecs(kHits), s_Counts[kMisses], Millisecs(kMisses),
+        s_Counts[kRejected], Millisecs(kRejected), Millisecs(kHits) + Millisecs(kMisses) + Millisecs(kRejected));
+}
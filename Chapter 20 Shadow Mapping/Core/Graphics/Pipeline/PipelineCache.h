@@ -0,0 +1,29 @@
+/*
+	ˮ״̬Ĵ̻棬˳ʱõPSO´ʱֱӽɫ
+	- ÿPSOݼһ: (ȥָ)ǩĹϣɫֽĹϣ벼ֺ
+	  PSO::Finalize ڴ滺Ĺϣָ룬ÿжͬڴ
+	- ļͷ¼ʽ汾Կ(̡ͺš汾)κһһʱļ
+	- ÿĿУͣ𻵵ĿܾĻ˻ص룬˳ʱ滻
+	- ͳСδСܾĴ͸ԵĴʱɺ
+
+	豸֧ GetCachedBlobɻ
+*/
+
+#pragma once
+
+#include "pch.h"
+
+namespace PipelineCache
+{
+    // 豸֮󡢴κPSO֮ǰ
+    void Initialize( const std::wstring& FileName );
+    // µĿʱдļ
+    void Shutdown( void );
+
+    // ûݴûлܾʱ룬±PSO뻺
+    HRESULT CreateGraphicsPipelineState( D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash, ID3D12PipelineState** PSO );
+    HRESULT CreateComputePipelineState( D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash, ID3D12PipelineState** PSO );
+
+    void ResetStats( void );
+    void PrintReport( void );
+}
@@ -14,23 +14,27 @@
 #include "GraphicsCore.h"
 #include "PipelineState.h"
 #include "RootSignature.h"
+#include "PipelineCache.h"
+#include "StateObjectCache.h"
+#include "SystemTime.h"
 #include "Hash.h"
 #include <map>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 using Math::IsAligned;
 using namespace Graphics;
 using Microsoft::WRL::ComPtr;
 using namespace std;
 
-static map< size_t, ComPtr<ID3D12PipelineState> > s_GraphicsPSOHashMap;
-static map< size_t, ComPtr<ID3D12PipelineState> > s_ComputePSOHashMap;
+static StateObjectCache<ID3D12PipelineState> s_GraphicsPSOCache;
+static StateObjectCache<ID3D12PipelineState> s_ComputePSOCache;
 
 void PSO::DestroyAll(void)
 {
-    s_GraphicsPSOHashMap.clear();
-    s_ComputePSOHashMap.clear();
+    s_GraphicsPSOCache.Destroy();
+    s_ComputePSOCache.Destroy();
 }
 
 
@@ -117,34 +121,13 @@ void GraphicsPSO::Finalize()
     HashCode = Utility::HashState(m_InputLayouts.get(), m_PSODesc.InputLayout.NumElements, HashCode);
     m_PSODesc.InputLayout.pInputElementDescs = m_InputLayouts.get();
 
-    ID3D12PipelineState** PSORef = nullptr;
-    bool firstCompile = false;
+    // ͬһϣֻһΣ̵߳ȴα
+    m_PSO = s_GraphicsPSOCache.GetOrCreate(HashCode, [&]()
     {
-        static mutex s_HashMapMutex;
-        lock_guard<mutex> CS(s_HashMapMutex);
-        auto iter = s_GraphicsPSOHashMap.find(HashCode);
-
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_GraphicsPSOHashMap.end())
-        {
-            firstCompile = true;
-            PSORef = s_GraphicsPSOHashMap[HashCode].GetAddressOf();
-        }
-        else
-            PSORef = iter->second.GetAddressOf();
-    }
-
-    if (firstCompile)
-    {
-        ASSERT_SUCCEEDED( g_Device->CreateGraphicsPipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)) );
-        s_GraphicsPSOHashMap[HashCode].Attach(m_PSO);
-    }
-    else
-    {
-        while (*PSORef == nullptr)
-            this_thread::yield();
-        m_PSO = *PSORef;
-    }
+        ID3D12PipelineState* PSO = nullptr;
+        ASSERT_SUCCEEDED( PipelineCache::CreateGraphicsPipelineState(m_PSODesc, m_RootSignature->GetHash(), &PSO) );
+        return PSO;
+    });
 }
 
 void ComputePSO::Finalize()
@@ -155,38 +138,158 @@ void ComputePSO::Finalize()
 
     size_t HashCode = Utility::HashState(&m_PSODesc);
 
-    ID3D12PipelineState** PSORef = nullptr;
-    bool firstCompile = false;
+    m_PSO = s_ComputePSOCache.GetOrCreate(HashCode, [&]()
     {
-        static mutex s_HashMapMutex;
-        lock_guard<mutex> CS(s_HashMapMutex);
-        auto iter = s_ComputePSOHashMap.find(HashCode);
+        ID3D12PipelineState* PSO = nullptr;
+        ASSERT_SUCCEEDED( PipelineCache::CreateComputePipelineState(m_PSODesc, m_RootSignature->GetHash(), &PSO) );
+        return PSO;
+    });
+}
 
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_ComputePSOHashMap.end())
+ComputePSO::ComputePSO()
+{
+    ZeroMemory(&m_PSODesc, sizeof(m_PSODesc));
+    m_PSODesc.NodeMask = 1;
+}
+
+namespace
+{
+    const uint32_t kBenchmarkPSOCount = 512;
+    const uint32_t kBenchmarkPasses = 16;
+    // 豸PSOûпģɫʱ
+    const double kBenchmarkCompileMicroseconds = 50.0;
+
+    // Ķǰ Finalize : ȫֻ std::mapĿڱʱȴ
+    class LegacyPSOCache
+    {
+    public:
+        template <typename CreateFunc>
+        ID3D12PipelineState* GetOrCreate( size_t HashCode, CreateFunc Create )
         {
-            firstCompile = true;
-            PSORef = s_ComputePSOHashMap[HashCode].GetAddressOf();
+            ID3D12PipelineState** PSORef = nullptr;
+            bool firstCompile = false;
+            {
+                lock_guard<mutex> CS(m_Mutex);
+                auto iter = m_Map.find(HashCode);
+                if (iter == m_Map.end())
+                {
+                    firstCompile = true;
+                    PSORef = m_Map[HashCode].GetAddressOf();
+                }
+                else
+                    PSORef = iter->second.GetAddressOf();
+            }
+
+            if (firstCompile)
+            {
+                ID3D12PipelineState* PSO = Create();
+                lock_guard<mutex> CS(m_Mutex);
+                m_Map[HashCode].Attach(PSO);
+                return PSO;
+            }
+
+            while (*(ID3D12PipelineState* volatile*)PSORef == nullptr)
+                this_thread::yield();
+            return *PSORef;
         }
-        else
-            PSORef = iter->second.GetAddressOf();
-    }
 
-    if (firstCompile)
-    {
-        ASSERT_SUCCEEDED( g_Device->CreateComputePipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)) );
-        s_ComputePSOHashMap[HashCode].Attach(m_PSO);
-    }
-    else
+    private:
+        mutex m_Mutex;
+        map< size_t, ComPtr<ID3D12PipelineState> > m_Map;
+    };
+
+    // ThreadCount ߳ͬʱʼÿ̴߳ӲͬλÿʼȫPSO Finalize kBenchmarkPasses 
+    // һǱȴ̱߳룬֮УغCompiles Ϊʵʱ
+    template <typename Cache>
+    double MeasureFinalize( Cache& PSOCache, uint32_t ThreadCount, const vector<D3D12_GRAPHICS_PIPELINE_STATE_DESC>& Descs,
+        uint32_t& Compiles )
     {
-        while (*PSORef == nullptr)
+        atomic<uint32_t> CompileCount(0);
+        atomic<uint32_t> ReadyCount(0);
+        atomic<bool> Go(false);
+
+        auto Worker = [&]( uint32_t Thread )
+        {
+            ++ReadyCount;
+            while (!Go.load())
+                this_thread::yield();
+
+            for (uint32_t Pass = 0; Pass < kBenchmarkPasses; ++Pass)
+            {
+                for (uint32_t i = 0; i < kBenchmarkPSOCount; ++i)
+                {
+                    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc = Descs[(i + Thread * kBenchmarkPSOCount / ThreadCount) % kBenchmarkPSOCount];
+                    size_t HashCode = Utility::HashState(&Desc);
+                    PSOCache.GetOrCreate(HashCode, [&]()
+                    {
+                        ++CompileCount;
+                        int64_t Start = SystemTime::GetCurrentTick();
+                        while (SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick()) * 1e6 < kBenchmarkCompileMicroseconds)
+                            ;
+                        ID3D12PipelineState* PSO = nullptr;
+                        ASSERT_SUCCEEDED( g_Device->CreateGraphicsPipelineState(&Desc, MY_IID_PPV_ARGS(&PSO)) );
+                        return PSO;
+                    });
+                }
+            }
+        };
+
+        vector<thread> Workers;
+        for (uint32_t t = 0; t < ThreadCount; ++t)
+            Workers.emplace_back(Worker, t);
+        while (ReadyCount.load() < ThreadCount)
             this_thread::yield();
-        m_PSO = *PSORef;
+
+        int64_t Start = SystemTime::GetCurrentTick();
+        Go = true;
+        for (auto& W : Workers)
+            W.join();
+        double Milliseconds = SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick()) * 1000.0;
+
+        Compiles = CompileCount.load();
+        return Milliseconds;
     }
 }
 
-ComputePSO::ComputePSO()
+void PSO::Benchmark(void)
 {
-    ZeroMemory(&m_PSODesc, sizeof(m_PSODesc));
-    m_PSODesc.NodeMask = 1;
+    if (!Graphics::Initialize(true))
+        return;
+
+    SystemTime::Initialize();
+
+    // ֻƫƲͬһPSOϣͬ
+    vector<D3D12_GRAPHICS_PIPELINE_STATE_DESC> Descs(kBenchmarkPSOCount);
+    for (uint32_t i = 0; i < kBenchmarkPSOCount; ++i)
+    {
+        ZeroMemory(&Descs[i], sizeof(Descs[i]));
+        Descs[i].NodeMask = 1;
+        Descs[i].SampleMask = 0xFFFFFFFFu;
+        Descs[i].SampleDesc.Count = 1;
+        Descs[i].RasterizerState = RasterizerDefault;
+        Descs[i].RasterizerState.DepthBias = (INT)i;
+        Descs[i].BlendState = BlendDisable;
+        Descs[i].DepthStencilState = DepthStateReadWrite;
+        Descs[i].PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    }
+
+    Utility::Printf("PSO cache: %u PSOs x %u passes per thread, %.0f us simulated compile\n",
+        kBenchmarkPSOCount, kBenchmarkPasses, kBenchmarkCompileMicroseconds);
+
+    const uint32_t ThreadCounts[] = { 1, 2, 4, 8, 16 };
+    for (uint32_t ThreadCount : ThreadCounts)
+    {
+        uint32_t LegacyCompiles = 0, ShardedCompiles = 0;
+
+        LegacyPSOCache Legacy;
+        double LegacyMs = MeasureFinalize(Legacy, ThreadCount, Descs, LegacyCompiles);
+
+        StateObjectCache<ID3D12PipelineState> Sharded;
+        double ShardedMs = MeasureFinalize(Sharded, ThreadCount, Descs, ShardedCompiles);
+
+        Utility::Printf("%2u threads: mutex+map %8.2f ms (%u compiles)  sharded %8.2f ms (%u compiles)  (x%.2f)\n",
+            ThreadCount, LegacyMs, LegacyCompiles, ShardedMs, ShardedCompiles, LegacyMs / ShardedMs);
+    }
+
+    Graphics::Shutdown();
 }
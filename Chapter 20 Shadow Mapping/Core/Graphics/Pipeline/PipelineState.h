@@ -32,6 +32,9 @@ public:
 
     static void DestroyAll( void );
 
+    // ڿ豸1~16߳ͬʱ Finalize صPSOϣȽԭĻ+std::mapͷƬ
+    static void Benchmark( void );
+
     void SetRootSignature( const RootSignature& BindMappings )
     {
         m_RootSignature = &BindMappings;
@@ -121,7 +121,7 @@ class RootSignature
 
 public:
 
-    RootSignature( UINT NumRootParams = 0, UINT NumStaticSamplers = 0 ) : m_Finalized(FALSE), m_NumParameters(NumRootParams)
+    RootSignature( UINT NumRootParams = 0, UINT NumStaticSamplers = 0 ) : m_Finalized(FALSE), m_NumParameters(NumRootParams), m_Hash(0)
     {
         Reset(NumRootParams, NumStaticSamplers);
     }
@@ -171,6 +171,9 @@ public:
 
     ID3D12RootSignature* GetSignature() const { return m_Signature; }
 
+    // ݼ㣬ָ룬ÿжͬΪ̻һ
+    size_t GetHash() const { return m_Hash; }
+
 protected:
 
     BOOL m_Finalized;
@@ -183,4 +186,5 @@ protected:
     std::unique_ptr<RootParameter[]> m_ParamArray;
     std::unique_ptr<D3D12_STATIC_SAMPLER_DESC[]> m_SamplerArray;
     ID3D12RootSignature* m_Signature;
+    size_t m_Hash;
 };
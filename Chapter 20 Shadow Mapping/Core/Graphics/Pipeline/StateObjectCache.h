@@ -0,0 +1,116 @@
+/*
+	PSO͸ǩϣ棬߳ͬʱ Finalize ʱҲ
+	- ֳ kShardCount ƬϣĵλѡƬÿƬ̽ĶѰַĿָ
+	- ֻԭӶ: ϣ̽⣬Ϊ˵ڣĿĹϣͬ
+	- CASռסղ̸ۣ߳룻ͬһϣ߳õͬһĿȴ futureֻһ
+	- Ŀ Destroy ֮ǰɾҲƶָһֱЧ
+	- ̶ݣPSO͸ǩԶС kShardCount * kSlotsPerShard
+*/
+
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+#include <future>
+
+template <typename T>
+class StateObjectCache
+{
+public:
+    static const size_t kShardCount = 16;
+    static const size_t kSlotsPerShard = 512;
+
+    StateObjectCache()
+    {
+        for (Shard& S : m_Shards)
+        {
+            for (auto& Slot : S.Slots)
+                Slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~StateObjectCache() { Destroy(); }
+
+    // عϣӦĶ󣬲ʱɵһ̵߳ Create 
+    template <typename CreateFunc>
+    T* GetOrCreate( size_t Hash, CreateFunc Create )
+    {
+        Shard& S = m_Shards[Hash % kShardCount];
+        const size_t Home = (Hash / kShardCount) % kSlotsPerShard;
+
+        Entry* Mine = nullptr;
+        for (size_t Probe = 0; Probe < kSlotsPerShard; ++Probe)
+        {
+            std::atomic<Entry*>& Slot = S.Slots[(Home + Probe) % kSlotsPerShard];
+            Entry* Found = Slot.load(std::memory_order_acquire);
+            if (Found == nullptr)
+            {
+                if (Mine == nullptr)
+                    Mine = new Entry(Hash);
+
+                if (Slot.compare_exchange_strong(Found, Mine, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    T* Object = Create();
+                    Mine->Object.store(Object, std::memory_order_release);
+                    Mine->Promise.set_value(Object);
+                    return Object;
+                }
+                // ʧʱ Found ȲĿ
+            }
+
+            if (Found->Hash == Hash)
+            {
+                delete Mine;
+                return Found->Wait();
+            }
+        }
+
+        ASSERT(false, "State object cache is full");
+        delete Mine;
+        return nullptr;
+    }
+
+    // ͷж󣬵ʱ߳ڲ
+    void Destroy( void )
+    {
+        for (Shard& S : m_Shards)
+        {
+            for (auto& Slot : S.Slots)
+            {
+                Entry* E = Slot.exchange(nullptr, std::memory_order_acq_rel);
+                if (E == nullptr)
+                    continue;
+
+                if (T* Object = E->Object.load(std::memory_order_acquire))
+                    Object->Release();
+                delete E;
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        explicit Entry( size_t Hash ) : Hash(Hash), Object(nullptr), Ready(Promise.get_future().share()) {}
+
+        // Ѿʱ future
+        T* Wait( void ) const
+        {
+            T* Result = Object.load(std::memory_order_acquire);
+            return Result != nullptr ? Result : Ready.get();
+        }
+
+        const size_t Hash;
+        std::atomic<T*> Object;
+        std::promise<T*> Promise;           //  Ready ֮ǰ
+        std::shared_future<T*> Ready;
+    };
+
+    // Ƭռ
+    struct alignas(64) Shard
+    {
+        std::atomic<Entry*> Slots[kSlotsPerShard];
+    };
+
+    Shard m_Shards[kShardCount];
+};
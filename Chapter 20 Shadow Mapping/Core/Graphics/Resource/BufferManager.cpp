@@ -22,10 +22,14 @@ namespace Graphics
     DepthBuffer g_SceneDepthBuffer;
     ColorBuffer g_SceneColorBuffer;
     ColorCubeBuffer g_SceneCubeBuff;
+    ColorCubeBuffer g_SceneCubeStaticBuff;
+    DepthBuffer g_SceneCubeDepth;
+    DepthBuffer g_SceneCubeStaticDepth[6];
     ColorBuffer g_OverlayBuffer;
     ColorBuffer g_HorizontalBuffer;
 
     ShadowBuffer g_ShadowBuffer;
+    ShadowBuffer g_CubeStaticShadowBuffer;
 
     DXGI_FORMAT DefaultHdrColorFormat = DXGI_FORMAT_R11G11B10_FLOAT;
 }
@@ -97,7 +101,7 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 //     g_AOHighQuality4.Create(L"AO High Quality 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram);
 //     esram.PopStack();    // End generating SSAO
 // 
-    g_ShadowBuffer.Create(L"Shadow Map", 2048, 2048, esram);
+    g_ShadowBuffer.Create(L"Shadow Map", 4096, 4096, esram);
 // 
 //     esram.PopStack();    // End Shading
 // 
@@ -170,6 +174,12 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 //     esram.PopStack();
 
     g_SceneCubeBuff.Create(L"scene cube buffer", 1024, 1024, 1, DefaultHdrColorFormat);
+    g_SceneCubeStaticBuff.Create(L"scene cube static buffer", 1024, 1024, 1, DefaultHdrColorFormat);
+    g_SceneCubeDepth.Create(L"scene cube depth", 1024, 1024, DSV_FORMAT);
+    // ͼֻ1024Ӱͼһķֱʣͼеλò
+    g_CubeStaticShadowBuffer.Create(L"cube static shadow map", 2048, 2048);
+    for (auto& depth : g_SceneCubeStaticDepth)
+        depth.Create(L"scene cube static depth", 1024, 1024, DSV_FORMAT);
     g_OverlayBuffer.Create(L"UI Overlay", g_DisplayWidth, g_DisplayHeight, 1, DXGI_FORMAT_R8G8B8A8_UNORM, esram);
     g_HorizontalBuffer.Create(L"Bicubic Intermediate", g_DisplayWidth, bufferHeight, 1, DefaultHdrColorFormat, esram);
 
@@ -189,7 +199,12 @@ void Graphics::DestroyRenderingBuffers()
     g_SceneDepthBuffer.Destroy();
     g_SceneColorBuffer.Destroy();
     g_SceneCubeBuff.Destroy();
+    g_SceneCubeStaticBuff.Destroy();
+    g_SceneCubeDepth.Destroy();
+    for (auto& depth : g_SceneCubeStaticDepth)
+        depth.Destroy();
     g_OverlayBuffer.Destroy();
     g_HorizontalBuffer.Destroy();
     g_ShadowBuffer.Destroy();
+    g_CubeStaticShadowBuffer.Destroy();
 }
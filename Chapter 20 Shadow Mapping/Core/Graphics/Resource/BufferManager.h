@@ -27,8 +27,12 @@ namespace Graphics
     extern ColorBuffer g_OverlayBuffer;        // R8G8B8A8_UNORM
     extern ColorBuffer g_HorizontalBuffer;    // For separable (bicubic) upsampling
     extern ColorCubeBuffer g_SceneCubeBuff;     // պ6RTVcolorbuffer
+    extern ColorCubeBuffer g_SceneCubeStaticBuff;   // ͼо̬պеĻ
+    extern DepthBuffer g_SceneCubeDepth;            // ͼ
+    extern DepthBuffer g_SceneCubeStaticDepth[6];   // ÿ澲ֵ̬Ȼ
 
     extern ShadowBuffer g_ShadowBuffer;
+    extern ShadowBuffer g_CubeStaticShadowBuffer;   // ֻо̬ͶӰͼͼؽ̬ʱʹ
 
     void InitializeRenderingBuffers(uint32_t NativeWidth, uint32_t NativeHeight );
     void ResizeDisplayDependentBuffers(uint32_t NativeWidth, uint32_t NativeHeight);
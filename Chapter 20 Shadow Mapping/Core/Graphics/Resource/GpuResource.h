@@ -22,21 +22,20 @@ class GpuResource
     friend class CommandContext;
     friend class GraphicsContext;
     friend class ComputeContext;
+    friend class ResourceStateTracker;
 
 public:
     GpuResource() : 
         m_GpuVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL),
         m_UserAllocatedMemory(nullptr),
-        m_UsageState(D3D12_RESOURCE_STATE_COMMON),
-        m_TransitioningState((D3D12_RESOURCE_STATES)-1)
+        m_UsageState(D3D12_RESOURCE_STATE_COMMON)
     {}
 
     GpuResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES CurrentState) :
         m_GpuVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL),
         m_UserAllocatedMemory(nullptr),
         m_pResource(pResource),
-        m_UsageState(CurrentState),
-        m_TransitioningState((D3D12_RESOURCE_STATES)-1)
+        m_UsageState(CurrentState)
     {
     }
 
@@ -44,6 +43,7 @@ public:
     virtual void Destroy()
     {
         m_pResource = nullptr;
+        m_SubresourceStates.clear();
         m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
         if (m_UserAllocatedMemory != nullptr)
         {
@@ -68,8 +68,10 @@ public:
 protected:
 
     Microsoft::WRL::ComPtr<ID3D12Resource> m_pResource;
+    // һύ֮״̬ ResourceStateTracker ύʱ£¼ʱҪֱӶд
+    // Դ״̬һʱ m_SubresourceStates Դ¼Ϊա m_UsageState Ϊ׼
     D3D12_RESOURCE_STATES m_UsageState;
-    D3D12_RESOURCE_STATES m_TransitioningState;
+    std::vector<D3D12_RESOURCE_STATES> m_SubresourceStates;
     D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
 
     // When using VirtualAlloc() to allocate memory directly, record the allocation here so that it can be freed.  The
@@ -15,6 +15,7 @@
 #include "ShadowBuffer.h"
 #include "EsramAllocator.h"
 #include "CommandContext.h"
+#include <algorithm>
 
 void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Height, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr )
 {
@@ -32,6 +33,8 @@ void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t He
     m_Scissor.top = 1;
     m_Scissor.right = (LONG)Width - 2;
     m_Scissor.bottom = (LONG)Height - 2;
+
+    SetCascadeCount(1);
 }
 
 void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Height, EsramAllocator& Allocator )
@@ -50,6 +53,8 @@ void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t He
     m_Scissor.top = 1;
     m_Scissor.right = (LONG)Width - 2;
     m_Scissor.bottom = (LONG)Height - 2;
+
+    SetCascadeCount(1);
 }
 
 void ShadowBuffer::BeginRendering( GraphicsContext& Context )
@@ -64,3 +69,43 @@ void ShadowBuffer::EndRendering( GraphicsContext& Context )
 {
     Context.TransitionResource(*this, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
+
+void ShadowBuffer::SetCascadeCount( uint32_t Count )
+{
+    ASSERT(Count > 0, "Shadow buffer needs at least one cascade");
+
+    m_CascadeCount = Count;
+    m_CascadeColumns = Count > 1 ? 2 : 1;
+    m_CascadeRows = (Count + m_CascadeColumns - 1) / m_CascadeColumns;
+    m_CascadeSize = std::min(m_Width / m_CascadeColumns, m_Height / m_CascadeRows);
+}
+
+Math::Vector4 ShadowBuffer::GetCascadeScaleOffset( uint32_t Cascade ) const
+{
+    float ScaleX = (float)m_CascadeSize / m_Width;
+    float ScaleY = (float)m_CascadeSize / m_Height;
+    return Math::Vector4(ScaleX, ScaleY, ScaleX * (Cascade % m_CascadeColumns), ScaleY * (Cascade / m_CascadeColumns));
+}
+
+void ShadowBuffer::SetCascadeViewport( GraphicsContext& Context, uint32_t Cascade )
+{
+    ASSERT(Cascade < m_CascadeCount, "Shadow cascade out of range");
+
+    uint32_t Left = m_CascadeSize * (Cascade % m_CascadeColumns);
+    uint32_t Top = m_CascadeSize * (Cascade / m_CascadeColumns);
+
+    D3D12_VIEWPORT Viewport = m_Viewport;
+    Viewport.TopLeftX = (float)Left;
+    Viewport.TopLeftY = (float)Top;
+    Viewport.Width = (float)m_CascadeSize;
+    Viewport.Height = (float)m_CascadeSize;
+
+    // ͼһ߽أڼӰụ
+    D3D12_RECT Scissor;
+    Scissor.left = (LONG)Left + 1;
+    Scissor.top = (LONG)Top + 1;
+    Scissor.right = (LONG)(Left + m_CascadeSize) - 2;
+    Scissor.bottom = (LONG)(Top + m_CascadeSize) - 2;
+
+    Context.SetViewportAndScissor(Viewport, Scissor);
+}
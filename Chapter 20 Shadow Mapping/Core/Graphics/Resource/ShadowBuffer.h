@@ -33,7 +33,22 @@ public:
     void BeginRendering( GraphicsContext& context );
     void EndRendering( GraphicsContext& context );
 
+    // Ӱͼ: һʱÿ2ÿռһ
+    void SetCascadeCount( uint32_t Count );
+    uint32_t GetCascadeCount() const { return m_CascadeCount; }
+    // ÿı߳ҲǼ ShadowCamera  BufferSize
+    uint32_t GetCascadeSize() const { return m_CascadeSize; }
+    // xy Ϊͼţzw Ϊƫƣuv * xy + zw õͼе
+    Math::Vector4 GetCascadeScaleOffset( uint32_t Cascade ) const;
+    //  BeginRendering ֮ãӿںͲü赽ڵ
+    void SetCascadeViewport( GraphicsContext& context, uint32_t Cascade );
+
 private:
     D3D12_VIEWPORT m_Viewport;
     D3D12_RECT m_Scissor;
+
+    uint32_t m_CascadeCount = 1;
+    uint32_t m_CascadeColumns = 1;
+    uint32_t m_CascadeRows = 1;
+    uint32_t m_CascadeSize = 0;
 };
@@ -0,0 +1,423 @@
+#include "pch.h"
+#include "UploadRing.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "SystemTime.h"
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+using namespace Graphics;
+using namespace std;
+
+UploadRingBuffer UploadRingAllocator::sm_Ring;
+
+UploadRingBuffer::UploadRingBuffer() :
+    m_CpuVirtualAddress(nullptr),
+    m_Size(0),
+    m_Head(0),
+    m_Tail(0),
+    m_OutstandingChunks(0),
+    m_LastFrameHead(0),
+    m_PeakFrameBytes(0)
+{
+    ResetStats();
+}
+
+void UploadRingBuffer::Create(const std::wstring& Name, size_t FrameBudget)
+{
+    Destroy();
+
+    m_Size = Math::AlignUp(FrameBudget, kChunkSize) * kFrameCount;
+
+    D3D12_HEAP_PROPERTIES HeapProps;
+    HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+    HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    HeapProps.CreationNodeMask = 1;
+    HeapProps.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC ResourceDesc;
+    ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    ResourceDesc.Alignment = 0;
+    ResourceDesc.Width = m_Size;
+    ResourceDesc.Height = 1;
+    ResourceDesc.DepthOrArraySize = 1;
+    ResourceDesc.MipLevels = 1;
+    ResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    ResourceDesc.SampleDesc.Count = 1;
+    ResourceDesc.SampleDesc.Quality = 0;
+    ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    ResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    m_UsageState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+    ASSERT_SUCCEEDED( g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE,
+        &ResourceDesc, m_UsageState, nullptr, MY_IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())) );
+
+    m_pResource->SetName(Name.c_str());
+
+    m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
+    m_pResource->Map(0, nullptr, (void**)&m_CpuVirtualAddress);
+}
+
+void UploadRingBuffer::Destroy()
+{
+    if (m_pResource != nullptr && m_CpuVirtualAddress != nullptr)
+        m_pResource->Unmap(0, nullptr);
+
+    GpuResource::Destroy();
+
+    m_CpuVirtualAddress = nullptr;
+    m_Size = 0;
+    m_Head = 0;
+    m_Tail = 0;
+    m_OutstandingChunks = 0;
+    m_Frames = std::queue<FrameMarker>();
+    m_LastFrameHead = 0;
+}
+
+bool UploadRingBuffer::RequestChunk(size_t& Offset)
+{
+    if (m_Size == 0)
+        return false;
+
+    // ĴСǿСԶԽĩβ
+    uint64_t Head = m_Head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t End = Head + kChunkSize;
+
+        if (End - m_Tail.load(std::memory_order_acquire) > m_Size)
+        {
+            lock_guard<mutex> LockGuard(m_Mutex);
+
+            RetireCompletedFrames();
+
+            while (End - m_Tail.load(std::memory_order_relaxed) > m_Size)
+            {
+                // ûѽ֡Եȴ֡ķѾռ
+                if (m_Frames.empty())
+                    return false;
+
+                const FrameMarker& Oldest = m_Frames.front();
+                g_CommandManager.WaitForFence(Oldest.GraphicsFence);
+                g_CommandManager.WaitForFence(Oldest.ComputeFence);
+                m_Tail.store(Oldest.Head, std::memory_order_release);
+                m_Frames.pop();
+                ++m_Stats[kRingStalls];
+            }
+
+            Head = m_Head.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (m_Head.compare_exchange_weak(Head, End, std::memory_order_relaxed))
+            break;
+    }
+
+    ++m_OutstandingChunks;
+    ++m_Stats[kRingChunks];
+
+    Offset = (size_t)(Head % m_Size);
+    return true;
+}
+
+void UploadRingBuffer::RetireCompletedFrames(void)
+{
+    while (!m_Frames.empty())
+    {
+        const FrameMarker& Oldest = m_Frames.front();
+        if (!g_CommandManager.IsFenceComplete(Oldest.GraphicsFence) || !g_CommandManager.IsFenceComplete(Oldest.ComputeFence))
+            break;
+
+        m_Tail.store(Oldest.Head, std::memory_order_release);
+        m_Frames.pop();
+    }
+}
+
+void UploadRingBuffer::EndFrame(void)
+{
+    if (m_Size == 0)
+        return;
+
+    ASSERT(m_OutstandingChunks == 0, "All command contexts must be finished before the frame ends");
+
+    // ֡ебѾύһΧֵʱ֡ʹõĿͶԻ
+    FrameMarker Marker;
+    Marker.Head = m_Head.load(std::memory_order_relaxed);
+    Marker.GraphicsFence = g_CommandManager.GetGraphicsQueue().GetNextFenceValue() - 1;
+    Marker.ComputeFence = g_CommandManager.GetComputeQueue().GetNextFenceValue() - 1;
+
+    lock_guard<mutex> LockGuard(m_Mutex);
+
+    m_PeakFrameBytes = std::max(m_PeakFrameBytes, Marker.Head - m_LastFrameHead);
+    m_LastFrameHead = Marker.Head;
+
+    m_Frames.push(Marker);
+    RetireCompletedFrames();
+
+    ++m_Stats[kRingFrames];
+}
+
+void UploadRingBuffer::AddStats(const uint64_t (&Stats)[kRingStatCount])
+{
+    for (int i = 0; i < kRingStatCount; ++i)
+    {
+        if (Stats[i] != 0)
+            m_Stats[i].fetch_add(Stats[i], std::memory_order_relaxed);
+    }
+}
+
+UploadRingStats UploadRingBuffer::GetStats(void) const
+{
+    UploadRingStats Stats;
+    for (int i = 0; i < kRingStatCount; ++i)
+        Stats.Value[i] = m_Stats[i].load(std::memory_order_relaxed);
+    Stats.PeakFrameBytes = m_PeakFrameBytes;
+    return Stats;
+}
+
+void UploadRingBuffer::ResetStats(void)
+{
+    for (int i = 0; i < kRingStatCount; ++i)
+        m_Stats[i] = 0;
+    m_PeakFrameBytes = 0;
+}
+
+void UploadRingBuffer::PrintReport(const char* Label) const
+{
+    UploadRingStats Stats = GetStats();
+
+    // еֽҪôȥҪôǶ˷ѣҪôǿβ˷
+    double Claimed = (double)std::max<uint64_t>(Stats[kRingChunks] * kChunkSize, 1);
+    auto Percent = [&](UploadRingStat s) { return Stats[s] * 100.0 / Claimed; };
+
+    Utility::Printf("%s: %.1f MB ring, %llu frames, %llu allocations (avg %.0f B)\n",
+        Label, m_Size / (1024.0 * 1024.0), Stats[kRingFrames], Stats[kRingAllocations],
+        Stats[kRingRequestedBytes] / (double)std::max<uint64_t>(Stats[kRingAllocations], 1));
+    Utility::Printf("  per frame: %.0f allocations  %.2f KB requested  peak %.1f KB of chunks\n",
+        Stats[kRingAllocations] / (double)std::max<uint64_t>(Stats[kRingFrames], 1),
+        Stats[kRingRequestedBytes] / 1024.0 / std::max<uint64_t>(Stats[kRingFrames], 1),
+        Stats.PeakFrameBytes / 1024.0);
+    Utility::Printf("  of %llu chunk bytes: requested %.1f%%  size rounding %.1f%%  padding %.1f%%  chunk tails %.1f%%\n",
+        Stats[kRingChunks] * kChunkSize, Percent(kRingRequestedBytes), Percent(kRingRoundingBytes),
+        Percent(kRingPaddingBytes), Percent(kRingChunkTailBytes));
+    Utility::Printf("  %llu chunks, %llu stalls, %llu fallbacks (%.1f KB)\n",
+        Stats[kRingChunks], Stats[kRingStalls], Stats[kRingFallbacks], Stats[kRingFallbackBytes] / 1024.0);
+}
+
+UploadRingAllocator::UploadRingAllocator(UploadRingBuffer& Ring) :
+    m_Ring(Ring),
+    m_Fallback(kCpuWritable),
+    m_UseFallback(false),
+    m_HasChunk(false),
+    m_CurOffset(0),
+    m_ChunkEnd(0)
+{
+    memset(m_Stats, 0, sizeof(m_Stats));
+}
+
+DynAlloc UploadRingAllocator::Allocate(size_t SizeInBytes, size_t Alignment)
+{
+    const size_t AlignmentMask = Alignment - 1;
+
+    // Assert that it's a power of two.
+    ASSERT((AlignmentMask & Alignment) == 0);
+
+    const size_t AlignedSize = Math::AlignUpWithMask(SizeInBytes, AlignmentMask);
+    size_t Offset = Math::AlignUpWithMask(m_CurOffset, AlignmentMask);
+
+    if (Offset + AlignedSize > m_ChunkEnd)
+    {
+        // ķ(Ҫǳʼʱϴͼ)ռû
+        bool UseRing = !m_UseFallback && AlignedSize <= UploadRingBuffer::kChunkSize;
+
+        if (UseRing)
+        {
+            RetireChunk();
+
+            size_t ChunkOffset;
+            if (m_Ring.RequestChunk(ChunkOffset))
+            {
+                m_HasChunk = true;
+                m_CurOffset = ChunkOffset;
+                m_ChunkEnd = ChunkOffset + UploadRingBuffer::kChunkSize;
+                Offset = ChunkOffset;
+            }
+            else
+            {
+                m_UseFallback = true;
+                UseRing = false;
+            }
+        }
+
+        if (!UseRing)
+        {
+            ++m_Stats[kRingFallbacks];
+            m_Stats[kRingFallbackBytes] += AlignedSize;
+            return m_Fallback.Allocate(SizeInBytes, Alignment);
+        }
+    }
+
+    ++m_Stats[kRingAllocations];
+    m_Stats[kRingRequestedBytes] += SizeInBytes;
+    m_Stats[kRingRoundingBytes] += AlignedSize - SizeInBytes;
+    m_Stats[kRingPaddingBytes] += Offset - m_CurOffset;
+
+    DynAlloc ret(m_Ring, Offset, AlignedSize);
+    ret.DataPtr = m_Ring.GetCpuAddress(Offset);
+    ret.GpuAddress = m_Ring.GetGpuAddress(Offset);
+
+    m_CurOffset = Offset + AlignedSize;
+
+    return ret;
+}
+
+void UploadRingAllocator::RetireChunk(void)
+{
+    if (!m_HasChunk)
+        return;
+
+    m_Stats[kRingChunkTailBytes] += m_ChunkEnd - m_CurOffset;
+    m_Ring.ReleaseChunk();
+
+    m_HasChunk = false;
+    m_CurOffset = 0;
+    m_ChunkEnd = 0;
+}
+
+void UploadRingAllocator::CleanupUsedPages(uint64_t FenceID)
+{
+    RetireChunk();
+    m_UseFallback = false;
+
+    m_Fallback.CleanupUsedPages(FenceID);
+
+    m_Ring.AddStats(m_Stats);
+    memset(m_Stats, 0, sizeof(m_Stats));
+}
+
+namespace
+{
+    // ÿ߳ÿ֡ɵÿĵķ
+    const uint32_t kBenchmarkFrames = 64;
+    const uint32_t kBenchmarkWarmupFrames = 4;
+    const uint32_t kContextsPerFrame = 4;
+    const uint32_t kAllocationsPerContext = 512;
+
+    // ĴСֲ󲿷峣
+    const size_t kAllocationSizes[] = { 192, 192, 192, 192, 192, 80, 176, 592, 192, 192, 192, 1024, 192, 64, 192, 3072 };
+    const size_t kAllocationSizeCount = _countof(kAllocationSizes);
+
+    size_t ContextUploadBytes(void)
+    {
+        size_t Bytes = 0;
+        for (uint32_t i = 0; i < kAllocationsPerContext; ++i)
+            Bytes += Math::AlignUp(kAllocationSizes[i % kAllocationSizeCount], DEFAULT_ALIGN);
+        return Bytes;
+    }
+
+    // ThreadCount ̰߳֡ͬ MakeAllocator ķ䣬ÿ֡ʱ EndFrame
+    // ÿķ
+    template <typename Allocator>
+    double MeasureAllocationRate(uint32_t ThreadCount, const std::function<Allocator*(void)>& MakeAllocator,
+        const std::function<void(void)>& EndFrame)
+    {
+        mutex SyncMutex;
+        condition_variable SyncEvent;
+        uint32_t Frame = 0;
+        uint32_t Pending = 0;
+
+        vector<thread> Workers;
+        for (uint32_t t = 0; t < ThreadCount; ++t)
+        {
+            Workers.emplace_back([&]()
+            {
+                unique_ptr<Allocator> Alloc(MakeAllocator());
+
+                for (uint32_t f = 1; f <= kBenchmarkFrames; ++f)
+                {
+                    {
+                        unique_lock<mutex> Lock(SyncMutex);
+                        SyncEvent.wait(Lock, [&]() { return Frame >= f; });
+                    }
+
+                    for (uint32_t c = 0; c < kContextsPerFrame; ++c)
+                    {
+                        for (uint32_t i = 0; i < kAllocationsPerContext; ++i)
+                        {
+                            DynAlloc Mem = Alloc->Allocate(kAllocationSizes[i % kAllocationSizeCount]);
+                            *(uint32_t*)Mem.DataPtr = i;
+                        }
+                        Alloc->CleanupUsedPages(g_CommandManager.GetGraphicsQueue().IncrementFence());
+                    }
+
+                    lock_guard<mutex> Lock(SyncMutex);
+                    if (--Pending == 0)
+                        SyncEvent.notify_all();
+                }
+            });
+        }
+
+        int64_t Start = 0;
+        for (uint32_t f = 1; f <= kBenchmarkFrames; ++f)
+        {
+            if (f == kBenchmarkWarmupFrames + 1)
+                Start = SystemTime::GetCurrentTick();
+
+            unique_lock<mutex> Lock(SyncMutex);
+            Frame = f;
+            Pending = ThreadCount;
+            SyncEvent.notify_all();
+            SyncEvent.wait(Lock, [&]() { return Pending == 0; });
+            Lock.unlock();
+
+            EndFrame();
+        }
+        double Seconds = SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick());
+
+        for (auto& Worker : Workers)
+            Worker.join();
+
+        double Count = (double)ThreadCount * (kBenchmarkFrames - kBenchmarkWarmupFrames) * kContextsPerFrame * kAllocationsPerContext;
+        return Count / Seconds;
+    }
+}
+
+void UploadRingAllocator::Benchmark(void)
+{
+    if (!Graphics::Initialize(true))
+        return;
+
+    SystemTime::Initialize();
+
+    Utility::Printf("Upload allocators: %u contexts x %u allocations per thread per frame (allocations/s)\n",
+        kContextsPerFrame, kAllocationsPerContext);
+
+    const uint32_t ThreadCounts[] = { 1, 2, 4, 8, 16 };
+    for (uint32_t ThreadCount : ThreadCounts)
+    {
+        double LinearRate = MeasureAllocationRate<LinearAllocator>(ThreadCount,
+            []() { return new LinearAllocator(kCpuWritable); },
+            []() {});
+
+        // ÿ˷һ
+        UploadRingBuffer Ring;
+        Ring.Create(L"Benchmark Upload Ring",
+            ThreadCount * kContextsPerFrame * (ContextUploadBytes() + UploadRingBuffer::kChunkSize));
+
+        double RingRate = MeasureAllocationRate<UploadRingAllocator>(ThreadCount,
+            [&]() { return new UploadRingAllocator(Ring); },
+            [&]() { Ring.EndFrame(); });
+
+        Utility::Printf("%2u threads: LinearAllocator %7.2f M/s  UploadRingAllocator %7.2f M/s  (x%.2f)\n",
+            ThreadCount, LinearRate / 1e6, RingRate / 1e6, RingRate / LinearRate);
+
+        char Label[32];
+        sprintf_s(Label, "  %u threads", ThreadCount);
+        Ring.PrintReport(Label);
+    }
+
+    Graphics::Shutdown();
+}
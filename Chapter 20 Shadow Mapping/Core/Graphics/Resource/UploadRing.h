@@ -0,0 +1,139 @@
+/*
+	ÿ֡Ļϴ CommandContext е CPU д LinearAllocator
+	- Ĺһ鳣פӳϴСΪ ֡Ԥ * kFrameCount
+	- ÿδӻȡһ kChunkSize Ŀ飬ȡֻǶԻͷһԭӱȽϽ
+	- ڵķֻɳиĵ߳ɣûκͬ
+	- ÿ֡ Present ʱ¼ͷ͸ΧֵΧɺβǰƵλãռٴʹ
+	- һķ䡢߻֡ռʱ˻صԭ LinearAllocator
+
+	ֻ Present ʱ֡գ֡ǰıѾ Finish
+*/
+
+#pragma once
+
+#include "LinearAllocator.h"
+#include <atomic>
+#include <queue>
+#include <mutex>
+
+enum UploadRingStat
+{
+    kRingAllocations,       // ڻɵķ
+    kRingRequestedBytes,    // ֽ
+    kRingRoundingBytes,     // Сȡֽ
+    kRingPaddingBytes,      // ʼַֽ
+    kRingChunks,            // ȡĿ
+    kRingChunkTailBytes,    // 黹ʱʣδõֽ
+    kRingStalls,            // ʱȴGPUĴ
+    kRingFallbacks,         // ˻ LinearAllocator ķ
+    kRingFallbackBytes,
+    kRingFrames,
+
+    kRingStatCount
+};
+
+struct UploadRingStats
+{
+    uint64_t Value[kRingStatCount];
+    uint64_t PeakFrameBytes;    // ֡ȡĿֽ
+
+    uint64_t operator[](UploadRingStat s) const { return Value[s]; }
+};
+
+// ϴ
+class UploadRingBuffer : public GpuResource
+{
+public:
+    static const uint32_t kFrameCount = 3;      // ǵ֡ͽһ
+    static const size_t kChunkSize = 0x10000;   // 64KҲǿܱ֤
+
+    UploadRingBuffer();
+    ~UploadRingBuffer() { Destroy(); }
+
+    // FrameBudget Ϊһ֡ԤʹõֽСȡ
+    void Create(const std::wstring& Name, size_t FrameBudget);
+    virtual void Destroy() override;
+
+    // ȡһ飬ؿڻеƫơѱδɵ֡ռʱȴɵһ֡
+    // ǰ֡Լռ򷵻false
+    bool RequestChunk(size_t& Offset);
+    // Ĳÿд
+    void ReleaseChunk(void) { --m_OutstandingChunks; }
+
+    // һ֡Ľã¼֡ĽλòGPUѾ֡
+    void EndFrame(void);
+
+    uint8_t* GetCpuAddress(size_t Offset) const { return m_CpuVirtualAddress + Offset; }
+    D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress(size_t Offset) const { return m_GpuVirtualAddress + Offset; }
+
+    void AddStats(const uint64_t (&Stats)[kRingStatCount]);
+    UploadRingStats GetStats(void) const;
+    void ResetStats(void);
+    void PrintReport(const char* Label) const;
+
+private:
+    struct FrameMarker
+    {
+        uint64_t Head;
+        uint64_t GraphicsFence;
+        uint64_t ComputeFence;
+    };
+
+    // ΧѾɵ֡Ҫ m_Mutex
+    void RetireCompletedFrames(void);
+
+    uint8_t* m_CpuVirtualAddress;
+    size_t m_Size;
+
+    // ͷͻβǵƫƣ m_Size ȡģõƫ
+    // [m_Tail, m_Head) ǿܻڱGPUȡĲ
+    std::atomic<uint64_t> m_Head;
+    std::atomic<uint64_t> m_Tail;
+    std::atomic<int32_t> m_OutstandingChunks;
+
+    std::mutex m_Mutex;
+    std::queue<FrameMarker> m_Frames;
+    uint64_t m_LastFrameHead;
+    uint64_t m_PeakFrameBytes;
+
+    std::atomic<uint64_t> m_Stats[kRingStatCount];
+};
+
+// ϴӿں LinearAllocator(kCpuWritable) ͬ
+// ÿ CommandContext һֻһ߳ʹ
+class UploadRingAllocator
+{
+public:
+
+    UploadRingAllocator(UploadRingBuffer& Ring = sm_Ring);
+
+    DynAlloc Allocate( size_t SizeInBytes, size_t Alignment = DEFAULT_ALIGN );
+
+    // 黹ǰĿ飬ϵĿռ䰴֡գFenceID ֻ˻ص LinearAllocator
+    void CleanupUsedPages( uint64_t FenceID );
+
+    static void Initialize( size_t FrameBudget ) { sm_Ring.Create(L"Upload Ring", FrameBudget); }
+    static void EndFrame( void ) { sm_Ring.EndFrame(); }
+    static void DestroyAll( void ) { sm_Ring.Destroy(); }
+
+    static void ResetStats( void ) { sm_Ring.ResetStats(); }
+    static void PrintReport( void ) { sm_Ring.PrintReport("Upload ring"); }
+
+    // ڿ豸ϱȽ LinearAllocator ͻη 1~16 ߳ÿķ
+    // ߳»ĶͿβ˷
+    static void Benchmark( void );
+
+private:
+
+    void RetireChunk( void );
+
+    static UploadRingBuffer sm_Ring;
+
+    UploadRingBuffer& m_Ring;
+    LinearAllocator m_Fallback;
+    bool m_UseFallback;         // лʣµķ䶼 LinearAllocator
+    bool m_HasChunk;
+    size_t m_CurOffset;         // ǰһõλ(еƫ)
+    size_t m_ChunkEnd;
+    uint64_t m_Stats[kRingStatCount];   //  CleanupUsedPages ʱۼӵ
+};
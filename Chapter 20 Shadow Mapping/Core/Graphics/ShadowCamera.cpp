@@ -13,6 +13,8 @@
 
 #include "pch.h"
 #include "ShadowCamera.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace Math;
 
@@ -26,17 +28,15 @@ void GameCore::ShadowCamera::UpdateMatrix(
     Vector3 RcpDimensions = Recip(ShadowBounds);
     Vector3 QuantizeScale = Vector3((float)BufferWidth, (float)BufferHeight, (float)((1 << BufferPrecision) - 1)) * RcpDimensions;
 
-    SetPosition(-LightDirection * ShadowBounds.GetX() / 2.0f);
+    // Transform to view space
+    ShadowCenter = ~GetRotation() * ShadowCenter;
+    // Scale to texel units, truncate fractional part, and scale back to world units
+    ShadowCenter = Floor(ShadowCenter * QuantizeScale) / QuantizeScale;
+    // Transform back into world space
+    ShadowCenter = GetRotation() * ShadowCenter;
 
-    // ԭȵĴʲô˼ ʱֱӸĳ
-//     // Transform to view space
-//     ShadowCenter = ~GetRotation() * ShadowCenter;
-//     // Scale to texel units, truncate fractional part, and scale back to world units
-//     ShadowCenter = Floor(ShadowCenter * QuantizeScale) / QuantizeScale;
-//     // Transform back into world space
-//     ShadowCenter = GetRotation() * ShadowCenter;
-// 
-//     SetPosition(ShadowCenter);
+    // ͶӰzΧ [0, ]ĵ󷽰ȴ
+    SetPosition(ShadowCenter - LightDirection * ShadowBounds.GetZ() / 2.0f);
 
     SetProjMatrix( Matrix4::MakeScale(Vector3(2.0f, 2.0f, 1.0f) * RcpDimensions) );
 
@@ -45,3 +45,223 @@ void GameCore::ShadowCamera::UpdateMatrix(
     // Transform from clip space to texture space
     m_ShadowMatrix =  Matrix4( AffineTransform( Matrix3::MakeScale( 0.5f, -0.5f, 1.0f ), Vector3(0.5f, 0.5f, 0.0f) ) ) * m_ViewProjMatrix;
 }
+
+void GameCore::ShadowCamera::Update()
+{
+    BaseCamera::Update();
+
+    m_FrustumVS = Frustum(m_ProjMatrix, 1.0f);
+    m_FrustumWS = m_CameraToWorld * m_FrustumVS;
+}
+
+void GameCore::CascadedShadowCamera::ComputeSplits( uint32_t CascadeCount, float Lambda, float NearClip, float FarClip, float* Splits )
+{
+    Splits[0] = NearClip;
+    for (uint32_t i = 1; i < CascadeCount; ++i)
+    {
+        float t = (float)i / CascadeCount;
+        float logSplit = NearClip * powf(FarClip / NearClip, t);
+        float uniformSplit = NearClip + (FarClip - NearClip) * t;
+        Splits[i] = Lambda * logSplit + (1.0f - Lambda) * uniformSplit;
+    }
+    Splits[CascadeCount] = FarClip;
+}
+
+BoundingSphere GameCore::CascadedShadowCamera::ComputeSliceBounds( float TanX, float TanY, float NearZ, float FarZ )
+{
+    // ϣƽǵԶƽǵľȣԶƽʱԶƽ
+    float k2 = TanX * TanX + TanY * TanY;
+    float centerZ = 0.5f * (NearZ + FarZ) * (1.0f + k2);
+    float radius;
+    if (centerZ >= FarZ)
+    {
+        centerZ = FarZ;
+        radius = FarZ * sqrtf(k2);
+    }
+    else
+    {
+        radius = sqrtf((FarZ - centerZ) * (FarZ - centerZ) + FarZ * FarZ * k2);
+    }
+    return BoundingSphere(Vector3(0.0f, 0.0f, centerZ), radius);
+}
+
+void GameCore::CascadedShadowCamera::UpdateMatrix( const Camera& ViewCamera, Vector3 LightDirection,
+    uint32_t CascadeCount, float Lambda, float ShadowDistance, float CasterDistance,
+    uint32_t BufferSize, uint32_t BufferPrecision )
+{
+    m_CascadeCount = std::min(std::max(CascadeCount, 1u), kMaxCascades);
+
+    float NearClip = ViewCamera.GetNearClip();
+    float FarClip = std::min(ShadowDistance, ViewCamera.GetFarClip());
+    ComputeSplits(m_CascadeCount, Lambda, NearClip, FarClip, m_Splits);
+
+    // ӿռԶƽĽǵŽǵ
+    Vector3 Corner = ViewCamera.GetViewSpaceFrustum().GetFrustumCorner(Frustum::kFarUpperRight);
+    float TanX = Corner.GetX() / Corner.GetZ();
+    float TanY = Corner.GetY() / Corner.GetZ();
+
+    for (uint32_t i = 0; i < m_CascadeCount; ++i)
+    {
+        BoundingSphere Slice = ComputeSliceBounds(TanX, TanY, m_Splits[i], m_Splits[i + 1]);
+
+        // 뾶ȡ1/16ӰͼǵķΧ֡仯
+        float Radius = ceilf(Slice.GetRadius() * 16.0f) / 16.0f;
+        Vector3 Center = ViewCamera.GetPosition() + ViewCamera.GetForwardVec() * Slice.GetCenter().GetZ();
+        m_Bounds[i] = BoundingSphere(Center, Radius);
+
+        float Size = 2.0f * Radius;
+        m_Cascades[i].UpdateMatrix(LightDirection, Center, Vector3(Size, Size, Size + 2.0f * CasterDistance),
+            BufferSize, BufferSize, BufferPrecision);
+    }
+}
+
+bool GameCore::CascadedShadowCamera::SelfTest( void )
+{
+    const uint32_t kCascades = 4;
+    const uint32_t kBufferSize = 2048;
+    const float kNear = 1.0f;
+    const float kFar = 60.0f;
+    const Vector3 LightDirection = Normalize(Vector3(0.57735f, -0.57735f, 0.57735f));
+
+    bool AllPassed = true;
+    auto Report = [&AllPassed]( const char* Name, bool Passed )
+    {
+        Utility::Printf("  %-40s %s\n", Name, Passed ? "ok" : "FAILED");
+        AllPassed = AllPassed && Passed;
+    };
+
+    Utility::Printf("Cascaded shadow self test\n");
+
+    // ֶ: ˵㡢Lambda Ϊ01ʱֱǾȺͶ
+    {
+        bool Passed = true;
+        const float Lambdas[] = { 0.0f, 0.5f, 1.0f };
+        for (float Lambda : Lambdas)
+        {
+            float Splits[kMaxCascades + 1];
+            ComputeSplits(kCascades, Lambda, kNear, kFar, Splits);
+            Passed = Passed && Splits[0] == kNear && Splits[kCascades] == kFar;
+            for (uint32_t i = 0; i < kCascades; ++i)
+            {
+                Passed = Passed && Splits[i] < Splits[i + 1];
+                if (Lambda == 0.0f)
+                    Passed = Passed && fabsf(Splits[i + 1] - Splits[i] - (kFar - kNear) / kCascades) < 1e-3f;
+                if (Lambda == 1.0f)
+                    Passed = Passed && fabsf(Splits[i + 1] / Splits[i] - powf(kFar / kNear, 1.0f / kCascades)) < 1e-3f;
+            }
+        }
+        Report("splits", Passed);
+    }
+
+    Camera ViewCamera;
+    ViewCamera.SetPerspectiveMatrix(XM_PIDIV4, 16.0f / 9.0f, kNear, 1000.0f);
+    ViewCamera.SetEyeAtUp(Vector3(0.0f, 5.0f, -10.0f), Vector3(kZero), Vector3(kYUnitVector));
+    ViewCamera.Update();
+
+    Vector3 Corner = ViewCamera.GetViewSpaceFrustum().GetFrustumCorner(Frustum::kFarUpperRight);
+    const float TanX = Corner.GetX() / Corner.GetZ();
+    const float TanY = Corner.GetY() / Corner.GetZ();
+
+    // ֶε8ǵ㣬ӿռ
+    auto SliceCorner = [&]( float NearZ, float FarZ, int Index )
+    {
+        float Z = (Index & 4) ? FarZ : NearZ;
+        return Vector3((Index & 1) ? TanX * Z : -TanX * Z, (Index & 2) ? TanY * Z : -TanY * Z, Z);
+    };
+
+    // Χסֶεнǵ
+    {
+        bool Passed = true;
+        float Splits[kMaxCascades + 1];
+        ComputeSplits(kCascades, 0.75f, kNear, kFar, Splits);
+        for (uint32_t i = 0; i < kCascades; ++i)
+        {
+            BoundingSphere Bounds = ComputeSliceBounds(TanX, TanY, Splits[i], Splits[i + 1]);
+            for (int c = 0; c < 8; ++c)
+            {
+                float Distance = Length(SliceCorner(Splits[i], Splits[i + 1], c) - Bounds.GetCenter());
+                Passed = Passed && Distance <= (float)Bounds.GetRadius() * 1.0001f;
+            }
+        }
+        Report("slice bounds contain slice corners", Passed);
+    }
+
+    // ѸԷֶεĽǵӳ䵽Ӱͼ
+    CascadedShadowCamera Shadow;
+    Shadow.UpdateMatrix(ViewCamera, LightDirection, kCascades, 0.75f, kFar, 30.0f, kBufferSize, 16);
+    {
+        bool Passed = Shadow.GetCascadeCount() == kCascades;
+        for (uint32_t i = 0; i < Shadow.GetCascadeCount(); ++i)
+        {
+            float NearZ = i == 0 ? kNear : Shadow.GetSplit(i - 1);
+            for (int c = 0; c < 8; ++c)
+            {
+                Vector3 View = SliceCorner(NearZ, Shadow.GetSplit(i), c);
+                Vector3 World = ViewCamera.GetPosition() + ViewCamera.GetRightVec() * View.GetX() +
+                    ViewCamera.GetUpVec() * View.GetY() + ViewCamera.GetForwardVec() * View.GetZ();
+                Vector4 Tex = Shadow.GetCascade(i).GetShadowMatrix() * World;
+                float Coords[3] = { Tex.GetX(), Tex.GetY(), Tex.GetZ() };
+                for (float v : Coords)
+                    Passed = Passed && v >= 0.0f && v <= 1.0f;
+            }
+        }
+        Report("cascade matrices cover their slices", Passed);
+    }
+
+    // ƽơתʱ̶ӰͼеСֲ䣬ߴ粻
+    auto TexelFraction = [&]( const CascadedShadowCamera& Cascades, uint32_t Cascade, Vector3 Point, float& FracU, float& FracV )
+    {
+        Vector4 Tex = Cascades.GetCascade(Cascade).GetShadowMatrix() * Point;
+        float U = (float)Tex.GetX() * kBufferSize;
+        float V = (float)Tex.GetY() * kBufferSize;
+        FracU = U - floorf(U);
+        FracV = V - floorf(V);
+    };
+    auto SameFraction = []( float a, float b )
+    {
+        float d = fabsf(a - b);
+        return std::min(d, 1.0f - d) < 0.01f;
+    };
+
+    const char* MoveNames[] = { "stable under camera translation", "stable under camera rotation" };
+    for (int Move = 0; Move < 2; ++Move)
+    {
+        bool Passed = true;
+        for (uint32_t i = 0; i < kCascades; ++i)
+        {
+            Vector3 Point = Shadow.GetBounds(i).GetCenter();
+            float BaseU, BaseV;
+            TexelFraction(Shadow, i, Point, BaseU, BaseV);
+            float BaseRadius = Shadow.GetBounds(i).GetRadius();
+
+            for (int Step = 1; Step <= 20; ++Step)
+            {
+                Camera Moved;
+                Moved.SetPerspectiveMatrix(XM_PIDIV4, 16.0f / 9.0f, kNear, 1000.0f);
+                if (Move == 0)
+                {
+                    Vector3 Offset(0.013f * Step, 0.0f, 0.007f * Step);
+                    Moved.SetEyeAtUp(Vector3(0.0f, 5.0f, -10.0f) + Offset, Offset, Vector3(kYUnitVector));
+                }
+                else
+                {
+                    Vector3 Target(sinf(0.01f * Step) * 10.0f, 0.0f, -10.0f + cosf(0.01f * Step) * 10.0f);
+                    Moved.SetEyeAtUp(Vector3(0.0f, 5.0f, -10.0f), Target, Vector3(kYUnitVector));
+                }
+                Moved.Update();
+
+                CascadedShadowCamera MovedShadow;
+                MovedShadow.UpdateMatrix(Moved, LightDirection, kCascades, 0.75f, kFar, 30.0f, kBufferSize, 16);
+
+                float U, V;
+                TexelFraction(MovedShadow, i, Point, U, V);
+                Passed = Passed && SameFraction(U, BaseU) && SameFraction(V, BaseV) &&
+                    (float)MovedShadow.GetBounds(i).GetRadius() == BaseRadius;
+            }
+        }
+        Report(MoveNames[Move], Passed);
+    }
+
+    Utility::Printf("Cascaded shadow self test %s\n", AllPassed ? "passed" : "FAILED");
+    return AllPassed;
+}
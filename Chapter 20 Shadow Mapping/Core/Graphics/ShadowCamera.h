@@ -25,6 +25,9 @@ namespace GameCore
 
         ShadowCamera() {}
 
+        // ͬʱͶӰ׶壬Ӱpass޳
+        virtual void Update() override;
+
         void UpdateMatrix( 
             Vector3 LightDirection,     // շ򣨵λ
             Vector3 ShadowCenter,       // ӰĿĵ
@@ -42,4 +45,46 @@ namespace GameCore
         Matrix4 m_ShadowMatrix;
     };
 
+    // Ӱ: ׶ [near, ShadowDistance] ֳɶΣÿһ ShadowCamera
+    // - ֶھȻֺͶ֮䰴 Lambda ֵ0ΪȻ֣1Ϊ
+    // - ÿðס׶СΧϣֻͷֶйأתʱӰͼǵķΧ
+    // - ڹԴռаȡ(ShadowCamera::UpdateMatrix)ƽʱӰ˸
+    class CascadedShadowCamera
+    {
+    public:
+        static const uint32_t kMaxCascades = 4;
+
+        void UpdateMatrix(
+            const Camera& ViewCamera,   // ۲ҪѾ Update
+            Vector3 LightDirection,     // շ򣨵λ
+            uint32_t CascadeCount,      // 1 ~ kMaxCascades
+            float Lambda,               // ֶηʽ
+            float ShadowDistance,       // ʼӰľ
+            float CasterDistance,       // Χ֮Դľ룬ڵԻͶӰ
+            uint32_t BufferSize,        // ÿӰͼ߳
+            uint32_t BufferPrecision    // Bit depth of shadow buffer--usually 16 or 24
+            );
+
+        uint32_t GetCascadeCount() const { return m_CascadeCount; }
+        const ShadowCamera& GetCascade( uint32_t Cascade ) const { return m_Cascades[Cascade]; }
+        //  Cascade ӿռԶ˾
+        float GetSplit( uint32_t Cascade ) const { return m_Splits[Cascade + 1]; }
+        const BoundingSphere& GetBounds( uint32_t Cascade ) const { return m_Bounds[Cascade]; }
+
+        // д CascadeCount + 1 ֶα߽磬һ NearClipһ FarClip
+        static void ComputeSplits( uint32_t CascadeCount, float Lambda, float NearClip, float FarClip, float* Splits );
+
+        // ӿռ׶ [NearZ, FarZ] һεСΧTanXTanY ˮƽֱŽǵ
+        static BoundingSphere ComputeSliceBounds( float TanX, float TanY, float NearZ, float FarZ );
+
+        // ֶΡΧĸǡԼƽƺתʱӰǷȶ Utility::Printf 
+        static bool SelfTest( void );
+
+    private:
+        uint32_t m_CascadeCount = 0;
+        float m_Splits[kMaxCascades + 1];
+        BoundingSphere m_Bounds[kMaxCascades];
+        ShadowCamera m_Cascades[kMaxCascades];
+    };
+
 }
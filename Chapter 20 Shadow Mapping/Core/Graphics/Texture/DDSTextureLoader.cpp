@@ -973,7 +973,8 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
                                      _In_ size_t maxsize,
                                      _In_ bool forceSRGB,
                                      _Outptr_opt_ ID3D12Resource** texture,
-                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                     _Out_opt_ std::vector<D3D12_SUBRESOURCE_DATA>* deferredData )
 {
     HRESULT hr = S_OK;
 
@@ -1182,7 +1183,13 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
             }
         }
 
-        if (SUCCEEDED(hr))
+        // ӳϴʱֻԴļλãɵ¼ƿ
+        if (SUCCEEDED(hr) && deferredData != nullptr)
+        {
+            UINT uploadCount = static_cast<UINT>(mipCount - skipMip) * arraySize;
+            deferredData->assign(initData.get(), initData.get() + uploadCount);
+        }
+        else if (SUCCEEDED(hr))
         {
             GpuResource DestTexture(*texture, D3D12_RESOURCE_STATE_COPY_DEST);
             CommandContext::InitializeTexture(DestTexture, subresourceCount, initData.get());
@@ -1222,16 +1229,16 @@ static DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header )
 }
 
 
-_Use_decl_annotations_
-HRESULT CreateDDSTextureFromMemory(
-    ID3D12Device* d3dDevice,
-    const uint8_t* ddsData,
-    size_t ddsDataSize,
-    size_t maxsize,
-    bool forceSRGB,
-    ID3D12Resource** texture,
-    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
-    DDS_ALPHA_MODE* alphaMode )
+//--------------------------------------------------------------------------------------
+static HRESULT CreateTextureFromDDSMemory( _In_ ID3D12Device* d3dDevice,
+                                           _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                           _In_ size_t ddsDataSize,
+                                           _In_ size_t maxsize,
+                                           _In_ bool forceSRGB,
+                                           _Outptr_opt_ ID3D12Resource** texture,
+                                           _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                           _Out_opt_ DDS_ALPHA_MODE* alphaMode,
+                                           _Out_opt_ std::vector<D3D12_SUBRESOURCE_DATA>* deferredData )
 {
     if ( texture )
     {
@@ -1284,7 +1291,7 @@ HRESULT CreateDDSTextureFromMemory(
 
     HRESULT hr = CreateTextureFromDDS( d3dDevice,
                                        header, ddsData + offset, ddsDataSize - offset, maxsize,
-                                       forceSRGB, texture, textureView );
+                                       forceSRGB, texture, textureView, deferredData );
     if ( SUCCEEDED(hr) )
     {
         if (texture != nullptr && *texture != nullptr)
@@ -1300,6 +1307,40 @@ HRESULT CreateDDSTextureFromMemory(
 }
 
 
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromMemory(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode )
+{
+    return CreateTextureFromDDSMemory( d3dDevice, ddsData, ddsDataSize, maxsize, forceSRGB,
+                                       texture, textureView, alphaMode, nullptr );
+}
+
+
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromMemoryDeferred(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+    DDS_ALPHA_MODE* alphaMode )
+{
+    subresources.clear();
+    return CreateTextureFromDDSMemory( d3dDevice, ddsData, ddsDataSize, maxsize, forceSRGB,
+                                       texture, textureView, alphaMode, &subresources );
+}
+
+
 _Use_decl_annotations_
 HRESULT CreateDDSTextureFromFile(
     ID3D12Device* d3dDevice,
@@ -1338,7 +1379,7 @@ HRESULT CreateDDSTextureFromFile(
 
     hr = CreateTextureFromDDS( d3dDevice,
                                header, bitData, bitSize, maxsize,
-                               forceSRGB, texture, textureView );
+                               forceSRGB, texture, textureView, nullptr );
 
     if ( alphaMode )
         *alphaMode = GetAlphaMode( header );
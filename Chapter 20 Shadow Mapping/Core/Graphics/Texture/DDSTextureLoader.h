@@ -27,6 +27,8 @@
 #include <stdint.h>
 #pragma warning(pop)
 
+#include <vector>
+
 enum DDS_ALPHA_MODE
 {
     DDS_ALPHA_MODE_UNKNOWN       = 0,
@@ -46,6 +48,19 @@ HRESULT __cdecl CreateDDSTextureFromMemory( _In_ ID3D12Device* d3dDevice,
                                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                             );
 
+// ֻļԴ(COPY_DEST)SRVϴݣsubresources ÿԴ ddsData λã
+// ɵڿ¼ƣddsData ڿ¼֮ǰҪһֱЧ
+HRESULT __cdecl CreateDDSTextureFromMemoryDeferred( _In_ ID3D12Device* d3dDevice,
+                                                _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                                _In_ size_t ddsDataSize,
+                                                _In_ size_t maxsize,
+                                                _In_ bool forceSRGB,
+                                                _Outptr_opt_ ID3D12Resource** texture,
+                                                _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                                _Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+                                                _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                            );
+
 HRESULT __cdecl CreateDDSTextureFromFile( _In_ ID3D12Device* d3dDevice,
                                             _In_z_ const wchar_t* szFileName,
                                             _In_ size_t maxsize,
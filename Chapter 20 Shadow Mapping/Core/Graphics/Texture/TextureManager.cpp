@@ -18,8 +18,8 @@
 #include "DDSTextureLoader.h"
 #include "GraphicsCore.h"
 #include "CommandContext.h"
+#include "TextureStreamer.h"
 #include <map>
-#include <thread>
 
 using namespace std;
 using namespace Graphics;
@@ -32,6 +32,7 @@ static UINT BytesPerPixel( DXGI_FORMAT Format )
 void Texture::Create( size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData )
 {
     m_UsageState = D3D12_RESOURCE_STATE_COPY_DEST;
+    m_SubresourceStates.clear();
 
     D3D12_RESOURCE_DESC texDesc = {};
     texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -69,8 +70,62 @@ void Texture::Create( size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT For
     g_Device->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
 }
 
-void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
+void Texture::CreateCube( size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData )
 {
+    m_UsageState = D3D12_RESOURCE_STATE_COPY_DEST;
+    m_SubresourceStates.clear();
+
+    D3D12_RESOURCE_DESC texDesc = {};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = Width;
+    texDesc.Height = (UINT)Height;
+    texDesc.DepthOrArraySize = 6;
+    texDesc.MipLevels = 1;
+    texDesc.Format = Format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.SampleDesc.Quality = 0;
+    texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    D3D12_HEAP_PROPERTIES HeapProps;
+    HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+    HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    HeapProps.CreationNodeMask = 1;
+    HeapProps.VisibleNodeMask = 1;
+
+    ASSERT_SUCCEEDED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+        m_UsageState, nullptr, MY_IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())));
+
+    m_pResource->SetName(L"Texture Cube");
+
+    D3D12_SUBRESOURCE_DATA texResource[6];
+    for (UINT Face = 0; Face < 6; ++Face)
+    {
+        texResource[Face].RowPitch = Width * BytesPerPixel(Format);
+        texResource[Face].SlicePitch = texResource[Face].RowPitch * Height;
+        texResource[Face].pData = (const uint8_t*)InitialData + Face * texResource[Face].SlicePitch;
+    }
+
+    CommandContext::InitializeTexture(*this, 6, texResource);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+    SRVDesc.Format = Format;
+    SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+    SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    SRVDesc.TextureCube.MipLevels = 1;
+
+    if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    g_Device->CreateShaderResourceView(m_pResource.Get(), &SRVDesc, m_hCpuDescriptorHandle);
+}
+
+bool Texture::DecodeTGA( const void* _filePtr, size_t fileSize, std::vector<uint32_t>& Pixels, uint32_t& Width, uint32_t& Height )
+{
+    const size_t kHeaderSize = 18;
+    if (fileSize < kHeaderSize)
+        return false;
+
     const uint8_t* filePtr = (const uint8_t*)_filePtr;
 
     // Skip first two bytes
@@ -90,11 +145,15 @@ void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
     // Ignore another byte
     filePtr++;
 
-    uint32_t* formattedData = new uint32_t[imageWidth * imageHeight];
-    uint32_t* iter = formattedData;
-
     uint8_t numChannels = bitCount / 8;
     uint32_t numBytes = imageWidth * imageHeight * numChannels;
+    if (fileSize < kHeaderSize + numBytes)
+        return false;
+
+    Width = imageWidth;
+    Height = imageHeight;
+    Pixels.assign((size_t)imageWidth * imageHeight, 0);
+    uint32_t* iter = Pixels.data();
 
     switch (numChannels)
     {
@@ -116,9 +175,18 @@ void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
         break;
     }
 
-    Create( imageWidth, imageHeight, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, formattedData );
+    return true;
+}
 
-    delete [] formattedData;
+bool Texture::CreateTGAFromMemory( const void* filePtr, size_t fileSize, bool sRGB )
+{
+    std::vector<uint32_t> Pixels;
+    uint32_t Width, Height;
+    if (!DecodeTGA(filePtr, fileSize, Pixels, Width, Height))
+        return false;
+
+    Create( Width, Height, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, Pixels.data() );
+    return true;
 }
 
 bool Texture::CreateDDSFromMemory( const void* filePtr, size_t fileSize, bool sRGB )
@@ -149,6 +217,18 @@ void Texture::CreatePIXImageFromMemory( const void* memBuffer, size_t fileSize )
     Create(header.Pitch, header.Width, header.Height, header.Format, (uint8_t*)memBuffer + sizeof(Header));
 }
 
+void Texture::Destroy()
+{
+    GpuResource::Destroy();
+
+    // ⲿľFreeDescriptor 
+    if (m_hCpuDescriptorHandle.ptr != 0 && m_hCpuDescriptorHandle.ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_hCpuDescriptorHandle);
+
+    // Ϊδ䣬ٴ Create ʱ
+    m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+}
+
 namespace TextureManager
 {
     wstring s_RootPath = L"";
@@ -161,6 +241,8 @@ namespace TextureManager
 
     void Shutdown( void )
     {
+        // ʽصҪأͷ
+        TextureStreamer::WaitForAll();
         s_TextureCache.clear();
     }
 
@@ -197,6 +279,7 @@ namespace TextureManager
 
         uint32_t BlackPixel = 0;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &BlackPixel);
+        ManTex->MarkLoaded();
         return *ManTex;
     }
 
@@ -215,6 +298,7 @@ namespace TextureManager
 
         uint32_t WhitePixel = 0xFFFFFFFFul;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &WhitePixel);
+        ManTex->MarkLoaded();
         return *ManTex;
     }
 
@@ -233,6 +317,45 @@ namespace TextureManager
 
         uint32_t MagentaPixel = 0x00FF00FF;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &MagentaPixel);
+        ManTex->MarkLoaded();
+        return *ManTex;
+    }
+
+    const Texture& GetFlatNormalTex2D(void)
+    {
+        auto ManagedTex = FindOrLoadTexture(L"DefaultFlatNormalTexture");
+
+        ManagedTexture* ManTex = ManagedTex.first;
+        const bool RequestsLoad = ManagedTex.second;
+
+        if (!RequestsLoad)
+        {
+            ManTex->WaitForLoad();
+            return *ManTex;
+        }
+
+        uint32_t FlatNormalPixel = 0xFFFF8080;
+        ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &FlatNormalPixel);
+        ManTex->MarkLoaded();
+        return *ManTex;
+    }
+
+    const Texture& GetBlackTexCube(void)
+    {
+        auto ManagedTex = FindOrLoadTexture(L"DefaultBlackCubeTexture");
+
+        ManagedTexture* ManTex = ManagedTex.first;
+        const bool RequestsLoad = ManagedTex.second;
+
+        if (!RequestsLoad)
+        {
+            ManTex->WaitForLoad();
+            return *ManTex;
+        }
+
+        uint32_t BlackFaces[6] = {};
+        ManTex->CreateCube(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, BlackFaces);
+        ManTex->MarkLoaded();
         return *ManTex;
     }
 
@@ -240,18 +363,56 @@ namespace TextureManager
 
 void ManagedTexture::WaitForLoad( void ) const
 {
-    volatile D3D12_CPU_DESCRIPTOR_HANDLE& VolHandle = (volatile D3D12_CPU_DESCRIPTOR_HANDLE&)m_hCpuDescriptorHandle;
-    volatile bool& VolValid = (volatile bool&)m_IsValid;
-    while (VolHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN && VolValid)
-        this_thread::yield();
+    if (IsLoaded())
+        return;
+
+    // ʽص: ߳Ͼ͵طصһ֡ TextureStreamer::Update
+    // ̵߳ȿɺ̷߳
+    if (m_IsStreaming)
+        TextureStreamer::WaitFor(*this);
+
+    unique_lock<mutex> Lock(m_LoadMutex);
+    m_LoadedEvent.wait(Lock, [this]() { return IsLoaded(); });
+}
+
+void ManagedTexture::MarkLoaded( void )
+{
+    {
+        lock_guard<mutex> Lock(m_LoadMutex);
+        m_IsLoaded.store(true, std::memory_order_release);
+    }
+    m_LoadedEvent.notify_all();
 }
 
 void ManagedTexture::SetToInvalidTexture( void )
 {
-    m_hCpuDescriptorHandle = TextureManager::GetMagentaTex2D().GetSRV();
+    const Texture& Magenta = TextureManager::GetMagentaTex2D();
+
+    // ʧǰѾʽصľҲѾʹߣԭλĳ
+    if (!m_BorrowsDescriptor && m_hCpuDescriptorHandle.ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+    {
+        g_Device->CopyDescriptorsSimple(1, m_hCpuDescriptorHandle, Magenta.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+    else
+    {
+        m_hCpuDescriptorHandle = Magenta.GetSRV();
+        m_BorrowsDescriptor = true;
+    }
+
     m_IsValid = false;
 }
 
+void ManagedTexture::Destroy( void )
+{
+    if (m_BorrowsDescriptor)
+    {
+        m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+        m_BorrowsDescriptor = false;
+    }
+
+    Texture::Destroy();
+}
+
 const ManagedTexture* TextureManager::LoadFromFile( const std::wstring& fileName, bool sRGB )
 {
     std::wstring CatPath = fileName;
@@ -263,6 +424,31 @@ const ManagedTexture* TextureManager::LoadFromFile( const std::wstring& fileName
     return Tex;
 }
 
+const ManagedTexture* TextureManager::LoadFromFileAsync( const std::wstring& fileName, bool sRGB, const Texture& Placeholder )
+{
+    auto ManagedTex = FindOrLoadTexture(fileName + L".dds");
+
+    ManagedTexture* ManTex = ManagedTex.first;
+    const bool RequestsLoad = ManagedTex.second;
+
+    if (!RequestsLoad)
+    {
+        // ʽصʱо
+        if (ManTex->IsStreaming())
+            return ManTex;
+
+        // ͬеҪõLoadFromFile  .dds ʱ .dds Ŀ졢
+        //  .tga Ŀһ .tga
+        ManTex->WaitForLoad();
+        if (!ManTex->IsValid())
+            return LoadTGAFromFile( fileName + L".tga", sRGB );
+        return ManTex;
+    }
+
+    TextureStreamer::Request(*ManTex, s_RootPath + fileName, sRGB, Placeholder);
+    return ManTex;
+}
+
 const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileName, bool sRGB )
 {
     auto ManagedTex = FindOrLoadTexture(fileName);
@@ -282,6 +468,7 @@ const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileN
     else
         ManTex->GetResource()->SetName(fileName.c_str());
 
+    ManTex->MarkLoaded();
     return ManTex;
 }
 
@@ -299,14 +486,13 @@ const ManagedTexture* TextureManager::LoadTGAFromFile( const std::wstring& fileN
     }
 
     Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
-    if (ba->size() > 0)
-    {
-        ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB );
+    // ļΪջʧ(ʽ֧֡ݽض)ʱûдԴ
+    if (ba->size() > 0 && ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB ))
         ManTex->GetResource()->SetName(fileName.c_str());
-    }
     else
         ManTex->SetToInvalidTexture();
 
+    ManTex->MarkLoaded();
     return ManTex;
 }
 
@@ -333,5 +519,6 @@ const ManagedTexture* TextureManager::LoadPIXImageFromFile( const std::wstring&
     else
         ManTex->SetToInvalidTexture();
 
+    ManTex->MarkLoaded();
     return ManTex;
 }
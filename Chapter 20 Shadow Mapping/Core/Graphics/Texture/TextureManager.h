@@ -17,6 +17,9 @@
 #include "pch.h"
 #include "GpuResource.h"
 #include "Utility.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 class Texture : public GpuResource
 {
@@ -34,20 +37,21 @@ public:
         Create(Width, Width, Height, Format, InitData);
     }
 
-    void CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
+    // Create a 1-level cube map, InitData holds the six faces one after another
+    void CreateCube(size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitData );
+
+    bool CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
     bool CreateDDSFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
     void CreatePIXImageFromMemory( const void* memBuffer, size_t fileSize );
 
-    virtual void Destroy() override
-    {
-        GpuResource::Destroy();
-        // This leaks descriptor handles.  We should really give it back to be reused.
-        m_hCpuDescriptorHandle.ptr = 0;
-    }
+    // TGA RGBA8 أԴʽڹ߳ϵ
+    static bool DecodeTGA( const void* memBuffer, size_t fileSize, std::vector<uint32_t>& Pixels, uint32_t& Width, uint32_t& Height );
+
+    virtual void Destroy() override;
 
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV() const { return m_hCpuDescriptorHandle; }
 
-    bool operator!() { return m_hCpuDescriptorHandle.ptr == 0; }
+    bool operator!() { return m_hCpuDescriptorHandle.ptr == 0 || m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
 
 protected:
 
@@ -56,20 +60,38 @@ protected:
 
 class ManagedTexture : public Texture
 {
+    friend class TextureStreamer;
+
 public:
-    ManagedTexture( const std::wstring& FileName ) : m_MapKey(FileName), m_IsValid(true) {}
+    ManagedTexture( const std::wstring& FileName ) :
+        m_MapKey(FileName), m_IsValid(true), m_IsStreaming(false), m_BorrowsDescriptor(false), m_IsLoaded(false) {}
 
     void operator= ( const Texture& Texture );
 
+    // ؽ(ɹʧ)ʽصȿɲ̷̵߳߳ʱ̲߳ͬʱڵ
     void WaitForLoad(void) const;
     void Unload(void);
 
+    // õSRVܹ黹
+    virtual void Destroy() override;
+
     void SetToInvalidTexture(void);
     bool IsValid(void) const { return m_IsValid; }
+    bool IsStreaming(void) const { return m_IsStreaming; }
+
+    // ؽʱɼطã WaitForLoad
+    void MarkLoaded(void);
+    bool IsLoaded(void) const { return m_IsLoaded.load(std::memory_order_acquire); }
 
 private:
     std::wstring m_MapKey;        // For deleting from the map later
     bool m_IsValid;
+    bool m_IsStreaming;           //  TextureStreamer أǰ SRV ռλ
+    bool m_BorrowsDescriptor;     // ûԼָ
+
+    std::atomic<bool> m_IsLoaded;
+    mutable std::mutex m_LoadMutex;
+    mutable std::condition_variable m_LoadedEvent;
 };
 
 namespace TextureManager
@@ -82,6 +104,10 @@ namespace TextureManager
     const ManagedTexture* LoadTGAFromFile( const std::wstring& fileName, bool sRGB = false );
     const ManagedTexture* LoadPIXImageFromFile( const std::wstring& fileName );
 
+    // أSRV  Placeholder Ŀļں̨ȡ벢ϴ
+    // ɺ TextureStreamer::Update ԭλ滻䡣 .dds  .tga
+    const ManagedTexture* LoadFromFileAsync( const std::wstring& fileName, bool sRGB, const Texture& Placeholder );
+
     inline const ManagedTexture* LoadFromFile( const std::string& fileName, bool sRGB = false )
     {
         return LoadFromFile(MakeWStr(fileName), sRGB);
@@ -102,6 +128,16 @@ namespace TextureManager
         return LoadPIXImageFromFile(MakeWStr(fileName));
     }
 
+    inline const ManagedTexture* LoadFromFileAsync( const std::string& fileName, bool sRGB, const Texture& Placeholder )
+    {
+        return LoadFromFileAsync(MakeWStr(fileName), sRGB, Placeholder);
+    }
+
     const Texture& GetBlackTex2D(void);
     const Texture& GetWhiteTex2D(void);
+    const Texture& GetMagentaTex2D(void);
+    // (0,0,1)Ϊͼռλ
+    const Texture& GetFlatNormalTex2D(void);
+    // 1x1 ĺɫͼΪͼռλ
+    const Texture& GetBlackTexCube(void);
 }
@@ -0,0 +1,589 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "TextureManager.h"
+#include "DDSTextureLoader.h"
+#include "FileUtility.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "DynamicDescriptorHeap.h"
+#include "ResourceStateTracker.h"
+#include "JobSystem.h"
+#include "SystemTime.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
+
+using namespace Graphics;
+using namespace std;
+using Microsoft::WRL::ComPtr;
+
+enum TextureStreamState { kStreamReading, kStreamDecoded, kStreamSubmitted, kStreamFailed };
+
+struct TextureStreamRequest
+{
+    ManagedTexture* Texture;
+    wstring FilePath;                           // չ
+    wstring FileName;                           // ʵʶļ
+    bool sRGB;
+    bool IsDDS;
+    TextureStreamState State;
+
+    // ¼ͷ
+    Utility::ByteArray FileData;                // DDS Դָ
+    vector<uint32_t> Pixels;                    // TGA 
+    vector<D3D12_SUBRESOURCE_DATA> Subresources;
+
+    ComPtr<ID3D12Resource> Resource;
+    D3D12_CPU_DESCRIPTOR_HANDLE StagingSRV;     // ʱʱԼSRV
+    uint64_t UploadBytes;
+    uint64_t FenceValue;
+};
+
+namespace
+{
+    typedef shared_ptr<TextureStreamRequest> RequestPtr;
+
+    // һбϴݣʱɶ
+    const uint64_t kMaxBatchBytes = 64 * 1024 * 1024;
+
+    struct UploadBatch
+    {
+        ComPtr<ID3D12Resource> UploadBuffer;    // ɺͷ
+        uint64_t FenceValue;
+        vector<RequestPtr> Requests;
+    };
+
+    mutex s_Mutex;                              // ״̬
+    condition_variable s_UploadEvent;           // дϴҪ˳ϴ߳
+    condition_variable s_ProgressEvent;         // ύʧܻϴ߳̿Уѵȴ
+    thread s_UploadThread;
+    bool s_UploadThreadRunning = false;
+    bool s_StopRequested = false;
+    bool s_Uploading = false;                   // ϴ߳ûύ
+    uint32_t s_Reading = 0;                     // ȡе
+    vector<RequestPtr> s_Decoded;               // ȴϴ
+    vector<RequestPtr> s_Failed;                // ȴ
+    deque<UploadBatch> s_Batches;               // ύΧ˳
+    map<const ManagedTexture*, RequestPtr> s_Pending;   // û
+
+    // ϴ̶߳ռ
+    ID3D12GraphicsCommandList* s_CommandList = nullptr;
+
+    // ֻ߳Ϸ: ̬ʼִ߳Уÿ֡ Update Ҳ
+    const thread::id s_PublishThread = this_thread::get_id();
+
+    // ӵһȫͳƣȫʱӡ
+    bool s_PrintSummary = true;
+    int64_t s_FirstRequestTick = 0;
+    uint32_t s_RequestCount = 0;
+    uint32_t s_FailedCount = 0;
+    uint32_t s_BatchCount = 0;
+    uint64_t s_UploadedBytes = 0;
+
+    bool DecodeDDS( TextureStreamRequest& Request )
+    {
+        Request.StagingSRV = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        HRESULT hr = CreateDDSTextureFromMemoryDeferred(g_Device, Request.FileData->data(), Request.FileData->size(), 0,
+            Request.sRGB, Request.Resource.ReleaseAndGetAddressOf(), Request.StagingSRV, Request.Subresources);
+
+        return SUCCEEDED(hr);
+    }
+
+    bool DecodeTGA( TextureStreamRequest& Request )
+    {
+        uint32_t Width, Height;
+        if (!Texture::DecodeTGA(Request.FileData->data(), Request.FileData->size(), Request.Pixels, Width, Height) ||
+            Width == 0 || Height == 0)
+            return false;
+
+        // Ѿ
+        Request.FileData.reset();
+
+        D3D12_RESOURCE_DESC TexDesc = {};
+        TexDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        TexDesc.Width = Width;
+        TexDesc.Height = Height;
+        TexDesc.DepthOrArraySize = 1;
+        TexDesc.MipLevels = 1;
+        TexDesc.Format = Request.sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        TexDesc.SampleDesc.Count = 1;
+        TexDesc.SampleDesc.Quality = 0;
+        TexDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        TexDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+        D3D12_HEAP_PROPERTIES HeapProps;
+        HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        HeapProps.CreationNodeMask = 1;
+        HeapProps.VisibleNodeMask = 1;
+
+        if (FAILED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &TexDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(Request.Resource.ReleaseAndGetAddressOf()))))
+            return false;
+
+        Request.StagingSRV = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        g_Device->CreateShaderResourceView(Request.Resource.Get(), nullptr, Request.StagingSRV);
+
+        D3D12_SUBRESOURCE_DATA Subresource;
+        Subresource.pData = Request.Pixels.data();
+        Subresource.RowPitch = Width * sizeof(uint32_t);
+        Subresource.SlicePitch = Subresource.RowPitch * Height;
+        Request.Subresources.assign(1, Subresource);
+
+        return true;
+    }
+
+    // ߳ϽļԴϴ̻߳ߵŷ
+    void Decode( const RequestPtr& Request )
+    {
+        bool Succeeded = Request->FileData->size() > 0 && (Request->IsDDS ? DecodeDDS(*Request) : DecodeTGA(*Request));
+
+        if (Succeeded)
+        {
+            Request->UploadBytes = GetRequiredIntermediateSize(Request->Resource.Get(), 0, (UINT)Request->Subresources.size());
+        }
+        else
+        {
+            Request->Resource = nullptr;
+            Request->FileData.reset();
+            Request->Pixels.clear();
+            Request->Subresources.clear();
+        }
+
+        {
+            lock_guard<mutex> Lock(s_Mutex);
+            --s_Reading;
+            if (Succeeded)
+            {
+                Request->State = kStreamDecoded;
+                s_Decoded.push_back(Request);
+                s_UploadEvent.notify_one();
+            }
+            else
+            {
+                Request->State = kStreamFailed;
+                s_Failed.push_back(Request);
+            }
+        }
+        s_ProgressEvent.notify_all();
+    }
+
+    ComPtr<ID3D12Resource> CreateUploadBuffer( uint64_t Size )
+    {
+        D3D12_HEAP_PROPERTIES HeapProps;
+        HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+        HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        HeapProps.CreationNodeMask = 1;
+        HeapProps.VisibleNodeMask = 1;
+
+        D3D12_RESOURCE_DESC ResourceDesc;
+        ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        ResourceDesc.Alignment = 0;
+        ResourceDesc.Width = Size;
+        ResourceDesc.Height = 1;
+        ResourceDesc.DepthOrArraySize = 1;
+        ResourceDesc.MipLevels = 1;
+        ResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+        ResourceDesc.SampleDesc.Count = 1;
+        ResourceDesc.SampleDesc.Quality = 0;
+        ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        ResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+        ComPtr<ID3D12Resource> Buffer;
+        ASSERT_SUCCEEDED( g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE,
+            &ResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, MY_IID_PPV_ARGS(Buffer.GetAddressOf())) );
+        Buffer->SetName(L"Texture Streaming Upload");
+        return Buffer;
+    }
+
+    void PrintSummary( void )
+    {
+        Utility::Printf("Texture streaming: %u textures (%u failed)  %.2f MB in %u copy batches  %.1f ms from first request to last publish\n",
+            s_RequestCount, s_FailedCount, s_UploadedBytes / (1024.0 * 1024.0), s_BatchCount,
+            SystemTime::TimeBetweenTicks(s_FirstRequestTick, SystemTime::GetCurrentTick()) * 1000.0);
+    }
+}
+
+void TextureStreamer::Request( ManagedTexture& Tex, const wstring& FilePath, bool sRGB, const Texture& Placeholder )
+{
+    // ھͽߣռλ
+    Tex.m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    g_Device->CopyDescriptorsSimple(1, Tex.m_hCpuDescriptorHandle, Placeholder.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    Tex.m_IsStreaming = true;
+
+    RequestPtr Request = make_shared<TextureStreamRequest>();
+    Request->Texture = &Tex;
+    Request->FilePath = FilePath;
+    Request->sRGB = sRGB;
+    Request->IsDDS = false;
+    Request->State = kStreamReading;
+    Request->StagingSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+    Request->UploadBytes = 0;
+    Request->FenceValue = 0;
+
+    {
+        lock_guard<mutex> Lock(s_Mutex);
+
+        if (!s_UploadThreadRunning)
+        {
+            s_StopRequested = false;
+            s_UploadThread = thread(UploadThreadMain);
+            s_UploadThreadRunning = true;
+        }
+
+        if (s_Pending.empty())
+        {
+            s_FirstRequestTick = SystemTime::GetCurrentTick();
+            s_RequestCount = 0;
+            s_FailedCount = 0;
+            s_BatchCount = 0;
+            s_UploadedBytes = 0;
+        }
+
+        ++s_RequestCount;
+        ++s_Reading;
+        s_Pending[&Tex] = Request;
+    }
+
+    //  LoadFromFile һ .dds  .tgaѾڹ߳ϣ.tga ֱͬȡ
+    // ûй߳ʱ Async  Then ڵִ߳
+    Utility::ReadFileAsync(FilePath + L".dds").Then([Request](const Utility::ByteArray& Data)
+    {
+        if (Data->size() > 0)
+        {
+            Request->FileName = Request->FilePath + L".dds";
+            Request->IsDDS = true;
+            Request->FileData = Data;
+        }
+        else
+        {
+            Request->FileName = Request->FilePath + L".tga";
+            Request->FileData = Utility::ReadFileSync(Request->FileName);
+        }
+
+        Decode(Request);
+    });
+}
+
+void TextureStreamer::UploadThreadMain( void )
+{
+    for (;;)
+    {
+        vector<RequestPtr> Requests;
+        uint64_t BufferSize = 0;
+        {
+            unique_lock<mutex> Lock(s_Mutex);
+            s_UploadEvent.wait(Lock, []() { return !s_Decoded.empty() || s_StopRequested; });
+            if (s_Decoded.empty())
+                break;
+
+            // һ¼ڼµĶϣһ
+            size_t Count = 0;
+            for (; Count < s_Decoded.size(); ++Count)
+            {
+                uint64_t Bytes = Math::AlignUp(s_Decoded[Count]->UploadBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+                if (Count > 0 && BufferSize + Bytes > kMaxBatchBytes)
+                    break;
+                BufferSize += Bytes;
+            }
+
+            Requests.assign(s_Decoded.begin(), s_Decoded.begin() + Count);
+            s_Decoded.erase(s_Decoded.begin(), s_Decoded.begin() + Count);
+            s_Uploading = true;
+        }
+
+        UploadBatch Batch;
+        Batch.UploadBuffer = CreateUploadBuffer(BufferSize);
+        Batch.FenceValue = RecordUploads(Requests, Batch.UploadBuffer.Get());
+        Batch.Requests = Requests;
+
+        {
+            lock_guard<mutex> Lock(s_Mutex);
+            for (auto& Request : Requests)
+            {
+                Request->FenceValue = Batch.FenceValue;
+                Request->State = kStreamSubmitted;
+            }
+            s_UploadedBytes += BufferSize;
+            ++s_BatchCount;
+            s_Batches.push_back(std::move(Batch));
+            s_Uploading = false;
+        }
+        s_ProgressEvent.notify_all();
+    }
+}
+
+uint64_t TextureStreamer::RecordUploads( const vector<RequestPtr>& Requests, ID3D12Resource* UploadBuffer )
+{
+    CommandQueue& CopyQueue = g_CommandManager.GetCopyQueue();
+
+    ID3D12CommandAllocator* Allocator = nullptr;
+    if (s_CommandList == nullptr)
+    {
+        g_CommandManager.CreateNewCommandList(D3D12_COMMAND_LIST_TYPE_COPY, &s_CommandList, &Allocator);
+        s_CommandList->SetName(L"Texture Streaming");
+    }
+    else
+    {
+        Allocator = CopyQueue.RequestAllocator();
+        s_CommandList->Reset(Allocator, nullptr);
+    }
+
+    uint64_t Offset = 0;
+    for (auto& Request : Requests)
+    {
+        UpdateSubresources(s_CommandList, Request->Resource.Get(), UploadBuffer, Offset,
+            0, (UINT)Request->Subresources.size(), Request->Subresources.data());
+        Offset += Math::AlignUp(Request->UploadBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        // Ѿдϴ
+        Request->FileData.reset();
+        vector<uint32_t>().swap(Request->Pixels);
+        Request->Subresources.clear();
+    }
+
+    uint64_t FenceValue = CopyQueue.ExecuteCommandList(s_CommandList);
+    CopyQueue.DiscardAllocator(FenceValue, Allocator);
+    return FenceValue;
+}
+
+void TextureStreamer::Publish( TextureStreamRequest& Request )
+{
+    ManagedTexture& Tex = *Request.Texture;
+
+    if (Request.State == kStreamFailed)
+    {
+        Tex.SetToInvalidTexture();
+    }
+    else
+    {
+        // ùԴ ExecuteCommandLists ˻Ϊ COMMONֱӶжȡʱʽ
+        // Դȫ״̬ύʱ״̬дһύ
+        {
+            lock_guard<mutex> Lock(ResourceStateTracker::GetSubmissionMutex());
+            Tex.m_pResource = Request.Resource;
+            Tex.m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+            Tex.m_SubresourceStates.clear();
+        }
+        Tex.m_pResource->SetName(Request.FileName.c_str());
+        g_Device->CopyDescriptorsSimple(1, Tex.m_hCpuDescriptorHandle, Request.StagingSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+
+    if (Request.StagingSRV.ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, Request.StagingSRV);
+    Request.Resource = nullptr;
+
+    Tex.MarkLoaded();
+}
+
+void TextureStreamer::Update( void )
+{
+    ASSERT(this_thread::get_id() == s_PublishThread, "TextureStreamer::Update must be called on the main thread");
+
+    vector<RequestPtr> Ready;
+    {
+        lock_guard<mutex> Lock(s_Mutex);
+        if (s_Pending.empty())
+            return;
+
+        while (!s_Batches.empty() && g_CommandManager.IsFenceComplete(s_Batches.front().FenceValue))
+        {
+            Ready.insert(Ready.end(), s_Batches.front().Requests.begin(), s_Batches.front().Requests.end());
+            s_Batches.pop_front();
+        }
+
+        Ready.insert(Ready.end(), s_Failed.begin(), s_Failed.end());
+        s_Failed.clear();
+    }
+
+    if (Ready.empty())
+        return;
+
+    // Ҫﴴ
+    for (auto& Request : Ready)
+        Publish(*Request);
+
+    // SRV ԭλд֮ǰﻹռλ
+    DynamicDescriptorHeap::InvalidateTableCaches();
+
+    bool Finished;
+    {
+        lock_guard<mutex> Lock(s_Mutex);
+        for (auto& Request : Ready)
+        {
+            if (Request->State == kStreamFailed)
+                ++s_FailedCount;
+            s_Pending.erase(Request->Texture);
+        }
+        Finished = s_Pending.empty();
+    }
+    s_ProgressEvent.notify_all();
+
+    if (Finished && s_PrintSummary)
+        PrintSummary();
+}
+
+void TextureStreamer::WaitFor( const ManagedTexture& Tex )
+{
+    uint64_t FenceValue = 0;
+    {
+        unique_lock<mutex> Lock(s_Mutex);
+        auto Iter = s_Pending.find(&Tex);
+        if (Iter == s_Pending.end())
+            return;
+
+        RequestPtr Request = Iter->second;
+        s_ProgressEvent.wait(Lock, [&Request]() { return Request->State == kStreamSubmitted || Request->State == kStreamFailed; });
+        FenceValue = Request->FenceValue;
+    }
+
+    // а˳ɣȵΧʱǰҲ
+    if (FenceValue != 0)
+        g_CommandManager.WaitForFence(FenceValue);
+
+    // ̲߳ɵߵ߳һ Update  MarkLoaded
+    if (this_thread::get_id() == s_PublishThread)
+        Update();
+}
+
+void TextureStreamer::WaitForAll( void )
+{
+    if (this_thread::get_id() != s_PublishThread)
+    {
+        unique_lock<mutex> Lock(s_Mutex);
+        s_ProgressEvent.wait(Lock, []() { return s_Pending.empty(); });
+        return;
+    }
+
+    uint64_t FenceValue = 0;
+    {
+        unique_lock<mutex> Lock(s_Mutex);
+        s_ProgressEvent.wait(Lock, []() { return s_Reading == 0 && s_Decoded.empty() && !s_Uploading; });
+        if (!s_Batches.empty())
+            FenceValue = s_Batches.back().FenceValue;
+    }
+
+    if (FenceValue != 0)
+        g_CommandManager.WaitForFence(FenceValue);
+
+    Update();
+}
+
+uint32_t TextureStreamer::GetPendingCount( void )
+{
+    lock_guard<mutex> Lock(s_Mutex);
+    return (uint32_t)s_Pending.size();
+}
+
+void TextureStreamer::Shutdown( void )
+{
+    if (!s_UploadThreadRunning)
+        return;
+
+    WaitForAll();
+
+    {
+        lock_guard<mutex> Lock(s_Mutex);
+        s_StopRequested = true;
+    }
+    s_UploadEvent.notify_all();
+    s_UploadThread.join();
+    s_UploadThreadRunning = false;
+
+    if (s_CommandList != nullptr)
+    {
+        s_CommandList->Release();
+        s_CommandList = nullptr;
+    }
+}
+
+void TextureStreamer::Benchmark( void )
+{
+    if (!Graphics::Initialize(true))
+        return;
+
+    SystemTime::Initialize();
+    JobSystem::Initialize();
+
+    //  GameApp::buildMaterials صһ
+    struct TextureDesc
+    {
+        const wchar_t* Name;
+        bool sRGB;
+        const Texture& (*Placeholder)(void);
+    };
+    const TextureDesc kTextures[] =
+    {
+        { L"bricks2", true, TextureManager::GetWhiteTex2D },
+        { L"bricks2_nmap", false, TextureManager::GetFlatNormalTex2D },
+        { L"tile", true, TextureManager::GetWhiteTex2D },
+        { L"tile_nmap", false, TextureManager::GetFlatNormalTex2D },
+        { L"white1x1", true, TextureManager::GetWhiteTex2D },
+        { L"default_nmap", false, TextureManager::GetFlatNormalTex2D },
+        { L"snowcube1024", true, TextureManager::GetBlackTexCube },
+    };
+    const uint32_t kTextureCount = _countof(kTextures);
+    const uint32_t kRuns = 8;
+
+    s_PrintSummary = false;
+
+    double SyncTime = 0.0, AsyncReturnTime = 0.0, AsyncLoadTime = 0.0;
+    uint32_t Valid = 0;
+    for (uint32_t Run = 0; Run < kRuns; ++Run)
+    {
+        // ռλڼʱ֮ⴴַʽջ¶ļ
+        TextureManager::Initialize(L"Textures/");
+        TextureManager::GetMagentaTex2D();
+        for (const TextureDesc& Desc : kTextures)
+            Desc.Placeholder();
+
+        int64_t Start = SystemTime::GetCurrentTick();
+        for (const TextureDesc& Desc : kTextures)
+            TextureManager::LoadFromFile(Desc.Name, Desc.sRGB);
+        SyncTime += SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick());
+        TextureManager::Shutdown();
+
+        TextureManager::Initialize(L"Textures/");
+        TextureManager::GetMagentaTex2D();
+        for (const TextureDesc& Desc : kTextures)
+            Desc.Placeholder();
+
+        vector<const ManagedTexture*> Textures;
+        Start = SystemTime::GetCurrentTick();
+        for (const TextureDesc& Desc : kTextures)
+            Textures.push_back(TextureManager::LoadFromFileAsync(Desc.Name, Desc.sRGB, Desc.Placeholder()));
+        int64_t Returned = SystemTime::GetCurrentTick();
+
+        // ൱߳ÿ֡һ Update
+        while (GetPendingCount() > 0)
+        {
+            Update();
+            this_thread::yield();
+        }
+        int64_t Loaded = SystemTime::GetCurrentTick();
+
+        AsyncReturnTime += SystemTime::TimeBetweenTicks(Start, Returned);
+        AsyncLoadTime += SystemTime::TimeBetweenTicks(Start, Loaded);
+
+        Valid = 0;
+        for (const ManagedTexture* Tex : Textures)
+            Valid += Tex->IsValid() ? 1 : 0;
+
+        TextureManager::Shutdown();
+    }
+
+    s_PrintSummary = true;
+
+    Utility::Printf("Texture loading: %u textures from Textures/ (%u found), average of %u runs, %u workers\n",
+        kTextureCount, Valid, kRuns, JobSystem::GetWorkerCount());
+    Utility::Printf("  LoadFromFile:      %8.3f ms blocking before the first frame\n", SyncTime * 1000.0 / kRuns);
+    Utility::Printf("  LoadFromFileAsync: %8.3f ms blocking before the first frame  %8.3f ms until all textures are published\n",
+        AsyncReturnTime * 1000.0 / kRuns, AsyncLoadTime * 1000.0 / kRuns);
+
+    Graphics::Shutdown();
+    JobSystem::Shutdown();
+}
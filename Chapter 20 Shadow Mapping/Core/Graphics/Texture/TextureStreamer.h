@@ -0,0 +1,52 @@
+/*
+	ʽأTextureManager::LoadFromFileAsync ĺ
+	- ʱԼSRVռλSRVõľӴ˲
+	- ļ: Utility::ReadFileAsync JobSystem Ĺ߳ϣ.dds ʱٶ .tga
+	- :  JobSystem ĺнDDS/TGA COPY_DEST ԴݴSRVûй߳ʱڵ߳
+	- ϴ: һϴ̰߳µĽϽһбһϴѣ g_CommandManager.GetCopyQueue() ύ
+	- : ֻ߳ϣUpdate ÿ֡ãΧɵݴSRVԼSRVԴڿ˻Ϊ COMMON
+	  ֱӶжȡʱʽҪϡԭλдSRVҪ DynamicDescriptorHeap ʧЧ
+	- ʧܵڷʱSRVĳ
+*/
+
+#pragma once
+
+#include "pch.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class Texture;
+class ManagedTexture;
+struct TextureStreamRequest;
+
+class TextureStreamer
+{
+public:
+    //  TextureManager::LoadFromFileAsync ãFilePath Ŀ¼չ
+    static void Request( ManagedTexture& Tex, const std::wstring& FilePath, bool sRGB, const Texture& Placeholder );
+
+    // ߳ÿ֡ãɵ̷ֻ߳߳ϵ¼ƺύῴһԴ
+    static void Update( void );
+
+    // ϴ꣬ ManagedTexture::WaitForLoad á߳˳㷢ֻ߳ȵύ
+    static void WaitFor( const ManagedTexture& Tex );
+
+    // 󷢲꣬߳ϵʱ̵߳ Update 
+    static void WaitForAll( void );
+
+    // û
+    static uint32_t GetPendingCount( void );
+
+    // ͣϴ̣߳ JobSystem ر֮ǰ
+    static void Shutdown( void );
+
+    // 豸 Textures/ Ƚͬغʽ: ȫصʱ(൱֡ǰ)ȫõʱ
+    static void Benchmark( void );
+
+private:
+    // ⼸Ҫ ManagedTexture  CommandQueue ˽гԱ
+    static void UploadThreadMain( void );
+    static uint64_t RecordUploads( const std::vector<std::shared_ptr<TextureStreamRequest>>& Requests, ID3D12Resource* UploadBuffer );
+    static void Publish( TextureStreamRequest& Request );
+};
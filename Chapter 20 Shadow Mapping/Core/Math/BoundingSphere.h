@@ -14,6 +14,7 @@
 #pragma once
 
 #include "VectorMath.h"
+#include <vector>
 
 namespace Math
 {
@@ -57,4 +58,40 @@ namespace Math
         return m_repr.GetW();
     }
 
+    // һΧ򣬰ṹ(SoA)洢ĺͰ뾶SSEһδ4Χ
+    // 鳤Ȳ뵽4ı벿ְ뾶Ϊ0λԭ㣬÷ֻʹǰ Size() 
+    class BoundingSphereSoA
+    {
+    public:
+        static const size_t kAlignment = 4;
+
+        void Resize( size_t count )
+        {
+            m_Count = count;
+            size_t padded = (count + kAlignment - 1) & ~(kAlignment - 1);
+            for (int i = 0; i < 4; ++i)
+                m_Sphere[i].assign(padded, 0.0f);
+        }
+
+        void Set( size_t index, const BoundingSphere& sphere )
+        {
+            Vector3 center = sphere.GetCenter();
+            m_Sphere[0][index] = center.GetX();
+            m_Sphere[1][index] = center.GetY();
+            m_Sphere[2][index] = center.GetZ();
+            m_Sphere[3][index] = sphere.GetRadius();
+        }
+
+        size_t Size( void ) const { return m_Count; }
+        size_t PaddedSize( void ) const { return m_Sphere[0].size(); }
+        const float* CenterX( void ) const { return m_Sphere[0].data(); }
+        const float* CenterY( void ) const { return m_Sphere[1].data(); }
+        const float* CenterZ( void ) const { return m_Sphere[2].data(); }
+        const float* Radius( void ) const { return m_Sphere[3].data(); }
+
+    private:
+        size_t m_Count = 0;
+        std::vector<float> m_Sphere[4];
+    };
+
 } // namespace Math
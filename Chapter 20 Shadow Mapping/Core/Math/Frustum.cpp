@@ -14,6 +14,7 @@
 #include "pch.h"
 #include "Frustum.h"
 #include "Camera.h"
+#include <intrin.h>
 
 using namespace Math;
 
@@ -51,24 +52,24 @@ void Frustum::ConstructPerspectiveFrustum( float HTan, float VTan, float NearCli
 
 void Frustum::ConstructOrthographicFrustum( float Left, float Right, float Top, float Bottom, float Front, float Back )
 {
-    // TODO ޸Ϊϵ
+    // ѸΪϵ+z
     // Define the frustum corners
-    m_FrustumCorners[ kNearLowerLeft  ] = Vector3(Left,   Bottom,    -Front);    // Near lower left
-    m_FrustumCorners[ kNearUpperLeft  ] = Vector3(Left,   Top,        -Front);    // Near upper left
-    m_FrustumCorners[ kNearLowerRight ] = Vector3(Right,  Bottom,    -Front);    // Near lower right
-    m_FrustumCorners[ kNearUpperRight ] = Vector3(Right,  Top,        -Front);    // Near upper right
-    m_FrustumCorners[ kFarLowerLeft   ] = Vector3(Left,   Bottom,     -Back);    // Far lower left
-    m_FrustumCorners[ kFarUpperLeft   ] = Vector3(Left,   Top,         -Back);    // Far upper left
-    m_FrustumCorners[ kFarLowerRight  ] = Vector3(Right,  Bottom,     -Back);    // Far lower right
-    m_FrustumCorners[ kFarUpperRight  ] = Vector3(Right,  Top,         -Back);    // Far upper right
-
-    // Define the bounding planes
-    m_FrustumPlanes[kNearPlane]        = BoundingPlane(  0.0f,  0.0f, -1.0f, -Front );
-    m_FrustumPlanes[kFarPlane]        = BoundingPlane(  0.0f,  0.0f,  1.0f,   Back );
+    m_FrustumCorners[ kNearLowerLeft  ] = Vector3(Left,   Bottom,    Front);    // Near lower left
+    m_FrustumCorners[ kNearUpperLeft  ] = Vector3(Left,   Top,       Front);    // Near upper left
+    m_FrustumCorners[ kNearLowerRight ] = Vector3(Right,  Bottom,    Front);    // Near lower right
+    m_FrustumCorners[ kNearUpperRight ] = Vector3(Right,  Top,       Front);    // Near upper right
+    m_FrustumCorners[ kFarLowerLeft   ] = Vector3(Left,   Bottom,     Back);    // Far lower left
+    m_FrustumCorners[ kFarUpperLeft   ] = Vector3(Left,   Top,        Back);    // Far upper left
+    m_FrustumCorners[ kFarLowerRight  ] = Vector3(Right,  Bottom,     Back);    // Far lower right
+    m_FrustumCorners[ kFarUpperRight  ] = Vector3(Right,  Top,        Back);    // Far upper right
+
+    // Define the bounding planesָ׶ڲ
+    m_FrustumPlanes[kNearPlane]        = BoundingPlane(  0.0f,  0.0f,  1.0f, -Front );
+    m_FrustumPlanes[kFarPlane]        = BoundingPlane(  0.0f,  0.0f, -1.0f,   Back );
     m_FrustumPlanes[kLeftPlane]        = BoundingPlane(  1.0f,  0.0f,  0.0f,  -Left );
     m_FrustumPlanes[kRightPlane]    = BoundingPlane( -1.0f,  0.0f,  0.0f,  Right );
-    m_FrustumPlanes[kTopPlane]        = BoundingPlane(  0.0f, -1.0f,  0.0f, Bottom );
-    m_FrustumPlanes[kBottomPlane]    = BoundingPlane(  0.0f,  1.0f,  0.0f,   -Top );
+    m_FrustumPlanes[kTopPlane]        = BoundingPlane(  0.0f, -1.0f,  0.0f,    Top );
+    m_FrustumPlanes[kBottomPlane]    = BoundingPlane(  0.0f,  1.0f,  0.0f, -Bottom );
 }
 
 
@@ -83,14 +84,16 @@ Frustum::Frustum(const Matrix4& ProjMat, float NearDivFar)
     // Identify if the projection is perspective or orthographic by looking at the 4th row.
     if (ProjMatF[3] == 0.0f && ProjMatF[7] == 0.0f && ProjMatF[11] == 0.0f && ProjMatF[15] == 1.0f)
     {
-        // TODO ޸Ϊϵ
         // Orthographic
+        // ͶӰzֱȡԾ󣬲Ҫ NearDivFar
+        const float RcpDepth = 1.0f / ProjMatF[10];
+
         float Left     = (-1.0f - ProjMatF[12]) * RcpXX;
         float Right     = ( 1.0f - ProjMatF[12]) * RcpXX;
         float Top     = ( 1.0f - ProjMatF[13]) * RcpYY;
         float Bottom = (-1.0f - ProjMatF[13]) * RcpYY;
-        float Front     = ( 0.0f - ProjMatF[14]) * RcpZZ;
-        float Back   = ( 1.0f - ProjMatF[14]) * RcpZZ;
+        float Front     = ( 0.0f - ProjMatF[14]) * RcpDepth;
+        float Back   = ( 1.0f - ProjMatF[14]) * RcpDepth;
 
         // Check for reverse Z here.  The bounding planes need to point into the frustum.
         if (Front < Back)
@@ -110,3 +113,49 @@ Frustum::Frustum(const Matrix4& ProjMat, float NearDivFar)
         ConstructPerspectiveFrustum( RcpXX, RcpYY, NearClip, FarClip );
     }
 }
+
+void Frustum::IntersectSpheres( const BoundingSphereSoA& spheres, uint32_t* masks, uint32_t bit ) const
+{
+    //  IntersectSphere ͬĵһľ + 뾶 < 0 ʱɼ
+    __m128 planeX[6], planeY[6], planeZ[6], planeD[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        Vector4 plane = m_FrustumPlanes[i];
+        planeX[i] = _mm_set1_ps(plane.GetX());
+        planeY[i] = _mm_set1_ps(plane.GetY());
+        planeZ[i] = _mm_set1_ps(plane.GetZ());
+        planeD[i] = _mm_set1_ps(plane.GetW());
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    const float* cx = spheres.CenterX();
+    const float* cy = spheres.CenterY();
+    const float* cz = spheres.CenterZ();
+    const float* cr = spheres.Radius();
+    const size_t count = spheres.Size();
+
+    for (size_t base = 0; base < count; base += BoundingSphereSoA::kAlignment)
+    {
+        __m128 centerX = _mm_loadu_ps(cx + base);
+        __m128 centerY = _mm_loadu_ps(cy + base);
+        __m128 centerZ = _mm_loadu_ps(cz + base);
+        __m128 radius = _mm_loadu_ps(cr + base);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < 6; ++i)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[i], centerX), _mm_mul_ps(planeY[i], centerY)),
+                _mm_add_ps(_mm_mul_ps(planeZ[i], centerZ), planeD[i]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+
+        // һг count Ĳֲд
+        uint32_t visible = (uint32_t)_mm_movemask_ps(inside);
+        size_t lanes = count - base < BoundingSphereSoA::kAlignment ? count - base : BoundingSphereSoA::kAlignment;
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            if (visible & (1u << lane))
+                masks[base + lane] |= bit;
+        }
+    }
+}
@@ -47,6 +47,10 @@ namespace Math
         // simple struct in the Model project.)
         bool IntersectBoundingBox(const Vector3 minBound, const Vector3 maxBound) const;
 
+        // һΧÿSSEͬʱ4Χ򣬽 IntersectSphere ͬ
+        // ɼΧӦ masks[i]  bitmasks Ҫ spheres.Size() Ԫ
+        void IntersectSpheres(const BoundingSphereSoA& spheres, uint32_t* masks, uint32_t bit) const;
+
         friend Frustum  operator* ( const OrthogonalTransform& xform, const Frustum& frustum );    // Fast
         friend Frustum  operator* ( const AffineTransform& xform, const Frustum& frustum );        // Slow
         friend Frustum  operator* ( const Matrix4& xform, const Frustum& frustum );                // Slowest (and most general)
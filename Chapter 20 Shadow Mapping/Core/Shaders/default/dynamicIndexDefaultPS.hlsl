@@ -45,49 +45,6 @@ SamplerState gsamLinearWrap  : register(s0);
 SamplerState gsamAnisotropicWrap  : register(s1);
 SamplerComparisonState gsamShadow  : register(s2);
 
-float CalcShadowFactor(float4 shadowPosH)
-{
-    // Complete projection by doing division by w.
-    shadowPosH.xyz /= shadowPosH.w;
-
-    // Depth in NDC space.
-    float depth = shadowPosH.z;
-
-    uint width, height, numMips;
-    gShadowMap.GetDimensions(0, width, height, numMips);
-
-    // Texel size.
-    float dx = 1.0f / (float)width;
-
-    float percentLit = 0.0f;
-    const float2 offsets[9] =
-    {
-        float2(-dx,  -dx), float2(0.0f,  -dx), float2(dx,  -dx),
-        float2(-dx, 0.0f), float2(0.0f, 0.0f), float2(dx, 0.0f),
-        float2(-dx,  +dx), float2(0.0f,  +dx), float2(dx,  +dx)
-    };
-
-    [unroll]
-    for (int i = 0; i < 9; ++i)
-    {
-        percentLit += gShadowMap.SampleCmpLevelZero(gsamShadow,
-            shadowPosH.xy + offsets[i], depth).r;
-    }
-
-    return percentLit / 9.0f;
-}
-
-cbuffer VSConstants : register(b0)
-{
-    float4x4 modelToWorld;
-    float4x4 gTexTransform;
-    float4x4 gMatTransform;
-    uint gMaterialIndex;
-    uint vPad0;   // ռλ
-    uint vPad1;   // ռλ
-    uint vPad2;   // ռλ
-};
-
 // Constant data that varies per frame.
 cbuffer cbPass : register(b1)
 {
@@ -109,22 +66,73 @@ cbuffer cbPass : register(b1)
     // indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
     // are spot lights for a maximum of MaxLights per object.
     Light gLights[MaxLights];
+
+    // Ӱ: תӰͼ꣬Լͼе(xy)ƫ(zw)
+    float4x4 gCascadeShadow[4];
+    float4 gCascadeAtlas[4];
+    uint gCascadeCount;
+    uint3 pad3;
 };
 
+float CalcShadowFactor(float3 posW)
+{
+    uint width, height, numMips;
+    gShadowMap.GetDimensions(0, width, height, numMips);
+
+    // Texel size.
+    float dx = 1.0f / (float)width;
+
+    // ˳ҵһסõļPCFΧͼ߽
+    for (uint c = 0; c < gCascadeCount; ++c)
+    {
+        float3 shadowPos = mul(float4(posW, 1.0f), gCascadeShadow[c]).xyz;
+        float margin = 2.0f * dx / gCascadeAtlas[c].x;
+        if (any(shadowPos.xy < margin) || any(shadowPos.xy > 1.0f - margin) ||
+            shadowPos.z < 0.0f || shadowPos.z > 1.0f)
+            continue;
+
+        float2 uv = shadowPos.xy * gCascadeAtlas[c].xy + gCascadeAtlas[c].zw;
+
+        // Depth in NDC space.
+        float depth = shadowPos.z;
+
+        float percentLit = 0.0f;
+        const float2 offsets[9] =
+        {
+            float2(-dx,  -dx), float2(0.0f,  -dx), float2(dx,  -dx),
+            float2(-dx, 0.0f), float2(0.0f, 0.0f), float2(dx, 0.0f),
+            float2(-dx,  +dx), float2(0.0f,  +dx), float2(dx,  +dx)
+        };
+
+        [unroll]
+        for (int i = 0; i < 9; ++i)
+        {
+            percentLit += gShadowMap.SampleCmpLevelZero(gsamShadow,
+                uv + offsets[i], depth).r;
+        }
+
+        return percentLit / 9.0f;
+    }
+
+    // мûӰ
+    return 1.0f;
+}
+
 struct VertexOut
 {
     float4 PosH    : SV_POSITION;
-    float4 ShadowPosH : POSITION0;
-    float3 PosW    : POSITION1;
+    float3 PosW    : POSITION;
     float3 NormalW : NORMAL;
     float3 TangentW : TANGENT; // ߵ
     float2 TexC    : TEXCOORD;
+
+    nointerpolation uint MatIndex : MATINDEX;
 };
 
 float4 main(VertexOut pin) : SV_Target0
 {
     // ȡĲ
-    MaterialData matData = gMaterialData[gMaterialIndex];
+    MaterialData matData = gMaterialData[pin.MatIndex];
     float4 diffuseAlbedo = matData.DiffuseAlbedo;
     float3 fresnelR0 = matData.FresnelR0;
     float  roughness = matData.Roughness;
@@ -158,7 +166,7 @@ float4 main(VertexOut pin) : SV_Target0
     float4 ambient = gAmbientLight * diffuseAlbedo;
 
     float3 shadowFactor = float3(1.0f, 1.0f, 1.0f);
-    shadowFactor[0] = CalcShadowFactor(pin.ShadowPosH);
+    shadowFactor[0] = CalcShadowFactor(pin.PosW);
 
     const float shininess = (1.0f - roughness) * normalMapSample.a;
     Material mat = { diffuseAlbedo, fresnelR0, shininess };
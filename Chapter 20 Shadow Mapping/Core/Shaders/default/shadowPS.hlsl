@@ -22,27 +22,18 @@ Texture2D gTextureMaps[7] : register(t1);
 
 SamplerState gsamAnisotropicWrap  : register(s1);
 
-cbuffer VSConstants : register(b0)
-{
-    float4x4 modelToWorld;
-    float4x4 gTexTransform;
-    float4x4 gMatTransform;
-    uint gMaterialIndex;
-    uint vPad0;   // ռλ
-    uint vPad1;   // ռλ
-    uint vPad2;   // ռλ
-};
-
 struct VertexOut
 {
     float4 PosH    : SV_POSITION;
     float2 TexC    : TEXCOORD;
+
+    nointerpolation uint MatIndex : MATINDEX;
 };
 
 void main(VertexOut pin)
 {
     // ȡĲ
-    MaterialData matData = gMaterialData[gMaterialIndex];
+    MaterialData matData = gMaterialData[pin.MatIndex];
     float4 diffuseAlbedo = matData.DiffuseAlbedo;
     uint diffuseTexIndex = matData.DiffuseMapIndex;
 
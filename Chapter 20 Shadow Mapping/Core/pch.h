@@ -43,9 +43,11 @@
 #include <memory>
 #include <string>
 #include <exception>
+#include <atomic>
+#include <functional>
+#include <mutex>
 
 #include <wrl.h>
-#include <ppltasks.h>
 
 #include "Utility.h"
 #include "VectorMath.h"
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "CubeMapCache.h"
+#include "SystemTime.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+void CubeMapCache::Invalidate(void)
+{
+    m_valid = 0;
+    m_dirty = kAllFaces;
+    m_staticDirty = kAllFaces;
+}
+
+uint32_t CubeMapCache::facesOf(const Math::BoundingSphere& bounds, const Math::Camera (&cameras)[kFaceCount]) const
+{
+    uint32_t faces = 0;
+    for (int i = 0; i < kFaceCount; ++i)
+    {
+        if (cameras[i].GetWorldSpaceFrustum().IntersectSphere(bounds))
+            faces |= 1u << i;
+    }
+    return faces;
+}
+
+void CubeMapCache::TrackMovement(const std::vector<RenderItem*>& items, const Math::Camera (&cameras)[kFaceCount])
+{
+    for (RenderItem* item : items)
+    {
+        if (memcmp(&item->modeToWorld, &item->lastModeToWorld, sizeof(Math::Matrix4)) == 0)
+            continue;
+
+        // λҪλҪ
+        uint32_t oldFaces = facesOf(TransformBounds(item->lastModeToWorld, item->Bounds), cameras);
+        uint32_t newFaces = facesOf(TransformBounds(item->modeToWorld, item->Bounds), cameras);
+        m_dirty |= oldFaces | newFaces;
+
+        // һƶ֮ǰ˾̬棬Ӱӿκһ
+        if (!item->Dynamic)
+        {
+            item->Dynamic = true;
+            m_staticDirty = kAllFaces;
+        }
+
+        item->lastModeToWorld = item->modeToWorld;
+    }
+}
+
+void CubeMapCache::TrackLighting(float lightAngle, float tolerance)
+{
+    m_lightAngle = lightAngle;
+    for (int i = 0; i < kFaceCount; ++i)
+    {
+        if (fabsf(lightAngle - m_faceLightAngle[i]) > tolerance)
+            m_staticDirty |= 1u << i;
+    }
+}
+
+void CubeMapCache::SelectFaces(int maxFaces)
+{
+    // ؽ̬Ҫػ̬
+    uint32_t pending = m_dirty | m_staticDirty;
+
+    m_selected = pending & ~m_valid;
+    int count = 0;
+    for (int i = 0; i < kFaceCount; ++i)
+    {
+        if (maxFaces > 0 && count >= maxFaces)
+            break;
+
+        int face = (m_nextFace + i) % kFaceCount;
+        if ((pending & m_valid) & (1u << face))
+        {
+            m_selected |= 1u << face;
+            m_nextFace = (face + 1) % kFaceCount;
+            ++count;
+        }
+    }
+
+    m_selectedStatic = m_selected & m_staticDirty;
+    for (int i = 0; i < kFaceCount; ++i)
+    {
+        if (m_selectedStatic & (1u << i))
+            m_faceLightAngle[i] = m_lightAngle;
+    }
+
+    m_valid |= m_selected;
+    m_dirty &= ~m_selected;
+    m_staticDirty &= ~m_selected;
+
+    auto bitCount = [](uint32_t mask) { int n = 0; for (; mask != 0; mask &= mask - 1) ++n; return n; };
+    ++m_stats[kFrames];
+    m_stats[kFacesUpdated] += bitCount(m_selected);
+    m_stats[kStaticRebuilds] += bitCount(m_selectedStatic);
+    m_stats[kFacesSkipped] += kFaceCount - bitCount(pending);
+    m_stats[kFacesDeferred] += bitCount(pending & ~m_selected);
+}
+
+void CubeMapCache::ResetStats(void)
+{
+    memset(m_stats, 0, sizeof(m_stats));
+}
+
+void CubeMapCache::PrintReport(void) const
+{
+    double frames = (double)std::max<uint64_t>(m_stats[kFrames], 1);
+    Utility::Printf("Cube map: %.2f faces updated/frame (%.2f static rebuilds)  %.2f skipped  %.2f deferred\n",
+        m_stats[kFacesUpdated] / frames, m_stats[kStaticRebuilds] / frames,
+        m_stats[kFacesSkipped] / frames, m_stats[kFacesDeferred] / frames);
+    // 豸ûGPUʱ䣬ʡĻ
+    Utility::Printf("  %.0f draws/frame (full redraw %.0f, %.1f%% saved)  recording %.3f ms/frame\n",
+        m_stats[kDrawsIssued] / frames, m_stats[kDrawsFull] / frames,
+        m_stats[kDrawsFull] ? 100.0 * (1.0 - (double)m_stats[kDrawsIssued] / m_stats[kDrawsFull]) : 0.0,
+        SystemTime::TicksToMillisecs((int64_t)m_stats[kRecordTicks]) / frames);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include "d3dUtil.h"
+#include "Camera.h"
+
+// ̬ͼǺͷ֡
+// - ÿ֡Ƚ modeToWorldƶ¾Χ6׶󽻣ཻΪ
+// - һƶΪ̬壬ٻ̬棬Ҳٸ̬ͶӰ涼Ҫؽ̬
+// - ̬(̬ + պ)ڹԴ仯ֵʱؽһʱȿ̬棬ٻ̬
+//   ̬ӰͼͼΪϣƶʹ̬ʧЧ
+// - ÿ֡ maxFaces 棬ϴͣµ濪ʼѡûֵ汣
+// - ûݵ(մ Invalidate ֮)ÿ֡
+class CubeMapCache
+{
+public:
+    static const int kFaceCount = 6;
+    static const uint32_t kAllFaces = (1u << kFaceCount) - 1;
+
+    enum Stat
+    {
+        kFrames,
+        kFacesUpdated,      // ػ(ؽ̬)
+        kStaticRebuilds,    // ؽ̬
+        kFacesSkipped,      // ûб仯ֱһ֡ݵ
+        kFacesDeferred,     // б仯ÿ֡˳ӵ
+        kDrawsIssued,       // ʵ¼Ƶͼ
+        kDrawsFull,         // ÿ֡ػ6ҪĻ
+        kRecordTicks,       // ¼ͼCPUʱ
+
+        kStatCount
+    };
+
+    CubeMapCache() { Invalidate(); ResetStats(); }
+
+    // ݺ;̬涼ʧЧͼı
+    void Invalidate(void);
+
+    //  items ƶ壬items ǻửͼ
+    void TrackMovement(const std::vector<RenderItem*>& items, const Math::Camera (&cameras)[kFaceCount]);
+
+    // Դĳ澲̬¼ķ tolerance()ʱؽ
+    void TrackLighting(float lightAngle, float tolerance);
+
+    // ѡ֡µ棬maxFaces <= 0 ʾƣ֮ Get*Faces ر֡Ľ
+    void SelectFaces(int maxFaces);
+
+    uint32_t GetFaces(void) const { return m_selected; }
+    // ֡Ҫؽ̬棬 GetFaces Ӽ
+    uint32_t GetStaticFaces(void) const { return m_selectedStatic; }
+
+    void AddStat(Stat s, uint64_t value) { m_stats[s] += value; }
+    void ResetStats(void);
+    void PrintReport(void) const;
+
+private:
+    uint32_t facesOf(const Math::BoundingSphere& bounds, const Math::Camera (&cameras)[kFaceCount]) const;
+
+    uint32_t m_valid;           // Ѿݵ
+    uint32_t m_dirty;           // Ҫػ̬
+    uint32_t m_staticDirty;     // Ҫؽ̬
+    uint32_t m_selected = 0;
+    uint32_t m_selectedStatic = 0;
+    int m_nextFace = 0;
+
+    float m_lightAngle = 0.0f;
+    float m_faceLightAngle[kFaceCount] = {};
+
+    uint64_t m_stats[kStatCount];
+};
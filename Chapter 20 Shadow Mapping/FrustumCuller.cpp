@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+#include "SystemTime.h"
+#include <algorithm>
+
+int FrustumCuller::AddFrustum(const Math::Frustum& frustum, const char* name)
+{
+    ASSERT(m_frustumCount < kMaxFrusta, "Too many frusta for one culling pass");
+
+    int index = m_frustumCount++;
+    m_frusta[index] = frustum;
+    m_names[index] = name;
+    m_namedCount = std::max(m_namedCount, m_frustumCount);
+    return index;
+}
+
+void FrustumCuller::Cull(const std::vector<std::unique_ptr<RenderItem>>& items)
+{
+    int64_t start = SystemTime::GetCurrentTick();
+
+    // ռΧ ObjIndex дSoA飬ÿһβ4Χ
+    m_bounds.Resize(items.size());
+    for (auto& item : items)
+        m_bounds.Set(item->ObjIndex, TransformBounds(item->modeToWorld, item->Bounds));
+
+    m_masks.assign(items.size(), 0);
+    for (int i = 0; i < m_frustumCount; ++i)
+        m_frusta[i].IntersectSpheres(m_bounds, m_masks.data(), 1u << i);
+
+    ++m_frames;
+    m_cullTicks += SystemTime::GetCurrentTick() - start;
+}
+
+void FrustumCuller::ResetStats(void)
+{
+    m_frames = 0;
+    m_cullTicks = 0;
+    std::fill(std::begin(m_tested), std::end(m_tested), 0);
+    std::fill(std::begin(m_culled), std::end(m_culled), 0);
+}
+
+void FrustumCuller::PrintReport(void) const
+{
+    if (m_frames == 0)
+        return;
+
+    double frames = (double)m_frames;
+    Utility::Printf("Frustum culling: %d frusta  %.3f ms/frame\n", m_namedCount,
+        SystemTime::TicksToMillisecs((int64_t)m_cullTicks) / frames);
+    for (int i = 0; i < m_namedCount; ++i)
+    {
+        Utility::Printf("  %-8s %8.0f tested/frame  %8.0f culled (%.1f%%)\n", m_names[i],
+            m_tested[i] / frames, m_culled[i] / frames,
+            m_tested[i] ? 100.0 * m_culled[i] / m_tested[i] : 0.0);
+    }
+}
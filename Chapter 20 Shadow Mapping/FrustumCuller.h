@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "d3dUtil.h"
+#include "Math/Frustum.h"
+
+// ׶޳pass
+// ÿ֡ AddFrustum pass׶壬Cull ֻһ: ÿΧֻһΣ
+// ΧSoAţÿ׶ÿһβ4Χ
+// ǰ ObjIndex 洢Ŀɼ룬 i λӦ i ׶
+// passȾʱ Test ˣͬʱͳÿ׶Ժ޳
+class FrustumCuller
+{
+public:
+    static const int kMaxFrusta = 32;
+
+    // һ֡׶壬ͳƱ
+    void BeginFrame(void) { m_frustumCount = 0; }
+
+    // ׶ţÿ֡ͬ˳ʱͳƲŶӦͬһpassname ҪǾַ̬
+    int AddFrustum(const Math::Frustum& frustum, const char* name);
+
+    void Cull(const std::vector<std::unique_ptr<RenderItem>>& items);
+
+    // frustum Ϊʾpass޳
+    bool Test(const RenderItem& item, int frustum)
+    {
+        if (frustum < 0)
+            return true;
+
+        bool visible = (m_masks[item.ObjIndex] & (1u << frustum)) != 0;
+        ++m_tested[frustum];
+        m_culled[frustum] += visible ? 0 : 1;
+        return visible;
+    }
+
+    void ResetStats(void);
+    void PrintReport(void) const;
+
+private:
+    Math::Frustum m_frusta[kMaxFrusta];
+    const char* m_names[kMaxFrusta] = {};
+    int m_frustumCount = 0;
+    int m_namedCount = 0;
+
+    Math::BoundingSphereSoA m_bounds;
+    std::vector<uint32_t> m_masks;
+
+    uint64_t m_frames = 0;
+    uint64_t m_cullTicks = 0;
+    uint64_t m_tested[kMaxFrusta] = {};
+    uint64_t m_culled[kMaxFrusta] = {};
+};
@@ -4,11 +4,18 @@
 #include "BufferManager.h"
 #include "CommandContext.h"
 #include "TextureManager.h"
+#include "TextureStreamer.h"
 #include "GameInput.h"
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <tuple>
 #include "GeometryGenerator.h"
+#include "MeshCache.h"
+#include "JobSystem.h"
+#include "SystemTime.h"
 #include <DirectXCollision.h>
 
 #include "CompiledShaders/dynamicIndexDefaultPS.h"
@@ -28,6 +35,11 @@ void GameApp::Startup(void)
     buildRenderItem();
     buildCubeCamera(0.0f, 2.0f, 0.0f);
 
+    // ӰͼͼУÿķֱ
+    // ͼ̬ӰͼּŸ m_CubeStaticShadow
+    Graphics::g_ShadowBuffer.SetCascadeCount(std::min(std::max(g_shadowCascadeCount, 1), (int)GameCore::CascadedShadowCamera::kMaxCascades));
+    Graphics::g_CubeStaticShadowBuffer.SetCascadeCount(1);
+
     m_Camera.SetEyeAtUp({ 0.0f, 5.0f, -10.0f }, { 0.0f, 0.0f, 0.0f }, Math::Vector3(Math::kYUnitVector));
     m_CameraController.reset(new GameCore::CameraController(m_Camera, Math::Vector3(Math::kYUnitVector)));
 }
@@ -84,127 +96,284 @@ void GameApp::Update(float deltaT)
         XMStoreFloat3(&mRotatedLightDirections[i], lightDir);
     }
 
-    m_CameraShadow.UpdateMatrix(mRotatedLightDirections[0], { 0.0f, 0.0f, 0.0f },
-        { 30, 30, 60 }, (uint32_t)Graphics::g_ShadowBuffer.GetWidth(), (uint32_t)Graphics::g_ShadowBuffer.GetHeight(), 16);
+    m_CameraShadow.UpdateMatrix(m_Camera, mRotatedLightDirections[0], Graphics::g_ShadowBuffer.GetCascadeCount(),
+        g_shadowCascadeLambda, g_shadowDistance, g_shadowCasterDistance, Graphics::g_ShadowBuffer.GetCascadeSize(), 16);
+
+    // ͼ̬ӰϣһӰͺػĽһ
+    float cubeShadowSize = 2.0f * g_shadowDistance;
+    uint32_t cubeShadowTexels = Graphics::g_CubeStaticShadowBuffer.GetCascadeSize();
+    m_CubeStaticShadow.UpdateMatrix(mRotatedLightDirections[0], m_CameraCube[0].GetPosition(),
+        Vector3(cubeShadowSize, cubeShadowSize, cubeShadowSize + 2.0f * g_shadowCasterDistance), cubeShadowTexels, cubeShadowTexels, 16);
 }
 
 void GameApp::RenderScene(void)
 {
     GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
 
-    // һЩͨõ
+    // ѡ֡Ҫػͼ棬ǷҪͼĶ
+    updateCubeMapCache();
+
+    // һα壬pass׶
+    cullRenderItems();
+
+    // ״̬岢ϲʵεظ״̬ᱻ GraphicsContext ˵
+    buildRenderQueues(gfxContext);
+
+    // ϴ֡ĳӰͼ6passʹһ
+    uploadObjectConstants(gfxContext);
+
+    // Դ״̬ɸķֱ١ύʱ˳passڲͬ߳˳¼
+
+    if (g_parallelRecording && JobSystem::GetWorkerCount() > 0)
+    {
+        recordPassesParallel(gfxContext);
+        return;
+    }
+
+    setCommonRootParameters(gfxContext);
+
+    // ȾӰͼ
+    DrawShadow(gfxContext);
+
+    // ̬պȾ => g_SceneCubeBuffer
+    DrawCubeMap(gfxContext);
+
+    DrawMainPass(gfxContext);
+
+    gfxContext.Finish();
+}
+
+void GameApp::recordPassesParallel(GraphicsContext& gfxContext)
+{
+    // Ӱͼpassһģ߳з䣬ಢ3
+    // ͼ6ͬһ¼ƣ֮乲þ̬ȵ״̬ת
+    // ûе״̬תģpass״ʹԴʱתӳٵύʱ׷ǰһĩβ
+    // gfxContext ǰ棬״ʹõԴ¼ʱѰȫ״̬תҪб
+    const int kPassCount = 3;
+    GraphicsContext* passes[kPassCount];
+    for (auto& pass : passes)
+    {
+        pass = &GraphicsContext::Begin();
+        pass->DeferStateResolution();
+    }
+
+    JobSystem::ParallelFor(0, kPassCount, 1, [&](int i)
+    {
+        GraphicsContext& context = *passes[i];
+        setCommonRootParameters(context);
+
+        if (i == 0)
+            DrawShadow(context);
+        else if (i == 1)
+            DrawCubeMap(context);
+        else
+            DrawMainPass(context);
+    });
+
+    //  ϴ(gfxContext) -> Ӱ -> ͼ -> pass ˳һύ
+    CommandContext* batch[kPassCount + 1] = { &gfxContext };
+    for (int i = 0; i < kPassCount; ++i)
+        batch[i + 1] = passes[i];
+    CommandContext::FinishBatch(batch, kPassCount + 1);
+}
+
+void GameApp::setCommonRootParameters(GraphicsContext& gfxContext)
+{
     // øǩ
     gfxContext.SetRootSignature(m_RootSignature);
 
     // ȫ
     gfxContext.SetBufferSRV(2, m_mats);
 
+    // ֡峣ʵ
+    gfxContext.SetShaderResourceView(5, m_ObjectConstantsGpu);
+    gfxContext.SetShaderResourceView(6, m_InstanceTableGpu);
+
     // ȫԴ
     gfxContext.SetDynamicDescriptors(3, 0, 7, &m_srvs[0]);
-    
-    // ȾӰͼ
-    DrawShadow(gfxContext);
-
-    // Ӱ
-    gfxContext.SetDynamicDescriptors(4, 0, 1, &Graphics::g_ShadowBuffer.GetSRV());
-
-    // ̬պȾ => g_SceneCubeBuffer
-    DrawSceneToCubeMap(gfxContext);
+}
 
-    gfxContext.TransitionResource(Graphics::g_SceneColorBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
+void GameApp::DrawMainPass(GraphicsContext& gfxContext)
+{
+    gfxContext.TransitionResource(Graphics::g_SceneColorBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    gfxContext.TransitionResource(Graphics::g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE);
     gfxContext.ClearColor(Graphics::g_SceneColorBuffer);
-    
-    gfxContext.TransitionResource(Graphics::g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
     gfxContext.ClearDepthAndStencil(Graphics::g_SceneDepthBuffer);
 
     gfxContext.SetRenderTarget(Graphics::g_SceneColorBuffer.GetRTV(), Graphics::g_SceneDepthBuffer.GetDSV());
 
     gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
 
+    // Ӱ
+    gfxContext.SetDynamicDescriptors(4, 0, 1, &Graphics::g_ShadowBuffer.GetSRV());
+
     // ͨõĳ
     PassConstants psc;
     updatePassConstants(psc, m_Camera);
     gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
 
-    gfxContext.SetPipelineState(m_mapPSO[E_EPT_DEFAULT]);
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Opaque]);
+    gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_DEFAULT));
+    drawRenderItems(gfxContext, m_renderQueues[(int)RenderLayer::Opaque]);
 
     // Ⱦмˮϱ߶̬ɵպ
     // ö̬պԴ
     gfxContext.SetDynamicDescriptors(3, 6, 1, &Graphics::g_SceneCubeBuff.GetSRV());
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::OpaqueDynamicReflectors]);
+    drawRenderItems(gfxContext, m_renderQueues[(int)RenderLayer::OpaqueDynamicReflectors]);
 
     // պ
-    gfxContext.SetPipelineState(m_mapPSO[E_EPT_SKY]);
+    gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_SKY));
     // ԭʼպԴ
     gfxContext.SetDynamicDescriptors(3, 6, 1, &m_srvs[6]);
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Sky]);
+    drawRenderItems(gfxContext, m_renderQueues[(int)RenderLayer::Sky]);
 
     // Ӱdebug
-    gfxContext.SetPipelineState(m_mapPSO[E_EPT_SHADOW_DEBUG]);
-    drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::shadowDebug]);
+    gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_SHADOW_DEBUG));
+    drawRenderItems(gfxContext, m_renderQueues[(int)RenderLayer::shadowDebug]);
 
     gfxContext.TransitionResource(Graphics::g_SceneColorBuffer, D3D12_RESOURCE_STATE_PRESENT);
-
-    gfxContext.Finish();
 }
 
 void GameApp::DrawShadow(GraphicsContext& gfxContext)
 {
-    Graphics::g_ShadowBuffer.BeginRendering(gfxContext);
+    drawShadowCascades(gfxContext, Graphics::g_ShadowBuffer, m_shadowQueues);
+}
+
+void GameApp::drawShadowCascades(GraphicsContext& gfxContext, ShadowBuffer& shadowBuffer, RenderQueue* queues)
+{
+    shadowBuffer.BeginRendering(gfxContext);
+    gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_SHADOW));
+    for (uint32_t i = 0; i < m_CameraShadow.GetCascadeCount(); ++i)
     {
-        // ͨõĳ
+        // ÿͼиԵ
+        shadowBuffer.SetCascadeViewport(gfxContext, i);
+
         PassConstants psc;
-        updatePassConstants(psc, m_CameraShadow);
+        updatePassConstants(psc, m_CameraShadow.GetCascade(i));
         gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
 
-        // Ӱͼg_ShadowBuffer
-        gfxContext.SetPipelineState(m_mapPSO[E_EPT_SHADOW]);
-        drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::allButSky]);
+        drawRenderItems(gfxContext, queues[i]);
     }
-    Graphics::g_ShadowBuffer.EndRendering(gfxContext);
+    shadowBuffer.EndRendering(gfxContext);
 }
 
-void GameApp::DrawSceneToCubeMap(GraphicsContext& gfxContext)
+void GameApp::DrawCubeMap(GraphicsContext& gfxContext)
 {
-    // ı仺
-    gfxContext.TransitionResource(Graphics::g_SceneCubeBuff, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
+    const uint32_t faces = m_cubeCache.GetFaces();
+    const uint32_t staticFaces = m_cubeCache.GetStaticFaces();
 
-    // ģ建
-    gfxContext.TransitionResource(Graphics::g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+    if (faces != 0)
+    {
+        int64_t recordStart = SystemTime::GetCurrentTick();
+        uint64_t draws = 0;
 
-    // ɫ
-    gfxContext.ClearColor(Graphics::g_SceneCubeBuff);
+        // ֻ̬ܾ̬ͶӰ̬ӰӻڻߺҲʧ
+        if (staticFaces != 0)
+        {
+            ShadowBuffer& staticShadow = Graphics::g_CubeStaticShadowBuffer;
+            staticShadow.BeginRendering(gfxContext);
+            gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_SHADOW));
+            staticShadow.SetCascadeViewport(gfxContext, 0);
 
-    // ӿںͲü
-    auto width = Graphics::g_SceneCubeBuff.GetWidth();
-    auto height = Graphics::g_SceneCubeBuff.GetHeight();
-    D3D12_VIEWPORT mViewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
-    D3D12_RECT mScissorRect = { 0, 0, (LONG)width, (LONG)height };
-    gfxContext.SetViewportAndScissor(mViewport, mScissorRect);
+            PassConstants psc;
+            updatePassConstants(psc, m_CubeStaticShadow);
+            gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
 
-    for (int i = 0; i < 6; ++i)
-    {
-        gfxContext.ClearDepthAndStencil(Graphics::g_SceneDepthBuffer);
-        // ΪȾĿ
-        gfxContext.SetRenderTarget(Graphics::g_SceneCubeBuff.GetRTV(i), Graphics::g_SceneDepthBuffer.GetDSV());
+            drawRenderItems(gfxContext, m_cubeShadowQueue);
+            staticShadow.EndRendering(gfxContext);
 
-        // ͨõĳ
-        PassConstants psc;
-        updatePassConstants(psc, m_CameraCube[i]);
-        gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
+            draws += m_cubeShadowQueue.GetBatches().size();
+        }
+
+        // ӿںͲü
+        auto width = Graphics::g_SceneCubeBuff.GetWidth();
+        auto height = Graphics::g_SceneCubeBuff.GetHeight();
+        D3D12_VIEWPORT mViewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
+        D3D12_RECT mScissorRect = { 0, 0, (LONG)width, (LONG)height };
+        gfxContext.SetViewportAndScissor(mViewport, mScissorRect);
+
+        // 1. ؽ̬: ̬պл g_SceneCubeStaticBuff ͸Լ
+        if (staticFaces != 0)
+        {
+            gfxContext.SetDynamicDescriptors(4, 0, 1, &Graphics::g_CubeStaticShadowBuffer.GetSRV());
+
+            gfxContext.TransitionResource(Graphics::g_SceneCubeStaticBuff, D3D12_RESOURCE_STATE_RENDER_TARGET);
+            for (int i = 0; i < CubeMapCache::kFaceCount; ++i)
+            {
+                if (staticFaces & (1u << i))
+                    gfxContext.TransitionResource(Graphics::g_SceneCubeStaticDepth[i], D3D12_RESOURCE_STATE_DEPTH_WRITE);
+            }
+            gfxContext.FlushResourceBarriers();
+
+            for (int i = 0; i < CubeMapCache::kFaceCount; ++i)
+            {
+                if (!(staticFaces & (1u << i)))
+                    continue;
+
+                DepthBuffer& depth = Graphics::g_SceneCubeStaticDepth[i];
+                gfxContext.ClearColor(Graphics::g_SceneCubeStaticBuff, i);
+                gfxContext.ClearDepthAndStencil(depth);
+                gfxContext.SetRenderTarget(Graphics::g_SceneCubeStaticBuff.GetRTV(i), depth.GetDSV());
+
+                PassConstants psc;
+                updatePassConstants(psc, m_CameraCube[i]);
+                useCubeStaticShadow(psc);
+                gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
+
+                gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_DEFAULT));
+                drawRenderItems(gfxContext, m_cubeStaticQueues[i]);
+
+                // պ
+                gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_SKY));
+                drawRenderItems(gfxContext, m_renderQueues[(int)RenderLayer::Sky]);
+
+                draws += m_cubeStaticQueues[i].GetBatches().size() + m_renderQueues[(int)RenderLayer::Sky].GetBatches().size();
+            }
+        }
+
+        // 2. Ҫµȿ̬ɫͼֻ1mipԴž
+        gfxContext.TransitionResource(Graphics::g_SceneCubeStaticBuff, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        gfxContext.TransitionResource(Graphics::g_SceneCubeBuff, D3D12_RESOURCE_STATE_COPY_DEST);
+        for (int i = 0; i < CubeMapCache::kFaceCount; ++i)
+        {
+            if (faces & (1u << i))
+                gfxContext.CopySubresource(Graphics::g_SceneCubeBuff, i, Graphics::g_SceneCubeStaticBuff, i);
+        }
+        gfxContext.TransitionResource(Graphics::g_SceneCubeBuff, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        // 3. ֵ̬ȣٻ̬壬̬ʹӰͼ
+        gfxContext.SetDynamicDescriptors(4, 0, 1, &Graphics::g_ShadowBuffer.GetSRV());
+        for (int i = 0; i < CubeMapCache::kFaceCount; ++i)
+        {
+            if (!(faces & (1u << i)))
+                continue;
+
+            // ȻԴֻƽ(Դ0)ͼpassʹģ
+            gfxContext.TransitionResource(Graphics::g_SceneCubeStaticDepth[i], D3D12_RESOURCE_STATE_COPY_SOURCE);
+            gfxContext.TransitionResource(Graphics::g_SceneCubeDepth, D3D12_RESOURCE_STATE_COPY_DEST);
+            gfxContext.CopySubresource(Graphics::g_SceneCubeDepth, 0, Graphics::g_SceneCubeStaticDepth[i], 0);
+            gfxContext.TransitionResource(Graphics::g_SceneCubeDepth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+            gfxContext.SetRenderTarget(Graphics::g_SceneCubeBuff.GetRTV(i), Graphics::g_SceneCubeDepth.GetDSV());
 
-        // ʼ
-        gfxContext.SetPipelineState(m_mapPSO[E_EPT_DEFAULT]);
-        drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Opaque]);
+            PassConstants psc;
+            updatePassConstants(psc, m_CameraCube[i]);
+            gfxContext.SetDynamicConstantBufferView(1, sizeof(psc), &psc);
 
-        // պ
-        gfxContext.SetPipelineState(m_mapPSO[E_EPT_SKY]);
-        drawRenderItems(gfxContext, m_vecRenderItems[(int)RenderLayer::Sky]);
+            gfxContext.SetPipelineState(m_mapPSO.at(E_EPT_DEFAULT));
+            drawRenderItems(gfxContext, m_cubeDynamicQueues[i]);
+
+            draws += m_cubeDynamicQueues[i].GetBatches().size();
+        }
+
+        m_cubeCache.AddStat(CubeMapCache::kDrawsIssued, draws);
+        m_cubeCache.AddStat(CubeMapCache::kRecordTicks, SystemTime::GetCurrentTick() - recordStart);
     }
-    
-    // ı仺
-    gfxContext.TransitionResource(Graphics::g_SceneCubeBuff, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+
+    // ÿ֡ػ6ʱĻΪԱ
+    m_cubeCache.AddStat(CubeMapCache::kDrawsFull, CubeMapCache::kFaceCount *
+        (m_renderQueues[(int)RenderLayer::Opaque].GetBatches().size() + m_renderQueues[(int)RenderLayer::Sky].GetBatches().size()));
+
+    // ûиµ汣һ֡ݣΪˮ
+    gfxContext.TransitionResource(Graphics::g_SceneCubeBuff, D3D12_RESOURCE_STATE_GENERIC_READ);
 }
 
 void GameApp::RenderUI(class GraphicsContext& gfxContext)
@@ -212,10 +381,12 @@ void GameApp::RenderUI(class GraphicsContext& gfxContext)
     
 }
 
-void GameApp::drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem *>& ritems)
+void GameApp::drawRenderItems(GraphicsContext& gfxContext, RenderQueue& queue)
 {
-    for (auto& item : ritems)
+    for (auto& batch : queue.GetBatches())
     {
+        RenderItem* item = batch.item;
+
         // ö
         gfxContext.SetVertexBuffer(0, item->geo->vertexView);
 
@@ -225,30 +396,170 @@ void GameApp::drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderIte
         // ö˽ṹ
         gfxContext.SetPrimitiveTopology(item->PrimitiveType);
 
-        // ȾĿתƾ
-        ObjectConstants obc;
+        // һʵеʼλãɫͨʵҵԵתƾ
+        gfxContext.SetConstants(0, batch.instanceBase);
+
+        gfxContext.DrawIndexedInstanced(item->IndexCount, batch.instanceCount, item->StartIndexLocation, item->BaseVertexLocation, 0);
+    }
+}
+
+void GameApp::buildRenderQueues(GraphicsContext& gfxContext)
+{
+    // ÿʹõPSO RenderScene еһ
+    static const int layerPSO[(int)RenderLayer::Count] = {
+        E_EPT_DEFAULT,          // Opaque
+        E_EPT_DEFAULT,          // OpaqueDynamicReflectors
+        E_EPT_SKY,              // Sky
+        E_EPT_SHADOW,           // allButSky
+        E_EPT_SHADOW_DEBUG      // shadowDebug
+    };
+
+    // ÿӦpass׶壬պкӰԴڲ޳allButSky ɶ
+    const int layerFrustum[(int)RenderLayer::Count] = {
+        m_mainFrustum,          // Opaque
+        m_mainFrustum,          // OpaqueDynamicReflectors
+        -1,                     // Sky
+        -1,                     // allButSky
+        -1                      // shadowDebug
+    };
+
+    // Ͱͳһ㣬ÿֻһ
+    if (g_sortRenderItems)
+    {
+        Math::Vector3 eye = m_Camera.GetPosition();
+        m_vecDepthKeys.resize(m_vecAll.size());
+        for (auto& item : m_vecAll)
+        {
+            // modeToWorld תô洢ģתû4ƽ
+            Math::Vector3 pos(Math::Transpose(item->modeToWorld).GetW());
+            m_vecDepthKeys[item->ObjIndex] = RenderQueue::MakeDepthKey(Math::LengthSquare(pos - eye));
+        }
+    }
+
+    m_vecInstances.clear();
+    for (int i = 0; i < (int)RenderLayer::Count; ++i)
+    {
+        if (i == (int)RenderLayer::allButSky)
+            continue;
+
+        RenderQueue& queue = m_renderQueues[i];
+        uint64_t psoKey = RenderQueue::MakePsoKey(layerPSO[i]);
+
+        // ʱмΪ0ÿһ˶ּ˳
+        queue.Clear();
+        for (auto& item : m_vecRenderItems[i])
+        {
+            if (!m_culler.Test(*item, layerFrustum[i]))
+                continue;
+
+            uint64_t key = g_sortRenderItems ? (psoKey | item->SortKey | m_vecDepthKeys[item->ObjIndex]) : 0;
+            queue.Push(key, item);
+        }
+        queue.Sort();
+        queue.BuildBatches(g_instanceRenderItems, m_submeshCount, m_vecInstances);
+    }
+
+    // ÿֻԼ׶ཻͶ
+    const uint64_t shadowKey = RenderQueue::MakePsoKey(E_EPT_SHADOW);
+    for (uint32_t cascade = 0; cascade < m_CameraShadow.GetCascadeCount(); ++cascade)
+    {
+        RenderQueue& queue = m_shadowQueues[cascade];
+        queue.Clear();
+        for (auto& item : m_vecRenderItems[(int)RenderLayer::allButSky])
+        {
+            if (!m_culler.Test(*item, m_shadowFrustums[cascade]))
+                continue;
+
+            uint64_t key = g_sortRenderItems ? (shadowKey | item->SortKey | m_vecDepthKeys[item->ObjIndex]) : 0;
+            queue.Push(key, item);
+        }
+        queue.Sort();
+        queue.BuildBatches(g_instanceRenderItems, m_submeshCount, m_vecInstances);
+    }
+
+    // ؽͼ̬õӰͼֻ̬Ͷ
+    if (m_cubeCache.GetStaticFaces() != 0)
+    {
+        m_cubeShadowQueue.Clear();
+        for (auto& item : m_vecRenderItems[(int)RenderLayer::allButSky])
+        {
+            if (item->Dynamic || !m_culler.Test(*item, m_cubeShadowFrustum))
+                continue;
+
+            uint64_t key = g_sortRenderItems ? (shadowKey | item->SortKey | m_vecDepthKeys[item->ObjIndex]) : 0;
+            m_cubeShadowQueue.Push(key, item);
+        }
+        m_cubeShadowQueue.Sort();
+        m_cubeShadowQueue.BuildBatches(g_instanceRenderItems, m_submeshCount, m_vecInstances);
+    }
+
+    // ͼÿľ̬/̬УֻΪ֡Ҫµɣ̬ھ̬ؽʱҪ
+    const uint64_t cubeKey = RenderQueue::MakePsoKey(E_EPT_DEFAULT);
+    for (int face = 0; face < CubeMapCache::kFaceCount; ++face)
+    {
+        const bool cubeStatic = (m_cubeCache.GetStaticFaces() & (1u << face)) != 0;
+        const bool cubeDynamic = (m_cubeCache.GetFaces() & (1u << face)) != 0;
+        if (!cubeDynamic)
+            continue;
+
+        RenderQueue& staticQueue = m_cubeStaticQueues[face];
+        RenderQueue& dynamicQueue = m_cubeDynamicQueues[face];
+        staticQueue.Clear();
+        dynamicQueue.Clear();
+        for (auto& item : m_vecRenderItems[(int)RenderLayer::Opaque])
+        {
+            if (!item->Dynamic && !cubeStatic)
+                continue;
+            if (!m_culler.Test(*item, m_cubeFrustums[face]))
+                continue;
+
+            uint64_t key = g_sortRenderItems ? (cubeKey | item->SortKey | m_vecDepthKeys[item->ObjIndex]) : 0;
+            (item->Dynamic ? dynamicQueue : staticQueue).Push(key, item);
+        }
+        for (RenderQueue* queue : { &staticQueue, &dynamicQueue })
+        {
+            queue->Sort();
+            queue->BuildBatches(g_instanceRenderItems, m_submeshCount, m_vecInstances);
+        }
+    }
+
+    // вʵһϴpass
+    size_t tableSize = m_vecInstances.size() * sizeof(UINT);
+    DynAlloc table = gfxContext.ReserveUploadMemory(tableSize);
+    memcpy(table.DataPtr, m_vecInstances.data(), tableSize);
+    m_InstanceTableGpu = table.GpuAddress;
+}
+
+void GameApp::uploadObjectConstants(GraphicsContext& gfxContext)
+{
+    // ֱдϴѣʡȥһο
+    DynAlloc table = gfxContext.ReserveUploadMemory(sizeof(ObjectConstants) * m_vecAll.size());
+    ObjectConstants* obcs = (ObjectConstants*)table.DataPtr;
+    for (auto& item : m_vecAll)
+    {
+        ObjectConstants& obc = obcs[item->ObjIndex];
         obc.World = item->modeToWorld;
         obc.texTransform = item->texTransform;
         obc.matTransform = item->matTransform;
         obc.MaterialIndex = item->MaterialIndex;
-        gfxContext.SetDynamicConstantBufferView(0, sizeof(obc), &obc);
-
-        gfxContext.DrawIndexed(item->IndexCount, item->StartIndexLocation, item->BaseVertexLocation);
     }
+    m_ObjectConstantsGpu = table.GpuAddress;
 }
 
 void GameApp::buildPSO()
 {
     // ǩ
-    m_RootSignature.Reset(5, 3);
+    m_RootSignature.Reset(7, 3);
     m_RootSignature.InitStaticSampler(0, Graphics::SamplerLinearWrapDesc);
     m_RootSignature.InitStaticSampler(1, Graphics::SamplerAnisoWrapDesc);
     m_RootSignature.InitStaticSampler(2, Graphics::SamplerShadowDesc);
-    m_RootSignature[0].InitAsConstantBuffer(0);
+    m_RootSignature[0].InitAsConstants(0, 1);
     m_RootSignature[1].InitAsConstantBuffer(1);
     m_RootSignature[2].InitAsBufferSRV(0);
     m_RootSignature[3].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 7);
     m_RootSignature[4].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 8, 1);
+    m_RootSignature[5].InitAsBufferSRV(9);
+    m_RootSignature[6].InitAsBufferSRV(10);
     m_RootSignature.Finalize(L"18 RS", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
     // PSO
@@ -439,6 +750,10 @@ void GameApp::buildShapeGeo()
     geo->createVertex(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
     geo->createIndex(L"index buff", (UINT)indices.size(), sizeof(std::uint16_t), indices.data());
 
+    // һCPU˵ĶΧ
+    std::vector<std::int32_t> indices32(indices.begin(), indices.end());
+    geo->storeVertexAndIndex(vertices, indices32);
+
     geo->geoMap["box"] = boxSubmesh;
     geo->geoMap["grid"] = gridSubmesh;
     geo->geoMap["sphere"] = sphereSubmesh;
@@ -450,59 +765,15 @@ void GameApp::buildShapeGeo()
 
 void GameApp::buildSkullGeo()
 {
-    std::ifstream fin("Models/skull.txt");
-
-    if (!fin)
+    // ȶȡ Models/skull.meshʱ skull.txt ɻ
+    std::vector<Vertex> vertices;
+    std::vector<std::int32_t> indices;
+    if (!MeshCache::LoadModel(L"Models/skull.txt", vertices, indices))
     {
         MessageBox(0, L"Models/skull.txt not found.", 0, 0);
         return;
     }
-
-    UINT vcount = 0;
-    UINT tcount = 0;
-    std::string ignore;
-
-    fin >> ignore >> vcount;
-    fin >> ignore >> tcount;
-    fin >> ignore >> ignore >> ignore >> ignore;
-
-    std::vector<Vertex> vertices(vcount);
-    for (UINT i = 0; i < vcount; ++i)
-    {
-        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-
-        XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
-        // 
-        XMFLOAT3 spherePos;
-        XMStoreFloat3(&spherePos, XMVector3Normalize(P));
-
-        float theta = atan2f(spherePos.z, spherePos.x);
-
-        // Put in [0, 2pi].
-        if (theta < 0.0f)
-            theta += XM_2PI;
-
-        float phi = acosf(spherePos.y);
-
-        float u = theta / (2.0f * XM_PI);
-        float v = phi / XM_PI;
-
-        vertices[i].TexC = { u, v };
-    }
-
-    fin >> ignore;
-    fin >> ignore;
-    fin >> ignore;
-
-    std::vector<std::int32_t> indices(3 * tcount);
-    for (UINT i = 0; i < tcount; ++i)
-    {
-        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-    }
-
-    fin.close();
+    UINT tcount = (UINT)indices.size() / 3;
 
     auto geo = std::make_unique<MeshGeometry>();
     geo->name = "skullGeo";
@@ -535,16 +806,18 @@ void GameApp::buildMaterials()
     // 
     m_mats.Create(L"materials", (UINT)v.size(), sizeof(MaterialConstants), v.data());
 
-    // 7
+    // 7ʽ: ռλ䡢ԭλ滻
     m_srvs.resize(7);
     TextureManager::Initialize(L"Textures/");
-    m_srvs[0] = TextureManager::LoadFromFile(L"bricks2", true)->GetSRV();
-    m_srvs[1] = TextureManager::LoadFromFile(L"bricks2_nmap", false)->GetSRV();
-    m_srvs[2] = TextureManager::LoadFromFile(L"tile", true)->GetSRV();
-    m_srvs[3] = TextureManager::LoadFromFile(L"tile_nmap", false)->GetSRV();
-    m_srvs[4] = TextureManager::LoadFromFile(L"white1x1", true)->GetSRV();
-    m_srvs[5] = TextureManager::LoadFromFile(L"default_nmap", false)->GetSRV();
-    m_srvs[6] = TextureManager::LoadFromFile(L"snowcube1024", true)->GetSRV();
+    const Texture& white = TextureManager::GetWhiteTex2D();
+    const Texture& flatNormal = TextureManager::GetFlatNormalTex2D();
+    m_srvs[0] = TextureManager::LoadFromFileAsync(L"bricks2", true, white)->GetSRV();
+    m_srvs[1] = TextureManager::LoadFromFileAsync(L"bricks2_nmap", false, flatNormal)->GetSRV();
+    m_srvs[2] = TextureManager::LoadFromFileAsync(L"tile", true, white)->GetSRV();
+    m_srvs[3] = TextureManager::LoadFromFileAsync(L"tile_nmap", false, flatNormal)->GetSRV();
+    m_srvs[4] = TextureManager::LoadFromFileAsync(L"white1x1", true, white)->GetSRV();
+    m_srvs[5] = TextureManager::LoadFromFileAsync(L"default_nmap", false, flatNormal)->GetSRV();
+    m_srvs[6] = TextureManager::LoadFromFileAsync(L"snowcube1024", true, TextureManager::GetBlackTexCube())->GetSRV();
 }
 
 void GameApp::buildRenderItem()
@@ -691,6 +964,67 @@ void GameApp::buildRenderItem()
         m_vecRenderItems[(int)RenderLayer::allButSky].push_back(rightSphereRitem.get());
         m_vecAll.push_back(std::move(rightSphereRitem));
     }
+
+    // ѹ: Ѳ͸ľ̬帴Ƶ g_sceneItemCount ڳ
+    // ֻģ壬ʱļνṹͲʾͬ
+    std::vector<RenderItem*> templates;
+    for (auto& item : m_vecRenderItems[(int)RenderLayer::allButSky])
+    {
+        auto& opaque = m_vecRenderItems[(int)RenderLayer::Opaque];
+        if (std::find(opaque.begin(), opaque.end(), item) != opaque.end())
+            templates.push_back(item);
+    }
+    if (g_sceneItemCount > (int)m_vecAll.size() && !templates.empty())
+    {
+        const int kColumns = 100;
+        const float kSpacing = 12.0f;
+        int copyCount = g_sceneItemCount - (int)m_vecAll.size();
+        for (int i = 0; i < copyCount; ++i)
+        {
+            Vector3 offset(((i % kColumns) - kColumns / 2) * kSpacing, 0.0f, (i / kColumns + 2) * kSpacing);
+
+            auto copyRitem = std::make_unique<RenderItem>(*templates[i % templates.size()]);
+            copyRitem->modeToWorld = Transpose(Matrix4(AffineTransform(offset)) * Transpose(copyRitem->modeToWorld));
+            m_vecRenderItems[(int)RenderLayer::Opaque].push_back(copyRitem.get());
+            m_vecRenderItems[(int)RenderLayer::allButSky].push_back(copyRitem.get());
+            m_vecAll.push_back(std::move(copyRitem));
+        }
+    }
+
+    // ڳеλ
+    for (size_t i = 0; i < m_vecAll.size(); ++i)
+        m_vecAll[i]->ObjIndex = (UINT)i;
+
+    // в֡仯Ĳ֣νṹһγֵ˳
+    std::unordered_map<MeshGeometry*, uint32_t> geoIds;
+    for (auto& item : m_vecAll)
+    {
+        auto it = geoIds.emplace(item->geo, (uint32_t)geoIds.size()).first;
+        item->SortKey = RenderQueue::MakeStateKey(it->second, item->PrimitiveType, item->MaterialIndex);
+    }
+
+    // νṹ˶ͬԺϲΪһʵ
+    std::map<std::tuple<MeshGeometry*, int, int, int, int>, UINT> submeshIds;
+    for (auto& item : m_vecAll)
+    {
+        auto submesh = std::make_tuple(item->geo, item->IndexCount, item->StartIndexLocation, item->BaseVertexLocation, (int)item->PrimitiveType);
+        item->SubmeshId = submeshIds.emplace(submesh, (UINT)submeshIds.size()).first->second;
+    }
+    m_submeshCount = (UINT)submeshIds.size();
+
+    // ģͿռİΧͬһֻһ
+    std::vector<bool> boundsDone(m_submeshCount, false);
+    std::vector<BoundingSphere> bounds(m_submeshCount);
+    for (auto& item : m_vecAll)
+    {
+        if (!boundsDone[item->SubmeshId])
+        {
+            bounds[item->SubmeshId] = item->geo->computeBounds(item->IndexCount, item->StartIndexLocation, item->BaseVertexLocation);
+            boundsDone[item->SubmeshId] = true;
+        }
+        item->Bounds = bounds[item->SubmeshId];
+        item->lastModeToWorld = item->modeToWorld;
+    }
 }
 
 void GameApp::cameraUpdate()
@@ -773,12 +1107,67 @@ void GameApp::buildCubeCamera(float x, float y, float z)
         m_CameraCube[i].SetPerspectiveMatrix(Math::XM_PIDIV2, 1.0f, 0.1f, 1000.0f);
         m_CameraCube[i].Update();
     }
+
+    // ˣͼȫ
+    m_cubeCache.Invalidate();
+}
+
+void GameApp::updateCubeMapCache()
+{
+    // رջʱÿ֡ȫϣͬһ·ػ6棬ΪԱȵĻ׼
+    if (!g_cubeMapCaching)
+        m_cubeCache.Invalidate();
+
+    // ʽص滻ռλﻭĻռλ
+    uint32_t streamingTextures = TextureStreamer::GetPendingCount();
+    if (streamingTextures != m_streamingTextures)
+    {
+        m_streamingTextures = streamingTextures;
+        m_cubeCache.Invalidate();
+    }
+
+    m_cubeCache.TrackMovement(m_vecRenderItems[(int)RenderLayer::Opaque], m_CameraCube);
+    m_cubeCache.TrackLighting(mLightRotationAngle, g_cubeLightTolerance);
+    m_cubeCache.SelectFaces(g_cubeFacesPerFrame);
 }
 
-void GameApp::updatePassConstants(PassConstants& psc, Math::BaseCamera& camera)
+void GameApp::cullRenderItems()
+{
+    m_culler.BeginFrame();
+
+    if (!g_openFrustumCull)
+    {
+        for (int& frustum : m_cubeFrustums)
+            frustum = -1;
+        for (int& frustum : m_shadowFrustums)
+            frustum = -1;
+        m_cubeShadowFrustum = -1;
+        m_mainFrustum = -1;
+        return;
+    }
+
+    static const char* faceNames[CubeMapCache::kFaceCount] = { "cube +X", "cube -X", "cube +Y", "cube -Y", "cube +Z", "cube -Z" };
+    for (int i = 0; i < CubeMapCache::kFaceCount; ++i)
+        m_cubeFrustums[i] = m_culler.AddFrustum(m_CameraCube[i].GetWorldSpaceFrustum(), faceNames[i]);
+    static const char* cascadeNames[GameCore::CascadedShadowCamera::kMaxCascades] = { "shadow 0", "shadow 1", "shadow 2", "shadow 3" };
+    for (uint32_t i = 0; i < m_CameraShadow.GetCascadeCount(); ++i)
+        m_shadowFrustums[i] = m_culler.AddFrustum(m_CameraShadow.GetCascade(i).GetWorldSpaceFrustum(), cascadeNames[i]);
+    m_cubeShadowFrustum = m_culler.AddFrustum(m_CubeStaticShadow.GetWorldSpaceFrustum(), "cube shadow");
+    m_mainFrustum = m_culler.AddFrustum(m_Camera.GetWorldSpaceFrustum(), "main");
+
+    m_culler.Cull(m_vecAll);
+}
+
+void GameApp::updatePassConstants(PassConstants& psc, const Math::BaseCamera& camera)
 {
     psc.viewProj = Transpose(camera.GetViewProjMatrix());
-    psc.modelToShadow = Transpose(m_CameraShadow.GetShadowMatrix());
+    psc.modelToShadow = Transpose(m_CameraShadow.GetCascade(0).GetShadowMatrix());
+    psc.cascadeCount = m_CameraShadow.GetCascadeCount();
+    for (uint32_t i = 0; i < psc.cascadeCount; ++i)
+    {
+        psc.cascadeShadow[i] = Transpose(m_CameraShadow.GetCascade(i).GetShadowMatrix());
+        psc.cascadeAtlas[i] = Graphics::g_ShadowBuffer.GetCascadeScaleOffset(i);
+    }
     psc.eyePosW = camera.GetPosition();
     psc.ambientLight = { 0.25f, 0.25f, 0.35f, 1.0f };
     psc.Lights[0].Direction = mRotatedLightDirections[0];
@@ -787,4 +1176,12 @@ void GameApp::updatePassConstants(PassConstants& psc, Math::BaseCamera& camera)
     psc.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
     psc.Lights[2].Direction = mRotatedLightDirections[2];
     psc.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
+}
+
+void GameApp::useCubeStaticShadow(PassConstants& psc)
+{
+    psc.modelToShadow = Transpose(m_CubeStaticShadow.GetShadowMatrix());
+    psc.cascadeCount = 1;
+    psc.cascadeShadow[0] = psc.modelToShadow;
+    psc.cascadeAtlas[0] = Graphics::g_CubeStaticShadowBuffer.GetCascadeScaleOffset(0);
 }
\ No newline at end of file
@@ -9,9 +9,13 @@
 #include "ShadowCamera.h"
 #include "d3dUtil.h"
 #include "CameraController.h"
+#include "RenderQueue.h"
+#include "CubeMapCache.h"
+#include "FrustumCuller.h"
 
 class RootSignature;
 class GraphicsPSO;
+class ShadowBuffer;
 class GameApp : public GameCore::IGameApp
 {
 public:
@@ -25,6 +29,9 @@ public:
 	virtual void RenderScene(void) override;
     virtual void RenderUI(class GraphicsContext& gfxContext) override;
 
+    virtual void ResetStats(void) override { m_cubeCache.ResetStats(); m_culler.ResetStats(); }
+    virtual void PrintStats(void) override { m_cubeCache.PrintReport(); m_culler.PrintReport(); }
+
 private:
     void cameraUpdate();   // camera
 
@@ -33,17 +40,29 @@ private:
     void buildGeo();
     void buildMaterials();
     void buildRenderItem();
-    void drawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& ritems);
+    void drawRenderItems(GraphicsContext& gfxContext, RenderQueue& queue);
+    void uploadObjectConstants(GraphicsContext& gfxContext);
+    void buildRenderQueues(GraphicsContext& gfxContext);
     
     void buildCubeCamera(float x, float y, float z);
+    void updateCubeMapCache();
+    void cullRenderItems();
+
+    // passֻȡ֡Ѿ׼õݣڲͬ߳¼ƵԵ
+    void setCommonRootParameters(GraphicsContext& gfxContext);
     void DrawShadow(GraphicsContext& gfxContext);
-    void DrawSceneToCubeMap(GraphicsContext& gfxContext);
+    void drawShadowCascades(GraphicsContext& gfxContext, ShadowBuffer& shadowBuffer, RenderQueue* queues);
+    void DrawCubeMap(GraphicsContext& gfxContext);
+    void DrawMainPass(GraphicsContext& gfxContext);
+    void recordPassesParallel(GraphicsContext& gfxContext);
 
 private:
     void buildShapeGeo();
     void buildSkullGeo();
 
-    void updatePassConstants(PassConstants& psc, Math::BaseCamera& camera);
+    void updatePassConstants(PassConstants& psc, const Math::BaseCamera& camera);
+    // Ӱͼ̬Ӱͼؽ̬ʱʹ
+    void useCubeStaticShadow(PassConstants& psc);
 
 private:
     // νṹmap
@@ -62,6 +81,30 @@ private:
     std::vector<RenderItem*> m_vecRenderItems[(int)RenderLayer::Count];
     std::vector<std::unique_ptr<RenderItem>> m_vecAll;
 
+    // ÿ֡ m_vecRenderItems ɵȾУg_sortRenderItems رʱּ˳
+    RenderQueue m_renderQueues[(int)RenderLayer::Count];
+    std::vector<uint64_t> m_vecDepthKeys;   //  ObjIndex 洢֡Ͱ
+    std::vector<UINT> m_vecInstances;       // ֡εʵ
+    UINT m_submeshCount = 0;
+
+    // ͼֻػ֡ѡ棬ÿ Opaque 㰴 RenderItem::Dynamic ɾ̬Ͷ̬
+    CubeMapCache m_cubeCache;
+    uint32_t m_streamingTextures = 0;   // ϴμʱʽص仯ʱҪػ
+    RenderQueue m_cubeStaticQueues[CubeMapCache::kFaceCount];
+    RenderQueue m_cubeDynamicQueues[CubeMapCache::kFaceCount];
+
+    // ÿһӰУ allButSky 㰴׶޳
+    RenderQueue m_shadowQueues[GameCore::CascadedShadowCamera::kMaxCascades];
+    // ֻо̬ͶӰУ m_CubeStaticShadow ׶޳֡Ҫؽͼ̬ʱ
+    RenderQueue m_cubeShadowQueue;
+
+    // pass׶ m_culler еţ-1 ʾ޳
+    FrustumCuller m_culler;
+    int m_cubeFrustums[CubeMapCache::kFaceCount] = { -1, -1, -1, -1, -1, -1 };
+    int m_shadowFrustums[GameCore::CascadedShadowCamera::kMaxCascades] = { -1, -1, -1, -1 };
+    int m_cubeShadowFrustum = -1;
+    int m_mainFrustum = -1;
+
     enum eMaterialType
     {
         bricks = 0,
@@ -77,6 +120,11 @@ private:
     // ǩ
     RootSignature m_RootSignature;
 
+    // ֡峣GPUַÿ֡ϴһΣpass
+    D3D12_GPU_VIRTUAL_ADDRESS m_ObjectConstantsGpu = 0;
+    // ֡ʵGPUַ
+    D3D12_GPU_VIRTUAL_ADDRESS m_InstanceTableGpu = 0;
+
     // Ⱦˮ
     enum ePSOType
     {
@@ -92,8 +140,12 @@ private:
     // պ
     Math::Camera m_CameraCube[6];
 
-    // Ӱ
-    GameCore::ShadowCamera m_CameraShadow;
+    // Ӱ
+    GameCore::CascadedShadowCamera m_CameraShadow;
+
+    // ͼ̬õӰͼΪġ g_shadowDistance ķΧ
+    // ֻ͹Դйأƶʱ̬ӰȻЧԴ CubeMapCache::TrackLighting 
+    GameCore::ShadowCamera m_CubeStaticShadow;
 
     // Դ
     float mLightRotationAngle = 0.0f;
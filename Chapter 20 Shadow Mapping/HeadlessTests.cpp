@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "HeadlessTests.h"
+#include "ShadowCamera.h"
+#include "PipelineState.h"
+#include "UploadRing.h"
+#include "DescriptorFreeList.h"
+#include "ResourceStateTracker.h"
+#include "TextureStreamer.h"
+#include "JobSystem.h"
+#include "SystemTime.h"
+#include "MeshCache.h"
+#include "MeshTextLoader.h"
+
+#include <sstream>
+
+namespace
+{
+    // ģ(skullԼ3MB)Сģ(carԼ130KB)
+    const wchar_t* const kModels[] = { L"Models/skull.txt", L"Models/car.txt" };
+
+    struct Entry
+    {
+        const char* name;
+        std::function<bool(GameCore::IGameApp&)> run;
+    };
+
+    // ͼ豸Ҫù̵߳Ĳ
+    template <typename F>
+    bool WithJobSystem(F func)
+    {
+        JobSystem::Initialize();
+        bool passed = func();
+        JobSystem::Shutdown();
+        return passed;
+    }
+
+    //  false ʾʧܣ-selftest дʱȫ
+    const Entry kSelfTests[] =
+    {
+        { "jobsystem", [](GameCore::IGameApp&) { return WithJobSystem([]() { return JobSystem::StressTest(); }); } },
+        { "meshtextloader", [](GameCore::IGameApp&)
+            {
+                return WithJobSystem([]()
+                {
+                    bool passed = true;
+                    for (const wchar_t* model : kModels)
+                        passed = MeshTextLoader::SelfTest(model) && passed;
+                    return passed;
+                });
+            } },
+        { "shadowcascade", [](GameCore::IGameApp&) { return GameCore::CascadedShadowCamera::SelfTest(); } },
+        { "descriptorfreelist", [](GameCore::IGameApp&) { return DescriptorFreeList::SelfTest(); } },
+        { "resourcestatetracker", [](GameCore::IGameApp&) { return ResourceStateTracker::SelfTest(); } },
+    };
+
+    // ֻܲһһ
+    const Entry kBenchmarks[] =
+    {
+        // 豸600֡ RenderScene CPUʱdraw callϺ
+        { "nulldevice", [](GameCore::IGameApp& app) { GameCore::RunHeadless(app, 600); return true; } },
+        //  0(¼)124816 ߳Уֻ3passУ3̲߳¼ʱ
+        { "parallelrecording", [](GameCore::IGameApp& app) { GameCore::RunHeadless(app, 300, { 0, 1, 2, 4, 8, 16 }); return true; } },
+        // ֱرպʹ600֡Ƚÿ֡ύʱ
+        { "descriptortablecache", [](GameCore::IGameApp& app) { GameCore::RunHeadless(app, 600, {}, true); return true; } },
+        // ϴ1~16߳µķٶȺϴ˷ͳ
+        { "uploadring", [](GameCore::IGameApp&) { UploadRingAllocator::Benchmark(); return true; } },
+        // 1~16߳ͬʱ Finalize PSOȽϻͷƬ
+        { "psocache", [](GameCore::IGameApp&) { PSO::Benchmark(); return true; } },
+        // 100/ͷţȽԷͿĶʱ
+        { "descriptorchurn", [](GameCore::IGameApp&) { DescriptorFreeList::Benchmark(); return true; } },
+        // ͬغʽ Textures/ Ƚ֡ǰʱȫʱ
+        { "texturestreaming", [](GameCore::IGameApp&) { TextureStreamer::Benchmark(); return true; } },
+        // /ȴʱParallelFor ڲͬµļٱ
+        { "jobsystem", [](GameCore::IGameApp&) { return WithJobSystem([]() { JobSystem::Benchmark(); return true; }); } },
+        // ı ifstream ĽٶȣıͶƻļغʱ
+        { "meshload", [](GameCore::IGameApp&)
+            {
+                return WithJobSystem([]()
+                {
+                    for (const wchar_t* model : kModels)
+                    {
+                        MeshTextLoader::Benchmark(model);
+                        MeshCache::Benchmark(model);
+                    }
+                    return true;
+                });
+            } },
+    };
+
+    template <size_t N>
+    const Entry* Find(const Entry (&entries)[N], const std::string& name)
+    {
+        for (const Entry& entry : entries)
+        {
+            if (name == entry.name)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    template <size_t N>
+    void PrintNames(const char* title, const Entry (&entries)[N])
+    {
+        Utility::Printf("%s:", title);
+        for (const Entry& entry : entries)
+            Utility::Printf(" %s", entry.name);
+        Utility::Printf("\n");
+    }
+}
+
+bool HeadlessTests::Run(const char* commandLine, GameCore::IGameApp& app, int& exitCode)
+{
+    std::istringstream args(commandLine != nullptr ? commandLine : "");
+    std::string option, name;
+    args >> option >> name;
+
+    bool selfTest = option == "-selftest";
+    if (!selfTest && option != "-benchmark")
+        return false;
+
+    SystemTime::Initialize();
+
+    if (selfTest && name.empty())
+    {
+        int failed = 0;
+        for (const Entry& test : kSelfTests)
+        {
+            if (!test.run(app))
+                ++failed;
+        }
+        Utility::Printf("Self test: %d of %d failed\n", failed, (int)_countof(kSelfTests));
+        exitCode = failed > 0 ? 1 : 0;
+        return true;
+    }
+
+    const Entry* entry = selfTest ? Find(kSelfTests, name) : Find(kBenchmarks, name);
+    if (entry == nullptr)
+    {
+        Utility::Printf("Unknown %s '%s'\n", option.c_str(), name.c_str());
+        PrintNames("-selftest", kSelfTests);
+        PrintNames("-benchmark", kBenchmarks);
+        exitCode = 2;
+        return true;
+    }
+
+    exitCode = entry->run(app) ? 0 : 1;
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "GameCore.h"
+
+// еԼܲԣпѡ
+//  -selftest []      һԼ죬дʱȫԼ죬һʧʱ̷1
+//  -benchmark <>     һܲԣ̨
+// дʱгпõֲ2
+namespace HeadlessTests
+{
+    //  -selftest  -benchmark ʱжӦĲԲ trueexitCode Ϊ̵˳
+    // ûʱ falseճ
+    bool Run(const char* commandLine, GameCore::IGameApp& app, int& exitCode);
+}
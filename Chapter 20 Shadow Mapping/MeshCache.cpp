@@ -0,0 +1,279 @@
+#include "pch.h"
+#include "MeshCache.h"
+#include "MeshTextLoader.h"
+#include "SystemTime.h"
+#include "Hash.h"
+
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+    // ֻڴӳļ
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::wstring& fileName)
+        {
+            m_hFile = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+                return;
+
+            m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_hMapping == nullptr)
+                return;
+
+            m_pData = (const uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (m_pData != nullptr)
+                m_Size = (size_t)size.QuadPart;
+        }
+
+        ~MappedFile()
+        {
+            if (m_pData != nullptr)
+                UnmapViewOfFile(m_pData);
+            if (m_hMapping != nullptr)
+                CloseHandle(m_hMapping);
+            if (m_hFile != INVALID_HANDLE_VALUE)
+                CloseHandle(m_hFile);
+        }
+
+        const uint8_t* Data() const { return m_pData; }
+        size_t Size() const { return m_Size; }
+
+    private:
+        HANDLE m_hFile = INVALID_HANDLE_VALUE;
+        HANDLE m_hMapping = nullptr;
+        const uint8_t* m_pData = nullptr;
+        size_t m_Size = 0;
+    };
+
+    uint32_t Checksum(const uint8_t* data, size_t size)
+    {
+        ASSERT((size & 3) == 0);
+        return (uint32_t)Utility::HashRange((const uint32_t*)data, (const uint32_t*)(data + size), 2166136261U);
+    }
+
+    // ıģ͵ĴС޸ʱ䣬ļʱfalse
+    bool GetSourceStamp(const std::wstring& textFile, uint64_t& size, uint64_t& writeTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(textFile.c_str(), GetFileExInfoStandard, &data))
+            return false;
+
+        size = (uint64_t)data.nFileSizeHigh << 32 | data.nFileSizeLow;
+        writeTime = (uint64_t)data.ftLastWriteTime.dwHighDateTime << 32 | data.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+}
+
+std::wstring MeshCache::GetCacheFileName(const std::wstring& textFile)
+{
+    size_t dot = textFile.find_last_of(L'.');
+    size_t slash = textFile.find_last_of(L"/\\");
+    if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+        return textFile + L".mesh";
+    return textFile.substr(0, dot) + L".mesh";
+}
+
+void MeshCache::ComputeSphereTexC(Vertex& vertex)
+{
+    XMVECTOR P = XMLoadFloat3(&vertex.Pos);
+
+    // 
+    XMFLOAT3 spherePos;
+    XMStoreFloat3(&spherePos, XMVector3Normalize(P));
+
+    float theta = atan2f(spherePos.z, spherePos.x);
+
+    // Put in [0, 2pi].
+    if (theta < 0.0f)
+        theta += XM_2PI;
+
+    float phi = acosf(spherePos.y);
+
+    float u = theta / (2.0f * XM_PI);
+    float v = phi / XM_PI;
+
+    vertex.TexC = { u, v };
+    vertex.TangentU = { 0.0f, 0.0f, 0.0f };
+}
+
+bool MeshCache::LoadText(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices)
+{
+    std::ifstream fin(textFile);
+    if (!fin)
+        return false;
+
+    UINT vcount = 0;
+    UINT tcount = 0;
+    std::string ignore;
+
+    fin >> ignore >> vcount;
+    fin >> ignore >> tcount;
+    fin >> ignore >> ignore >> ignore >> ignore;
+
+    vertices.assign(vcount, Vertex());
+    for (UINT i = 0; i < vcount; ++i)
+    {
+        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
+        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+
+        ComputeSphereTexC(vertices[i]);
+    }
+
+    fin >> ignore;
+    fin >> ignore;
+    fin >> ignore;
+
+    indices.assign(3 * tcount, 0);
+    for (UINT i = 0; i < tcount; ++i)
+    {
+        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+    }
+
+    return !fin.fail();
+}
+
+bool MeshCache::Save(const std::wstring& cacheFile, const std::wstring& textFile, const std::vector<Vertex>& vertices, const std::vector<std::int32_t>& indices)
+{
+    Header header;
+    if (!GetSourceStamp(textFile, header.sourceSize, header.sourceWriteTime))
+        return false;
+    header.indexStride = vertices.size() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.vertexCount = (uint32_t)vertices.size();
+    header.indexCount = (uint32_t)indices.size();
+
+    size_t vertexBytes = vertices.size() * sizeof(Vertex);
+    size_t indexBytes = indices.size() * header.indexStride;
+    header.payloadSize = (uint32_t)Math::AlignUp(vertexBytes + indexBytes, 4);
+
+    // ڴƴȫݣټУֵһд
+    std::vector<uint8_t> payload(header.payloadSize, 0);
+    memcpy(payload.data(), vertices.data(), vertexBytes);
+    if (header.indexStride == sizeof(uint16_t))
+    {
+        uint16_t* dst = (uint16_t*)(payload.data() + vertexBytes);
+        for (size_t i = 0; i < indices.size(); ++i)
+            dst[i] = (uint16_t)indices[i];
+    }
+    else
+    {
+        memcpy(payload.data() + vertexBytes, indices.data(), indexBytes);
+    }
+    header.checksum = Checksum(payload.data(), payload.size());
+
+    std::ofstream fout(cacheFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fout)
+        return false;
+
+    fout.write((const char*)&header, sizeof(header));
+    fout.write((const char*)payload.data(), payload.size());
+    return fout.good();
+}
+
+bool MeshCache::Load(const std::wstring& cacheFile, const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices)
+{
+    // ֻ .mesh ûıģʱֻͷУжϻǷ
+    uint64_t sourceSize = 0, sourceWriteTime = 0;
+    bool hasSource = GetSourceStamp(textFile, sourceSize, sourceWriteTime);
+
+    MappedFile file(cacheFile);
+    if (file.Data() == nullptr || file.Size() < sizeof(Header))
+        return false;
+
+    const Header& header = *(const Header*)file.Data();
+    if (header.magic != kMagic || header.version != kVersion || header.vertexStride != sizeof(Vertex))
+        return false;
+    if (header.indexStride != sizeof(uint16_t) && header.indexStride != sizeof(uint32_t))
+        return false;
+
+    // ıģɻ֮޸Ĺ
+    if (hasSource && (header.sourceSize != sourceSize || header.sourceWriteTime != sourceWriteTime))
+        return false;
+
+    size_t vertexBytes = (size_t)header.vertexCount * sizeof(Vertex);
+    size_t indexBytes = (size_t)header.indexCount * header.indexStride;
+    if (header.payloadSize != Math::AlignUp(vertexBytes + indexBytes, 4) ||
+        file.Size() != sizeof(Header) + header.payloadSize)
+        return false;
+
+    const uint8_t* payload = file.Data() + sizeof(Header);
+    if (Checksum(payload, header.payloadSize) != header.checksum)
+        return false;
+
+    // ֱ鿽Ҫ
+    vertices.resize(header.vertexCount);
+    memcpy(vertices.data(), payload, vertexBytes);
+
+    indices.resize(header.indexCount);
+    if (header.indexStride == sizeof(uint16_t))
+    {
+        const uint16_t* src = (const uint16_t*)(payload + vertexBytes);
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = src[i];
+    }
+    else
+    {
+        memcpy(indices.data(), payload + vertexBytes, indexBytes);
+    }
+
+    return true;
+}
+
+bool MeshCache::LoadModel(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices)
+{
+    std::wstring cacheFile = GetCacheFileName(textFile);
+    if (Load(cacheFile, textFile, vertices, indices))
+        return true;
+
+    if (!MeshTextLoader::Load(textFile, vertices, indices))
+        return false;
+
+    if (!Save(cacheFile, textFile, vertices, indices))
+        Utility::Printf(L"MeshCache: failed to write %s\n", cacheFile.c_str());
+
+    return true;
+}
+
+bool MeshCache::Convert(const std::wstring& textFile)
+{
+    std::vector<Vertex> vertices;
+    std::vector<std::int32_t> indices;
+    if (!MeshTextLoader::Load(textFile, vertices, indices))
+        return false;
+
+    return Save(GetCacheFileName(textFile), textFile, vertices, indices);
+}
+
+void MeshCache::Benchmark(const std::wstring& textFile, int loopCount)
+{
+    if (!Convert(textFile))
+    {
+        Utility::Printf(L"MeshCache: %s not found.\n", textFile.c_str());
+        return;
+    }
+
+    std::wstring cacheFile = GetCacheFileName(textFile);
+    std::vector<Vertex> vertices;
+    std::vector<std::int32_t> indices;
+
+    int64_t start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < loopCount; ++i)
+        LoadText(textFile, vertices, indices);
+    double textMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start) / loopCount;
+
+    start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < loopCount; ++i)
+        Load(cacheFile, textFile, vertices, indices);
+    double binaryMs = SystemTime::TicksToMillisecs(SystemTime::GetCurrentTick() - start) / loopCount;
+
+    Utility::Printf(L"MeshCache: %s  vertex: %u  index: %u  text: %.3f ms  binary: %.3f ms  x%.1f\n",
+        textFile.c_str(), (UINT)vertices.size(), (UINT)indices.size(), textMs, binaryMs, textMs / binaryMs);
+}
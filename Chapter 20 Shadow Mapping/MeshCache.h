@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "d3dUtil.h"
+
+// ģļ(Models/*.txt)Ķƻ
+// һμʱıļͬ .mesh ļֱ֮Ӱ .mesh ӳ䵽ڴп
+//
+// .mesh ļʽ:
+//  Header
+//  Vertex[vertexCount]                         ݣ d3dUtil.h е Vertex ȫһ
+//  uint16_t/uint32_t[indexCount]               ݣ65536ʱʹ16λ
+//  뵽4ֽ
+namespace MeshCache
+{
+    static const uint32_t kMagic = 'HSEM';  // "MESH"
+    static const uint32_t kVersion = 2;
+
+    struct Header
+    {
+        uint32_t magic = kMagic;
+        uint32_t version = kVersion;
+        uint32_t vertexStride = sizeof(Vertex);     // Vertexṹı󣬾ɵĻԶʧЧ
+        uint32_t indexStride = 0;                   // 2  4
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t payloadSize = 0;                   // headerֽ֮
+        uint32_t checksum = 0;                      // header֮ȫݵhash
+        uint64_t sourceSize = 0;                    // ɻʱıģ͵ĴС޸ʱ䣬
+        uint64_t sourceWriteTime = 0;               // ıģ͸ĶɵĻԶʧЧ
+    };
+
+    // ıģͶӦĻļ  Models/skull.txt -> Models/skull.mesh
+    std::wstring GetCacheFileName(const std::wstring& textFile);
+
+    // ݶλü
+    void ComputeSphereTexC(Vertex& vertex);
+
+    //  ifstream ıģͣ
+    bool LoadText(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices);
+
+    // дƻ棬textFile ǻӦıģ͡汾СУ鲻һʱȡʧ
+    // ıģʹʱĴС޸ʱɻʱһҲȡʧܣʱֻҪ汾Чֱʹ
+    bool Save(const std::wstring& cacheFile, const std::wstring& textFile, const std::vector<Vertex>& vertices, const std::vector<std::int32_t>& indices);
+    bool Load(const std::wstring& cacheFile, const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices);
+
+    // ȶȡ棬治ڻʧЧʱıɻ棬ûıģʱֻû
+    bool LoadModel(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices);
+
+    // ıģתΪƻ棬Ƿɹ
+    bool Convert(const std::wstring& textFile);
+
+    // ԱıͶƵļغʱ̨
+    void Benchmark(const std::wstring& textFile, int loopCount = 10);
+}
@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "MeshTextLoader.h"
+#include "MeshCache.h"
+#include "FileUtility.h"
+#include "SystemTime.h"
+#include "JobSystem.h"
+
+#include <cstdlib>
+
+namespace
+{
+    // ÿıĴСεı߽ƶһз
+    const size_t kChunkSize = 64 * 1024;
+
+    // 10^0 ~ 10^10 floatȷʾ
+    const float kPow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+    inline bool IsDigit(char c)
+    {
+        return (unsigned)(c - '0') < 10u;
+    }
+
+    inline const char* SkipSpace(const char* p, const char* end)
+    {
+        while (p < end && (unsigned char)*p <= ' ')
+            ++p;
+        return p;
+    }
+
+    inline const char* SkipLine(const char* p, const char* end)
+    {
+        while (p < end && *p != '\n')
+            ++p;
+        return p < end ? p + 1 : end;
+    }
+
+    inline const char* ParseInt(const char* p, int32_t& value)
+    {
+        bool negative = *p == '-';
+        p += (*p == '-' || *p == '+');
+
+        uint32_t v = 0;
+        while (IsDigit(*p))
+            v = v * 10 + (*p++ - '0');
+
+        value = negative ? -(int32_t)v : (int32_t)v;
+        return p;
+    }
+
+    // β2^24ָ[-10, 10]֮ʱβ10ݶܱfloatȷʾ
+    // һγ˷õľȷĽstrtofһ¡strtof
+    inline const char* ParseFloat(const char* p, float& value)
+    {
+        const char* start = p;
+        bool negative = *p == '-';
+        p += (*p == '-' || *p == '+');
+
+        uint64_t mantissa = 0;
+        int digits = 0;     // Чָ
+        int exp10 = 0;
+        bool truncated = false;
+
+        for (; IsDigit(*p); ++p)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += (mantissa != 0);
+            }
+            else
+            {
+                ++exp10;
+                truncated = true;
+            }
+        }
+
+        if (*p == '.')
+        {
+            for (++p; IsDigit(*p); ++p)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += (mantissa != 0);
+                    --exp10;
+                }
+                else
+                {
+                    truncated = true;
+                }
+            }
+        }
+
+        if (*p == 'e' || *p == 'E')
+        {
+            int32_t e = 0;
+            p = ParseInt(p + 1, e);
+            exp10 += e;
+        }
+
+        if (!truncated && mantissa <= (1u << 24) && exp10 >= -10 && exp10 <= 10)
+        {
+            float f = (float)mantissa;
+            f = exp10 < 0 ? f / kPow10[-exp10] : f * kPow10[exp10];
+            value = negative ? -f : f;
+            return p;
+        }
+
+        char* last = nullptr;
+        value = strtof(start, &last);
+        return last;
+    }
+
+    //  [begin, end) зֳɶ
+    void SplitLines(const char* begin, const char* end, std::vector<const char*>& bounds)
+    {
+        bounds.clear();
+        bounds.push_back(begin);
+        const char* p = begin;
+        while (end - p > (ptrdiff_t)kChunkSize)
+        {
+            p = SkipLine(p + kChunkSize, end);
+            bounds.push_back(p);
+        }
+        if (bounds.back() != end)
+            bounds.push_back(end);
+    }
+
+    //  [p, end) в text text ֮λ
+    const char* FindAfter(const char* p, const char* end, const char* text)
+    {
+        size_t len = strlen(text);
+        for (; p + len <= end; ++p)
+        {
+            if (memcmp(p, text, len) == 0)
+                return p + len;
+        }
+        return nullptr;
+    }
+
+    // ոνƴӳս֤˳봮нһ
+    template <typename T>
+    void MergeChunks(std::vector<std::vector<T>>& chunks, std::vector<T>& result)
+    {
+        size_t total = 0;
+        for (auto& c : chunks)
+            total += c.size();
+
+        result.resize(total);
+        size_t offset = 0;
+        for (auto& c : chunks)
+        {
+            if (!c.empty())
+                memcpy(result.data() + offset, c.data(), c.size() * sizeof(T));
+            offset += c.size();
+        }
+    }
+}
+
+bool MeshTextLoader::Parse(const char* begin, const char* end, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices)
+{
+    // ļͷ
+    //  VertexCount: 31076
+    //  TriangleCount: 60339
+    //  VertexList (pos, normal)
+    //  {
+    const char* p = FindAfter(begin, end, "VertexCount:");
+    if (p == nullptr)
+        return false;
+    int32_t vcount = 0;
+    p = ParseInt(SkipSpace(p, end), vcount);
+
+    p = FindAfter(p, end, "TriangleCount:");
+    if (p == nullptr)
+        return false;
+    int32_t tcount = 0;
+    p = ParseInt(SkipSpace(p, end), tcount);
+
+    const char* vertexBegin = FindAfter(p, end, "{");
+    const char* vertexEnd = vertexBegin ? (const char*)memchr(vertexBegin, '}', end - vertexBegin) : nullptr;
+    if (vertexEnd == nullptr)
+        return false;
+
+    //  }
+    //  TriangleList
+    //  {
+    const char* indexBegin = FindAfter(vertexEnd, end, "{");
+    const char* indexEnd = indexBegin ? (const char*)memchr(indexBegin, '}', end - indexBegin) : nullptr;
+    if (indexEnd == nullptr)
+        return false;
+
+    std::vector<const char*> vertexBounds;
+    std::vector<const char*> indexBounds;
+    SplitLines(vertexBegin, vertexEnd, vertexBounds);
+    SplitLines(indexBegin, indexEnd, indexBounds);
+
+    size_t vertexChunkCount = vertexBounds.size() - 1;
+    size_t indexChunkCount = indexBounds.size() - 1;
+    std::vector<std::vector<Vertex>> vertexChunks(vertexChunkCount);
+    std::vector<std::vector<std::int32_t>> indexChunks(indexChunkCount);
+
+    // κζηͬһѭвн
+    JobSystem::ParallelFor(0, (int)(vertexChunkCount + indexChunkCount), 1, [&](int chunk)
+    {
+        size_t i = (size_t)chunk;
+        if (i < vertexChunkCount)
+        {
+            const char* s = vertexBounds[i];
+            const char* e = vertexBounds[i + 1];
+            auto& out = vertexChunks[i];
+            out.reserve((e - s) / 48);
+            for (s = SkipSpace(s, e); s < e; s = SkipSpace(s, e))
+            {
+                const char* line = s;
+                Vertex v;
+                s = ParseFloat(s, v.Pos.x);
+                s = ParseFloat(SkipSpace(s, e), v.Pos.y);
+                s = ParseFloat(SkipSpace(s, e), v.Pos.z);
+                s = ParseFloat(SkipSpace(s, e), v.Normal.x);
+                s = ParseFloat(SkipSpace(s, e), v.Normal.y);
+                s = ParseFloat(SkipSpace(s, e), v.Normal.z);
+                if (s == line)
+                    break;      // ޷ʶַУʧ
+                MeshCache::ComputeSphereTexC(v);
+                out.push_back(v);
+            }
+        }
+        else
+        {
+            i -= vertexChunkCount;
+            const char* s = indexBounds[i];
+            const char* e = indexBounds[i + 1];
+            auto& out = indexChunks[i];
+            out.reserve((e - s) / 4);
+            for (s = SkipSpace(s, e); s < e; s = SkipSpace(s, e))
+            {
+                const char* number = s;
+                int32_t index;
+                s = ParseInt(s, index);
+                if (s == number)
+                    break;
+                out.push_back(index);
+            }
+        }
+    });
+
+    MergeChunks(vertexChunks, vertices);
+    MergeChunks(indexChunks, indices);
+
+    return vertices.size() == (size_t)vcount && indices.size() == 3 * (size_t)tcount;
+}
+
+bool MeshTextLoader::Load(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices)
+{
+    Utility::ByteArray file = Utility::ReadFileSync(textFile);
+    if (file == Utility::NullFile || file->empty())
+        return false;
+
+    // ֽһֱַΪֹĩβһ'\0'
+    size_t size = file->size();
+    file->push_back('\0');
+
+    const char* begin = (const char*)file->data();
+    return Parse(begin, begin + size, vertices, indices);
+}
+
+bool MeshTextLoader::SelfTest(const std::wstring& textFile)
+{
+    std::vector<Vertex> refVertices, vertices;
+    std::vector<std::int32_t> refIndices, indices;
+    bool refLoaded = MeshCache::LoadText(textFile, refVertices, refIndices);
+    bool loaded = Load(textFile, vertices, indices);
+
+    // λȽֽȫ
+    bool ok = refLoaded && loaded &&
+        refVertices.size() == vertices.size() && refIndices.size() == indices.size() &&
+        memcmp(refVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0 &&
+        memcmp(refIndices.data(), indices.data(), indices.size() * sizeof(std::int32_t)) == 0;
+
+    Utility::Printf(L"MeshTextLoader: %s  vertex: %u/%u  index: %u/%u  %s
+", textFile.c_str(),
+        (UINT)vertices.size(), (UINT)refVertices.size(), (UINT)indices.size(), (UINT)refIndices.size(),
+        ok ? L"PASS" : L"FAIL");
+    return ok;
+}
+
+void MeshTextLoader::Benchmark(const std::wstring& textFile, int loopCount)
+{
+    std::vector<Vertex> vertices;
+    std::vector<std::int32_t> indices;
+
+    int64_t start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < loopCount; ++i)
+        MeshCache::LoadText(textFile, vertices, indices);
+    double streamSec = SystemTime::TimeBetweenTicks(start, SystemTime::GetCurrentTick()) / loopCount;
+
+    start = SystemTime::GetCurrentTick();
+    for (int i = 0; i < loopCount; ++i)
+        Load(textFile, vertices, indices);
+    double parallelSec = SystemTime::TimeBetweenTicks(start, SystemTime::GetCurrentTick()) / loopCount;
+
+    Utility::ByteArray file = Utility::ReadFileSync(textFile);
+    if (file == Utility::NullFile)
+        return;
+
+    double fileMB = file->size() / (1024.0 * 1024.0);
+    Utility::Printf(L"MeshTextLoader: %s  ifstream: %.1f MB/s  parallel: %.1f MB/s\n",
+        textFile.c_str(), fileMB / streamSec, fileMB / parallelSec);
+}
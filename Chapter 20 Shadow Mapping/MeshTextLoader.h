@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "d3dUtil.h"
+
+// ̵߳ıģ(Models/*.txt)ûжƻʱʹ
+// һԶļѶο鰴зֳɶΣÿڲͬ߳н
+// ֽ iostream  locale MeshCache::LoadText λһ
+namespace MeshTextLoader
+{
+    // ȡıģ
+    bool Load(const std::wstring& textFile, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices);
+
+    // ڴеıģͣ[begin, end) ֮ '\0' β
+    bool Parse(const char* begin, const char* end, std::vector<Vertex>& vertices, std::vector<std::int32_t>& indices);
+
+    // ֱñ MeshCache::LoadText أλȽȫ
+    // ߶سɹȫһʱ true
+    bool SelfTest(const std::wstring& textFile);
+
+    //  MeshCache::LoadText Ľٶ(MB/s)
+    void Benchmark(const std::wstring& textFile, int loopCount = 10);
+}
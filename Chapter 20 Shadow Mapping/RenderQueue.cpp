@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "RenderQueue.h"
+#include <cstring>
+
+uint64_t RenderQueue::MakeStateKey(uint32_t geometry, D3D12_PRIMITIVE_TOPOLOGY topology, uint32_t material)
+{
+    const uint32_t materialShift = kDepthBits;
+    const uint32_t topologyShift = materialShift + kMaterialBits;
+    const uint32_t geometryShift = topologyShift + kTopologyBits;
+
+    uint64_t key = 0;
+    key |= (uint64_t)(geometry & ((1u << kGeometryBits) - 1)) << geometryShift;
+    key |= (uint64_t)((uint32_t)topology & ((1u << kTopologyBits) - 1)) << topologyShift;
+    key |= (uint64_t)(material & ((1u << kMaterialBits) - 1)) << materialShift;
+    return key;
+}
+
+uint64_t RenderQueue::MakePsoKey(uint32_t pso)
+{
+    return (uint64_t)(pso & ((1u << kPsoBits) - 1)) << (64 - kPsoBits);
+}
+
+uint64_t RenderQueue::MakeDepthKey(float distanceSq)
+{
+    // NaN0
+    if (!(distanceSq > 0.0f))
+        return 0;
+
+    uint32_t bits;
+    memcpy(&bits, &distanceSq, sizeof(bits));
+    return bits >> (32 - kDepthBits);
+}
+
+void RenderQueue::Sort(void)
+{
+    const size_t count = m_entries.size();
+
+    if (count > 1)
+    {
+        // һαͳȫ8ֽڵֱͼ
+        uint32_t histogram[8][256] = {};
+        for (const Entry& e : m_entries)
+        {
+            for (int pass = 0; pass < 8; ++pass)
+                ++histogram[pass][(e.key >> (pass * 8)) & 0xFF];
+        }
+
+        m_scratch.resize(count);
+        Entry* src = m_entries.data();
+        Entry* dst = m_scratch.data();
+
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            uint32_t* bucket = histogram[pass];
+
+            // һֽȫͬ˳򲻻ı
+            if (bucket[(src[0].key >> (pass * 8)) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (int i = 0; i < 256; ++i)
+            {
+                uint32_t n = bucket[i];
+                bucket[i] = offset;
+                offset += n;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+                dst[bucket[(src[i].key >> (pass * 8)) & 0xFF]++] = src[i];
+
+            std::swap(src, dst);
+        }
+
+        if (src != m_entries.data())
+            m_entries.swap(m_scratch);
+    }
+
+    m_items.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        m_items[i] = m_entries[i].item;
+}
+
+void RenderQueue::BuildBatches(bool merge, UINT submeshCount, std::vector<UINT>& instances)
+{
+    UINT base = (UINT)instances.size();
+    m_batches.clear();
+
+    if (!merge)
+    {
+        instances.resize(base + m_items.size());
+        for (RenderItem* item : m_items)
+        {
+            m_batches.push_back({ item, base, 1 });
+            instances[base++] = item->ObjIndex;
+        }
+        return;
+    }
+
+    // ͳÿʵ
+    m_batchOfSubmesh.assign(submeshCount, -1);
+    for (RenderItem* item : m_items)
+    {
+        int& batch = m_batchOfSubmesh[item->SubmeshId];
+        if (batch < 0)
+        {
+            batch = (int)m_batches.size();
+            m_batches.push_back({ item, 0, 0 });
+        }
+        ++m_batches[batch].instanceCount;
+    }
+
+    // ʵеλãٰ˳д
+    for (DrawBatch& batch : m_batches)
+    {
+        batch.instanceBase = base;
+        base += batch.instanceCount;
+        batch.instanceCount = 0;
+    }
+
+    instances.resize(base);
+    for (RenderItem* item : m_items)
+    {
+        DrawBatch& batch = m_batches[m_batchOfSubmesh[item->SubmeshId]];
+        instances[batch.instanceBase + batch.instanceCount++] = item->ObjIndex;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "d3dUtil.h"
+
+// 64λȾ
+// ͬ״̬һGraphicsContext ˵ڵظ
+// ٰͬϲΪһʵƣдÿ֡ʵ
+//
+// (Ӹߵ):
+//  [63..56] PSO            ͬһPSOͬ
+//  [55..40] νṹ        㡢
+//  [39..36] ͼԪ
+//  [35..24] 
+//  [23.. 0] Ͱ          ƽĸλĸ24λɽԶ
+class RenderQueue
+{
+public:
+    static const uint32_t kPsoBits = 8;
+    static const uint32_t kGeometryBits = 16;
+    static const uint32_t kTopologyBits = 4;
+    static const uint32_t kMaterialBits = 12;
+    static const uint32_t kDepthBits = 24;
+
+    // ֡仯Ĳ: νṹˡ
+    static uint64_t MakeStateKey(uint32_t geometry, D3D12_PRIMITIVE_TOPOLOGY topology, uint32_t material);
+    static uint64_t MakePsoKey(uint32_t pso);
+    // ǸƽĸλֵӣֱȡλΪͰ
+    static uint64_t MakeDepthKey(float distanceSq);
+
+    void Clear(void) { m_entries.clear(); }
+    void Push(uint64_t key, RenderItem* item) { m_entries.push_back({ key, item }); }
+
+    // 8λһ˵LSDмĳһֽͬʱһ
+    // ȶģͬ屣ּ˳
+    void Sort(void);
+
+    // һʵ: item ṩݣʵ [instanceBase, instanceBase + instanceCount) Ǹʵ
+    struct DrawBatch
+    {
+        RenderItem* item;
+        UINT instanceBase;
+        UINT instanceCount;
+    };
+
+    //  RenderItem::SubmeshId ϲ壬ΰһڶе˳
+    // merge Ϊfalseʱÿ嵥һ׷ӵ instances ֮
+    void BuildBatches(bool merge, UINT submeshCount, std::vector<UINT>& instances);
+
+    // 
+    std::vector<RenderItem*>& GetItems(void) { return m_items; }
+    // BuildBatches Ľֱӽ drawRenderItems
+    std::vector<DrawBatch>& GetBatches(void) { return m_batches; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        RenderItem* item;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_scratch;
+    std::vector<RenderItem*> m_items;
+
+    std::vector<DrawBatch> m_batches;
+    std::vector<int> m_batchOfSubmesh;     //  -> m_batches еλ
+};
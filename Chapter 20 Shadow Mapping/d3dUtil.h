@@ -1,13 +1,37 @@
 #pragma once
 
 #include <string>
+#include <cfloat>
 #include <unordered_map>
 #include "VectorMath.h"
+#include "Math/BoundingSphere.h"
 
 // Ũ
 static float flFrogAlpha = 0.0f;
-// Ƿ׶޳
+// Ƿ׶޳: Ӱͼ6pass԰׶޳壬Χ׶ֻһ
 static bool g_openFrustumCull = true;
+// ÿ֡(PSOνṹʡ)Ⱦ壬رպ󰴼˳ƣڶԱ״̬л
+static bool g_sortRenderItems = true;
+// ÿ֡ѸͬϲΪһ DrawIndexedInstancedرպÿ嵥
+static bool g_instanceRenderItems = true;
+// ѳеľ̬帴Ƶ(0Ϊ) -benchmark nulldevice ״̬˺ʵϲ 1000050000
+static int g_sceneItemCount = 0;
+// Ӱͼ(6ͬһ)pass3passڹ߳¼ƵԵģͬ¼Ƴϴһύ
+static bool g_parallelRecording = true;
+// ͼֻƶձ仯棬̬պлڵͼУرպÿ֡ػȫ6
+static bool g_cubeMapCaching = true;
+// ÿ֡µͼ˳ӵ֮֡6Ϊ֡
+static int g_cubeFacesPerFrame = 2;
+// Դĳ澲̬¼ķǶ()ʱؽ
+static float g_cubeLightTolerance = 0.05f;
+// Ӱļ(1~4)һʱ2еͼ
+static int g_shadowCascadeCount = 4;
+// ķֶηʽ0ΪȻ֣1Ϊ֣֮Բֵ
+static float g_shadowCascadeLambda = 0.75f;
+// ʼӰľ룬ٲӰͼ
+static float g_shadowDistance = 80.0f;
+// Χ֮Դľ룬ڵԻͶӰ
+static float g_shadowCasterDistance = 40.0f;
 
 // HLSLһ
 struct Light
@@ -28,6 +52,10 @@ struct ObjectConstants
     Math::Matrix4 texTransform = Math::Matrix4(Math::kIdentity); // öת
     Math::Matrix4 matTransform = Math::Matrix4(Math::kIdentity);
     UINT MaterialIndex;
+    // ΪṹԪϴ뵽ɫе ObjectData ͬĴС
+    UINT ObjPad0;
+    UINT ObjPad1;
+    UINT ObjPad2;
 };
 
 struct PassConstants
@@ -47,6 +75,12 @@ struct PassConstants
     // indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
     // are spot lights for a maximum of MaxLights per object.
     Light Lights[MaxLights];
+
+    // Ӱ dynamicIndexDefaultPS.hlsl е cbPass һ
+    Math::Matrix4 cascadeShadow[4];     // תӰͼ
+    Math::Vector4 cascadeAtlas[4];      // ͼе xy ź zw ƫ
+    UINT cascadeCount = 0;
+    UINT pad3[3];
 };
 
 struct MaterialConstants
@@ -114,6 +148,29 @@ public:
         vecIndex = std::move(index);
     }
 
+    //  vecVertex/vecIndex һõĶİΧ: ΧĵԶľΪ뾶
+    Math::BoundingSphere computeBounds(int indexCount, int startIndex, int baseVertex) const
+    {
+        if (indexCount <= 0 || vecIndex.empty())
+            return Math::BoundingSphere(Math::Vector3(Math::kZero), 0.0f);
+
+        Math::Vector3 minPos(FLT_MAX, FLT_MAX, FLT_MAX);
+        Math::Vector3 maxPos(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (int i = startIndex; i < startIndex + indexCount; ++i)
+        {
+            Math::Vector3 pos(vecVertex[baseVertex + vecIndex[i]].Pos);
+            minPos = Math::Min(minPos, pos);
+            maxPos = Math::Max(maxPos, pos);
+        }
+
+        Math::Vector3 center = (minPos + maxPos) * 0.5f;
+        Math::Scalar radiusSq(0.0f);
+        for (int i = startIndex; i < startIndex + indexCount; ++i)
+            radiusSq = Math::Max(radiusSq, Math::LengthSquare(Math::Vector3(vecVertex[baseVertex + vecIndex[i]].Pos) - center));
+
+        return Math::BoundingSphere(center, Math::Sqrt(radiusSq));
+    }
+
     void destroy()
     {
         vertexBuff.Destroy();
@@ -144,6 +201,13 @@ struct RenderItem
     Math::Matrix4 matTransform = Math::Matrix4(Math::kIdentity);     // ƾ󣬱̬ͨƶ
 
     UINT MaterialIndex = -1;           // ĿӦ
+    UINT ObjIndex = 0;                 // ÿ֡峣еλ
+    uint64_t SortKey = 0;              // в֡仯Ĳ(νṹˡ)
+    UINT SubmeshId = 0;                // νṹ˶ͬͬԺϲΪһʵ
+
+    Math::BoundingSphere Bounds;       // ģͿռİΧ
+    Math::Matrix4 lastModeToWorld = Math::Matrix4(Math::kIdentity);  // ͼϴμʱ modeToWorld
+    bool Dynamic = false;              // ƶ岻ٻͼľ̬
 
     int IndexCount = 0;             // 
     int StartIndexLocation = 0;     // ʼλ
@@ -151,4 +215,15 @@ struct RenderItem
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
     MeshGeometry* geo = nullptr;    // νṹָ룬ӦĶԼ
-};
\ No newline at end of file
+};
+
+// ģͿռİΧתռ䣬뾶ŷŴ
+inline Math::BoundingSphere TransformBounds(const Math::Matrix4& modeToWorld, const Math::BoundingSphere& bounds)
+{
+    // modeToWorld תô洢
+    Math::Matrix4 world = Math::Transpose(modeToWorld);
+    Math::Vector3 center(world * bounds.GetCenter());
+    Math::Scalar scaleSq = Math::Max(Math::LengthSquare(Math::Vector3(world.GetX())),
+        Math::Max(Math::LengthSquare(Math::Vector3(world.GetY())), Math::LengthSquare(Math::Vector3(world.GetZ()))));
+    return Math::BoundingSphere(center, bounds.GetRadius() * Math::Sqrt(scaleSq));
+}
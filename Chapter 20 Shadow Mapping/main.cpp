@@ -1,4 +1,5 @@
 #include "GameApp.h"
+#include "HeadlessTests.h"
 
 int WINAPI WinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 	_In_ LPSTR lpCmdLine, _In_ int nShowCmd )
@@ -9,7 +10,10 @@ int WINAPI WinMain( _In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 #endif
 
 	GameApp* app = new GameApp();
-	GameCore::RunApplication(*app, hInstance, L"CrossGate");
+	// -selftest / -benchmark ڣ HeadlessTests.h
+	int exitCode = 0;
+	if (!HeadlessTests::Run(lpCmdLine, *app, exitCode))
+		GameCore::RunApplication(*app, hInstance, L"CrossGate");
 	delete app;
-	return 0;
+	return exitCode;
 }
\ No newline at end of file